@@ -0,0 +1,536 @@
+/******************************************************************************
+    libseistamp - Public API
+    Copyright (C) 2026
+
+    SEI timestamp building/parsing, access-unit scanning and the NTP / link
+    clock time service, with no dependency on libobs. Memory, logging and the
+    monotonic clock go through hooks that the host installs once at startup.
+******************************************************************************/
+
+#pragma once
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SEISTAMP_VERSION_MAJOR 1
+#define SEISTAMP_VERSION_MINOR 0
+#define SEISTAMP_VERSION_PATCH 0
+
+/* 返回 (major << 16) | (minor << 8) | patch, 用于检查运行时链接的版本 */
+uint32_t seistamp_version(void);
+
+/* ------------------------------------------------------------------------- */
+/* 钩子: 在任何其他调用之前设置一次; 传入NULL恢复默认实现 */
+
+/* 日志级别 (取值与libobs一致,宿主可以直接转发) */
+enum {
+  SEISTAMP_LOG_ERROR = 100,
+  SEISTAMP_LOG_WARNING = 200,
+  SEISTAMP_LOG_INFO = 300,
+  SEISTAMP_LOG_DEBUG = 400,
+};
+
+/* 内存分配 (默认malloc/free) */
+typedef struct seistamp_allocator {
+  void *(*malloc)(size_t size);
+  void (*free)(void *ptr);
+} seistamp_allocator_t;
+
+void seistamp_set_allocator(const seistamp_allocator_t *allocator);
+void *seistamp_malloc(size_t size);
+void seistamp_free(void *ptr);
+
+/* 日志 (默认: WARNING及以上输出到stderr) */
+typedef void (*seistamp_log_handler_t)(int level, const char *format,
+                                       va_list args, void *param);
+
+void seistamp_set_log_handler(seistamp_log_handler_t handler, void *param);
+
+/*
+ * 单调时钟(纳秒), 用于NTP往返计算和本地时间换算
+ * 默认: CLOCK_MONOTONIC / QueryPerformanceCounter
+ */
+typedef uint64_t (*seistamp_clock_t)(void);
+
+void seistamp_set_clock(seistamp_clock_t clock);
+uint64_t seistamp_now_ns(void);
+
+/* ------------------------------------------------------------------------- */
+/* NTP时间戳 */
+
+/* 1900到1970的秒数 */
+#define SEISTAMP_NTP_DELTA 2208988800ULL
+
+/* NTP时间戳结构 - 64位,包含秒和分数部分 */
+typedef struct seistamp_ntp_time {
+  uint32_t seconds;  /* 从1900年1月1日开始的秒数 */
+  uint32_t fraction; /* 秒的分数部分(2^-32秒为单位) */
+} seistamp_ntp_time_t;
+
+/* 64x64 -> 128位乘法,返回低64位,高64位写入hi */
+static inline uint64_t seistamp_mul128(uint64_t a, uint64_t b, uint64_t *hi) {
+#if defined(_MSC_VER) && defined(_M_X64)
+  return _umul128(a, b, hi);
+#elif defined(__SIZEOF_INT128__)
+  unsigned __int128 r = (unsigned __int128)a * b;
+  *hi = (uint64_t)(r >> 64);
+  return (uint64_t)r;
+#else
+  uint64_t a_lo = (uint32_t)a, a_hi = a >> 32;
+  uint64_t b_lo = (uint32_t)b, b_hi = b >> 32;
+  uint64_t lo_lo = a_lo * b_lo;
+  uint64_t hi_lo = a_hi * b_lo;
+  uint64_t lo_hi = a_lo * b_hi;
+  uint64_t cross = (lo_lo >> 32) + (uint32_t)hi_lo + lo_hi;
+  *hi = a_hi * b_hi + (hi_lo >> 32) + (cross >> 32);
+  return (cross << 32) | (uint32_t)lo_lo;
+#endif
+}
+
+/*
+ * NTP时间戳与纳秒(Unix纪元)之间的转换
+ * 每帧都会调用,因此用定点乘法代替除法
+ */
+static inline uint64_t seistamp_ntp_to_ns(const seistamp_ntp_time_t *ntp) {
+  uint64_t seconds = (uint64_t)ntp->seconds;
+
+  /* 转换为Unix时间戳 */
+  if (seconds > SEISTAMP_NTP_DELTA) {
+    seconds -= SEISTAMP_NTP_DELTA;
+  }
+
+  /* 分数部分转纳秒: fraction / 2^32 * 10^9 */
+  return seconds * 1000000000ULL +
+         (((uint64_t)ntp->fraction * 1000000000ULL) >> 32);
+}
+
+static inline void seistamp_ntp_from_ns(uint64_t ns,
+                                        seistamp_ntp_time_t *ntp) {
+  /* ns / 10^9 = (ns * ceil(2^90 / 10^9)) >> 90 */
+  uint64_t hi;
+  seistamp_mul128(ns, 0x112E0BE826D694B3ULL, &hi);
+  uint64_t seconds = hi >> 26;
+  uint64_t fraction_ns = ns - seconds * 1000000000ULL;
+
+  /* 转换为NTP时间戳(从1900年开始) */
+  ntp->seconds = (uint32_t)(seconds + SEISTAMP_NTP_DELTA);
+
+  /* 分数部分: fraction_ns * 2^32 / 10^9 = (fraction_ns * floor(2^64 / 10^9))
+   * >> 32, fraction_ns < 10^9 时乘积不会溢出 */
+  ntp->fraction = (uint32_t)((fraction_ns * 0x44B82FA09ULL) >> 32);
+}
+
+/*
+ * 获取本机系统时钟(Unix纪元纳秒)
+ * 未与NTP同步时用作时间戳的回退值,接收端可以按链路估计偏移
+ */
+uint64_t seistamp_wallclock_ns(void);
+
+/* ------------------------------------------------------------------------- */
+/* 时间戳SEI: 构建与解析 */
+
+/* 时间戳SEI的UUID: a5b3c2d1-e4f5-6789-abcd-ef0123456789 */
+extern const uint8_t SEISTAMP_UUID[16];
+
+/* payload: UUID(16) + PTS(8) + NTP秒(4) + NTP分数(4), 均为big-endian */
+#define SEISTAMP_PAYLOAD_SIZE 32
+
+/* SEI payload类型 */
+#define SEISTAMP_SEI_USER_DATA_UNREGISTERED 5
+
+/* SEI NAL单元类型 */
+typedef enum seistamp_nal_type {
+  SEISTAMP_NAL_H264_SEI = 6,         /* H.264 SEI */
+  SEISTAMP_NAL_H265_PREFIX_SEI = 39, /* H.265 PREFIX_SEI_NUT */
+  SEISTAMP_NAL_H265_SUFFIX_SEI = 40  /* H.265 SUFFIX_SEI_NUT */
+} seistamp_nal_type_t;
+
+/* 码流类型 (决定NAL头长度和SEI类型) */
+typedef enum seistamp_codec {
+  SEISTAMP_CODEC_H264,
+  SEISTAMP_CODEC_H265,
+} seistamp_codec_t;
+
+/* 解析出的时间戳 */
+typedef struct seistamp_stamp {
+  int64_t pts;                  /* 发送端写入的PTS */
+  seistamp_ntp_time_t ntp_time; /* 帧送入编码器时的NTP时间 */
+} seistamp_stamp_t;
+
+/* 将时间戳payload写入调用者提供的缓冲区(至少 SEISTAMP_PAYLOAD_SIZE 字节) */
+void seistamp_write_payload(uint8_t *payload, int64_t pts,
+                            const seistamp_ntp_time_t *ntp_time);
+
+/* 包含给定payload的SEI NAL单元(含4字节起始码和防竞争字节)的最大大小 */
+size_t seistamp_sei_nal_max_size(size_t payload_size,
+                                 seistamp_nal_type_t nal_type);
+
+/*
+ * 将SEI NAL单元写入调用者提供的缓冲区(插入防竞争字节)
+ * 参数:
+ *   out - 输出缓冲区
+ *   capacity - 缓冲区大小(至少 seistamp_sei_nal_max_size())
+ *   payload - user_data_unregistered payload
+ *   payload_size - payload大小
+ *   nal_type - NAL单元类型
+ * 返回:
+ *   写入的字节数, 缓冲区不足时返回0
+ */
+size_t seistamp_write_sei_nal(uint8_t *out, size_t capacity,
+                              const uint8_t *payload, size_t payload_size,
+                              seistamp_nal_type_t nal_type);
+
+/*
+ * 构建完整的时间戳SEI NAL单元(通过分配钩子分配, seistamp_free释放)
+ * 返回:
+ *   NAL单元, 失败返回NULL
+ */
+uint8_t *seistamp_build_sei_nal(int64_t pts,
+                                const seistamp_ntp_time_t *ntp_time,
+                                seistamp_codec_t codec, size_t *size_out);
+
+/*
+ * 解析以UUID开头的时间戳payload (例如FFmpeg的SEI_UNREGISTERED附加数据)
+ * 返回:
+ *   true - UUID匹配且长度足够
+ */
+bool seistamp_parse_payload(const uint8_t *payload, size_t size,
+                            seistamp_stamp_t *stamp_out);
+
+/*
+ * 在任意数据中查找时间戳payload(按UUID搜索)
+ * 注意: 数据需已去除防竞争字节
+ */
+bool seistamp_find_payload(const uint8_t *data, size_t size,
+                           seistamp_stamp_t *stamp_out);
+
+/*
+ * 从单个NAL单元(含起始码)中取出第一条SEI消息的payload
+ * payload_out指向nal_data内部,未去除防竞争字节
+ */
+bool seistamp_extract_sei_payload(const uint8_t *nal_data, size_t nal_size,
+                                  const uint8_t **payload_out,
+                                  size_t *payload_size);
+
+/*
+ * 扫描Annex B访问单元: 遍历所有NAL,对每个SEI NAL去除防竞争字节,
+ * 再逐条检查其中的SEI消息
+ * 参数:
+ *   data - 访问单元(一个或多个带起始码的NAL)
+ *   size - 数据大小
+ *   codec - 码流类型
+ *   stamp_out - 输出的时间戳
+ * 返回:
+ *   true - 找到时间戳SEI
+ */
+bool seistamp_scan_access_unit(const uint8_t *data, size_t size,
+                               seistamp_codec_t codec,
+                               seistamp_stamp_t *stamp_out);
+
+/*
+ * 检查单个NAL单元(不含起始码,例如MP4中按长度前缀存放的NAL)
+ * 非SEI NAL直接返回false; SEI NAL去除防竞争字节后逐条检查SEI消息
+ */
+bool seistamp_scan_nal(const uint8_t *nal, size_t size, seistamp_codec_t codec,
+                       seistamp_stamp_t *stamp_out);
+
+/* ------------------------------------------------------------------------- */
+/* 时间服务: NTP客户端 */
+
+/* NTP数据包结构 (48字节) */
+typedef struct seistamp_ntp_packet {
+  uint8_t li_vn_mode; /* Leap Indicator(2位) + Version(3位) + Mode(3位) */
+  uint8_t stratum;    /* 层级(0-15) */
+  uint8_t poll;       /* 轮询间隔 */
+  uint8_t precision;  /* 精度 */
+
+  uint32_t root_delay;      /* 根延迟 */
+  uint32_t root_dispersion; /* 根离散度 */
+  uint32_t reference_id;    /* 参考时钟标识符 */
+
+  seistamp_ntp_time_t reference_timestamp; /* 参考时间戳 */
+  seistamp_ntp_time_t originate_timestamp; /* 起始时间戳 (T1) */
+  seistamp_ntp_time_t receive_timestamp;   /* 接收时间戳 (T2) */
+  seistamp_ntp_time_t transmit_timestamp;  /* 传输时间戳 (T3) */
+} seistamp_ntp_packet_t;
+
+/* NTP客户端上下文 */
+typedef struct seistamp_ntp_client {
+  char server_address[256]; /* NTP服务器地址 */
+  uint16_t server_port;     /* NTP服务器端口(通常是123) */
+
+  int socket_fd;       /* UDP socket文件描述符 */
+  bool is_initialized; /* 是否已初始化 */
+  bool is_synced;      /* 是否已同步 */
+
+  seistamp_ntp_time_t last_sync_time; /* 最后同步的NTP时间 */
+  uint64_t last_sync_local_time; /* 最后同步时的本地时间(seistamp_now_ns) */
+  int64_t time_offset_ns;        /* 时间偏移(纳秒) */
+
+  uint32_t timeout_ms; /* 等待应答的超时(毫秒),默认5000 */
+
+  uint32_t sync_count;  /* 同步次数 */
+  uint32_t error_count; /* 错误次数 */
+} seistamp_ntp_client_t;
+
+/* 接收端重新同步策略 */
+typedef struct seistamp_resync_policy {
+  uint64_t min_interval_ns;   /* 两次同步之间的最小间隔 */
+  int64_t drift_threshold_ns; /* 帧时间与当前NTP时间允许的最大偏差 */
+} seistamp_resync_policy_t;
+
+/* 触发重新同步的原因 */
+typedef enum seistamp_resync_reason {
+  SEISTAMP_RESYNC_NONE = 0, /* 不需要 */
+  SEISTAMP_RESYNC_INITIAL,  /* 尚未同步过 */
+  SEISTAMP_RESYNC_KEYFRAME, /* 关键帧且已超过最小间隔 */
+  SEISTAMP_RESYNC_DRIFT,    /* 帧时间与本地NTP时间偏差超过阈值 */
+} seistamp_resync_reason_t;
+
+/* 初始化NTP客户端(不发送请求) */
+bool seistamp_ntp_client_init(seistamp_ntp_client_t *client, const char *server,
+                              uint16_t port);
+
+/* 执行一次NTP时间同步(阻塞,最长timeout_ms) */
+bool seistamp_ntp_client_sync(seistamp_ntp_client_t *client);
+
+/* 当前NTP时间; 未同步时返回false */
+bool seistamp_ntp_client_get_time(seistamp_ntp_client_t *client,
+                                  seistamp_ntp_time_t *timestamp);
+
+/* 当前时间戳: 已同步时返回NTP时间(true),否则返回本机系统时钟(false) */
+bool seistamp_ntp_client_get_time_or_local(seistamp_ntp_client_t *client,
+                                           seistamp_ntp_time_t *timestamp);
+
+/* 时间偏移(NTP时间 - 本地时间, 纳秒) */
+int64_t seistamp_ntp_client_get_offset(seistamp_ntp_client_t *client);
+
+/* 距上次同步是否已超过max_age_seconds */
+bool seistamp_ntp_client_needs_resync(seistamp_ntp_client_t *client,
+                                      uint32_t max_age_seconds);
+
+/*
+ * 接收端的重新同步判断: 收到带时间戳的帧时调用
+ * 参数:
+ *   now_ns - 当前本地时间(seistamp_now_ns)
+ *   last_sync_ns - 上次尝试同步的本地时间(0表示从未尝试)
+ *   keyframe - 当前帧是否为关键帧
+ *   frame_time - 帧携带的NTP时间戳
+ */
+seistamp_resync_reason_t seistamp_ntp_client_check_resync(
+    seistamp_ntp_client_t *client, const seistamp_resync_policy_t *policy,
+    uint64_t now_ns, uint64_t last_sync_ns, bool keyframe,
+    const seistamp_ntp_time_t *frame_time);
+
+void seistamp_ntp_client_destroy(seistamp_ntp_client_t *client);
+
+/* ------------------------------------------------------------------------- */
+/* 时间服务: 链路时钟 (无NTP服务器时,由SEI时间戳估计发送端时钟偏移) */
+
+/* 最小值滤波窗口(样本数) */
+#define SEISTAMP_LINK_CLOCK_WINDOW 64
+
+typedef struct seistamp_link_clock {
+  int64_t samples[SEISTAMP_LINK_CLOCK_WINDOW]; /* 到达时间 - 发送端时间戳 */
+  size_t sample_index;                         /* 下一个写入位置 */
+  size_t sample_count;                         /* 窗口内样本数 */
+
+  int64_t transport_delay_ns; /* 已知的传输延迟(SRT latency) */
+  int64_t offset_ns;          /* 平滑后的偏移: 本地时钟 - 发送端时钟 */
+  bool valid;                 /* 是否已有可用估计 */
+  int step_sign;              /* 连续越界样本的方向(+1/-1) */
+  uint32_t step_count;        /* 连续同方向越界的样本数 */
+
+  uint64_t total_samples; /* 累计样本数 */
+  uint32_t reset_count;   /* 因时钟跳变而重置的次数 */
+} seistamp_link_clock_t;
+
+/* transport_delay_ns: 发送到交付之间的固定延迟(例如SRT的TSBPD latency) */
+void seistamp_link_clock_init(seistamp_link_clock_t *clock,
+                              int64_t transport_delay_ns);
+
+/* 每收到一个带时间戳的帧调用一次 (sender_ns为Unix纪元纳秒) */
+void seistamp_link_clock_add_sample(seistamp_link_clock_t *clock,
+                                    uint64_t sender_ns,
+                                    uint64_t local_arrival_ns);
+
+/* 将发送端时间映射到本地时钟; 尚无估计时返回false */
+bool seistamp_link_clock_to_local(const seistamp_link_clock_t *clock,
+                                  uint64_t sender_ns, int64_t *local_out);
+
+/* ------------------------------------------------------------------------- */
+/* 时间服务: PTS时间线 (展开PTS回绕, 回归拟合PTS到发送端NTP时间的映射) */
+
+/* MPEG-TS的PTS为33位, 90kHz下约26.5小时回绕一次 */
+#define SEISTAMP_PTS_WRAP_BITS_MPEGTS 33
+
+/* 把一个流的原始PTS换算为连续的纳秒时间 */
+typedef struct seistamp_pts_unwrap {
+  int64_t modulus;        /* 2^回绕位数, 0表示不回绕 */
+  int32_t time_base_num;  /* 流的time_base分子 */
+  int32_t time_base_den;  /* 流的time_base分母 */
+  bool has_last;          /* 已有上一个PTS */
+  int64_t last_raw;       /* 上一个原始PTS */
+  int64_t last_unwrapped; /* 上一个展开后的PTS(tick) */
+} seistamp_pts_unwrap_t;
+
+/*
+ * 参数:
+ *   wrap_bits - PTS位数(AVStream.pts_wrap_bits), 0或>=63表示不回绕
+ *   time_base_num/den - 流的time_base, 无效时按1/90000
+ */
+void seistamp_pts_unwrap_init(seistamp_pts_unwrap_t *unwrap, int wrap_bits,
+                              int32_t time_base_num, int32_t time_base_den);
+
+/*
+ * 展开并换算为纳秒: 取与上一个PTS最接近的同余值,
+ * 因此B帧重排序跨过回绕点时也不会误判
+ */
+int64_t seistamp_pts_unwrap_ns(seistamp_pts_unwrap_t *unwrap, int64_t pts);
+
+/* 回归窗口(样本数)及样本间隔: 窗口覆盖约64秒 */
+#define SEISTAMP_PTS_TIMELINE_WINDOW 128
+#define SEISTAMP_PTS_TIMELINE_SAMPLE_INTERVAL_NS 500000000LL
+
+/* 发送端NTP时间 = 截距 + 斜率 * PTS (均相对于本段的起点) */
+typedef struct seistamp_pts_timeline {
+  int64_t pts[SEISTAMP_PTS_TIMELINE_WINDOW]; /* 样本PTS - base_pts_ns */
+  int64_t ntp[SEISTAMP_PTS_TIMELINE_WINDOW]; /* 样本NTP - base_ntp_ns */
+  size_t sample_index;                       /* 下一个写入位置 */
+  size_t sample_count;                       /* 窗口内样本数 */
+
+  int64_t base_pts_ns; /* 本段第一个样本的PTS */
+  int64_t base_ntp_ns; /* 本段第一个样本的NTP时间 */
+  int64_t last_pts;    /* 最近写入窗口的样本(相对值) */
+  double slope;        /* NTP时间/PTS时间, 即发送端PTS时钟的速率 */
+  double intercept_ns; /* 相对值的截距 */
+  bool valid;          /* 是否已有可用映射 */
+
+  uint64_t total_samples; /* 累计样本数 */
+  uint32_t reset_count;   /* 因PTS或时钟不连续而重置的次数 */
+} seistamp_pts_timeline_t;
+
+void seistamp_pts_timeline_init(seistamp_pts_timeline_t *timeline);
+
+/* 每个带时间戳的帧调用一次 (pts_ns来自seistamp_pts_unwrap_ns) */
+void seistamp_pts_timeline_add_sample(seistamp_pts_timeline_t *timeline,
+                                      int64_t pts_ns, uint64_t ntp_ns);
+
+/* 把任意帧(包括没有时间戳的帧)的PTS映射为发送端NTP时间 */
+bool seistamp_pts_timeline_to_ntp(const seistamp_pts_timeline_t *timeline,
+                                  int64_t pts_ns, uint64_t *ntp_out);
+
+/* 拟合出的速率偏差(百万分比): 发送端PTS时钟相对NTP时间的快慢 */
+double seistamp_pts_timeline_rate_ppm(const seistamp_pts_timeline_t *timeline);
+
+/* ------------------------------------------------------------------------- */
+/* 录像时间戳索引 (.ssix边车文件)
+ *
+ * 放在录像文件旁边: 32字节文件头之后是按NTP时间递增排列的定长记录,
+ * 可以直接mmap后二分查找, 按墙钟时间定位而无需读取媒体数据.
+ * 所有字段为小端字节序. 记录数由文件大小决定, 因此写入中断(崩溃/断电)
+ * 时已写入的完整记录仍然可用.
+ */
+
+#define SEISTAMP_INDEX_MAGIC 0x58495353u /* "SSIX" */
+#define SEISTAMP_INDEX_VERSION 1
+#define SEISTAMP_INDEX_EXTENSION ".ssix"
+
+/* 记录标志 */
+#define SEISTAMP_INDEX_KEYFRAME 0x00000001u /* 可以从该帧开始解码 */
+
+typedef struct seistamp_index_header {
+  uint32_t magic;        /* SEISTAMP_INDEX_MAGIC */
+  uint16_t version;      /* SEISTAMP_INDEX_VERSION */
+  uint16_t entry_size;   /* sizeof(seistamp_index_entry_t) */
+  uint32_t codec;        /* seistamp_codec_t */
+  int32_t time_base_num; /* 记录中PTS的时间基 */
+  int32_t time_base_den;
+  uint8_t reserved[12];
+} seistamp_index_header_t;
+
+typedef struct seistamp_index_entry {
+  uint64_t ntp_ns; /* 帧送入编码器时的NTP时间(Unix纪元纳秒) */
+  int64_t pts;     /* 录像容器中的PTS */
+  uint64_t offset; /* 帧在录像文件中的字节偏移 */
+  uint32_t flags;  /* SEISTAMP_INDEX_* */
+  uint32_t reserved;
+} seistamp_index_entry_t;
+
+/* 索引写入器: 边录制边追加 */
+typedef struct seistamp_index_writer seistamp_index_writer_t;
+
+/*
+ * 创建索引文件(覆盖已有文件)并写入文件头
+ * 返回:
+ *   写入器, 无法创建文件时返回NULL
+ */
+seistamp_index_writer_t *seistamp_index_writer_create(const char *path,
+                                                      seistamp_codec_t codec,
+                                                      int32_t time_base_num,
+                                                      int32_t time_base_den);
+
+/*
+ * 追加一帧(按解码顺序即可, B帧造成的乱序在写入器内重排)
+ * NTP时间早于已写入的记录时丢弃该帧以保持有序(NTP校时回跳);
+ * 关键帧记录写入后立即刷新到文件
+ * 返回:
+ *   false - 写入失败(磁盘已满等)
+ */
+bool seistamp_index_writer_add(seistamp_index_writer_t *writer,
+                               uint64_t ntp_ns, int64_t pts, uint64_t offset,
+                               uint32_t flags);
+
+/* 已写入的记录数 */
+uint64_t seistamp_index_writer_count(const seistamp_index_writer_t *writer);
+
+/* 刷新并关闭; 返回false表示有数据未能写入 */
+bool seistamp_index_writer_close(seistamp_index_writer_t *writer);
+
+/* 只读映射的索引 */
+typedef struct seistamp_index {
+  seistamp_index_header_t header;
+  const seistamp_index_entry_t *entries; /* 小端主机上指向映射内存 */
+  size_t count;
+
+  void *mapping; /* 内部使用 */
+  size_t mapping_size;
+  void *decoded; /* 内部使用: 大端主机上解码后的记录 */
+} seistamp_index_t;
+
+/*
+ * 以mmap方式打开索引文件并检查文件头 (大端主机上记录被解码为副本)
+ * 返回:
+ *   false - 无法打开、不是索引文件或版本不支持
+ */
+bool seistamp_index_open(seistamp_index_t *index, const char *path);
+
+void seistamp_index_close(seistamp_index_t *index);
+
+/*
+ * 二分查找最后一条ntp_ns <= 给定时间的记录
+ * 返回:
+ *   记录下标, 所有记录都晚于给定时间时返回SIZE_MAX
+ */
+size_t seistamp_index_find(const seistamp_index_t *index, uint64_t ntp_ns);
+
+/*
+ * 从记录i向前(含i)查找关键帧, 即从该处开始解码能到达记录i
+ * 返回:
+ *   记录下标, 没有关键帧时返回SIZE_MAX
+ */
+size_t seistamp_index_find_keyframe(const seistamp_index_t *index, size_t i);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,101 @@
+/******************************************************************************
+    libseistamp - Host Hooks
+    Copyright (C) 2026
+
+    Allocator, logging and monotonic clock hooks with standalone defaults
+******************************************************************************/
+
+#include "seistamp-internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+/* 钩子只在启动时设置一次,之后只读 */
+static seistamp_allocator_t allocator = {malloc, free};
+static seistamp_log_handler_t log_handler;
+static void *log_param;
+static seistamp_clock_t clock_hook;
+
+uint32_t seistamp_version(void) {
+  return (SEISTAMP_VERSION_MAJOR << 16) | (SEISTAMP_VERSION_MINOR << 8) |
+         SEISTAMP_VERSION_PATCH;
+}
+
+void seistamp_set_allocator(const seistamp_allocator_t *hooks) {
+  if (hooks && hooks->malloc && hooks->free) {
+    allocator = *hooks;
+  } else {
+    allocator.malloc = malloc;
+    allocator.free = free;
+  }
+}
+
+void *seistamp_malloc(size_t size) { return allocator.malloc(size); }
+
+void seistamp_free(void *ptr) {
+  if (ptr)
+    allocator.free(ptr);
+}
+
+void seistamp_set_log_handler(seistamp_log_handler_t handler, void *param) {
+  log_handler = handler;
+  log_param = param;
+}
+
+void seistamp_log(int level, const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+
+  if (log_handler) {
+    log_handler(level, format, args, log_param);
+  } else if (level <= SEISTAMP_LOG_WARNING) {
+    vfprintf(stderr, format, args);
+    fputc('\n', stderr);
+  }
+
+  va_end(args);
+}
+
+void seistamp_set_clock(seistamp_clock_t clock) { clock_hook = clock; }
+
+/* 默认单调时钟,与libobs的os_gettime_ns()同一时基 */
+static uint64_t default_clock_ns(void) {
+#ifdef _WIN32
+  static LARGE_INTEGER frequency;
+  LARGE_INTEGER counter;
+  if (!frequency.QuadPart)
+    QueryPerformanceFrequency(&frequency);
+  QueryPerformanceCounter(&counter);
+
+  /* 与os_gettime_ns()相同的换算 */
+  return (uint64_t)((double)counter.QuadPart * 1000000000.0 /
+                    (double)frequency.QuadPart);
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+uint64_t seistamp_now_ns(void) {
+  return clock_hook ? clock_hook() : default_clock_ns();
+}
+
+uint64_t seistamp_wallclock_ns(void) {
+#ifdef _WIN32
+  FILETIME ft;
+  GetSystemTimePreciseAsFileTime(&ft);
+  uint64_t ticks = ((uint64_t)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+  /* FILETIME: 自1601年起的100ns单位 */
+  return (ticks - 116444736000000000ULL) * 100ULL;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
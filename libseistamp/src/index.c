@@ -0,0 +1,387 @@
+/******************************************************************************
+    libseistamp - Recording Index
+    Copyright (C) 2026
+
+    Writer and memory-mapped reader for the .ssix sidecar that maps NTP
+    wall-clock time to container PTS and byte offsets of a recording
+******************************************************************************/
+
+#include "seistamp-internal.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* 磁盘格式固定, 不允许编译器改变布局 */
+_Static_assert(sizeof(seistamp_index_header_t) == 32, "index header size");
+_Static_assert(sizeof(seistamp_index_entry_t) == 32, "index entry size");
+
+#define HEADER_SIZE 32
+#define ENTRY_SIZE 32
+
+/* 文件按小端逐字段读写, 与主机字节序无关 */
+static inline void write_le16(uint8_t *p, uint16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void write_le32(uint8_t *p, uint32_t v) {
+  write_le16(p, (uint16_t)v);
+  write_le16(p + 2, (uint16_t)(v >> 16));
+}
+
+static inline void write_le64(uint8_t *p, uint64_t v) {
+  write_le32(p, (uint32_t)v);
+  write_le32(p + 4, (uint32_t)(v >> 32));
+}
+
+static inline uint16_t read_le16(const uint8_t *p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t read_le32(const uint8_t *p) {
+  return (uint32_t)read_le16(p) | ((uint32_t)read_le16(p + 2) << 16);
+}
+
+static inline uint64_t read_le64(const uint8_t *p) {
+  return (uint64_t)read_le32(p) | ((uint64_t)read_le32(p + 4) << 32);
+}
+
+static void encode_header(uint8_t *out, const seistamp_index_header_t *h) {
+  memset(out, 0, HEADER_SIZE);
+  write_le32(out, h->magic);
+  write_le16(out + 4, h->version);
+  write_le16(out + 6, h->entry_size);
+  write_le32(out + 8, h->codec);
+  write_le32(out + 12, (uint32_t)h->time_base_num);
+  write_le32(out + 16, (uint32_t)h->time_base_den);
+}
+
+static void decode_header(seistamp_index_header_t *h, const uint8_t *in) {
+  memset(h, 0, sizeof(*h));
+  h->magic = read_le32(in);
+  h->version = read_le16(in + 4);
+  h->entry_size = read_le16(in + 6);
+  h->codec = read_le32(in + 8);
+  h->time_base_num = (int32_t)read_le32(in + 12);
+  h->time_base_den = (int32_t)read_le32(in + 16);
+}
+
+static void encode_entry(uint8_t *out, const seistamp_index_entry_t *e) {
+  write_le64(out, e->ntp_ns);
+  write_le64(out + 8, (uint64_t)e->pts);
+  write_le64(out + 16, e->offset);
+  write_le32(out + 24, e->flags);
+  write_le32(out + 28, e->reserved);
+}
+
+static void decode_entry(seistamp_index_entry_t *e, const uint8_t *in) {
+  e->ntp_ns = read_le64(in);
+  e->pts = (int64_t)read_le64(in + 8);
+  e->offset = read_le64(in + 16);
+  e->flags = read_le32(in + 24);
+  e->reserved = read_le32(in + 28);
+}
+
+/* 小端主机上文件布局与结构体一致, 可以直接使用映射内存 */
+static inline bool host_is_little_endian(void) {
+  const uint16_t probe = 1;
+  return *(const uint8_t *)&probe == 1;
+}
+
+#define index_log(level, format, ...)                                          \
+  seistamp_log(level, "[Index] " format, ##__VA_ARGS__)
+
+/* 帧按解码顺序到达, 有B帧时NTP时间(采集顺序)在小范围内乱序;
+ * 在窗口内排序后再写入, 窗口大于H.264/H.265的最大重排深度(16) */
+#define REORDER_WINDOW 32
+
+struct seistamp_index_writer {
+  FILE *file;
+  seistamp_index_entry_t pending[REORDER_WINDOW]; /* 按ntp_ns升序 */
+  size_t pending_count;
+  uint64_t last_ntp_ns; /* 最后写入文件的记录 */
+  uint64_t count;
+  uint64_t skipped; /* NTP回跳而丢弃的帧 */
+  bool failed;
+};
+
+/* 路径为UTF-8 (与libobs一致), Windows上需要转换为宽字符 */
+static FILE *open_file(const char *path, const char *mode) {
+#ifdef _WIN32
+  wchar_t wpath[MAX_PATH], wmode[8];
+  if (!MultiByteToWideChar(CP_UTF8, 0, path, -1, wpath, MAX_PATH) ||
+      !MultiByteToWideChar(CP_UTF8, 0, mode, -1, wmode, 8))
+    return NULL;
+  return _wfopen(wpath, wmode);
+#else
+  return fopen(path, mode);
+#endif
+}
+
+seistamp_index_writer_t *seistamp_index_writer_create(const char *path,
+                                                      seistamp_codec_t codec,
+                                                      int32_t time_base_num,
+                                                      int32_t time_base_den) {
+  if (!path || time_base_num <= 0 || time_base_den <= 0)
+    return NULL;
+
+  FILE *file = open_file(path, "wb");
+  if (!file) {
+    index_log(SEISTAMP_LOG_ERROR, "Cannot create %s", path);
+    return NULL;
+  }
+
+  seistamp_index_header_t header = {
+      .magic = SEISTAMP_INDEX_MAGIC,
+      .version = SEISTAMP_INDEX_VERSION,
+      .entry_size = sizeof(seistamp_index_entry_t),
+      .codec = (uint32_t)codec,
+      .time_base_num = time_base_num,
+      .time_base_den = time_base_den,
+  };
+  uint8_t bytes[HEADER_SIZE];
+  encode_header(bytes, &header);
+  if (fwrite(bytes, sizeof(bytes), 1, file) != 1 || fflush(file) != 0) {
+    index_log(SEISTAMP_LOG_ERROR, "Cannot write %s", path);
+    fclose(file);
+    return NULL;
+  }
+
+  seistamp_index_writer_t *writer = seistamp_malloc(sizeof(*writer));
+  if (!writer) {
+    fclose(file);
+    return NULL;
+  }
+  memset(writer, 0, sizeof(*writer));
+  writer->file = file;
+  return writer;
+}
+
+/* 写出窗口中最早的记录 */
+static bool write_oldest(seistamp_index_writer_t *writer) {
+  const seistamp_index_entry_t *entry = &writer->pending[0];
+  uint8_t bytes[ENTRY_SIZE];
+  encode_entry(bytes, entry);
+  if (fwrite(bytes, sizeof(bytes), 1, writer->file) != 1 ||
+      ((entry->flags & SEISTAMP_INDEX_KEYFRAME) && fflush(writer->file) != 0)) {
+    writer->failed = true;
+    return false;
+  }
+
+  writer->last_ntp_ns = entry->ntp_ns;
+  writer->count++;
+  writer->pending_count--;
+  memmove(writer->pending, writer->pending + 1,
+          writer->pending_count * sizeof(seistamp_index_entry_t));
+  return true;
+}
+
+bool seistamp_index_writer_add(seistamp_index_writer_t *writer,
+                               uint64_t ntp_ns, int64_t pts, uint64_t offset,
+                               uint32_t flags) {
+  if (!writer || writer->failed)
+    return false;
+
+  /* 查找依赖有序, 早于已写入记录的帧(NTP回跳)不进入索引 */
+  if (writer->count && ntp_ns < writer->last_ntp_ns) {
+    writer->skipped++;
+    return true;
+  }
+
+  if (writer->pending_count == REORDER_WINDOW && !write_oldest(writer))
+    return false;
+
+  /* 插入排序: 通常只比较最后一条 */
+  size_t i = writer->pending_count;
+  while (i > 0 && writer->pending[i - 1].ntp_ns > ntp_ns) {
+    writer->pending[i] = writer->pending[i - 1];
+    i--;
+  }
+  writer->pending[i] = (seistamp_index_entry_t){
+      .ntp_ns = ntp_ns,
+      .pts = pts,
+      .offset = offset,
+      .flags = flags,
+  };
+  writer->pending_count++;
+  return true;
+}
+
+uint64_t seistamp_index_writer_count(const seistamp_index_writer_t *writer) {
+  return writer ? writer->count + writer->pending_count : 0;
+}
+
+bool seistamp_index_writer_close(seistamp_index_writer_t *writer) {
+  if (!writer)
+    return false;
+
+  while (writer->pending_count && !writer->failed)
+    write_oldest(writer);
+
+  bool ok = !writer->failed;
+  if (fclose(writer->file) != 0)
+    ok = false;
+
+  if (writer->skipped)
+    index_log(SEISTAMP_LOG_WARNING,
+              "%llu frames left out of the index (NTP time went backwards)",
+              (unsigned long long)writer->skipped);
+
+  seistamp_free(writer);
+  return ok;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* 映射整个文件; 失败时返回NULL */
+static void *map_file(const char *path, size_t *size_out) {
+#ifdef _WIN32
+  wchar_t wpath[MAX_PATH];
+  if (!MultiByteToWideChar(CP_UTF8, 0, path, -1, wpath, MAX_PATH))
+    return NULL;
+
+  /* 允许录制中的文件被同时打开 */
+  HANDLE file = CreateFileW(wpath, GENERIC_READ,
+                            FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE)
+    return NULL;
+
+  LARGE_INTEGER size;
+  HANDLE mapping = NULL;
+  if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+    mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  CloseHandle(file);
+  if (!mapping)
+    return NULL;
+
+  void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mapping);
+  *size_out = (size_t)size.QuadPart;
+  return data;
+#else
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return NULL;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return NULL;
+  }
+
+  void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+    return NULL;
+
+  *size_out = (size_t)st.st_size;
+  return data;
+#endif
+}
+
+static void unmap_file(void *data, size_t size) {
+#ifdef _WIN32
+  (void)size;
+  UnmapViewOfFile(data);
+#else
+  munmap(data, size);
+#endif
+}
+
+bool seistamp_index_open(seistamp_index_t *index, const char *path) {
+  if (!index || !path)
+    return false;
+  memset(index, 0, sizeof(*index));
+
+  size_t size = 0;
+  uint8_t *data = map_file(path, &size);
+  if (!data) {
+    index_log(SEISTAMP_LOG_ERROR, "Cannot map %s", path);
+    return false;
+  }
+
+  if (size < HEADER_SIZE) {
+    index_log(SEISTAMP_LOG_ERROR, "%s: file too short", path);
+    unmap_file(data, size);
+    return false;
+  }
+
+  decode_header(&index->header, data);
+  if (index->header.magic != SEISTAMP_INDEX_MAGIC ||
+      index->header.version != SEISTAMP_INDEX_VERSION ||
+      index->header.entry_size != ENTRY_SIZE) {
+    index_log(SEISTAMP_LOG_ERROR, "%s: not a version %d index", path,
+              SEISTAMP_INDEX_VERSION);
+    unmap_file(data, size);
+    return false;
+  }
+
+  /* 写入中断时末尾可能有不完整的记录, 忽略 */
+  index->count = (size - HEADER_SIZE) / ENTRY_SIZE;
+  index->mapping = data;
+  index->mapping_size = size;
+
+  if (host_is_little_endian()) {
+    index->entries = (const seistamp_index_entry_t *)(data + HEADER_SIZE);
+    return true;
+  }
+
+  /* 大端主机: 解码到内存副本 */
+  seistamp_index_entry_t *decoded =
+      seistamp_malloc(index->count ? index->count * sizeof(*decoded) : 1);
+  if (!decoded) {
+    seistamp_index_close(index);
+    return false;
+  }
+  for (size_t i = 0; i < index->count; i++)
+    decode_entry(&decoded[i], data + HEADER_SIZE + i * ENTRY_SIZE);
+  index->entries = decoded;
+  index->decoded = decoded;
+  return true;
+}
+
+void seistamp_index_close(seistamp_index_t *index) {
+  if (!index)
+    return;
+  if (index->mapping)
+    unmap_file(index->mapping, index->mapping_size);
+  seistamp_free(index->decoded);
+  memset(index, 0, sizeof(*index));
+}
+
+size_t seistamp_index_find(const seistamp_index_t *index, uint64_t ntp_ns) {
+  if (!index || index->count == 0 || index->entries[0].ntp_ns > ntp_ns)
+    return SIZE_MAX;
+
+  /* 不变量: entries[lo].ntp_ns <= ntp_ns < entries[hi].ntp_ns */
+  size_t lo = 0, hi = index->count;
+  while (hi - lo > 1) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (index->entries[mid].ntp_ns <= ntp_ns)
+      lo = mid;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+size_t seistamp_index_find_keyframe(const seistamp_index_t *index, size_t i) {
+  if (!index || i >= index->count)
+    return SIZE_MAX;
+
+  for (;; i--) {
+    if (index->entries[i].flags & SEISTAMP_INDEX_KEYFRAME)
+      return i;
+    if (i == 0)
+      return SIZE_MAX;
+  }
+}
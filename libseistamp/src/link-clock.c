@@ -0,0 +1,108 @@
+/******************************************************************************
+    libseistamp - Link Clock Estimator
+    Copyright (C) 2026
+
+    Estimates the sender-to-receiver clock offset of a single SRT link from
+    the SEI timestamps it carries, without any NTP server
+******************************************************************************/
+
+#include "seistamp-internal.h"
+#include <string.h>
+
+/* 估计值突变超过该阈值时认为发送端时钟跳变(例如重启或被NTP校准),重新收敛 */
+#define LINK_CLOCK_STEP_THRESHOLD_NS 200000000LL /* 200ms */
+
+/* 连续这么多个同方向越界的样本才认为是时钟跳变, 单个迟到的帧不算 */
+#define LINK_CLOCK_STEP_CONFIRM_SAMPLES 3
+
+/* 平滑系数 1/2^N, 每个样本向窗口最小值靠近 1/8 */
+#define LINK_CLOCK_SMOOTH_SHIFT 3
+
+void seistamp_link_clock_init(seistamp_link_clock_t *clock,
+                              int64_t transport_delay_ns) {
+  if (!clock) {
+    return;
+  }
+
+  memset(clock, 0, sizeof(seistamp_link_clock_t));
+  clock->transport_delay_ns = transport_delay_ns;
+}
+
+/* 窗口内的最小值: 排队、解码抖动只会让样本变大,最小值最接近真实偏移 */
+static int64_t window_min(const seistamp_link_clock_t *clock) {
+  int64_t min = clock->samples[0];
+  for (size_t i = 1; i < clock->sample_count; i++) {
+    if (clock->samples[i] < min) {
+      min = clock->samples[i];
+    }
+  }
+  return min;
+}
+
+static void push_sample(seistamp_link_clock_t *clock, int64_t sample) {
+  clock->samples[clock->sample_index] = sample;
+  clock->sample_index = (clock->sample_index + 1) % SEISTAMP_LINK_CLOCK_WINDOW;
+  if (clock->sample_count < SEISTAMP_LINK_CLOCK_WINDOW) {
+    clock->sample_count++;
+  }
+}
+
+void seistamp_link_clock_add_sample(seistamp_link_clock_t *clock,
+                                    uint64_t sender_ns,
+                                    uint64_t local_arrival_ns) {
+  if (!clock || sender_ns == 0) {
+    return;
+  }
+
+  int64_t sample = (int64_t)(local_arrival_ns - sender_ns);
+  clock->total_samples++;
+
+  if (!clock->valid) {
+    push_sample(clock, sample);
+    clock->offset_ns = window_min(clock) - clock->transport_delay_ns;
+    clock->valid = true;
+    return;
+  }
+
+  int64_t step = sample - clock->transport_delay_ns - clock->offset_ns;
+  int sign = step > LINK_CLOCK_STEP_THRESHOLD_NS    ? 1
+             : step < -LINK_CLOCK_STEP_THRESHOLD_NS ? -1
+                                                    : 0;
+  if (sign == 0) {
+    clock->step_count = 0;
+  } else {
+    if (sign != clock->step_sign) {
+      clock->step_count = 0;
+      clock->step_sign = sign;
+    }
+    if (++clock->step_count >= LINK_CLOCK_STEP_CONFIRM_SAMPLES) {
+      /* 发送端时钟跳变: 丢弃旧窗口,从当前样本重新开始 */
+      clock->sample_index = 0;
+      clock->sample_count = 0;
+      push_sample(clock, sample);
+      clock->offset_ns = sample - clock->transport_delay_ns;
+      clock->step_count = 0;
+      clock->reset_count++;
+      return;
+    }
+    /* 偏大的样本(重传、接收线程停顿)照常进入窗口, 由最小值滤波忽略;
+     * 偏小的样本只可能来自时钟跳变, 确认之前不进入窗口 */
+    if (sign < 0) {
+      return;
+    }
+  }
+
+  push_sample(clock, sample);
+  int64_t target = window_min(clock) - clock->transport_delay_ns;
+  clock->offset_ns += (target - clock->offset_ns) >> LINK_CLOCK_SMOOTH_SHIFT;
+}
+
+bool seistamp_link_clock_to_local(const seistamp_link_clock_t *clock,
+                                  uint64_t sender_ns, int64_t *local_out) {
+  if (!clock || !clock->valid || !local_out) {
+    return false;
+  }
+
+  *local_out = (int64_t)sender_ns + clock->offset_ns;
+  return true;
+}
@@ -1,14 +1,13 @@
 /******************************************************************************
-    NTP Client Module - Implementation
+    libseistamp - NTP Client
     Copyright (C) 2026
 
     Implements NTP (Network Time Protocol) client for time synchronization
 ******************************************************************************/
 
-#include "ntp-client.h"
-#include <obs-module.h>
+#include "seistamp-internal.h"
+#include <stdio.h>
 #include <string.h>
-#include <util/platform.h>
 
 #ifdef _WIN32
 #include <winsock2.h>
@@ -19,19 +18,19 @@
 #include <netdb.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
+#include <time.h>
 #include <unistd.h>
 
 #endif
 
 /* NTP常量 */
-#define NTP_TIMESTAMP_DELTA 2208988800ULL /* 1900到1970的秒数 */
 #define NTP_VERSION 3
 #define NTP_MODE_CLIENT 3
 #define NTP_PACKET_SIZE 48
 
 /* 日志宏 */
 #define ntp_log(level, format, ...)                                            \
-  blog(level, "[NTP Client] " format, ##__VA_ARGS__)
+  seistamp_log(level, "[NTP Client] " format, ##__VA_ARGS__)
 
 /* 辅助函数:将网络字节序转换为主机字节序 */
 static uint32_t ntohl_swap(uint32_t netlong) { return ntohl(netlong); }
@@ -40,39 +39,7 @@ static uint32_t ntohl_swap(uint32_t netlong) { return ntohl(netlong); }
 static uint32_t htonl_swap(uint32_t hostlong) { return htonl(hostlong); }
 
 /* 辅助函数:获取当前时间(纳秒) */
-static uint64_t get_current_time_ns(void) { return os_gettime_ns(); }
-
-/* 辅助函数:将NTP时间戳转换为纳秒 */
-static uint64_t ntp_to_ns(ntp_timestamp_t *ntp) {
-  uint64_t seconds = (uint64_t)ntp->seconds;
-  uint64_t fraction = (uint64_t)ntp->fraction;
-
-  /* 转换为Unix时间戳 */
-  if (seconds > NTP_TIMESTAMP_DELTA) {
-    seconds -= NTP_TIMESTAMP_DELTA;
-  }
-
-  /* 秒转纳秒 */
-  uint64_t ns = seconds * 1000000000ULL;
-
-  /* 分数部分转纳秒: fraction / 2^32 * 10^9 */
-  ns += (fraction * 1000000000ULL) >> 32;
-
-  return ns;
-}
-
-/* 辅助函数:将纳秒转换为NTP时间戳 */
-static void ns_to_ntp(uint64_t ns, ntp_timestamp_t *ntp) {
-  /* 纳秒转秒 */
-  uint64_t seconds = ns / 1000000000ULL;
-  uint64_t fraction_ns = ns % 1000000000ULL;
-
-  /* 转换为NTP时间戳(从1900年开始) */
-  ntp->seconds = (uint32_t)(seconds + NTP_TIMESTAMP_DELTA);
-
-  /* 分数部分: fraction_ns / 10^9 * 2^32 */
-  ntp->fraction = (uint32_t)((fraction_ns << 32) / 1000000000ULL);
-}
+static uint64_t get_current_time_ns(void) { return seistamp_now_ns(); }
 
 /* 初始化Winsock(仅Windows) */
 #ifdef _WIN32
@@ -85,7 +52,7 @@ static bool init_winsock(void) {
   WSADATA wsa_data;
   int result = WSAStartup(MAKEWORD(2, 2), &wsa_data);
   if (result != 0) {
-    ntp_log(LOG_ERROR, "WSAStartup failed: %d", result);
+    ntp_log(SEISTAMP_LOG_ERROR, "WSAStartup failed: %d", result);
     return false;
   }
 
@@ -95,13 +62,14 @@ static bool init_winsock(void) {
 #endif
 
 /* 初始化NTP客户端 */
-bool ntp_client_init(ntp_client_t *client, const char *server, uint16_t port) {
+bool seistamp_ntp_client_init(seistamp_ntp_client_t *client, const char *server,
+                              uint16_t port) {
   if (!client || !server) {
-    ntp_log(LOG_ERROR, "Invalid parameters");
+    ntp_log(SEISTAMP_LOG_ERROR, "Invalid parameters");
     return false;
   }
 
-  memset(client, 0, sizeof(ntp_client_t));
+  memset(client, 0, sizeof(seistamp_ntp_client_t));
 
 #ifdef _WIN32
   if (!init_winsock()) {
@@ -113,23 +81,25 @@ bool ntp_client_init(ntp_client_t *client, const char *server, uint16_t port) {
   strncpy(client->server_address, server, sizeof(client->server_address) - 1);
   client->server_port = port;
   client->socket_fd = -1;
+  client->timeout_ms = 5000;
   client->is_initialized = true;
 
-  ntp_log(LOG_INFO, "NTP client initialized (server: %s:%d)", server, port);
+  ntp_log(SEISTAMP_LOG_INFO, "NTP client initialized (server: %s:%d)", server,
+          port);
 
   return true;
 }
 
 /* 执行NTP时间同步 */
-bool ntp_client_sync(ntp_client_t *client) {
+bool seistamp_ntp_client_sync(seistamp_ntp_client_t *client) {
   if (!client || !client->is_initialized) {
-    ntp_log(LOG_ERROR, "Client not initialized");
+    ntp_log(SEISTAMP_LOG_ERROR, "Client not initialized");
     return false;
   }
 
   int sock = -1;
   struct addrinfo hints, *server_info = NULL;
-  ntp_packet_t packet;
+  seistamp_ntp_packet_t packet;
   bool success = false;
 
   /* 创建UDP socket */
@@ -142,22 +112,26 @@ bool ntp_client_sync(ntp_client_t *client) {
 
   int ret = getaddrinfo(client->server_address, port_str, &hints, &server_info);
   if (ret != 0) {
-    ntp_log(LOG_ERROR, "getaddrinfo failed for %s: %d", client->server_address,
-            ret);
+    ntp_log(SEISTAMP_LOG_ERROR, "getaddrinfo failed for %s: %d",
+            client->server_address, ret);
     goto cleanup;
   }
 
   sock = (int)socket(server_info->ai_family, server_info->ai_socktype,
                      server_info->ai_protocol);
   if (sock < 0) {
-    ntp_log(LOG_ERROR, "socket creation failed");
+    ntp_log(SEISTAMP_LOG_ERROR, "socket creation failed");
     goto cleanup;
   }
 
-  /* 设置超时 */
+  /* 设置超时 (Windows的SO_RCVTIMEO为DWORD毫秒,其他平台为timeval) */
+#ifdef _WIN32
+  DWORD timeout = client->timeout_ms;
+#else
   struct timeval timeout;
-  timeout.tv_sec = 5;
-  timeout.tv_usec = 0;
+  timeout.tv_sec = client->timeout_ms / 1000;
+  timeout.tv_usec = (client->timeout_ms % 1000) * 1000;
+#endif
   setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (const char *)&timeout,
              sizeof(timeout));
 
@@ -167,7 +141,7 @@ bool ntp_client_sync(ntp_client_t *client) {
 
   /* 记录发送时间 (T1) */
   uint64_t t1 = get_current_time_ns();
-  ns_to_ntp(t1, &packet.transmit_timestamp);
+  seistamp_ntp_from_ns(t1, &packet.transmit_timestamp);
   packet.transmit_timestamp.seconds =
       htonl_swap(packet.transmit_timestamp.seconds);
   packet.transmit_timestamp.fraction =
@@ -177,7 +151,7 @@ bool ntp_client_sync(ntp_client_t *client) {
   ret = sendto(sock, (const char *)&packet, sizeof(packet), 0,
                server_info->ai_addr, (int)server_info->ai_addrlen);
   if (ret < 0) {
-    ntp_log(LOG_ERROR, "sendto failed");
+    ntp_log(SEISTAMP_LOG_ERROR, "sendto failed");
     goto cleanup;
   }
 
@@ -190,20 +164,20 @@ bool ntp_client_sync(ntp_client_t *client) {
   /* 记录接收时间 (T4) */
   uint64_t t4 = get_current_time_ns();
 
-  if (ret < sizeof(packet)) {
-    ntp_log(LOG_ERROR, "recvfrom failed or incomplete packet");
+  if (ret < (int)sizeof(packet)) {
+    ntp_log(SEISTAMP_LOG_ERROR, "recvfrom failed or incomplete packet");
     goto cleanup;
   }
 
   /* 解析响应 */
-  ntp_timestamp_t t2, t3;
+  seistamp_ntp_time_t t2, t3;
   t2.seconds = ntohl_swap(packet.receive_timestamp.seconds);
   t2.fraction = ntohl_swap(packet.receive_timestamp.fraction);
   t3.seconds = ntohl_swap(packet.transmit_timestamp.seconds);
   t3.fraction = ntohl_swap(packet.transmit_timestamp.fraction);
 
-  uint64_t t2_ns = ntp_to_ns(&t2);
-  uint64_t t3_ns = ntp_to_ns(&t3);
+  uint64_t t2_ns = seistamp_ntp_to_ns(&t2);
+  uint64_t t3_ns = seistamp_ntp_to_ns(&t3);
 
   /* 计算时间偏移: offset = ((T2 - T1) + (T3 - T4)) / 2 */
   int64_t offset = ((int64_t)(t2_ns - t1) + (int64_t)(t3_ns - t4)) / 2;
@@ -215,8 +189,8 @@ bool ntp_client_sync(ntp_client_t *client) {
   client->is_synced = true;
   client->sync_count++;
 
-  ntp_log(LOG_INFO, "NTP sync successful (offset: %lld ms, count: %u)",
-          offset / 1000000, client->sync_count);
+  ntp_log(SEISTAMP_LOG_INFO, "NTP sync successful (offset: %lld ms, count: %u)",
+          (long long)(offset / 1000000), client->sync_count);
 
   success = true;
 
@@ -240,7 +214,8 @@ cleanup:
 }
 
 /* 获取当前的NTP时间戳 */
-bool ntp_client_get_time(ntp_client_t *client, ntp_timestamp_t *timestamp) {
+bool seistamp_ntp_client_get_time(seistamp_ntp_client_t *client,
+                                  seistamp_ntp_time_t *timestamp) {
   if (!client || !timestamp || !client->is_synced) {
     return false;
   }
@@ -249,15 +224,29 @@ bool ntp_client_get_time(ntp_client_t *client, ntp_timestamp_t *timestamp) {
    */
   uint64_t current_local = get_current_time_ns();
   uint64_t elapsed = current_local - client->last_sync_local_time;
-  uint64_t current_ntp_ns = ntp_to_ns(&client->last_sync_time) + elapsed;
+  uint64_t current_ntp_ns =
+      seistamp_ntp_to_ns(&client->last_sync_time) + elapsed;
 
-  ns_to_ntp(current_ntp_ns, timestamp);
+  seistamp_ntp_from_ns(current_ntp_ns, timestamp);
 
   return true;
 }
 
+/* 获取当前时间戳,未同步时回退到本机时钟 */
+bool seistamp_ntp_client_get_time_or_local(seistamp_ntp_client_t *client,
+                                           seistamp_ntp_time_t *timestamp) {
+  if (seistamp_ntp_client_get_time(client, timestamp)) {
+    return true;
+  }
+
+  if (timestamp) {
+    seistamp_ntp_from_ns(seistamp_wallclock_ns(), timestamp);
+  }
+  return false;
+}
+
 /* 获取时间偏移 */
-int64_t ntp_client_get_offset(ntp_client_t *client) {
+int64_t seistamp_ntp_client_get_offset(seistamp_ntp_client_t *client) {
   if (!client) {
     return 0;
   }
@@ -265,7 +254,8 @@ int64_t ntp_client_get_offset(ntp_client_t *client) {
 }
 
 /* 检查是否需要重新同步 */
-bool ntp_client_needs_resync(ntp_client_t *client, uint32_t max_age_seconds) {
+bool seistamp_ntp_client_needs_resync(seistamp_ntp_client_t *client,
+                                      uint32_t max_age_seconds) {
   if (!client || !client->is_synced) {
     return true;
   }
@@ -277,14 +267,53 @@ bool ntp_client_needs_resync(ntp_client_t *client, uint32_t max_age_seconds) {
   return age_ns > max_age_ns;
 }
 
+/* 接收端的重新同步判断 */
+seistamp_resync_reason_t seistamp_ntp_client_check_resync(
+    seistamp_ntp_client_t *client, const seistamp_resync_policy_t *policy,
+    uint64_t now_ns, uint64_t last_sync_ns, bool keyframe,
+    const seistamp_ntp_time_t *frame_time) {
+  if (!client || !policy) {
+    return SEISTAMP_RESYNC_NONE;
+  }
+
+  /* 从未尝试过同步(例如初始同步时网络不可用) */
+  if (last_sync_ns == 0) {
+    return SEISTAMP_RESYNC_INITIAL;
+  }
+
+  /* 所有条件都受最小间隔限制,避免网络故障时每帧重试 */
+  if (now_ns - last_sync_ns < policy->min_interval_ns) {
+    return SEISTAMP_RESYNC_NONE;
+  }
+
+  if (keyframe) {
+    return SEISTAMP_RESYNC_KEYFRAME;
+  }
+
+  /* 帧时间与当前NTP时间的偏差 */
+  seistamp_ntp_time_t current;
+  if (frame_time && seistamp_ntp_client_get_time(client, &current)) {
+    int64_t diff = (int64_t)(seistamp_ntp_to_ns(frame_time) -
+                             seistamp_ntp_to_ns(&current));
+    if (diff < 0)
+      diff = -diff;
+
+    if (diff > policy->drift_threshold_ns) {
+      return SEISTAMP_RESYNC_DRIFT;
+    }
+  }
+
+  return SEISTAMP_RESYNC_NONE;
+}
+
 /* 销毁NTP客户端 */
-void ntp_client_destroy(ntp_client_t *client) {
+void seistamp_ntp_client_destroy(seistamp_ntp_client_t *client) {
   if (!client) {
     return;
   }
 
-  ntp_log(LOG_INFO, "NTP client destroyed (syncs: %u, errors: %u)",
+  ntp_log(SEISTAMP_LOG_INFO, "NTP client destroyed (syncs: %u, errors: %u)",
           client->sync_count, client->error_count);
 
-  memset(client, 0, sizeof(ntp_client_t));
+  memset(client, 0, sizeof(seistamp_ntp_client_t));
 }
@@ -0,0 +1,207 @@
+/******************************************************************************
+    libseistamp - PTS Timeline
+    Copyright (C) 2026
+
+    Unwraps a stream's PTS into continuous nanoseconds and fits a running
+    linear regression of PTS against the sender's NTP stamps, so every frame
+    (stamped or not) maps to a smooth sender time
+******************************************************************************/
+
+#include "seistamp-internal.h"
+#include <string.h>
+
+/* 拟合结果与新样本相差超过该阈值时认为PTS或发送端时钟不连续, 重新开始 */
+#define PTS_TIMELINE_STEP_THRESHOLD_NS 200000000LL /* 200ms */
+
+/* 样本跨度不足时斜率不可靠, 按名义速率(1.0)只估计截距 */
+#define PTS_TIMELINE_MIN_SPREAD_NS 10000000000LL /* 10秒 */
+
+/* 斜率的合理范围: 超出说明样本有问题, 按边界处理 */
+#define PTS_TIMELINE_MAX_RATE_PPM 1000.0
+
+/* 未设置time_base时按MPEG-TS的90kHz处理 */
+#define PTS_DEFAULT_TIME_BASE_DEN 90000
+
+void seistamp_pts_unwrap_init(seistamp_pts_unwrap_t *unwrap, int wrap_bits,
+                              int32_t time_base_num, int32_t time_base_den) {
+  if (!unwrap) {
+    return;
+  }
+
+  memset(unwrap, 0, sizeof(seistamp_pts_unwrap_t));
+  if (wrap_bits > 0 && wrap_bits < 63) {
+    unwrap->modulus = (int64_t)1 << wrap_bits;
+  }
+  if (time_base_num > 0 && time_base_den > 0) {
+    unwrap->time_base_num = time_base_num;
+    unwrap->time_base_den = time_base_den;
+  } else {
+    unwrap->time_base_num = 1;
+    unwrap->time_base_den = PTS_DEFAULT_TIME_BASE_DEN;
+  }
+}
+
+/* tick -> 纳秒, 分成整秒部分和余数部分避免溢出 */
+static int64_t ticks_to_ns(const seistamp_pts_unwrap_t *unwrap, int64_t ticks) {
+  int64_t den = unwrap->time_base_den;
+  int64_t scale = (int64_t)unwrap->time_base_num * 1000000000LL;
+  return ticks / den * scale + ticks % den * scale / den;
+}
+
+int64_t seistamp_pts_unwrap_ns(seistamp_pts_unwrap_t *unwrap, int64_t pts) {
+  if (!unwrap) {
+    return 0;
+  }
+
+  int64_t unwrapped = pts;
+  if (unwrap->modulus && unwrap->has_last) {
+    /* 与上一个PTS的差值取模后落在[-modulus/2, modulus/2) */
+    int64_t delta = (pts - unwrap->last_raw) & (unwrap->modulus - 1);
+    if (delta >= unwrap->modulus / 2) {
+      delta -= unwrap->modulus;
+    }
+    unwrapped = unwrap->last_unwrapped + delta;
+  }
+
+  unwrap->last_raw = pts;
+  unwrap->last_unwrapped = unwrapped;
+  unwrap->has_last = true;
+  return ticks_to_ns(unwrap, unwrapped);
+}
+
+void seistamp_pts_timeline_init(seistamp_pts_timeline_t *timeline) {
+  if (!timeline) {
+    return;
+  }
+
+  memset(timeline, 0, sizeof(seistamp_pts_timeline_t));
+  timeline->slope = 1.0;
+}
+
+/* 本段的第一个样本: 清空窗口, 以它为原点 */
+static void start_segment(seistamp_pts_timeline_t *timeline, int64_t pts_ns,
+                          uint64_t ntp_ns) {
+  timeline->base_pts_ns = pts_ns;
+  timeline->base_ntp_ns = (int64_t)ntp_ns;
+  timeline->pts[0] = 0;
+  timeline->ntp[0] = 0;
+  timeline->sample_index = 1;
+  timeline->sample_count = 1;
+  timeline->last_pts = 0;
+  timeline->slope = 1.0;
+  timeline->intercept_ns = 0.0;
+  timeline->valid = true;
+}
+
+/* 最小二乘拟合 (先求均值再求离差, 长时间运行时也不损失精度) */
+static void fit(seistamp_pts_timeline_t *timeline) {
+  size_t count = timeline->sample_count;
+  double mean_pts = 0.0;
+  double mean_ntp = 0.0;
+  int64_t min_pts = timeline->pts[0];
+  int64_t max_pts = timeline->pts[0];
+  for (size_t i = 0; i < count; i++) {
+    mean_pts += (double)timeline->pts[i];
+    mean_ntp += (double)timeline->ntp[i];
+    if (timeline->pts[i] < min_pts) {
+      min_pts = timeline->pts[i];
+    }
+    if (timeline->pts[i] > max_pts) {
+      max_pts = timeline->pts[i];
+    }
+  }
+  mean_pts /= (double)count;
+  mean_ntp /= (double)count;
+
+  double slope = 1.0;
+  if (max_pts - min_pts >= PTS_TIMELINE_MIN_SPREAD_NS) {
+    double sxx = 0.0;
+    double sxy = 0.0;
+    for (size_t i = 0; i < count; i++) {
+      double dx = (double)timeline->pts[i] - mean_pts;
+      sxx += dx * dx;
+      sxy += dx * ((double)timeline->ntp[i] - mean_ntp);
+    }
+    slope = sxy / sxx;
+
+    double limit = PTS_TIMELINE_MAX_RATE_PPM / 1000000.0;
+    if (slope > 1.0 + limit) {
+      slope = 1.0 + limit;
+    } else if (slope < 1.0 - limit) {
+      slope = 1.0 - limit;
+    }
+  }
+
+  timeline->slope = slope;
+  timeline->intercept_ns = mean_ntp - slope * mean_pts;
+}
+
+static double predict(const seistamp_pts_timeline_t *timeline, int64_t pts_ns) {
+  return timeline->intercept_ns +
+         timeline->slope * (double)(pts_ns - timeline->base_pts_ns);
+}
+
+void seistamp_pts_timeline_add_sample(seistamp_pts_timeline_t *timeline,
+                                      int64_t pts_ns, uint64_t ntp_ns) {
+  if (!timeline || ntp_ns == 0) {
+    return;
+  }
+
+  timeline->total_samples++;
+  if (!timeline->valid) {
+    start_segment(timeline, pts_ns, ntp_ns);
+    return;
+  }
+
+  /* 每个样本都检查连续性, 即使它不进入窗口 */
+  double residual = (double)((int64_t)ntp_ns - timeline->base_ntp_ns) -
+                    predict(timeline, pts_ns);
+  if (residual > PTS_TIMELINE_STEP_THRESHOLD_NS ||
+      residual < -PTS_TIMELINE_STEP_THRESHOLD_NS) {
+    start_segment(timeline, pts_ns, ntp_ns);
+    timeline->reset_count++;
+    return;
+  }
+
+  /* 按间隔抽取样本, 让固定大小的窗口覆盖足够长的时间来估计速率;
+   * B帧重排序造成的PTS回退不计入 */
+  int64_t pts = pts_ns - timeline->base_pts_ns;
+  if (pts - timeline->last_pts < SEISTAMP_PTS_TIMELINE_SAMPLE_INTERVAL_NS) {
+    return;
+  }
+
+  timeline->pts[timeline->sample_index] = pts;
+  timeline->ntp[timeline->sample_index] =
+      (int64_t)ntp_ns - timeline->base_ntp_ns;
+  timeline->sample_index =
+      (timeline->sample_index + 1) % SEISTAMP_PTS_TIMELINE_WINDOW;
+  if (timeline->sample_count < SEISTAMP_PTS_TIMELINE_WINDOW) {
+    timeline->sample_count++;
+  }
+  timeline->last_pts = pts;
+  fit(timeline);
+}
+
+bool seistamp_pts_timeline_to_ntp(const seistamp_pts_timeline_t *timeline,
+                                  int64_t pts_ns, uint64_t *ntp_out) {
+  if (!timeline || !timeline->valid || !ntp_out) {
+    return false;
+  }
+
+  /* 相对值在double中是精确的, 加回原点时用整数避免损失纳秒精度 */
+  double offset = predict(timeline, pts_ns);
+  int64_t ntp = timeline->base_ntp_ns +
+                (int64_t)(offset >= 0.0 ? offset + 0.5 : offset - 0.5);
+  if (ntp <= 0) {
+    return false;
+  }
+  *ntp_out = (uint64_t)ntp;
+  return true;
+}
+
+double seistamp_pts_timeline_rate_ppm(const seistamp_pts_timeline_t *timeline) {
+  if (!timeline || !timeline->valid) {
+    return 0.0;
+  }
+  return (timeline->slope - 1.0) * 1000000.0;
+}
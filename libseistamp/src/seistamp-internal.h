@@ -0,0 +1,17 @@
+/******************************************************************************
+    libseistamp - Internal Header
+    Copyright (C) 2026
+******************************************************************************/
+
+#pragma once
+
+#include "seistamp.h"
+
+#ifdef __GNUC__
+#define SEISTAMP_PRINTF(fmt, args) __attribute__((format(printf, fmt, args)))
+#else
+#define SEISTAMP_PRINTF(fmt, args)
+#endif
+
+/* 通过日志钩子输出 */
+void seistamp_log(int level, const char *format, ...) SEISTAMP_PRINTF(2, 3);
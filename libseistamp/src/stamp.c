@@ -0,0 +1,417 @@
+/******************************************************************************
+    libseistamp - Timestamp SEI
+    Copyright (C) 2026
+
+    Builds the timestamp SEI payload / NAL unit and finds it again in a
+    received access unit
+******************************************************************************/
+
+#include "seistamp-internal.h"
+#include <string.h>
+
+/* UUID for our custom SEI: a5b3c2d1-e4f5-6789-abcd-ef0123456789 */
+const uint8_t SEISTAMP_UUID[16] = {0xa5, 0xb3, 0xc2, 0xd1, 0xe4, 0xf5,
+                                   0x67, 0x89, 0xab, 0xcd, 0xef, 0x01,
+                                   0x23, 0x45, 0x67, 0x89};
+
+/* 去除防竞争字节时使用的栈缓冲区; 更大的SEI NAL通过分配钩子分配 */
+#define SCAN_STACK_BUFFER 512
+
+/* 可变长度编码(SEI type/size)的字节数 */
+static size_t variable_length_size(size_t value) { return value / 0xFF + 1; }
+
+static size_t write_variable_length(uint8_t *buf, size_t value) {
+  size_t written = 0;
+  while (value >= 0xFF) {
+    buf[written++] = 0xFF;
+    value -= 0xFF;
+  }
+  buf[written++] = (uint8_t)value;
+  return written;
+}
+
+/* 读取可变长度编码; 数据不完整时返回0 */
+static size_t read_variable_length(const uint8_t *buf, size_t max_size,
+                                   size_t *value_out) {
+  size_t value = 0;
+  size_t read = 0;
+
+  while (read < max_size && buf[read] == 0xFF) {
+    value += 0xFF;
+    read++;
+  }
+
+  if (read >= max_size)
+    return 0;
+
+  value += buf[read++];
+  *value_out = value;
+  return read;
+}
+
+static inline void write_be32(uint8_t *p, uint32_t v) {
+  p[0] = (uint8_t)(v >> 24);
+  p[1] = (uint8_t)(v >> 16);
+  p[2] = (uint8_t)(v >> 8);
+  p[3] = (uint8_t)v;
+}
+
+static inline uint32_t read_be32(const uint8_t *p) {
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+         ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+void seistamp_write_payload(uint8_t *payload, int64_t pts,
+                            const seistamp_ntp_time_t *ntp_time) {
+  memcpy(payload, SEISTAMP_UUID, 16);
+  write_be32(payload + 16, (uint32_t)((uint64_t)pts >> 32));
+  write_be32(payload + 20, (uint32_t)pts);
+  write_be32(payload + 24, ntp_time->seconds);
+  write_be32(payload + 28, ntp_time->fraction);
+}
+
+size_t seistamp_sei_nal_max_size(size_t payload_size,
+                                 seistamp_nal_type_t nal_type) {
+  size_t header_size = (nal_type == SEISTAMP_NAL_H264_SEI) ? 1 : 2;
+  size_t body = header_size +
+                variable_length_size(SEISTAMP_SEI_USER_DATA_UNREGISTERED) +
+                variable_length_size(payload_size) + payload_size + 1;
+  /* 最坏情况每两个字节插入一个防竞争字节 */
+  return 4 + body + body / 2;
+}
+
+/* 写入一个字节,必要时先插入防竞争字节(00 00 0x, x<=3 -> 00 00 03 0x) */
+static inline void put_escaped(uint8_t *out, size_t *offset, int *zeros,
+                               uint8_t byte) {
+  if (*zeros >= 2 && byte <= 0x03) {
+    out[(*offset)++] = 0x03;
+    *zeros = 0;
+  }
+  out[(*offset)++] = byte;
+  *zeros = byte == 0x00 ? *zeros + 1 : 0;
+}
+
+size_t seistamp_write_sei_nal(uint8_t *out, size_t capacity,
+                              const uint8_t *payload, size_t payload_size,
+                              seistamp_nal_type_t nal_type) {
+  if (!out || !payload ||
+      capacity < seistamp_sei_nal_max_size(payload_size, nal_type)) {
+    seistamp_log(SEISTAMP_LOG_ERROR,
+                 "[SEI Handler] Invalid parameters for SEI NAL unit");
+    return 0;
+  }
+
+  /* NAL单元结构:
+   * - 起始码: 0x00 0x00 0x00 0x01 (4字节)
+   * - NAL header: 1字节(H.264)或2字节(H.265)
+   * - SEI type / SEI size: 可变长度编码
+   * - Payload: payload_size字节
+   * - RBSP trailing bits: 0x80 (1字节)
+   * 起始码之后的内容按需插入防竞争字节(PTS的高位通常为连续的0)
+   */
+  uint8_t head[16];
+  size_t head_size = 0;
+
+  if (nal_type == SEISTAMP_NAL_H264_SEI) {
+    /* H.264: forbidden_bit(1) + nal_ref_idc(2) + nal_unit_type(5) */
+    head[head_size++] = SEISTAMP_NAL_H264_SEI;
+  } else {
+    /* H.265: forbidden_bit(1) + nal_unit_type(6) + nuh_layer_id(6) +
+     * nuh_temporal_id_plus1(3) */
+    head[head_size++] = (uint8_t)(nal_type << 1);
+    head[head_size++] = 1; /* temporal_id = 0 */
+  }
+  head_size += write_variable_length(head + head_size,
+                                     SEISTAMP_SEI_USER_DATA_UNREGISTERED);
+
+  size_t offset = 0;
+  int zeros = 0;
+
+  out[offset++] = 0x00;
+  out[offset++] = 0x00;
+  out[offset++] = 0x00;
+  out[offset++] = 0x01;
+
+  for (size_t i = 0; i < head_size; i++)
+    put_escaped(out, &offset, &zeros, head[i]);
+
+  size_t remaining = payload_size;
+  while (remaining >= 0xFF) {
+    put_escaped(out, &offset, &zeros, 0xFF);
+    remaining -= 0xFF;
+  }
+  put_escaped(out, &offset, &zeros, (uint8_t)remaining);
+
+  for (size_t i = 0; i < payload_size; i++)
+    put_escaped(out, &offset, &zeros, payload[i]);
+
+  /* 0x80 > 0x03, 不需要转义 */
+  out[offset++] = 0x80;
+  return offset;
+}
+
+uint8_t *seistamp_build_sei_nal(int64_t pts,
+                                const seistamp_ntp_time_t *ntp_time,
+                                seistamp_codec_t codec, size_t *size_out) {
+  if (!ntp_time || !size_out)
+    return NULL;
+
+  seistamp_nal_type_t nal_type = codec == SEISTAMP_CODEC_H265
+                                     ? SEISTAMP_NAL_H265_PREFIX_SEI
+                                     : SEISTAMP_NAL_H264_SEI;
+  uint8_t payload[SEISTAMP_PAYLOAD_SIZE];
+  seistamp_write_payload(payload, pts, ntp_time);
+
+  size_t size = seistamp_sei_nal_max_size(sizeof(payload), nal_type);
+  uint8_t *nal = seistamp_malloc(size);
+  if (!nal) {
+    seistamp_log(SEISTAMP_LOG_ERROR,
+                 "[SEI Handler] Failed to allocate SEI NAL unit");
+    return NULL;
+  }
+
+  *size_out = seistamp_write_sei_nal(nal, size, payload, sizeof(payload),
+                                     nal_type);
+  return nal;
+}
+
+bool seistamp_parse_payload(const uint8_t *payload, size_t size,
+                            seistamp_stamp_t *stamp_out) {
+  if (!payload || !stamp_out || size < SEISTAMP_PAYLOAD_SIZE ||
+      memcmp(payload, SEISTAMP_UUID, 16) != 0)
+    return false;
+
+  stamp_out->pts = (int64_t)(((uint64_t)read_be32(payload + 16) << 32) |
+                             read_be32(payload + 20));
+  stamp_out->ntp_time.seconds = read_be32(payload + 24);
+  stamp_out->ntp_time.fraction = read_be32(payload + 28);
+  return true;
+}
+
+bool seistamp_find_payload(const uint8_t *data, size_t size,
+                           seistamp_stamp_t *stamp_out) {
+  if (!data || !stamp_out)
+    return false;
+
+  /* 先用memchr定位UUID首字节,再比较完整payload */
+  size_t offset = 0;
+  while (offset + SEISTAMP_PAYLOAD_SIZE <= size) {
+    const uint8_t *p =
+        memchr(data + offset, SEISTAMP_UUID[0],
+               size - offset - SEISTAMP_PAYLOAD_SIZE + 1);
+    if (!p)
+      return false;
+
+    offset = (size_t)(p - data);
+    if (seistamp_parse_payload(p, size - offset, stamp_out))
+      return true;
+    offset++;
+  }
+  return false;
+}
+
+/* 起始码后的NAL头: 返回NAL类型和头长度 */
+static inline uint8_t nal_unit_type(const uint8_t *nal, seistamp_codec_t codec,
+                                    size_t *header_size) {
+  if (codec == SEISTAMP_CODEC_H265) {
+    *header_size = 2;
+    return (nal[0] >> 1) & 0x3F;
+  }
+  *header_size = 1;
+  return nal[0] & 0x1F;
+}
+
+static inline bool is_sei_nal(uint8_t type, seistamp_codec_t codec) {
+  if (codec == SEISTAMP_CODEC_H265)
+    return type == SEISTAMP_NAL_H265_PREFIX_SEI ||
+           type == SEISTAMP_NAL_H265_SUFFIX_SEI;
+  return type == SEISTAMP_NAL_H264_SEI;
+}
+
+/* VCL NAL: H.264 类型1-5, H.265 类型0-31 */
+static inline bool is_vcl_nal(uint8_t type, seistamp_codec_t codec) {
+  if (codec == SEISTAMP_CODEC_H265)
+    return type < 32;
+  return type >= 1 && type <= 5;
+}
+
+bool seistamp_extract_sei_payload(const uint8_t *nal_data, size_t nal_size,
+                                  const uint8_t **payload_out,
+                                  size_t *payload_size) {
+  if (!nal_data || !payload_out || !payload_size || nal_size < 5) {
+    return false;
+  }
+
+  size_t offset = 0;
+
+  /* 跳过起始码 */
+  if (nal_data[0] == 0x00 && nal_data[1] == 0x00) {
+    if (nal_data[2] == 0x00 && nal_data[3] == 0x01) {
+      offset = 4;
+    } else if (nal_data[2] == 0x01) {
+      offset = 3;
+    }
+  }
+
+  if (offset == 0) {
+    return false;
+  }
+
+  /* 检查NAL类型: 先按H.264,再按H.265 */
+  size_t header_size;
+  uint8_t type =
+      nal_unit_type(nal_data + offset, SEISTAMP_CODEC_H264, &header_size);
+  if (type != SEISTAMP_NAL_H264_SEI) {
+    type = nal_unit_type(nal_data + offset, SEISTAMP_CODEC_H265, &header_size);
+    if (!is_sei_nal(type, SEISTAMP_CODEC_H265)) {
+      return false;
+    }
+  }
+  offset += header_size;
+  if (offset >= nal_size) {
+    return false;
+  }
+
+  size_t sei_type, sei_size, read;
+  read = read_variable_length(nal_data + offset, nal_size - offset, &sei_type);
+  if (!read)
+    return false;
+  offset += read;
+
+  read = read_variable_length(nal_data + offset, nal_size - offset, &sei_size);
+  if (!read || offset + read + sei_size > nal_size)
+    return false;
+  offset += read;
+
+  *payload_out = nal_data + offset;
+  *payload_size = sei_size;
+  return true;
+}
+
+/*
+ * 查找下一个起始码(00 00 01)
+ * 返回起始码之后第一个字节的偏移,没有时返回size
+ */
+static size_t next_start_code(const uint8_t *data, size_t size, size_t from) {
+  while (from + 3 <= size) {
+    /* 先找0x01,再回头确认前两个字节为0 */
+    const uint8_t *p = memchr(data + from + 2, 0x01, size - from - 2);
+    if (!p)
+      return size;
+
+    size_t pos = (size_t)(p - data);
+    if (data[pos - 1] == 0x00 && data[pos - 2] == 0x00)
+      return pos + 1;
+    from = pos - 1;
+  }
+  return size;
+}
+
+/* 去除防竞争字节: 00 00 03 -> 00 00 */
+static size_t unescape_rbsp(const uint8_t *src, size_t size, uint8_t *dst) {
+  size_t out = 0;
+  int zeros = 0;
+
+  for (size_t i = 0; i < size; i++) {
+    if (zeros >= 2 && src[i] == 0x03) {
+      zeros = 0;
+      continue;
+    }
+    dst[out++] = src[i];
+    zeros = src[i] == 0x00 ? zeros + 1 : 0;
+  }
+  return out;
+}
+
+/* 逐条检查SEI消息 (rbsp已去除NAL头和防竞争字节) */
+static bool scan_sei_messages(const uint8_t *rbsp, size_t size,
+                              seistamp_stamp_t *stamp_out) {
+  size_t offset = 0;
+
+  /* 剩余仅为rbsp_trailing_bits时结束 */
+  while (offset + 2 <= size) {
+    size_t type, payload_size, read;
+
+    read = read_variable_length(rbsp + offset, size - offset, &type);
+    if (!read)
+      return false;
+    offset += read;
+
+    read = read_variable_length(rbsp + offset, size - offset, &payload_size);
+    if (!read || offset + read + payload_size > size)
+      return false;
+    offset += read;
+
+    if (type == SEISTAMP_SEI_USER_DATA_UNREGISTERED &&
+        seistamp_parse_payload(rbsp + offset, payload_size, stamp_out))
+      return true;
+
+    offset += payload_size;
+  }
+  return false;
+}
+
+static bool scan_sei_nal(const uint8_t *nal, size_t size,
+                         seistamp_stamp_t *stamp_out) {
+  uint8_t stack_buffer[SCAN_STACK_BUFFER];
+  uint8_t *rbsp = stack_buffer;
+
+  if (size > sizeof(stack_buffer)) {
+    rbsp = seistamp_malloc(size);
+    if (!rbsp)
+      return false;
+  }
+
+  size_t rbsp_size = unescape_rbsp(nal, size, rbsp);
+  bool found = scan_sei_messages(rbsp, rbsp_size, stamp_out);
+
+  if (rbsp != stack_buffer)
+    seistamp_free(rbsp);
+  return found;
+}
+
+bool seistamp_scan_access_unit(const uint8_t *data, size_t size,
+                               seistamp_codec_t codec,
+                               seistamp_stamp_t *stamp_out) {
+  if (!data || !stamp_out)
+    return false;
+
+  size_t start = next_start_code(data, size, 0);
+
+  while (start < size) {
+    size_t header_size;
+    uint8_t type = nal_unit_type(data + start, codec, &header_size);
+
+    /* 时间戳SEI写在图像数据之前; 遇到VCL NAL即停止,避免扫描整个slice */
+    if (is_vcl_nal(type, codec))
+      return false;
+
+    size_t next = next_start_code(data, size, start);
+
+    /* NAL结束位置: 下一个起始码之前,去掉4字节起始码的前导0 */
+    size_t end = next < size ? next - 3 : size;
+    while (end > start && data[end - 1] == 0x00)
+      end--;
+
+    if (is_sei_nal(type, codec) && end > start + header_size &&
+        scan_sei_nal(data + start + header_size, end - start - header_size,
+                     stamp_out))
+      return true;
+
+    start = next;
+  }
+  return false;
+}
+
+bool seistamp_scan_nal(const uint8_t *nal, size_t size, seistamp_codec_t codec,
+                       seistamp_stamp_t *stamp_out) {
+  if (!nal || !stamp_out || size < 2)
+    return false;
+
+  size_t header_size;
+  uint8_t type = nal_unit_type(nal, codec, &header_size);
+  if (!is_sei_nal(type, codec) || size <= header_size)
+    return false;
+
+  return scan_sei_nal(nal + header_size, size - header_size, stamp_out);
+}
@@ -0,0 +1,211 @@
+/******************************************************************************
+    Audio Resampler - Implementation
+    Copyright (C) 2026
+******************************************************************************/
+
+#include "audio-resampler.h"
+#include "live-stats.h"
+#include <libavutil/channel_layout.h>
+#include <libavutil/mathematics.h>
+#include <libavutil/mem.h>
+#include <libavutil/opt.h>
+#include <libavutil/samplefmt.h>
+#include <libswresample/swresample.h>
+#include <string.h>
+#include <util/platform.h>
+
+/* 误差的平滑系数(每个音频帧): 滤掉视频SEI带来的目标抖动 */
+#define ERROR_SMOOTHING 0.015625
+
+/* 补偿距离(秒): 只决定调整的精度, 每帧都会重新设置 */
+#define COMPENSATION_SECONDS 10
+
+/* 调整速率时输出可能比按输入估计的多几个样本 */
+#define OUTPUT_SLACK_SAMPLES 32
+
+/* 按声道数选择OBS的布局, OBS不支持的声道数下混为立体声 */
+typedef struct output_layout {
+  int channels;
+  enum speaker_layout speakers;
+  AVChannelLayout layout;
+} output_layout_t;
+
+static const output_layout_t output_layouts[] = {
+    {1, SPEAKERS_MONO, AV_CHANNEL_LAYOUT_MONO},
+    {2, SPEAKERS_STEREO, AV_CHANNEL_LAYOUT_STEREO},
+    {3, SPEAKERS_2POINT1, AV_CHANNEL_LAYOUT_2POINT1},
+    {4, SPEAKERS_4POINT0, AV_CHANNEL_LAYOUT_4POINT0},
+    {5, SPEAKERS_4POINT1, AV_CHANNEL_LAYOUT_4POINT1},
+    {6, SPEAKERS_5POINT1, AV_CHANNEL_LAYOUT_5POINT1_BACK},
+    {8, SPEAKERS_7POINT1, AV_CHANNEL_LAYOUT_7POINT1},
+};
+
+static const output_layout_t *find_output_layout(int channels) {
+  for (size_t i = 0; i < sizeof(output_layouts) / sizeof(output_layouts[0]);
+       i++) {
+    if (output_layouts[i].channels == channels)
+      return &output_layouts[i];
+  }
+  return &output_layouts[1];
+}
+
+static int64_t samples_to_ns(int64_t samples, int rate) {
+  return av_rescale(samples, 1000000000, rate);
+}
+
+static void free_buffers(audio_resampler_t *resampler) {
+  av_freep(&resampler->out_data[0]);
+  memset(resampler->out_data, 0, sizeof(resampler->out_data));
+  resampler->out_capacity = 0;
+}
+
+void audio_resampler_free(audio_resampler_t *resampler) {
+  swr_free(&resampler->swr);
+  av_channel_layout_uninit(&resampler->in_layout);
+  free_buffers(resampler);
+  resampler->has_timeline = false;
+  resampler->error_ns = 0.0;
+}
+
+/* 首帧或输入格式变化时(重新)创建转换器, 时间线随之重置 */
+static bool ensure_context(audio_resampler_t *resampler, const AVFrame *frame) {
+  if (frame->sample_rate <= 0 || frame->ch_layout.nb_channels <= 0)
+    return false;
+
+  AVChannelLayout in_layout = {0};
+  if (frame->ch_layout.order == AV_CHANNEL_ORDER_UNSPEC)
+    av_channel_layout_default(&in_layout, frame->ch_layout.nb_channels);
+  else if (av_channel_layout_copy(&in_layout, &frame->ch_layout) < 0)
+    return false;
+
+  if (resampler->swr && frame->format == resampler->in_format &&
+      frame->sample_rate == resampler->in_rate &&
+      av_channel_layout_compare(&in_layout, &resampler->in_layout) == 0) {
+    av_channel_layout_uninit(&in_layout);
+    return true;
+  }
+
+  audio_resampler_free(resampler);
+  const output_layout_t *out = find_output_layout(in_layout.nb_channels);
+  int ret = swr_alloc_set_opts2(&resampler->swr, &out->layout,
+                                AV_SAMPLE_FMT_FLTP, frame->sample_rate,
+                                &in_layout, frame->format, frame->sample_rate,
+                                0, NULL);
+  /* 采样率相同时也启用重采样, 否则第一次调整速率会重新初始化并丢掉缓冲的样本 */
+  if (ret >= 0)
+    ret = av_opt_set_int(resampler->swr, "flags", SWR_FLAG_RESAMPLE, 0);
+  if (ret >= 0)
+    ret = swr_init(resampler->swr);
+  if (ret < 0) {
+    blog(LOG_WARNING,
+         "[Audio Resampler] Failed to create converter (%d ch, %d Hz): %d",
+         in_layout.nb_channels, frame->sample_rate, ret);
+    swr_free(&resampler->swr);
+    av_channel_layout_uninit(&in_layout);
+    return false;
+  }
+
+  resampler->in_format = frame->format;
+  resampler->in_rate = frame->sample_rate;
+  resampler->in_layout = in_layout;
+  resampler->speakers = out->speakers;
+  resampler->out_channels = out->channels;
+  return true;
+}
+
+static bool ensure_capacity(audio_resampler_t *resampler, int samples) {
+  if (samples <= resampler->out_capacity)
+    return true;
+  free_buffers(resampler);
+  if (av_samples_alloc(resampler->out_data, NULL, resampler->out_channels,
+                       samples, AV_SAMPLE_FMT_FLTP, 0) < 0)
+    return false;
+  resampler->out_capacity = samples;
+  return true;
+}
+
+/*
+ * 对照目标时间线调整速率 (每帧送入样本之前)
+ * 输出时间戳 = 时间线起点 + 已输出样本数, 因此只能通过多输出或少输出样本
+ * 把本帧的首样本推到目标时间上
+ */
+static void track_timeline(audio_resampler_t *resampler, bool has_target,
+                           int64_t target_ns) {
+  /* 已送入但尚未输出的样本排在本帧之前 */
+  int64_t delay_ns = swr_get_delay(resampler->swr, 1000000000);
+
+  if (!resampler->has_timeline) {
+    int64_t start = has_target ? target_ns : (int64_t)os_gettime_ns();
+    resampler->timeline_start_ns = start - delay_ns;
+    resampler->samples_out = 0;
+    resampler->has_timeline = true;
+    resampler->error_ns = 0.0;
+    return;
+  }
+  if (!has_target)
+    return;
+
+  int64_t predicted_ns =
+      resampler->timeline_start_ns +
+      samples_to_ns(resampler->samples_out, resampler->in_rate) + delay_ns;
+  int64_t error_ns = target_ns - predicted_ns;
+  if (error_ns > AUDIO_RESAMPLER_RESYNC_NS ||
+      error_ns < -AUDIO_RESAMPLER_RESYNC_NS) {
+    /* 追赶需要太久(重连/发送端重启): 唯一会让时间戳跳变的情况 */
+    resampler->timeline_start_ns = target_ns - delay_ns;
+    resampler->samples_out = 0;
+    resampler->error_ns = 0.0;
+    live_stat_inc(&resampler->resyncs);
+  } else {
+    resampler->error_ns += (error_ns - resampler->error_ns) * ERROR_SMOOTHING;
+  }
+
+  /* 每COMPENSATION_SECONDS多(少)输出delta个样本 */
+  int64_t distance = (int64_t)resampler->in_rate * COMPENSATION_SECONDS;
+  int64_t limit = distance * AUDIO_RESAMPLER_MAX_PPM / 1000000;
+  int64_t delta =
+      (int64_t)(resampler->error_ns * resampler->in_rate / 1e9 *
+                COMPENSATION_SECONDS / AUDIO_RESAMPLER_CORRECTION_SECONDS);
+  if (delta > limit)
+    delta = limit;
+  else if (delta < -limit)
+    delta = -limit;
+  swr_set_compensation(resampler->swr, (int)delta, (int)distance);
+
+  live_stat_set(&resampler->correction_ppm, (long)(delta * 1000000 / distance));
+  live_stat_set(&resampler->error_us, (long)(resampler->error_ns / 1000.0));
+}
+
+bool audio_resampler_process(audio_resampler_t *resampler,
+                             const AVFrame *frame, bool has_target,
+                             int64_t target_ns,
+                             struct obs_source_audio *audio) {
+  if (!ensure_context(resampler, frame))
+    return false;
+
+  track_timeline(resampler, has_target, target_ns);
+
+  int capacity = swr_get_out_samples(resampler->swr, frame->nb_samples) +
+                 OUTPUT_SLACK_SAMPLES;
+  if (!ensure_capacity(resampler, capacity))
+    return false;
+
+  int samples = swr_convert(resampler->swr, resampler->out_data,
+                            resampler->out_capacity,
+                            (const uint8_t **)frame->extended_data,
+                            frame->nb_samples);
+  if (samples <= 0)
+    return false;
+
+  for (int i = 0; i < resampler->out_channels; i++)
+    audio->data[i] = resampler->out_data[i];
+  audio->frames = (uint32_t)samples;
+  audio->speakers = resampler->speakers;
+  audio->format = AUDIO_FORMAT_FLOAT_PLANAR;
+  audio->samples_per_sec = (uint32_t)resampler->in_rate;
+  audio->timestamp = (uint64_t)(resampler->timeline_start_ns +
+                                samples_to_ns(resampler->samples_out,
+                                              resampler->in_rate));
+  resampler->samples_out += samples;
+  return true;
+}
@@ -0,0 +1,72 @@
+/******************************************************************************
+    Audio Resampler - Header File
+    Copyright (C) 2026
+
+    Receiver audio stage: converts decoded audio to OBS's native planar
+    float with libswresample and keeps the output timestamps continuous.
+    Instead of stepping the timestamp whenever the target timeline moves,
+    it nudges the resampling ratio (at most AUDIO_RESAMPLER_MAX_PPM) until
+    the output drifts back onto it. Only a large error (reconnect, sender
+    restart) resets the timeline
+******************************************************************************/
+
+#pragma once
+
+#include <libavutil/frame.h>
+#include <obs-module.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 最大速率调整(百万分比): 0.1%, 音高变化约1.7音分, 听不出来 */
+#define AUDIO_RESAMPLER_MAX_PPM 1000
+/* 每秒修正平滑误差的 1/AUDIO_RESAMPLER_CORRECTION_SECONDS */
+#define AUDIO_RESAMPLER_CORRECTION_SECONDS 2
+/* 误差超过此值时不再追赶, 直接跳到目标时间线 */
+#define AUDIO_RESAMPLER_RESYNC_NS 200000000LL
+
+struct SwrContext;
+
+typedef struct audio_resampler {
+  /* 发布值 (os_atomic读写, 任意线程可读) */
+  volatile long correction_ppm; /* 当前速率调整, 正值为拉长(输出更多样本) */
+  volatile long error_us;       /* 平滑后的时间线误差, 正值为输出偏早 */
+  volatile long resyncs;        /* 时间线重置次数 */
+
+  /* 以下仅由接收线程访问 */
+  struct SwrContext *swr;
+  int in_format;                         /* AVSampleFormat */
+  int in_rate;                           /* 采样率(输出相同) */
+  AVChannelLayout in_layout;             /* 输入声道布局 */
+  enum speaker_layout speakers;          /* 输出声道布局 */
+  int out_channels;                      /* 输出声道数 */
+  uint8_t *out_data[MAX_AUDIO_CHANNELS]; /* 平面float输出缓冲区 */
+  int out_capacity;                      /* 每声道可容纳的样本数 */
+  bool has_timeline;                     /* 已确定输出时间线 */
+  int64_t timeline_start_ns;             /* 时间线起点 */
+  int64_t samples_out;                   /* 起点之后输出的样本数 */
+  double error_ns;                       /* 平滑后的误差 */
+} audio_resampler_t;
+
+/* 释放转换器及缓冲区 (连接关闭/销毁源时), 下一帧重新建立时间线 */
+void audio_resampler_free(audio_resampler_t *resampler);
+
+/*
+ * 转换一个解码后的音频帧 (接收线程)
+ * 参数:
+ *   has_target - target_ns有效
+ *   target_ns - 帧首样本在目标时间线上的本地时间
+ *   audio - 输出(数据指向内部缓冲区, 下次调用前有效)
+ * 返回:
+ *   true - audio中有样本可以输出
+ */
+bool audio_resampler_process(audio_resampler_t *resampler,
+                             const AVFrame *frame, bool has_target,
+                             int64_t target_ns, struct obs_source_audio *audio);
+
+#ifdef __cplusplus
+}
+#endif
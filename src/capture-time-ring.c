@@ -0,0 +1,50 @@
+/******************************************************************************
+    Capture Time Ring - Implementation
+    Copyright (C) 2026
+
+    Remembers the NTP time at which each frame entered the encoder, keyed by
+    PTS, so a stamp describes the frame it rides on even after reordering
+******************************************************************************/
+
+#include "capture-time-ring.h"
+#include <string.h>
+
+/*
+ * OBS的帧PTS每帧递增fps_den(时间基为{fps_den, fps_num}),不是1.
+ * 先除以步长换算成帧序号再取低位,否则fps_den=1000时只有1/8的槽位可用
+ */
+static inline size_t slot_of(const capture_time_ring_t *ring, int64_t pts) {
+  uint64_t frame_index = (uint64_t)(pts / ring->pts_step);
+  return (size_t)(frame_index & (CAPTURE_TIME_RING_SIZE - 1));
+}
+
+void capture_time_ring_init(capture_time_ring_t *ring, int64_t pts_step) {
+  if (!ring) {
+    return;
+  }
+
+  memset(ring, 0, sizeof(capture_time_ring_t));
+  ring->pts_step = pts_step > 0 ? pts_step : 1;
+}
+
+void capture_time_ring_put(capture_time_ring_t *ring, int64_t pts,
+                           const ntp_timestamp_t *ntp_time) {
+  capture_time_entry_t *entry = &ring->entries[slot_of(ring, pts)];
+  entry->pts = pts;
+  entry->ntp_time = *ntp_time;
+  entry->valid = true;
+}
+
+bool capture_time_ring_get(capture_time_ring_t *ring, int64_t pts,
+                           ntp_timestamp_t *ntp_time_out) {
+  const capture_time_entry_t *entry = &ring->entries[slot_of(ring, pts)];
+
+  if (!entry->valid || entry->pts != pts) {
+    ring->misses++;
+    return false;
+  }
+
+  *ntp_time_out = entry->ntp_time;
+  ring->hits++;
+  return true;
+}
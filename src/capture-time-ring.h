@@ -0,0 +1,71 @@
+/******************************************************************************
+    Capture Time Ring - Header File
+    Copyright (C) 2026
+
+    Remembers the NTP time at which each frame entered the encoder, keyed by
+    PTS, so a stamp describes the frame it rides on even after reordering
+******************************************************************************/
+
+#pragma once
+
+#include "ntp-client.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 环大小(2的幂): 必须大于编码器内同时在途的帧数(lookahead + B帧 + 异步深度) */
+#define CAPTURE_TIME_RING_SIZE 256
+
+/* 一帧的送入时间 */
+typedef struct capture_time_entry {
+  int64_t pts;
+  ntp_timestamp_t ntp_time;
+  bool valid;
+} capture_time_entry_t;
+
+/* 以帧序号(PTS / pts_step)为索引的环 */
+typedef struct capture_time_ring {
+  capture_time_entry_t entries[CAPTURE_TIME_RING_SIZE];
+  int64_t pts_step; /* 相邻帧的PTS差(时间基分子,即fps_den) */
+  uint64_t hits;    /* 查找成功次数 */
+  uint64_t misses;  /* 查找失败次数(已被覆盖或从未记录) */
+} capture_time_ring_t;
+
+/*
+ * 初始化环
+ * 参数:
+ *   ring - 环
+ *   pts_step - 相邻帧的PTS差; OBS以{fps_den, fps_num}为时间基,
+ *              故传入fps_den. <= 0 视为1
+ */
+void capture_time_ring_init(capture_time_ring_t *ring, int64_t pts_step);
+
+/*
+ * 记录一帧送入编码器时的NTP时间
+ * 参数:
+ *   ring - 环
+ *   pts - 送入编码器的帧PTS
+ *   ntp_time - 该帧的NTP时间
+ */
+void capture_time_ring_put(capture_time_ring_t *ring, int64_t pts,
+                           const ntp_timestamp_t *ntp_time);
+
+/*
+ * 按输出Packet的PTS查找送入时的NTP时间
+ * 参数:
+ *   ring - 环
+ *   pts - 输出Packet的PTS
+ *   ntp_time_out - 输出的NTP时间
+ * 返回:
+ *   true - 找到
+ *   false - 未找到(调用者应回退到当前时间)
+ */
+bool capture_time_ring_get(capture_time_ring_t *ring, int64_t pts,
+                           ntp_timestamp_t *ntp_time_out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,189 @@
+/******************************************************************************
+    End-to-End Latency - Implementation
+    Copyright (C) 2026
+******************************************************************************/
+
+#include "e2e-latency.h"
+#include "live-stats.h"
+#include <string.h>
+#include <util/bmem.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#define SUB_BUCKET_COUNT (1 << E2E_SUB_BUCKET_BITS)
+#define SUB_BUCKET_HALF (1 << (E2E_SUB_BUCKET_BITS - 1))
+#define MAX_VALUE_US ((1U << E2E_MAX_BITS) - 1)
+#define SLOTS_PER_STAGE (E2E_SHORT_SLOTS + E2E_LONG_SLOTS)
+
+struct e2e_histogram {
+  uint32_t counts[E2E_BUCKETS];
+  uint32_t total;
+  uint32_t max_us;
+};
+
+static int highest_bit(uint32_t value) {
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanReverse(&index, value);
+  return (int)index;
+#else
+  return 31 - __builtin_clz(value);
+#endif
+}
+
+/* 小于SUB_BUCKET_COUNT的值每档1微秒; 之后每个2倍区间分为SUB_BUCKET_HALF档 */
+static int bucket_index(uint32_t us) {
+  if (us < SUB_BUCKET_COUNT)
+    return (int)us;
+  int shift = highest_bit(us) - (E2E_SUB_BUCKET_BITS - 1);
+  return shift * SUB_BUCKET_HALF + (int)(us >> shift);
+}
+
+/* 档内的最大值 (百分位取档内最大值, 不会低估) */
+static uint32_t bucket_highest_us(int index) {
+  if (index < SUB_BUCKET_COUNT)
+    return (uint32_t)index;
+  int shift = index / SUB_BUCKET_HALF - 1;
+  uint32_t sub = (uint32_t)(index - shift * SUB_BUCKET_HALF);
+  return ((sub + 1) << shift) - 1;
+}
+
+static void histogram_record(e2e_histogram_t *histogram, uint32_t us) {
+  histogram->counts[bucket_index(us)]++;
+  histogram->total++;
+  if (us > histogram->max_us)
+    histogram->max_us = us;
+}
+
+static void histogram_merge(e2e_histogram_t *dst, const e2e_histogram_t *src) {
+  if (!src->total)
+    return;
+  for (int i = 0; i < E2E_BUCKETS; i++)
+    dst->counts[i] += src->counts[i];
+  dst->total += src->total;
+  if (src->max_us > dst->max_us)
+    dst->max_us = src->max_us;
+}
+
+/* quantile以万分之一为单位 (9990 = p99.9) */
+static uint32_t histogram_percentile(const e2e_histogram_t *histogram,
+                                     uint32_t quantile) {
+  if (!histogram->total)
+    return 0;
+  uint64_t rank = ((uint64_t)histogram->total * quantile + 9999) / 10000;
+  if (rank == 0)
+    rank = 1;
+
+  uint64_t seen = 0;
+  for (int i = 0; i < E2E_BUCKETS; i++) {
+    seen += histogram->counts[i];
+    if (seen >= rank) {
+      uint32_t value = bucket_highest_us(i);
+      return value < histogram->max_us ? value : histogram->max_us;
+    }
+  }
+  return histogram->max_us;
+}
+
+static e2e_histogram_t *stage_slots(e2e_latency_t *latency, int stage) {
+  return latency->slots + stage * SLOTS_PER_STAGE;
+}
+
+void e2e_latency_free(e2e_latency_t *latency) {
+  bfree(latency->slots);
+  latency->slots = NULL;
+}
+
+void e2e_latency_add(e2e_latency_t *latency, e2e_stage_t stage,
+                     int64_t latency_ns) {
+  if (!latency->slots) {
+    latency->slots = bzalloc(sizeof(e2e_histogram_t) * E2E_STAGE_COUNT *
+                             SLOTS_PER_STAGE);
+  }
+
+  int64_t us = latency_ns > 0 ? latency_ns / 1000 : 0;
+  if (us > MAX_VALUE_US)
+    us = MAX_VALUE_US;
+
+  e2e_histogram_t *slots = stage_slots(latency, stage);
+  uint32_t ticks = latency->ticks;
+  histogram_record(&slots[ticks % E2E_SHORT_SLOTS], (uint32_t)us);
+  histogram_record(&slots[E2E_SHORT_SLOTS +
+                          (ticks / E2E_LONG_SLOT_TICKS) % E2E_LONG_SLOTS],
+                   (uint32_t)us);
+}
+
+static void publish_window(e2e_published_t *out, const e2e_histogram_t *slots,
+                           int count) {
+  e2e_histogram_t merged;
+  memset(&merged, 0, sizeof(merged));
+  for (int i = 0; i < count; i++)
+    histogram_merge(&merged, &slots[i]);
+
+  live_stat_set(&out->count, (long)merged.total);
+  live_stat_set(&out->p50_us, (long)histogram_percentile(&merged, 5000));
+  live_stat_set(&out->p99_us, (long)histogram_percentile(&merged, 9900));
+  live_stat_set(&out->p999_us, (long)histogram_percentile(&merged, 9990));
+  live_stat_set(&out->max_us, (long)merged.max_us);
+}
+
+/* 结束一个短格: 清空下一个短格, 每E2E_LONG_SLOT_TICKS个短格换一个长格 */
+static void advance_slot(e2e_latency_t *latency) {
+  latency->ticks++;
+  if (!latency->slots)
+    return;
+
+  uint32_t ticks = latency->ticks;
+  for (int stage = 0; stage < E2E_STAGE_COUNT; stage++) {
+    e2e_histogram_t *slots = stage_slots(latency, stage);
+    memset(&slots[ticks % E2E_SHORT_SLOTS], 0, sizeof(e2e_histogram_t));
+    if (ticks % E2E_LONG_SLOT_TICKS == 0)
+      memset(&slots[E2E_SHORT_SLOTS +
+                    (ticks / E2E_LONG_SLOT_TICKS) % E2E_LONG_SLOTS],
+             0, sizeof(e2e_histogram_t));
+  }
+}
+
+void e2e_latency_update(e2e_latency_t *latency, uint64_t now_ns) {
+  if (latency->slot_start == 0) {
+    latency->slot_start = now_ns;
+    return;
+  }
+  if (now_ns - latency->slot_start < E2E_SLOT_NS)
+    return;
+
+  if (latency->slots) {
+    for (int stage = 0; stage < E2E_STAGE_COUNT; stage++) {
+      e2e_histogram_t *slots = stage_slots(latency, stage);
+      publish_window(&latency->published[stage][E2E_WINDOW_10S], slots,
+                     E2E_SHORT_SLOTS);
+      publish_window(&latency->published[stage][E2E_WINDOW_60S],
+                     slots + E2E_SHORT_SLOTS, E2E_LONG_SLOTS);
+    }
+  }
+
+  /* 长时间没有帧时跳过的格子同样清空 (最多清空整个60秒窗口) */
+  uint64_t elapsed = (now_ns - latency->slot_start) / E2E_SLOT_NS;
+  latency->slot_start += elapsed * E2E_SLOT_NS;
+  if (elapsed > E2E_LONG_SLOTS * E2E_LONG_SLOT_TICKS)
+    elapsed = E2E_LONG_SLOTS * E2E_LONG_SLOT_TICKS;
+  for (uint64_t i = 0; i < elapsed; i++)
+    advance_slot(latency);
+}
+
+void e2e_latency_snapshot(const e2e_latency_t *latency,
+                          e2e_latency_snapshot_t *snapshot) {
+  for (int stage = 0; stage < E2E_STAGE_COUNT; stage++) {
+    for (int window = 0; window < E2E_WINDOW_COUNT; window++) {
+      const e2e_published_t *in = &latency->published[stage][window];
+      e2e_window_snapshot_t *out = &snapshot->windows[stage][window];
+      out->count = live_stat_get(&in->count);
+      out->p50_ms = live_stat_get(&in->p50_us) / 1000.0;
+      out->p99_ms = live_stat_get(&in->p99_us) / 1000.0;
+      out->p999_ms = live_stat_get(&in->p999_us) / 1000.0;
+      out->max_ms = live_stat_get(&in->max_us) / 1000.0;
+    }
+  }
+}
@@ -0,0 +1,103 @@
+/******************************************************************************
+    End-to-End Latency - Header File
+    Copyright (C) 2026
+
+    Glass-to-glass latency per receiver: sender capture stamp to network
+    arrival, to decode done and to hand-off to OBS. Samples go into
+    HDR-style log-linear histograms owned by the receive thread. Once a
+    second the thread merges its slot rings into sliding windows and
+    publishes the percentiles with atomics, so readers never touch the
+    histograms
+******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 每个2倍区间的精度: 2^(6-1) = 32档, 相对误差约1.6% */
+#define E2E_SUB_BUCKET_BITS 6
+/* 可记录的最大延迟 2^27微秒 (约134秒), 更大的值记为最大值 */
+#define E2E_MAX_BITS 27
+#define E2E_BUCKETS                                                            \
+  ((E2E_MAX_BITS - E2E_SUB_BUCKET_BITS + 2) << (E2E_SUB_BUCKET_BITS - 1))
+
+/* 滑动窗口由格子组成: 10秒窗口 = 10个1秒格, 60秒窗口 = 6个10秒格 */
+#define E2E_SLOT_NS 1000000000ULL
+#define E2E_SHORT_SLOTS 10
+#define E2E_LONG_SLOTS 6
+#define E2E_LONG_SLOT_TICKS 10
+
+/* 延迟的终点 (起点都是发送端的采集时间) */
+typedef enum e2e_stage {
+  E2E_STAGE_ARRIVAL, /* 数据包到达 */
+  E2E_STAGE_DECODED, /* 解码完成 */
+  E2E_STAGE_OUTPUT,  /* 交给OBS (obs_source_output_video返回) */
+  E2E_STAGE_COUNT
+} e2e_stage_t;
+
+typedef enum e2e_window {
+  E2E_WINDOW_10S,
+  E2E_WINDOW_60S,
+  E2E_WINDOW_COUNT
+} e2e_window_t;
+
+/* 一个窗口的发布值 */
+typedef struct e2e_published {
+  volatile long count;
+  volatile long p50_us;
+  volatile long p99_us;
+  volatile long p999_us;
+  volatile long max_us;
+} e2e_published_t;
+
+typedef struct e2e_histogram e2e_histogram_t;
+
+typedef struct e2e_latency {
+  e2e_published_t published[E2E_STAGE_COUNT][E2E_WINDOW_COUNT];
+
+  /* 以下仅由接收线程访问 */
+  e2e_histogram_t *slots; /* 每个阶段的短格+长格, 第一个样本时分配 */
+  uint64_t slot_start;    /* 当前短格的开始时间 */
+  uint32_t ticks;         /* 已经结束的短格数 */
+} e2e_latency_t;
+
+/* 一个窗口的快照 (毫秒) */
+typedef struct e2e_window_snapshot {
+  long count;
+  double p50_ms;
+  double p99_ms;
+  double p999_ms;
+  double max_ms;
+} e2e_window_snapshot_t;
+
+typedef struct e2e_latency_snapshot {
+  e2e_window_snapshot_t windows[E2E_STAGE_COUNT][E2E_WINDOW_COUNT];
+} e2e_latency_snapshot_t;
+
+/* 释放直方图(销毁接收源时) */
+void e2e_latency_free(e2e_latency_t *latency);
+
+/*
+ * 记录一个样本(接收线程)
+ * 参数:
+ *   latency_ns - 终点的本地时间 - 发送端采集时间(已换算到本地时钟),
+ *                负值(时钟误差)记为0
+ */
+void e2e_latency_add(e2e_latency_t *latency, e2e_stage_t stage,
+                     int64_t latency_ns);
+
+/* 每帧调用(接收线程): 每E2E_SLOT_NS发布一次窗口统计并滚动格子 */
+void e2e_latency_update(e2e_latency_t *latency, uint64_t now_ns);
+
+/* 读取发布值(任意线程) */
+void e2e_latency_snapshot(const e2e_latency_t *latency,
+                          e2e_latency_snapshot_t *snapshot);
+
+#ifdef __cplusplus
+}
+#endif
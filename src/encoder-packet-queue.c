@@ -0,0 +1,172 @@
+/******************************************************************************
+    Encoder Packet Queue - Implementation
+    Copyright (C) 2026
+
+    Small FIFO between libavcodec and OBS: every packet the encoder has ready
+    is drained on each encode call and handed to OBS one per call, in order
+******************************************************************************/
+
+#include "encoder-packet-queue.h"
+#include <obs-module.h>
+#include <string.h>
+#include <util/bmem.h>
+
+/* 为[from, to)中的槽位分配AVPacket */
+static bool alloc_packets(encoder_packet_queue_t *queue, size_t from,
+                          size_t to) {
+  for (size_t i = from; i < to; i++) {
+    queue->entries[i].packet = av_packet_alloc();
+    if (!queue->entries[i].packet) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool encoder_packet_queue_init(encoder_packet_queue_t *queue) {
+  if (!queue) {
+    return false;
+  }
+
+  memset(queue, 0, sizeof(encoder_packet_queue_t));
+
+  queue->entries =
+      bzalloc(sizeof(encoder_queued_packet_t) * ENCODER_PACKET_QUEUE_SIZE);
+  queue->capacity = ENCODER_PACKET_QUEUE_SIZE;
+  queue->current.packet = av_packet_alloc();
+  if (!alloc_packets(queue, 0, queue->capacity) || !queue->current.packet) {
+    encoder_packet_queue_free(queue);
+    return false;
+  }
+
+  return true;
+}
+
+void encoder_packet_queue_free(encoder_packet_queue_t *queue) {
+  if (!queue) {
+    return;
+  }
+
+  if (queue->count > 0) {
+    blog(LOG_INFO,
+         "[Encoder Packet Queue] Released %zu queued packet(s) on close",
+         queue->count);
+  }
+
+  for (size_t i = 0; i < queue->capacity; i++) {
+    if (queue->entries[i].packet) {
+      av_packet_free(&queue->entries[i].packet);
+    }
+  }
+  bfree(queue->entries);
+  queue->entries = NULL;
+  queue->capacity = 0;
+  if (queue->current.packet) {
+    av_packet_free(&queue->current.packet);
+  }
+
+  queue->head = 0;
+  queue->count = 0;
+}
+
+/* 容量加倍: 按顺序搬到新缓冲区的开头, 新槽位分配AVPacket */
+static bool grow(encoder_packet_queue_t *queue) {
+  size_t capacity = queue->capacity * 2;
+  if (capacity > ENCODER_PACKET_QUEUE_MAX_SIZE) {
+    return false;
+  }
+
+  encoder_queued_packet_t *entries =
+      bzalloc(sizeof(encoder_queued_packet_t) * capacity);
+  for (size_t i = 0; i < queue->capacity; i++) {
+    entries[i] = queue->entries[(queue->head + i) % queue->capacity];
+  }
+  bfree(queue->entries);
+
+  size_t old_capacity = queue->capacity;
+  queue->entries = entries;
+  queue->capacity = capacity;
+  queue->head = 0;
+  if (!alloc_packets(queue, old_capacity, capacity)) {
+    /* 内存不足: 保持原容量 (已分配的新槽位在free时释放) */
+    queue->capacity = old_capacity;
+    for (size_t i = old_capacity; i < capacity; i++) {
+      if (entries[i].packet) {
+        av_packet_free(&entries[i].packet);
+      }
+    }
+    return false;
+  }
+
+  blog(LOG_INFO, "[Encoder Packet Queue] Grew output queue to %zu packets",
+       capacity);
+  return true;
+}
+
+int encoder_packet_queue_drain(encoder_packet_queue_t *queue,
+                               AVCodecContext *codec_context,
+                               const ntp_timestamp_t *ntp_time) {
+  int drained = 0;
+
+  for (;;) {
+    if (queue->count == queue->capacity) {
+      queue->full_count++;
+      /* 达到上限: 编码器里可能还有包,留到下次调用 */
+      if (!grow(queue)) {
+        return drained;
+      }
+    }
+
+    size_t tail = (queue->head + queue->count) % queue->capacity;
+    encoder_queued_packet_t *entry = &queue->entries[tail];
+
+    int ret = avcodec_receive_packet(codec_context, entry->packet);
+    if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+      return drained;
+    } else if (ret < 0) {
+      return ret;
+    }
+
+    entry->ntp_time = *ntp_time;
+    queue->count++;
+    drained++;
+  }
+}
+
+int encoder_packet_queue_send_frame(encoder_packet_queue_t *queue,
+                                    AVCodecContext *codec_context,
+                                    const AVFrame *frame,
+                                    const ntp_timestamp_t *ntp_time) {
+  int ret = avcodec_send_frame(codec_context, frame);
+  if (ret != AVERROR(EAGAIN)) {
+    return ret;
+  }
+
+  /* 编码器的输出未取走: 全部取到队列里再送, 已编码的包从不丢弃 */
+  int drained = encoder_packet_queue_drain(queue, codec_context, ntp_time);
+  if (drained < 0) {
+    return drained;
+  }
+  return avcodec_send_frame(codec_context, frame);
+}
+
+const encoder_queued_packet_t *
+encoder_packet_queue_pop(encoder_packet_queue_t *queue) {
+  av_packet_unref(queue->current.packet);
+
+  if (queue->count == 0) {
+    return NULL;
+  }
+
+  if (queue->count > queue->peak) {
+    queue->peak = queue->count;
+  }
+
+  encoder_queued_packet_t *entry = &queue->entries[queue->head];
+  av_packet_move_ref(queue->current.packet, entry->packet);
+  queue->current.ntp_time = entry->ntp_time;
+
+  queue->head = (queue->head + 1) % queue->capacity;
+  queue->count--;
+  return &queue->current;
+}
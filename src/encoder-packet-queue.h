@@ -0,0 +1,98 @@
+/******************************************************************************
+    Encoder Packet Queue - Header File
+    Copyright (C) 2026
+
+    Small FIFO between libavcodec and OBS: every packet the encoder has ready
+    is drained on each encode call and handed to OBS one per call, in order
+******************************************************************************/
+
+#pragma once
+
+#include "ntp-client.h"
+#include <libavcodec/avcodec.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 初始容量(包数): 取包时队列已满则加倍, 编码器的输出从不丢弃 */
+#define ENCODER_PACKET_QUEUE_SIZE 8
+/* 容量上限: 达到后剩余的包留在编码器内部, 编码器因此拒收新帧时encode失败 */
+#define ENCODER_PACKET_QUEUE_MAX_SIZE 256
+
+/* 队列中的一个包 */
+typedef struct encoder_queued_packet {
+  AVPacket *packet;         /* 编码器输出(引用) */
+  ntp_timestamp_t ntp_time; /* 从编码器取出时的NTP时间 */
+} encoder_queued_packet_t;
+
+/* 输出队列 */
+typedef struct encoder_packet_queue {
+  encoder_queued_packet_t *entries; /* 环形缓冲区 */
+  size_t capacity;                  /* 当前容量 */
+  size_t head;                      /* 最早的包 */
+  size_t count;                     /* 队列中的包数 */
+
+  encoder_queued_packet_t current; /* 已交给OBS的包,下次出队前保持有效 */
+
+  size_t peak;         /* 队列深度峰值 */
+  uint64_t full_count; /* 取包时队列已满(扩容或达到上限)的次数 */
+} encoder_packet_queue_t;
+
+/*
+ * 初始化队列(预先分配初始容量的AVPacket)
+ * 返回:
+ *   true - 成功
+ *   false - 内存不足
+ */
+bool encoder_packet_queue_init(encoder_packet_queue_t *queue);
+
+/*
+ * 释放队列及其中所有包 (仍在队列中的包数记录到日志)
+ */
+void encoder_packet_queue_free(encoder_packet_queue_t *queue);
+
+/*
+ * 从编码器取出所有就绪的包(直到EAGAIN/EOF, 队列已满时扩容, 直到容量上限)
+ * 参数:
+ *   queue - 输出队列
+ *   codec_context - 编码器上下文
+ *   ntp_time - 记录到本次取出的每个包上的NTP时间
+ * 返回:
+ *   >= 0 - 本次取出的包数
+ *   < 0 - avcodec_receive_packet 的错误码
+ */
+int encoder_packet_queue_drain(encoder_packet_queue_t *queue,
+                               AVCodecContext *codec_context,
+                               const ntp_timestamp_t *ntp_time);
+
+/*
+ * 把帧送入编码器
+ * 编码器的输出未取走时 avcodec_send_frame 返回 EAGAIN: 先取出就绪的包
+ * (队列按需扩容)再重试; 队列已达上限仍无法送入时返回 EAGAIN
+ * 参数:
+ *   frame - 输入帧 (NULL为冲刷)
+ *   ntp_time - 记录到重试前取出的包上的NTP时间
+ * 返回:
+ *   avcodec_send_frame 或 avcodec_receive_packet 的返回值
+ */
+int encoder_packet_queue_send_frame(encoder_packet_queue_t *queue,
+                                    AVCodecContext *codec_context,
+                                    const AVFrame *frame,
+                                    const ntp_timestamp_t *ntp_time);
+
+/*
+ * 取出最早的包
+ * 返回的包在下一次调用本函数或 encoder_packet_queue_free 前保持有效
+ * 返回:
+ *   队列为空时返回NULL
+ */
+const encoder_queued_packet_t *
+encoder_packet_queue_pop(encoder_packet_queue_t *queue);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,44 @@
+/******************************************************************************
+    Encoder SEI Side Data - Implementation
+    Copyright (C) 2026
+
+    Lets libavcodec encoders write the timestamp SEI themselves from
+    AV_FRAME_DATA_SEI_UNREGISTERED, instead of splicing it into the output
+******************************************************************************/
+
+#include "encoder-sei.h"
+#include "sei-handler.h"
+#include <libavutil/frame.h>
+#include <libavutil/opt.h>
+
+bool encoder_sei_enable_side_data(AVCodecContext *codec_context) {
+  if (!codec_context || !codec_context->priv_data) {
+    return false;
+  }
+
+  /* 不认识该选项的编码器会返回 AVERROR_OPTION_NOT_FOUND */
+  return av_opt_set_int(codec_context->priv_data, "udu_sei", 1, 0) >= 0;
+}
+
+bool encoder_sei_attach(AVFrame *frame, const ntp_timestamp_t *ntp_time) {
+  AVFrameSideData *side_data = av_frame_new_side_data(
+      frame, AV_FRAME_DATA_SEI_UNREGISTERED, NTP_SEI_PAYLOAD_SIZE);
+  if (!side_data) {
+    return false;
+  }
+
+  /* 数据格式与SEI payload相同: UUID开头,编码器按 payload type 5 输出 */
+  write_ntp_sei_payload(side_data->data, frame->pts, ntp_time);
+  return true;
+}
+
+bool encoder_sei_packet_has_stamp(const AVPacket *packet, bool hevc) {
+  if (!packet || !packet->data || packet->size <= 0) {
+    return false;
+  }
+
+  seistamp_stamp_t stamp;
+  return seistamp_scan_access_unit(
+      packet->data, (size_t)packet->size,
+      hevc ? SEISTAMP_CODEC_H265 : SEISTAMP_CODEC_H264, &stamp);
+}
@@ -0,0 +1,48 @@
+/******************************************************************************
+    Encoder SEI Side Data - Header File
+    Copyright (C) 2026
+
+    Lets libavcodec encoders write the timestamp SEI themselves from
+    AV_FRAME_DATA_SEI_UNREGISTERED, instead of splicing it into the output
+******************************************************************************/
+
+#pragma once
+
+#include "ntp-client.h"
+#include <libavcodec/avcodec.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 请求编码器输出帧附加数据中的用户数据SEI(udu_sei选项)
+ * 必须在 avcodec_open2 之前调用
+ * 返回:
+ *   true - 编码器支持(libx264, libx265, h264/hevc_nvenc 等)
+ *   false - 不支持,需要在编码后拼接SEI
+ */
+bool encoder_sei_enable_side_data(AVCodecContext *codec_context);
+
+/*
+ * 将时间戳SEI payload作为 AV_FRAME_DATA_SEI_UNREGISTERED 挂到输入帧上
+ * (payload中的PTS取 frame->pts)
+ * 返回:
+ *   true - 成功
+ *   false - 内存不足
+ */
+bool encoder_sei_attach(AVFrame *frame, const ntp_timestamp_t *ntp_time);
+
+/*
+ * 编码器输出的Packet中是否已有时间戳SEI (只检查第一个slice之前的NAL)
+ * 附加数据挂在每一帧上, 正常情况下每个Packet都有; 没有的关键帧在编码后拼接
+ * 参数:
+ *   hevc - H.265码流, 否则为H.264
+ */
+bool encoder_sei_packet_has_stamp(const AVPacket *packet, bool hevc);
+
+#ifdef __cplusplus
+}
+#endif
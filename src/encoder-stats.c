@@ -0,0 +1,220 @@
+/******************************************************************************
+    Encoder Stats - Implementation
+    Copyright (C) 2026
+******************************************************************************/
+
+#include "encoder-stats.h"
+#include "fast-clock.h"
+#include "live-stats.h"
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <util/dstr.h>
+#include <util/threading.h>
+
+/* 正在运行的编码器 (只在创建/销毁/查询时加锁, 编码线程不访问) */
+static pthread_mutex_t registry_mutex = PTHREAD_MUTEX_INITIALIZER;
+static encoder_stats_t *registry_head;
+
+void encoder_stats_register(encoder_stats_t *stats, obs_encoder_t *encoder) {
+  stats->encoder = encoder;
+  pthread_mutex_lock(&registry_mutex);
+  stats->next = registry_head;
+  registry_head = stats;
+  pthread_mutex_unlock(&registry_mutex);
+}
+
+void encoder_stats_unregister(encoder_stats_t *stats) {
+  pthread_mutex_lock(&registry_mutex);
+  for (encoder_stats_t **link = &registry_head; *link;
+       link = &(*link)->next) {
+    if (*link == stats) {
+      *link = stats->next;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&registry_mutex);
+  stats->next = NULL;
+}
+
+/* 每个周期发布一次码率/帧率, 时钟和队列状态 */
+static void publish_period(encoder_stats_t *stats, uint64_t now,
+                           const encoder_backend_state_t *backend) {
+  double elapsed = (now - stats->period_start) / 1000000000.0;
+  live_stat_set(&stats->bitrate_kbps,
+                (long)(stats->period_bytes * 8 / 1000.0 / elapsed));
+  live_stat_set(&stats->fps_centi,
+                (long)(stats->period_packets * 100.0 / elapsed));
+
+  ntp_client_t *ntp_client = backend->ntp_client;
+  if (ntp_client && ntp_client->is_synced) {
+    int64_t offset_ns = ntp_client_get_offset(ntp_client);
+    if (stats->has_ntp_offset && offset_ns != stats->last_ntp_offset_ns) {
+      stats->ntp_jitter_ns = live_jitter_update(
+          stats->ntp_jitter_ns, offset_ns - stats->last_ntp_offset_ns);
+      live_stat_set(&stats->ntp_jitter_us,
+                    (long)(stats->ntp_jitter_ns / 1000));
+    }
+    stats->has_ntp_offset = true;
+    stats->last_ntp_offset_ns = offset_ns;
+
+    int64_t offset_us = offset_ns / 1000;
+    if (offset_us > LONG_MAX)
+      offset_us = LONG_MAX;
+    else if (offset_us < LONG_MIN)
+      offset_us = LONG_MIN;
+    live_stat_set(&stats->ntp_offset_us, (long)offset_us);
+  }
+  os_atomic_set_bool(&stats->ntp_synced,
+                     ntp_client && ntp_client->is_synced);
+
+  if (backend->capture_times)
+    live_stat_set(&stats->stamp_misses, (long)backend->capture_times->misses);
+  if (backend->packet_queue) {
+    live_stat_set(&stats->queue_depth, (long)backend->packet_queue->count);
+    live_stat_set(&stats->queue_peak, (long)backend->packet_queue->peak);
+    live_stat_set(&stats->queue_full,
+                  (long)backend->packet_queue->full_count);
+  }
+
+  stats->period_start = now;
+  stats->period_bytes = 0;
+  stats->period_packets = 0;
+}
+
+void encoder_stats_record(encoder_stats_t *stats, bool ok,
+                          const struct encoder_packet *packet,
+                          const encoder_backend_state_t *backend) {
+  live_stat_inc(&stats->frames_in);
+  if (!ok)
+    live_stat_inc(&stats->encode_errors);
+
+  if (packet) {
+    live_stat_inc(&stats->packets_out);
+    if (packet->keyframe)
+      live_stat_inc(&stats->keyframes);
+    if (backend->packet_stamped)
+      live_stat_inc(&stats->stamped);
+    stats->period_bytes += packet->size;
+    stats->period_packets++;
+  }
+
+  uint64_t now = fast_clock_now_ns();
+  if (stats->period_start == 0)
+    stats->period_start = now;
+  else if (now - stats->period_start >= ENCODER_STATS_INTERVAL_NS)
+    publish_period(stats, now, backend);
+}
+
+void encoder_stats_snapshot(const encoder_stats_t *stats,
+                            encoder_stats_snapshot_t *snapshot) {
+  snapshot->frames_in = live_stat_get(&stats->frames_in);
+  snapshot->packets_out = live_stat_get(&stats->packets_out);
+  snapshot->keyframes = live_stat_get(&stats->keyframes);
+  snapshot->stamped = live_stat_get(&stats->stamped);
+  snapshot->stamp_misses = live_stat_get(&stats->stamp_misses);
+  snapshot->encode_errors = live_stat_get(&stats->encode_errors);
+  snapshot->bitrate_kbps = (double)live_stat_get(&stats->bitrate_kbps);
+  snapshot->fps = live_stat_get(&stats->fps_centi) / 100.0;
+  snapshot->ntp_offset_ms = live_stat_get(&stats->ntp_offset_us) / 1000.0;
+  snapshot->ntp_jitter_ms = live_stat_get(&stats->ntp_jitter_us) / 1000.0;
+  snapshot->ntp_synced = os_atomic_load_bool(&stats->ntp_synced);
+  snapshot->queue_depth = live_stat_get(&stats->queue_depth);
+  snapshot->queue_peak = live_stat_get(&stats->queue_peak);
+  snapshot->queue_full = live_stat_get(&stats->queue_full);
+}
+
+size_t encoder_stats_collect(encoder_stats_entry_t **entries) {
+  *entries = NULL;
+
+  pthread_mutex_lock(&registry_mutex);
+  size_t count = 0;
+  for (encoder_stats_t *stats = registry_head; stats; stats = stats->next)
+    count++;
+  if (count)
+    *entries = bzalloc(count * sizeof(encoder_stats_entry_t));
+
+  size_t i = 0;
+  for (encoder_stats_t *stats = registry_head; stats && *entries;
+       stats = stats->next, i++) {
+    const char *name = obs_encoder_get_name(stats->encoder);
+    snprintf((*entries)[i].name, sizeof((*entries)[i].name), "%s",
+             name ? name : "");
+    encoder_stats_snapshot(stats, &(*entries)[i].stats);
+  }
+  pthread_mutex_unlock(&registry_mutex);
+  return i;
+}
+
+static void list_encoders_proc(void *data, calldata_t *cd) {
+  UNUSED_PARAMETER(data);
+
+  struct dstr names = {0};
+  pthread_mutex_lock(&registry_mutex);
+  for (encoder_stats_t *stats = registry_head; stats; stats = stats->next) {
+    const char *name = obs_encoder_get_name(stats->encoder);
+    if (!name)
+      continue;
+    if (names.len)
+      dstr_cat(&names, "\n");
+    dstr_cat(&names, name);
+  }
+  pthread_mutex_unlock(&registry_mutex);
+
+  calldata_set_string(cd, "names", names.array ? names.array : "");
+  dstr_free(&names);
+}
+
+static void encoder_stats_proc(void *data, calldata_t *cd) {
+  UNUSED_PARAMETER(data);
+
+  const char *name = calldata_string(cd, "name");
+  encoder_stats_snapshot_t snapshot;
+  bool found = false;
+
+  pthread_mutex_lock(&registry_mutex);
+  for (encoder_stats_t *stats = registry_head; stats && name;
+       stats = stats->next) {
+    const char *encoder_name = obs_encoder_get_name(stats->encoder);
+    if (encoder_name && strcmp(encoder_name, name) == 0) {
+      encoder_stats_snapshot(stats, &snapshot);
+      found = true;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&registry_mutex);
+
+  calldata_set_bool(cd, "found", found);
+  if (!found)
+    return;
+
+  calldata_set_int(cd, "frames_in", snapshot.frames_in);
+  calldata_set_int(cd, "packets_out", snapshot.packets_out);
+  calldata_set_int(cd, "keyframes", snapshot.keyframes);
+  calldata_set_int(cd, "stamped", snapshot.stamped);
+  calldata_set_int(cd, "stamp_misses", snapshot.stamp_misses);
+  calldata_set_int(cd, "encode_errors", snapshot.encode_errors);
+  calldata_set_float(cd, "bitrate_kbps", snapshot.bitrate_kbps);
+  calldata_set_float(cd, "fps", snapshot.fps);
+  calldata_set_float(cd, "ntp_offset_ms", snapshot.ntp_offset_ms);
+  calldata_set_float(cd, "ntp_jitter_ms", snapshot.ntp_jitter_ms);
+  calldata_set_bool(cd, "ntp_synced", snapshot.ntp_synced);
+  calldata_set_int(cd, "queue_depth", snapshot.queue_depth);
+}
+
+void encoder_stats_add_procs(void) {
+  proc_handler_t *handler = obs_get_proc_handler();
+  if (!handler)
+    return;
+
+  proc_handler_add(handler, "void sei_stamper_list_encoders(out string names)",
+                   list_encoders_proc, NULL);
+  proc_handler_add(
+      handler,
+      "void sei_stamper_encoder_stats(in string name, out bool found, "
+      "out int frames_in, out int packets_out, out int keyframes, "
+      "out int stamped, out int stamp_misses, out int encode_errors, "
+      "out float bitrate_kbps, out float fps, out float ntp_offset_ms, "
+      "out float ntp_jitter_ms, out bool ntp_synced, out int queue_depth)",
+      encoder_stats_proc, NULL);
+}
@@ -0,0 +1,126 @@
+/******************************************************************************
+    Encoder Stats - Header File
+    Copyright (C) 2026
+
+    Live per-encoder counters written by the encode thread and published with
+    atomics, plus a registry of running encoders queried through global proc
+    handlers (OBS encoders have no per-instance proc handler)
+******************************************************************************/
+
+#pragma once
+
+#include "capture-time-ring.h"
+#include "encoder-packet-queue.h"
+#include "ntp-client.h"
+#include <obs-module.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 码率等周期值的统计周期 */
+#define ENCODER_STATS_INTERVAL_NS 1000000000ULL
+
+/* 发布的值(只由编码线程写入) 与注册表链接 */
+typedef struct encoder_stats {
+  volatile long frames_in;     /* 送入编码器的帧数 */
+  volatile long packets_out;   /* 输出的packet数 */
+  volatile long keyframes;     /* 输出的关键帧数 */
+  volatile long stamped;       /* 带时间戳SEI的packet数 */
+  volatile long stamp_misses;  /* 输出时找不到送入时间(使用了当前时间) */
+  volatile long encode_errors; /* encode调用失败次数 */
+  volatile long bitrate_kbps;  /* 上一周期的输出码率 */
+  volatile long fps_centi;     /* 上一周期的输出帧率 x100 */
+  volatile long ntp_offset_us; /* NTP时间 - 本地时间 */
+  volatile long ntp_jitter_us; /* NTP偏移变化的平滑平均 */
+  volatile bool ntp_synced;
+  volatile long queue_depth; /* 输出队列中的包数 */
+  volatile long queue_peak;  /* 输出队列深度峰值 */
+  volatile long queue_full;  /* 取包时输出队列已满(扩容或达到上限)的次数 */
+
+  /* 编码线程私有 */
+  uint64_t period_start;
+  uint64_t period_bytes;
+  long period_packets;
+  bool has_ntp_offset;
+  int64_t last_ntp_offset_ns;
+  int64_t ntp_jitter_ns;
+
+  /* 注册表 (由模块内的互斥锁保护) */
+  obs_encoder_t *encoder;
+  struct encoder_stats *next;
+} encoder_stats_t;
+
+/* 统计快照 */
+typedef struct encoder_stats_snapshot {
+  long frames_in;
+  long packets_out;
+  long keyframes;
+  long stamped;
+  long stamp_misses;
+  long encode_errors;
+  double bitrate_kbps;
+  double fps;
+  double ntp_offset_ms;
+  double ntp_jitter_ms;
+  bool ntp_synced;
+  long queue_depth;
+  long queue_peak;
+  long queue_full;
+} encoder_stats_snapshot_t;
+
+/* 按名字复制的快照 (见encoder_stats_collect) */
+typedef struct encoder_stats_entry {
+  char name[128];
+  encoder_stats_snapshot_t stats;
+} encoder_stats_entry_t;
+
+/* 后端编码器的状态, 每个周期读取一次(字段可以为NULL) */
+typedef struct encoder_backend_state {
+  ntp_client_t *ntp_client;
+  const capture_time_ring_t *capture_times;
+  const encoder_packet_queue_t *packet_queue;
+  bool packet_stamped; /* 本次输出的packet实际带有时间戳SEI */
+} encoder_backend_state_t;
+
+/* 编码器创建后登记(stats由调用者分配, 通常为编码器结构体的成员) */
+void encoder_stats_register(encoder_stats_t *stats, obs_encoder_t *encoder);
+
+/* 销毁前注销, 之后proc handler不再访问stats */
+void encoder_stats_unregister(encoder_stats_t *stats);
+
+/*
+ * 记录一次encode调用(编码线程)
+ * 参数:
+ *   ok - encode是否成功
+ *   packet - 本次输出的packet, 没有输出时为NULL
+ *   backend - 后端的时钟和队列状态, 每个周期发布一次;
+ *             packet非NULL时packet_stamped描述该packet
+ */
+void encoder_stats_record(encoder_stats_t *stats, bool ok,
+                          const struct encoder_packet *packet,
+                          const encoder_backend_state_t *backend);
+
+/* 读取当前值(任意线程) */
+void encoder_stats_snapshot(const encoder_stats_t *stats,
+                            encoder_stats_snapshot_t *snapshot);
+
+/*
+ * 复制所有运行中编码器的名字和快照
+ * 返回:
+ *   编码器数量, entries由调用者bfree (没有编码器时为NULL)
+ */
+size_t encoder_stats_collect(encoder_stats_entry_t **entries);
+
+/*
+ * 在全局proc handler上注册查询接口(模块加载时调用一次):
+ *   sei_stamper_list_encoders(out string names) - 以换行分隔的编码器名
+ *   sei_stamper_encoder_stats(in string name, out bool found, ...)
+ */
+void encoder_stats_add_procs(void);
+
+#ifdef __cplusplus
+}
+#endif
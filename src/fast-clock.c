@@ -0,0 +1,216 @@
+/******************************************************************************
+    Fast Clock Module - Implementation
+    Copyright (C) 2026
+
+    Calibrated invariant-TSC clock for per-frame timestamping, with
+    os_gettime_ns() fallback
+******************************************************************************/
+
+#include "fast-clock.h"
+#include <obs-module.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#define FAST_CLOCK_HAS_TSC 1
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define FAST_CLOCK_HAS_TSC 1
+#else
+#define FAST_CLOCK_HAS_TSC 0
+#endif
+
+/* 日志宏 */
+#define clock_log(level, format, ...)                                          \
+  blog(level, "[Fast Clock] " format, ##__VA_ARGS__)
+
+/* 首次校准所需的最短时间 */
+#define CALIBRATION_PERIOD_NS 1000000000ULL /* 1秒 */
+
+/* 重新锚定间隔: 与os_gettime_ns()比较并在下一个周期内平滑修正误差 */
+#define RECALIBRATION_PERIOD_NS 10000000000ULL /* 10秒 */
+
+/* 误差超过该值时直接跳到os_gettime_ns()(例如系统休眠后) */
+#define MAX_SLEW_ERROR_NS 1000000LL /* 1ms */
+
+/* 时钟状态 */
+enum {
+  CLOCK_STATE_UNINITIALIZED = 0,
+  CLOCK_STATE_CALIBRATING,
+  CLOCK_STATE_TSC,
+  CLOCK_STATE_FALLBACK,
+};
+
+/* 换算参数: ns = ns_base + ((tsc - tsc_base) * mult) >> 32 */
+typedef struct clock_params {
+  uint64_t tsc_base;
+  uint64_t ns_base;
+  uint64_t mult;
+} clock_params_t;
+
+static pthread_mutex_t clock_mutex = PTHREAD_MUTEX_INITIALIZER;
+static volatile long clock_state = CLOCK_STATE_UNINITIALIZED;
+
+/* 双缓冲: 写入非活动的一份后再切换索引,读取端无需加锁 */
+static clock_params_t clock_params[2];
+static volatile long clock_active;
+
+static uint64_t anchor_tsc; /* 校准起点 */
+static uint64_t anchor_ns;
+static double ticks_per_ns; /* 自起点起的平均频率 */
+static volatile long long next_recalibration_ns;
+
+#if FAST_CLOCK_HAS_TSC
+
+static inline uint64_t read_tsc(void) { return __rdtsc(); }
+
+/* CPUID 0x80000007 EDX bit 8: 不变TSC(频率恒定,跨核同步) */
+static bool has_invariant_tsc(void) {
+#ifdef _MSC_VER
+  int regs[4];
+  __cpuid(regs, 0x80000000);
+  if ((unsigned int)regs[0] < 0x80000007)
+    return false;
+  __cpuid(regs, 0x80000007);
+  return (regs[3] & (1 << 8)) != 0;
+#else
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx))
+    return false;
+  return (edx & (1 << 8)) != 0;
+#endif
+}
+
+/* 同时采样TSC和os_gettime_ns(),取三次中窗口最小的一次 */
+static void sample_pair(uint64_t *tsc, uint64_t *ns) {
+  uint64_t best_window = UINT64_MAX;
+
+  for (int i = 0; i < 3; i++) {
+    uint64_t before = read_tsc();
+    uint64_t now = os_gettime_ns();
+    uint64_t after = read_tsc();
+
+    if (after - before < best_window) {
+      best_window = after - before;
+      *tsc = before + (after - before) / 2;
+      *ns = now;
+    }
+  }
+}
+
+static inline uint64_t tsc_to_ns(const clock_params_t *p, uint64_t tsc) {
+  uint64_t hi;
+  uint64_t lo = fast_clock_mul128(tsc - p->tsc_base, p->mult, &hi);
+  return p->ns_base + ((hi << 32) | (lo >> 32));
+}
+
+static void publish(uint64_t tsc, uint64_t ns, double ticks_per_ns_now) {
+  long next = !os_atomic_load_long(&clock_active);
+  clock_params[next].tsc_base = tsc;
+  clock_params[next].ns_base = ns;
+  clock_params[next].mult = (uint64_t)(4294967296.0 / ticks_per_ns_now);
+  os_atomic_set_long(&clock_active, next);
+  next_recalibration_ns = (long long)(ns + RECALIBRATION_PERIOD_NS);
+}
+
+/* 校准(持有clock_mutex) */
+static void calibrate(void) {
+  uint64_t tsc, ns;
+  sample_pair(&tsc, &ns);
+
+  if (ns - anchor_ns < CALIBRATION_PERIOD_NS)
+    return;
+
+  ticks_per_ns = (double)(tsc - anchor_tsc) / (double)(ns - anchor_ns);
+  publish(tsc, ns, ticks_per_ns);
+  os_atomic_set_long(&clock_state, CLOCK_STATE_TSC);
+
+  clock_log(LOG_INFO, "Invariant TSC calibrated: %.3f MHz",
+            ticks_per_ns * 1000.0);
+}
+
+/* 重新锚定: 以当前读数为起点,在下一个周期内把误差平滑掉,保证连续单调 */
+static void recalibrate(void) {
+  if (pthread_mutex_trylock(&clock_mutex) != 0)
+    return;
+
+  const clock_params_t *p = &clock_params[os_atomic_load_long(&clock_active)];
+  uint64_t tsc, ns;
+  sample_pair(&tsc, &ns);
+
+  if ((long long)ns >= next_recalibration_ns) {
+    uint64_t fast_ns = tsc_to_ns(p, tsc);
+    int64_t error = (int64_t)(ns - fast_ns);
+
+    ticks_per_ns = (double)(tsc - anchor_tsc) / (double)(ns - anchor_ns);
+
+    if (error > MAX_SLEW_ERROR_NS || error < -MAX_SLEW_ERROR_NS) {
+      clock_log(LOG_WARNING, "TSC drifted %lld us from system clock, "
+                "re-anchoring", error / 1000);
+      anchor_tsc = tsc;
+      anchor_ns = ns;
+      publish(tsc, ns, ticks_per_ns);
+    } else {
+      double slew = 1.0 + (double)error / (double)RECALIBRATION_PERIOD_NS;
+      publish(tsc, fast_ns, ticks_per_ns / slew);
+    }
+  }
+
+  pthread_mutex_unlock(&clock_mutex);
+}
+
+#endif
+
+void fast_clock_init(void) {
+  if (os_atomic_load_long(&clock_state) != CLOCK_STATE_UNINITIALIZED)
+    return;
+
+  pthread_mutex_lock(&clock_mutex);
+  if (clock_state == CLOCK_STATE_UNINITIALIZED) {
+#if FAST_CLOCK_HAS_TSC
+    if (has_invariant_tsc()) {
+      sample_pair(&anchor_tsc, &anchor_ns);
+      os_atomic_set_long(&clock_state, CLOCK_STATE_CALIBRATING);
+    } else {
+      clock_log(LOG_INFO, "No invariant TSC, using system clock");
+      os_atomic_set_long(&clock_state, CLOCK_STATE_FALLBACK);
+    }
+#else
+    os_atomic_set_long(&clock_state, CLOCK_STATE_FALLBACK);
+#endif
+  }
+  pthread_mutex_unlock(&clock_mutex);
+}
+
+uint64_t fast_clock_now_ns(void) {
+  long state = os_atomic_load_long(&clock_state);
+
+#if FAST_CLOCK_HAS_TSC
+  if (state == CLOCK_STATE_TSC) {
+    const clock_params_t *p =
+        &clock_params[os_atomic_load_long(&clock_active)];
+    uint64_t ns = tsc_to_ns(p, read_tsc());
+    if ((long long)ns >= next_recalibration_ns)
+      recalibrate();
+    return ns;
+  }
+
+  if (state == CLOCK_STATE_CALIBRATING) {
+    if (pthread_mutex_trylock(&clock_mutex) == 0) {
+      if (clock_state == CLOCK_STATE_CALIBRATING)
+        calibrate();
+      pthread_mutex_unlock(&clock_mutex);
+    }
+  }
+#endif
+
+  if (state == CLOCK_STATE_UNINITIALIZED)
+    fast_clock_init();
+
+  return os_gettime_ns();
+}
+
+bool fast_clock_is_tsc(void) {
+  return os_atomic_load_long(&clock_state) == CLOCK_STATE_TSC;
+}
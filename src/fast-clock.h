@@ -0,0 +1,65 @@
+/******************************************************************************
+    Fast Clock Module - Header File
+    Copyright (C) 2026
+
+    Calibrated invariant-TSC clock for per-frame timestamping, with
+    os_gettime_ns() fallback
+******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 初始化快速时钟(可重复调用)
+ * 插件加载时调用一次以尽早开始TSC校准; 校准完成前读数回退到os_gettime_ns()
+ */
+void fast_clock_init(void);
+
+/*
+ * 获取当前单调时间(纳秒)
+ * 与os_gettime_ns()使用同一时基,可以混用
+ */
+uint64_t fast_clock_now_ns(void);
+
+/*
+ * 是否正在使用TSC
+ * 返回:
+ *   true - 已完成TSC校准
+ *   false - 使用os_gettime_ns()
+ */
+bool fast_clock_is_tsc(void);
+
+/* 64x64 -> 128位乘法,返回低64位,高64位写入hi */
+static inline uint64_t fast_clock_mul128(uint64_t a, uint64_t b,
+                                         uint64_t *hi) {
+#if defined(_MSC_VER) && defined(_M_X64)
+  return _umul128(a, b, hi);
+#elif defined(__SIZEOF_INT128__)
+  unsigned __int128 r = (unsigned __int128)a * b;
+  *hi = (uint64_t)(r >> 64);
+  return (uint64_t)r;
+#else
+  uint64_t a_lo = (uint32_t)a, a_hi = a >> 32;
+  uint64_t b_lo = (uint32_t)b, b_hi = b >> 32;
+  uint64_t lo_lo = a_lo * b_lo;
+  uint64_t hi_lo = a_hi * b_lo;
+  uint64_t lo_hi = a_lo * b_hi;
+  uint64_t cross = (lo_lo >> 32) + (uint32_t)hi_lo + lo_hi;
+  *hi = a_hi * b_hi + (hi_lo >> 32) + (cross >> 32);
+  return (cross << 32) | (uint32_t)lo_lo;
+#endif
+}
+
+#ifdef __cplusplus
+}
+#endif
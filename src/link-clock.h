@@ -0,0 +1,41 @@
+/******************************************************************************
+    Link Clock Estimator - Header File
+    Copyright (C) 2026
+
+    Estimates the sender-to-receiver clock offset of a single SRT link from
+    the SEI timestamps it carries, without any NTP server. The estimator is
+    implemented in libseistamp.
+******************************************************************************/
+
+#pragma once
+
+#include <seistamp.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LINK_CLOCK_WINDOW SEISTAMP_LINK_CLOCK_WINDOW
+
+typedef seistamp_link_clock_t link_clock_t;
+
+static inline void link_clock_init(link_clock_t *clock,
+                                   int64_t transport_delay_ns) {
+  seistamp_link_clock_init(clock, transport_delay_ns);
+}
+
+static inline void link_clock_add_sample(link_clock_t *clock,
+                                         uint64_t sender_ns,
+                                         uint64_t local_arrival_ns) {
+  seistamp_link_clock_add_sample(clock, sender_ns, local_arrival_ns);
+}
+
+static inline bool link_clock_to_local(const link_clock_t *clock,
+                                       uint64_t sender_ns,
+                                       int64_t *local_out) {
+  return seistamp_link_clock_to_local(clock, sender_ns, local_out);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,82 @@
+/******************************************************************************
+    Live Stats - Header File
+    Copyright (C) 2026
+
+    Single-writer counters: each value is written by exactly one thread
+    (receive thread, encode thread) and read by any thread via os_atomic
+    loads, so dashboards can poll without touching the hot path's locks
+******************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <util/threading.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 只有一个线程写入, 读-改-写不会丢失更新, 无需加锁指令 */
+static inline void live_stat_add(volatile long *value, long delta) {
+  os_atomic_set_long(value, os_atomic_load_long(value) + delta);
+}
+
+static inline void live_stat_inc(volatile long *value) {
+  live_stat_add(value, 1);
+}
+
+static inline void live_stat_set(volatile long *value, long v) {
+  os_atomic_set_long(value, v);
+}
+
+static inline long live_stat_get(const volatile long *value) {
+  return os_atomic_load_long(value);
+}
+
+/* 耗时直方图的档位数: 第i档上限为 250微秒 << i (250us ~ 512ms), 另有溢出档 */
+#define LIVE_HISTOGRAM_BUCKETS 12
+
+/* 单写者耗时直方图 (各档不累计; 导出Prometheus时再累加) */
+typedef struct live_histogram {
+  volatile long counts[LIVE_HISTOGRAM_BUCKETS + 1];
+  volatile long sum_ms; /* 总耗时, 由sum_ns发布 (long在Windows上只有32位) */
+  uint64_t sum_ns;      /* 写入线程私有 */
+} live_histogram_t;
+
+static inline long live_histogram_bound_us(int bucket) {
+  return 250L << bucket;
+}
+
+static inline void live_histogram_observe(live_histogram_t *histogram,
+                                          uint64_t duration_ns) {
+  int bucket = 0;
+  while (bucket < LIVE_HISTOGRAM_BUCKETS &&
+         duration_ns > (uint64_t)live_histogram_bound_us(bucket) * 1000)
+    bucket++;
+  live_stat_inc(&histogram->counts[bucket]);
+  histogram->sum_ns += duration_ns;
+  live_stat_set(&histogram->sum_ms, (long)(histogram->sum_ns / 1000000));
+}
+
+typedef struct live_histogram_snapshot {
+  long counts[LIVE_HISTOGRAM_BUCKETS + 1];
+  long sum_ms;
+} live_histogram_snapshot_t;
+
+static inline void live_histogram_snapshot(const live_histogram_t *histogram,
+                                           live_histogram_snapshot_t *out) {
+  for (int i = 0; i <= LIVE_HISTOGRAM_BUCKETS; i++)
+    out->counts[i] = live_stat_get(&histogram->counts[i]);
+  out->sum_ms = live_stat_get(&histogram->sum_ms);
+}
+
+/* 时钟偏移的抖动: 相邻两次偏移之差的平滑平均 (RFC 3550的1/16增益) */
+static inline int64_t live_jitter_update(int64_t jitter_ns, int64_t delta_ns) {
+  if (delta_ns < 0)
+    delta_ns = -delta_ns;
+  return jitter_ns + (delta_ns - jitter_ns) / 16;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,664 @@
+/******************************************************************************
+    Metrics Server - Implementation
+    Copyright (C) 2026
+******************************************************************************/
+
+#include "metrics-server.h"
+#include "encoder-stats.h"
+#include "sei-receiver-source.h"
+#include <obs-module.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#define METRICS_SERVER_POLL_MS 1000         /* 检查退出标志的间隔 */
+#define METRICS_SERVER_RECV_TIMEOUT_MS 1000 /* 等待请求头的时间 */
+#define METRICS_SERVER_MAX_REQUEST 2048
+
+#ifdef MSG_NOSIGNAL
+#define METRICS_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define METRICS_SEND_FLAGS 0
+#endif
+
+/* 日志宏 */
+#define metrics_log(level, format, ...)                                        \
+  blog(level, "[Metrics Server] " format, ##__VA_ARGS__)
+
+/* 指标服务器上下文 */
+typedef struct metrics_server {
+  char bind_address[64];       /* 监听地址 */
+  uint16_t port;               /* 监听端口 */
+  int socket_fd;               /* 监听socket */
+  pthread_t thread;            /* 服务线程 */
+  volatile bool thread_active; /* 线程活动标志 */
+  uint32_t requests_served;    /* 已应答的抓取数 */
+} metrics_server_t;
+
+/*============================================================================
+ * Prometheus文本格式
+ *============================================================================*/
+
+typedef enum metric_kind {
+  METRIC_LONG,
+  METRIC_DOUBLE,
+  METRIC_BOOL,
+} metric_kind_t;
+
+/* 一个指标: 快照结构体中的字段及换算到基本单位的系数 */
+typedef struct metric {
+  const char *name;
+  const char *type; /* counter / gauge */
+  const char *help;
+  size_t offset;
+  metric_kind_t kind;
+  double scale;
+  bool needs_transport; /* 只在有SRT传输统计时输出 */
+} metric_t;
+
+/* 耗时直方图 (live_histogram_snapshot_t字段) */
+typedef struct histogram_metric {
+  const char *name;
+  const char *help;
+  size_t offset;
+} histogram_metric_t;
+
+#define RECEIVER_FIELD(field) offsetof(receiver_stats_t, field)
+#define ENCODER_FIELD(field) offsetof(encoder_stats_snapshot_t, field)
+
+static const metric_t receiver_metrics[] = {
+    {"seistamp_receiver_connected", "gauge",
+     "Whether the receiver is connected to its stream",
+     RECEIVER_FIELD(connected), METRIC_BOOL, 1.0, false},
+    {"seistamp_receiver_frames_received_total", "counter",
+     "Video frames received", RECEIVER_FIELD(frames_received), METRIC_LONG,
+     1.0, false},
+    {"seistamp_receiver_frames_rendered_total", "counter",
+     "Video frames output to OBS", RECEIVER_FIELD(frames_rendered),
+     METRIC_LONG, 1.0, false},
+    {"seistamp_receiver_frames_dropped_total", "counter",
+     "Video frames dropped by the frame buffer",
+     RECEIVER_FIELD(frames_dropped), METRIC_LONG, 1.0, false},
+    {"seistamp_receiver_sei_frames_total", "counter",
+     "Frames carrying a timestamp SEI", RECEIVER_FIELD(sei_found),
+     METRIC_LONG, 1.0, false},
+    {"seistamp_receiver_decode_errors_total", "counter", "Decoder errors",
+     RECEIVER_FIELD(decode_errors), METRIC_LONG, 1.0, false},
+    {"seistamp_receiver_connects_total", "counter",
+     "Successful connections (reconnects included)",
+     RECEIVER_FIELD(connect_count), METRIC_LONG, 1.0, false},
+    {"seistamp_receiver_fps", "gauge", "Output frame rate",
+     RECEIVER_FIELD(fps), METRIC_DOUBLE, 1.0, false},
+    {"seistamp_receiver_sei_detection_ratio", "gauge",
+     "Share of frames carrying a timestamp SEI", RECEIVER_FIELD(sei_rate),
+     METRIC_DOUBLE, 0.01, false},
+    {"seistamp_receiver_ntp_offset_seconds", "gauge",
+     "NTP time minus local time", RECEIVER_FIELD(ntp_offset_ms),
+     METRIC_DOUBLE, 0.001, false},
+    {"seistamp_receiver_ntp_jitter_seconds", "gauge",
+     "Smoothed change of the NTP offset between samples",
+     RECEIVER_FIELD(ntp_jitter_ms), METRIC_DOUBLE, 0.001, false},
+    {"seistamp_receiver_srt_rtt_seconds", "gauge", "SRT round-trip time",
+     RECEIVER_FIELD(srt.rtt_ms), METRIC_DOUBLE, 0.001, true},
+    {"seistamp_receiver_srt_loss_ratio", "gauge",
+     "SRT packet loss over the last second", RECEIVER_FIELD(srt.loss_percent),
+     METRIC_DOUBLE, 0.01, true},
+    {"seistamp_receiver_srt_lost_packets_total", "counter",
+     "SRT packets lost on this connection", RECEIVER_FIELD(srt.lost_total),
+     METRIC_LONG, 1.0, true},
+    {"seistamp_receiver_srt_retransmitted_packets_total", "counter",
+     "SRT retransmitted packets received on this connection",
+     RECEIVER_FIELD(srt.retrans_total), METRIC_LONG, 1.0, true},
+    {"seistamp_receiver_srt_dropped_packets_total", "counter",
+     "SRT packets dropped for arriving too late on this connection",
+     RECEIVER_FIELD(srt.dropped_total), METRIC_LONG, 1.0, true},
+    {"seistamp_receiver_srt_receive_buffer_seconds", "gauge",
+     "Media held in the SRT receive buffer", RECEIVER_FIELD(srt.rcv_buf_ms),
+     METRIC_LONG, 0.001, true},
+    {"seistamp_receiver_srt_latency_seconds", "gauge",
+     "Negotiated SRT receive latency", RECEIVER_FIELD(srt.latency_ms),
+     METRIC_LONG, 0.001, true},
+    {"seistamp_receiver_srt_receive_bitrate_bps", "gauge",
+     "SRT receive rate", RECEIVER_FIELD(srt.recv_mbps), METRIC_DOUBLE, 1e6,
+     true},
+    {"seistamp_receiver_late_frames_transport_total", "counter",
+     "Late frames while the link lost or retransmitted packets",
+     RECEIVER_FIELD(srt.late_transport), METRIC_LONG, 1.0, false},
+    {"seistamp_receiver_late_frames_other_total", "counter",
+     "Late frames on a clean link (sender or clock)",
+     RECEIVER_FIELD(srt.late_other), METRIC_LONG, 1.0, false},
+    {"seistamp_receiver_audio_rate_correction_ratio", "gauge",
+     "Audio resampling ratio adjustment tracking the video timeline",
+     RECEIVER_FIELD(audio_correction_ppm), METRIC_DOUBLE, 1e-6, false},
+    {"seistamp_receiver_audio_timeline_error_seconds", "gauge",
+     "Smoothed audio timeline error (positive: audio early)",
+     RECEIVER_FIELD(audio_error_ms), METRIC_DOUBLE, 0.001, false},
+    {"seistamp_receiver_audio_resyncs_total", "counter",
+     "Audio timeline resets (timestamp steps)",
+     RECEIVER_FIELD(audio_resyncs), METRIC_LONG, 1.0, false},
+};
+
+static const histogram_metric_t receiver_histograms[] = {
+    {"seistamp_receiver_decode_seconds",
+     "Time from sending a packet to the decoder to receiving its frame",
+     RECEIVER_FIELD(decode_time)},
+    {"seistamp_receiver_convert_seconds",
+     "Time to download and convert a decoded frame for OBS",
+     RECEIVER_FIELD(convert_time)},
+};
+
+static const metric_t encoder_metrics[] = {
+    {"seistamp_encoder_frames_total", "counter", "Frames sent to the encoder",
+     ENCODER_FIELD(frames_in), METRIC_LONG, 1.0, false},
+    {"seistamp_encoder_packets_total", "counter", "Packets output",
+     ENCODER_FIELD(packets_out), METRIC_LONG, 1.0, false},
+    {"seistamp_encoder_keyframes_total", "counter", "Keyframes output",
+     ENCODER_FIELD(keyframes), METRIC_LONG, 1.0, false},
+    {"seistamp_encoder_stamped_packets_total", "counter",
+     "Packets carrying a timestamp SEI", ENCODER_FIELD(stamped), METRIC_LONG,
+     1.0, false},
+    {"seistamp_encoder_stamp_misses_total", "counter",
+     "Packets stamped with the output time because the capture time was "
+     "missing",
+     ENCODER_FIELD(stamp_misses), METRIC_LONG, 1.0, false},
+    {"seistamp_encoder_errors_total", "counter", "Failed encode calls",
+     ENCODER_FIELD(encode_errors), METRIC_LONG, 1.0, false},
+    {"seistamp_encoder_bitrate_bps", "gauge", "Output bitrate",
+     ENCODER_FIELD(bitrate_kbps), METRIC_DOUBLE, 1000.0, false},
+    {"seistamp_encoder_fps", "gauge", "Output frame rate", ENCODER_FIELD(fps),
+     METRIC_DOUBLE, 1.0, false},
+    {"seistamp_encoder_ntp_offset_seconds", "gauge",
+     "NTP time minus local time", ENCODER_FIELD(ntp_offset_ms), METRIC_DOUBLE,
+     0.001, false},
+    {"seistamp_encoder_ntp_jitter_seconds", "gauge",
+     "Smoothed change of the NTP offset between samples",
+     ENCODER_FIELD(ntp_jitter_ms), METRIC_DOUBLE, 0.001, false},
+    {"seistamp_encoder_ntp_synced", "gauge", "Whether the NTP clock is synced",
+     ENCODER_FIELD(ntp_synced), METRIC_BOOL, 1.0, false},
+    {"seistamp_encoder_packet_queue_depth", "gauge",
+     "Packets waiting in the output queue", ENCODER_FIELD(queue_depth),
+     METRIC_LONG, 1.0, false},
+    {"seistamp_encoder_packet_queue_peak", "gauge",
+     "Peak depth of the output queue", ENCODER_FIELD(queue_peak), METRIC_LONG,
+     1.0, false},
+    {"seistamp_encoder_packet_queue_full_total", "counter",
+     "Times the output queue was full and had to grow",
+     ENCODER_FIELD(queue_full), METRIC_LONG, 1.0, false},
+};
+
+static double metric_value(const metric_t *metric, const void *stats) {
+  const char *field = (const char *)stats + metric->offset;
+  switch (metric->kind) {
+  case METRIC_LONG:
+    return *(const long *)field * metric->scale;
+  case METRIC_DOUBLE:
+    return *(const double *)field * metric->scale;
+  case METRIC_BOOL:
+    return *(const bool *)field ? 1.0 : 0.0;
+  }
+  return 0.0;
+}
+
+/* 标签值转义: 反斜杠, 双引号, 换行 */
+static void cat_label_value(struct dstr *out, const char *value) {
+  for (const char *c = value; *c; c++) {
+    if (*c == '\\')
+      dstr_cat(out, "\\\\");
+    else if (*c == '"')
+      dstr_cat(out, "\\\"");
+    else if (*c == '\n')
+      dstr_cat(out, "\\n");
+    else
+      dstr_ncat(out, c, 1);
+  }
+}
+
+static void cat_header(struct dstr *out, const char *name, const char *type,
+                       const char *help) {
+  dstr_catf(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+static void cat_sample(struct dstr *out, const char *name, const char *suffix,
+                       const char *label, const char *instance,
+                       const char *le, double value) {
+  dstr_catf(out, "%s%s{%s=\"", name, suffix, label);
+  cat_label_value(out, instance);
+  if (le)
+    dstr_catf(out, "\",le=\"%s", le);
+  dstr_catf(out, "\"} %.15g\n", value);
+}
+
+static bool receiver_has_transport(const void *stats) {
+  return ((const receiver_stats_t *)stats)->srt.valid;
+}
+
+/* 每个指标先输出HELP/TYPE, 再输出每个实例的值 (同名样本必须连续) */
+static void render_metrics(struct dstr *out, const metric_t *metrics,
+                           size_t metric_count, const char *label,
+                           const char *entries, size_t entry_size,
+                           size_t count, size_t name_offset,
+                           size_t stats_offset,
+                           bool (*has_transport)(const void *stats)) {
+  for (size_t m = 0; m < metric_count; m++) {
+    const metric_t *metric = &metrics[m];
+    cat_header(out, metric->name, metric->type, metric->help);
+    for (size_t i = 0; i < count; i++) {
+      const char *entry = entries + i * entry_size;
+      const void *stats = entry + stats_offset;
+      if (metric->needs_transport && !(has_transport && has_transport(stats)))
+        continue;
+      cat_sample(out, metric->name, "", label, entry + name_offset, NULL,
+                 metric_value(metric, stats));
+    }
+  }
+}
+
+/* 累计档位 (le为上限秒数) + _sum + _count */
+static void render_histogram(struct dstr *out, const histogram_metric_t *hist,
+                             const receiver_stats_entry_t *entries,
+                             size_t count) {
+  cat_header(out, hist->name, "histogram", hist->help);
+  for (size_t i = 0; i < count; i++) {
+    const live_histogram_snapshot_t *snapshot =
+        (const live_histogram_snapshot_t *)((const char *)&entries[i].stats +
+                                            hist->offset);
+    double cumulative = 0.0;
+    char le[32];
+    for (int bucket = 0; bucket < LIVE_HISTOGRAM_BUCKETS; bucket++) {
+      cumulative += snapshot->counts[bucket];
+      snprintf(le, sizeof(le), "%g",
+               live_histogram_bound_us(bucket) / 1000000.0);
+      cat_sample(out, hist->name, "_bucket", "source", entries[i].name, le,
+                 cumulative);
+    }
+    cumulative += snapshot->counts[LIVE_HISTOGRAM_BUCKETS];
+    cat_sample(out, hist->name, "_bucket", "source", entries[i].name, "+Inf",
+               cumulative);
+    cat_sample(out, hist->name, "_sum", "source", entries[i].name, NULL,
+               snapshot->sum_ms / 1000.0);
+    cat_sample(out, hist->name, "_count", "source", entries[i].name, NULL,
+               cumulative);
+  }
+}
+
+static const char *const latency_stages[E2E_STAGE_COUNT] = {
+    "arrival", "decoded", "output"};
+static const char *const latency_windows[E2E_WINDOW_COUNT] = {"10s", "60s"};
+
+/* 端到端延迟的一个字段: 每个源/阶段/窗口一个样本, 没有样本的窗口不输出 */
+static void render_latency_field(struct dstr *out, const char *name,
+                                 const char *quantile, size_t offset,
+                                 const receiver_stats_entry_t *entries,
+                                 size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    for (int stage = 0; stage < E2E_STAGE_COUNT; stage++) {
+      for (int window = 0; window < E2E_WINDOW_COUNT; window++) {
+        const e2e_window_snapshot_t *snapshot =
+            &entries[i].stats.latency.windows[stage][window];
+        if (!snapshot->count)
+          continue;
+        dstr_catf(out, "%s{source=\"", name);
+        cat_label_value(out, entries[i].name);
+        dstr_catf(out, "\",stage=\"%s\",window=\"%s", latency_stages[stage],
+                  latency_windows[window]);
+        if (quantile)
+          dstr_catf(out, "\",quantile=\"%s", quantile);
+        dstr_catf(out, "\"} %.15g\n",
+                  *(const double *)((const char *)snapshot + offset) / 1000.0);
+      }
+    }
+  }
+}
+
+/* 端到端延迟 (仅NTP模式的接收源有样本) */
+static void render_latency(struct dstr *out,
+                           const receiver_stats_entry_t *entries,
+                           size_t count) {
+  cat_header(out, "seistamp_receiver_latency_seconds", "gauge",
+             "Latency from the sender capture stamp to each receive stage");
+  render_latency_field(out, "seistamp_receiver_latency_seconds", "0.5",
+                       offsetof(e2e_window_snapshot_t, p50_ms), entries,
+                       count);
+  render_latency_field(out, "seistamp_receiver_latency_seconds", "0.99",
+                       offsetof(e2e_window_snapshot_t, p99_ms), entries,
+                       count);
+  render_latency_field(out, "seistamp_receiver_latency_seconds", "0.999",
+                       offsetof(e2e_window_snapshot_t, p999_ms), entries,
+                       count);
+
+  cat_header(out, "seistamp_receiver_latency_max_seconds", "gauge",
+             "Maximum latency from the sender capture stamp in the window");
+  render_latency_field(out, "seistamp_receiver_latency_max_seconds", NULL,
+                       offsetof(e2e_window_snapshot_t, max_ms), entries,
+                       count);
+
+  cat_header(out, "seistamp_receiver_latency_frames", "gauge",
+             "Frames measured in the latency window");
+  for (size_t i = 0; i < count; i++) {
+    for (int stage = 0; stage < E2E_STAGE_COUNT; stage++) {
+      for (int window = 0; window < E2E_WINDOW_COUNT; window++) {
+        dstr_cat(out, "seistamp_receiver_latency_frames{source=\"");
+        cat_label_value(out, entries[i].name);
+        dstr_catf(out, "\",stage=\"%s\",window=\"%s\"} %ld\n",
+                  latency_stages[stage], latency_windows[window],
+                  entries[i].stats.latency.windows[stage][window].count);
+      }
+    }
+  }
+}
+
+void metrics_server_render(struct dstr *out) {
+  receiver_stats_entry_t *receivers = NULL;
+  size_t receiver_count = receiver_stats_collect(&receivers);
+  if (receiver_count) {
+    render_metrics(out, receiver_metrics,
+                   sizeof(receiver_metrics) / sizeof(receiver_metrics[0]),
+                   "source", (const char *)receivers,
+                   sizeof(receiver_stats_entry_t), receiver_count,
+                   offsetof(receiver_stats_entry_t, name),
+                   offsetof(receiver_stats_entry_t, stats),
+                   receiver_has_transport);
+    for (size_t h = 0;
+         h < sizeof(receiver_histograms) / sizeof(receiver_histograms[0]); h++)
+      render_histogram(out, &receiver_histograms[h], receivers,
+                       receiver_count);
+    render_latency(out, receivers, receiver_count);
+  }
+  bfree(receivers);
+
+  encoder_stats_entry_t *encoders = NULL;
+  size_t encoder_count = encoder_stats_collect(&encoders);
+  if (encoder_count) {
+    render_metrics(out, encoder_metrics,
+                   sizeof(encoder_metrics) / sizeof(encoder_metrics[0]),
+                   "encoder", (const char *)encoders,
+                   sizeof(encoder_stats_entry_t), encoder_count,
+                   offsetof(encoder_stats_entry_t, name),
+                   offsetof(encoder_stats_entry_t, stats), NULL);
+  }
+  bfree(encoders);
+}
+
+/*============================================================================
+ * HTTP
+ *============================================================================*/
+
+/* 初始化Winsock(仅Windows) */
+#ifdef _WIN32
+static bool init_winsock(void) {
+  static bool initialized = false;
+  if (initialized) {
+    return true;
+  }
+
+  WSADATA wsa_data;
+  int result = WSAStartup(MAKEWORD(2, 2), &wsa_data);
+  if (result != 0) {
+    metrics_log(LOG_ERROR, "WSAStartup failed: %d", result);
+    return false;
+  }
+
+  initialized = true;
+  return true;
+}
+#endif
+
+static void close_socket(int sock) {
+#ifdef _WIN32
+  closesocket(sock);
+#else
+  close(sock);
+#endif
+}
+
+static void set_recv_timeout(int sock, int timeout_ms) {
+#ifdef _WIN32
+  DWORD timeout = timeout_ms;
+#else
+  struct timeval timeout;
+  timeout.tv_sec = timeout_ms / 1000;
+  timeout.tv_usec = (timeout_ms % 1000) * 1000;
+#endif
+  setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (const char *)&timeout,
+             sizeof(timeout));
+}
+
+static bool send_all(int sock, const char *data, size_t size) {
+  while (size > 0) {
+    int ret = send(sock, data, (int)size, METRICS_SEND_FLAGS);
+    if (ret <= 0)
+      return false;
+    data += ret;
+    size -= (size_t)ret;
+  }
+  return true;
+}
+
+static void send_response(int sock, const char *status,
+                          const char *content_type, const char *body,
+                          size_t body_size) {
+  char header[256];
+  int len = snprintf(header, sizeof(header),
+                     "HTTP/1.1 %s\r\n"
+                     "Content-Type: %s\r\n"
+                     "Content-Length: %zu\r\n"
+                     "Connection: close\r\n\r\n",
+                     status, content_type, body_size);
+  if (len < 0 || (size_t)len >= sizeof(header))
+    return;
+  if (send_all(sock, header, (size_t)len) && body_size)
+    send_all(sock, body, body_size);
+}
+
+/* 读取请求头, 只应答 GET /metrics */
+static void handle_client(metrics_server_t *server, int client) {
+  char request[METRICS_SERVER_MAX_REQUEST];
+  size_t len = 0;
+
+  set_recv_timeout(client, METRICS_SERVER_RECV_TIMEOUT_MS);
+  while (len < sizeof(request) - 1) {
+    int ret = recv(client, request + len, (int)(sizeof(request) - 1 - len),
+                   0);
+    if (ret <= 0)
+      break;
+    len += (size_t)ret;
+    request[len] = '\0';
+    if (strstr(request, "\r\n\r\n"))
+      break;
+  }
+  if (len == 0)
+    return;
+  request[len] = '\0';
+
+  static const char text_plain[] = "text/plain; charset=utf-8";
+  if (strncmp(request, "GET ", 4) != 0) {
+    static const char body[] = "Method Not Allowed\n";
+    send_response(client, "405 Method Not Allowed", text_plain, body,
+                  sizeof(body) - 1);
+    return;
+  }
+
+  const char *path = request + 4;
+  size_t path_len = strcspn(path, " ?\r\n");
+  if (path_len != strlen("/metrics") ||
+      strncmp(path, "/metrics", path_len) != 0) {
+    static const char body[] = "Not Found (try /metrics)\n";
+    send_response(client, "404 Not Found", text_plain, body,
+                  sizeof(body) - 1);
+    return;
+  }
+
+  struct dstr body = {0};
+  metrics_server_render(&body);
+  send_response(client, "200 OK", "text/plain; version=0.0.4; charset=utf-8",
+                body.array ? body.array : "", body.len);
+  dstr_free(&body);
+  server->requests_served++;
+}
+
+/* 服务线程: 一次处理一个连接 (抓取频率低, 渲染只读原子值) */
+static void *metrics_server_thread(void *data) {
+  metrics_server_t *server = data;
+  os_set_thread_name("sei-stamper: metrics server");
+
+  metrics_log(LOG_INFO, "Serving metrics on http://%s:%u/metrics",
+              server->bind_address, server->port);
+
+  while (server->thread_active) {
+    fd_set read_fds;
+    FD_ZERO(&read_fds);
+    FD_SET(server->socket_fd, &read_fds);
+    struct timeval timeout;
+    timeout.tv_sec = METRICS_SERVER_POLL_MS / 1000;
+    timeout.tv_usec = (METRICS_SERVER_POLL_MS % 1000) * 1000;
+
+    int ready =
+        select(server->socket_fd + 1, &read_fds, NULL, NULL, &timeout);
+    if (ready <= 0) {
+      /* 超时,用于检查退出标志 */
+      continue;
+    }
+
+    int client = (int)accept(server->socket_fd, NULL, NULL);
+    if (client < 0) {
+      continue;
+    }
+
+#ifdef SO_NOSIGPIPE
+    int no_sigpipe = 1;
+    setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &no_sigpipe,
+               sizeof(no_sigpipe));
+#endif
+    handle_client(server, client);
+    close_socket(client);
+  }
+
+  return NULL;
+}
+
+static bool metrics_server_start(metrics_server_t *server,
+                                 const char *bind_address, uint16_t port) {
+  memset(server, 0, sizeof(metrics_server_t));
+  server->socket_fd = -1;
+  server->port = port ? port : METRICS_SERVER_DEFAULT_PORT;
+  snprintf(server->bind_address, sizeof(server->bind_address), "%s",
+           bind_address && bind_address[0] ? bind_address
+                                           : METRICS_SERVER_DEFAULT_BIND);
+
+#ifdef _WIN32
+  if (!init_winsock()) {
+    return false;
+  }
+#endif
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(server->port);
+  if (inet_pton(AF_INET, server->bind_address, &addr.sin_addr) != 1) {
+    metrics_log(LOG_ERROR, "Invalid bind address '%s' (IPv4 expected)",
+                server->bind_address);
+    return false;
+  }
+
+  int sock = (int)socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if (sock < 0) {
+    metrics_log(LOG_ERROR, "socket creation failed");
+    return false;
+  }
+
+  int reuse = 1;
+  setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (const char *)&reuse,
+             sizeof(reuse));
+
+  if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+      listen(sock, 8) < 0) {
+    metrics_log(LOG_ERROR, "bind to %s:%u failed (port in use?)",
+                server->bind_address, server->port);
+    close_socket(sock);
+    return false;
+  }
+
+  server->socket_fd = sock;
+  server->thread_active = true;
+  if (pthread_create(&server->thread, NULL, metrics_server_thread, server) !=
+      0) {
+    metrics_log(LOG_ERROR, "Failed to create server thread");
+    server->thread_active = false;
+    close_socket(sock);
+    server->socket_fd = -1;
+    return false;
+  }
+
+  return true;
+}
+
+static void metrics_server_stop(metrics_server_t *server) {
+  if (!server->thread_active) {
+    return;
+  }
+
+  server->thread_active = false;
+  pthread_join(server->thread, NULL);
+
+  if (server->socket_fd >= 0) {
+    close_socket(server->socket_fd);
+    server->socket_fd = -1;
+  }
+
+  metrics_log(LOG_INFO, "Metrics server stopped (scrapes served: %u)",
+              server->requests_served);
+}
+
+/*============================================================================
+ * 进程内共享实例
+ *============================================================================*/
+
+static pthread_mutex_t shared_server_mutex = PTHREAD_MUTEX_INITIALIZER;
+static metrics_server_t shared_server;
+static long shared_server_refs = 0;
+
+bool metrics_server_acquire(const char *bind_address, uint16_t port) {
+  bool running = true;
+
+  pthread_mutex_lock(&shared_server_mutex);
+  if (shared_server_refs == 0) {
+    running = metrics_server_start(&shared_server, bind_address, port);
+  } else if ((port && port != shared_server.port) ||
+             (bind_address && bind_address[0] &&
+              strcmp(bind_address, shared_server.bind_address) != 0)) {
+    metrics_log(LOG_WARNING,
+                "Metrics already served on %s:%u, ignoring %s:%u",
+                shared_server.bind_address, shared_server.port,
+                bind_address ? bind_address : "", port);
+  }
+
+  if (running) {
+    shared_server_refs++;
+  }
+  pthread_mutex_unlock(&shared_server_mutex);
+
+  return running;
+}
+
+void metrics_server_release(void) {
+  pthread_mutex_lock(&shared_server_mutex);
+  if (shared_server_refs > 0 && --shared_server_refs == 0) {
+    metrics_server_stop(&shared_server);
+  }
+  pthread_mutex_unlock(&shared_server_mutex);
+}
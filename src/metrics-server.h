@@ -0,0 +1,42 @@
+/******************************************************************************
+    Metrics Server - Header File
+    Copyright (C) 2026
+
+    Optional HTTP endpoint serving every running encoder's and receiver's live
+    stats in the Prometheus text format, so a scraper can watch a whole
+    rig without OBS scripts. Rendering only reads the published atomics
+******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <util/dstr.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 默认监听地址和端口 (只监听本机, 需要远程抓取时改为0.0.0.0) */
+#define METRICS_SERVER_DEFAULT_BIND "127.0.0.1"
+#define METRICS_SERVER_DEFAULT_PORT 9464
+
+/*
+ * 获取/释放进程内共享的指标服务器(引用计数)
+ * 编码器和接收源都可以开启, 但同一进程只运行一个服务线程
+ * 参数:
+ *   bind_address - 监听的IPv4地址(NULL或空表示默认地址)
+ *   port - 监听的TCP端口
+ * 返回:
+ *   true - 服务器正在运行
+ *   false - 启动失败(例如端口被占用)
+ */
+bool metrics_server_acquire(const char *bind_address, uint16_t port);
+void metrics_server_release(void);
+
+/* 把所有编码器和接收源的当前统计以Prometheus文本格式追加到out */
+void metrics_server_render(struct dstr *out);
+
+#ifdef __cplusplus
+}
+#endif
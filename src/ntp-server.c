@@ -0,0 +1,427 @@
+/******************************************************************************
+    NTP Server Module - Implementation
+    Copyright (C) 2026
+
+    Minimal NTPv4 server so one OBS instance can act as LAN time master
+******************************************************************************/
+
+#include "ntp-server.h"
+#include <obs-module.h>
+#include <string.h>
+#include <util/platform.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+/* NTP常量 */
+#define NTP_VERSION_SERVER 4
+#define NTP_MODE_CLIENT 3
+#define NTP_MODE_SERVER 4
+#define NTP_STRATUM_SYNCED 2  /* 上游已同步: 上游层级 + 1 */
+#define NTP_STRATUM_LOCAL 10  /* 仅本机时钟(孤立模式) */
+#define NTP_PRECISION_LOG2 -20 /* 约1微秒 */
+#define NTP_REFID_LOCAL 0x4C4F434CU    /* "LOCL" */
+#define NTP_REFID_UPSTREAM 0x53454953U /* "SEIS" */
+#define NTP_SERVER_RECV_TIMEOUT_MS 1000
+#define NTP_SERVER_UPSTREAM_POLL_MS 100 /* 上游线程检查退出标志的间隔 */
+
+/* 日志宏 */
+#define ntp_server_log(level, format, ...)                                     \
+  blog(level, "[NTP Server] " format, ##__VA_ARGS__)
+
+/* 初始化Winsock(仅Windows) */
+#ifdef _WIN32
+static bool init_winsock(void) {
+  static bool initialized = false;
+  if (initialized) {
+    return true;
+  }
+
+  WSADATA wsa_data;
+  int result = WSAStartup(MAKEWORD(2, 2), &wsa_data);
+  if (result != 0) {
+    ntp_server_log(LOG_ERROR, "WSAStartup failed: %d", result);
+    return false;
+  }
+
+  initialized = true;
+  return true;
+}
+#endif
+
+static void close_socket(int sock) {
+#ifdef _WIN32
+  closesocket(sock);
+#else
+  close(sock);
+#endif
+}
+
+/* 对外提供的时间: 上游已同步时使用校准后的时钟,否则使用本机时钟 */
+static uint64_t get_served_time_ns(ntp_server_t *server) {
+  pthread_mutex_lock(&server->clock_mutex);
+  bool disciplined = server->disciplined;
+  int64_t offset_ns = server->upstream_offset_ns;
+  pthread_mutex_unlock(&server->clock_mutex);
+
+  if (disciplined) {
+    return (uint64_t)((int64_t)fast_clock_now_ns() + offset_ns);
+  }
+  return ntp_get_wallclock_ns();
+}
+
+static void put_timestamp(ntp_timestamp_t *dst, uint64_t ns) {
+  ntp_timestamp_t ts;
+  ntp_timestamp_from_ns(ns, &ts);
+  dst->seconds = htonl(ts.seconds);
+  dst->fraction = htonl(ts.fraction);
+}
+
+/* 接收一个请求,并尽可能使用内核(软件)接收时间戳作为T2 */
+static int receive_request(ntp_server_t *server, ntp_packet_t *packet,
+                           struct sockaddr_storage *from,
+                           socklen_t *from_len, uint64_t *t2_ns) {
+#if defined(__linux__) && defined(SO_TIMESTAMPNS)
+  if (server->rx_timestamps) {
+    struct iovec iov = {.iov_base = packet, .iov_len = sizeof(*packet)};
+    char control[CMSG_SPACE(sizeof(struct timespec))];
+    struct msghdr msg = {0};
+    msg.msg_name = from;
+    msg.msg_namelen = *from_len;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    int ret = (int)recvmsg(server->socket_fd, &msg, 0);
+    uint64_t wall_now = ntp_get_wallclock_ns();
+    uint64_t served_now = get_served_time_ns(server);
+    *from_len = msg.msg_namelen;
+    *t2_ns = served_now;
+    if (ret < 0) {
+      return ret;
+    }
+
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg;
+         cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+      if (cmsg->cmsg_level == SOL_SOCKET &&
+          cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+        struct timespec ts;
+        memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+        uint64_t kernel_ns =
+            (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+        /* 内核时间戳基于本机挂钟,换算到对外提供的时钟 */
+        if (kernel_ns <= wall_now) {
+          *t2_ns = served_now - (wall_now - kernel_ns);
+        }
+        break;
+      }
+    }
+    return ret;
+  }
+#endif
+
+  int ret = recvfrom(server->socket_fd, (char *)packet, sizeof(*packet), 0,
+                     (struct sockaddr *)from, from_len);
+  *t2_ns = get_served_time_ns(server);
+  return ret;
+}
+
+/* 与上游保持同步 (独立线程: ntp_client_sync最多阻塞一个超时时间) */
+static void *ntp_upstream_thread(void *data) {
+  ntp_server_t *server = data;
+  os_set_thread_name("sei-stamper: ntp upstream");
+
+  uint64_t interval_ns =
+      (uint64_t)server->upstream_sync_interval_ms * 1000000ULL;
+  uint64_t last_sync_time = 0;
+
+  while (server->thread_active) {
+    uint64_t now = os_gettime_ns();
+    if (last_sync_time != 0 && now - last_sync_time < interval_ns) {
+      os_sleep_ms(NTP_SERVER_UPSTREAM_POLL_MS);
+      continue;
+    }
+
+    /* 无论成功与否都更新时间,上游不可达时按间隔重试 */
+    last_sync_time = now;
+    if (ntp_client_sync(&server->upstream)) {
+      int64_t offset_ns = server->upstream.time_offset_ns;
+      ntp_timestamp_t reference;
+      ntp_timestamp_from_ns((uint64_t)((int64_t)fast_clock_now_ns() +
+                                       offset_ns),
+                            &reference);
+
+      pthread_mutex_lock(&server->clock_mutex);
+      server->disciplined = true;
+      server->upstream_offset_ns = offset_ns;
+      server->reference_time = reference;
+      pthread_mutex_unlock(&server->clock_mutex);
+    } else if (server->upstream.is_synced) {
+      ntp_server_log(LOG_WARNING,
+                     "Upstream sync failed, keeping last disciplined clock");
+    }
+  }
+
+  return NULL;
+}
+
+static void handle_request(ntp_server_t *server, const ntp_packet_t *request,
+                           int request_size,
+                           const struct sockaddr_storage *from,
+                           socklen_t from_len, uint64_t t2_ns) {
+  if (request_size < (int)sizeof(ntp_packet_t)) {
+    server->requests_invalid++;
+    return;
+  }
+
+  uint8_t version = (request->li_vn_mode >> 3) & 0x07;
+  uint8_t mode = request->li_vn_mode & 0x07;
+  if (mode != NTP_MODE_CLIENT || version < 1 || version > 4) {
+    server->requests_invalid++;
+    return;
+  }
+
+  pthread_mutex_lock(&server->clock_mutex);
+  bool disciplined = server->disciplined;
+  ntp_timestamp_t reference = server->reference_time;
+  pthread_mutex_unlock(&server->clock_mutex);
+
+  ntp_packet_t reply;
+  memset(&reply, 0, sizeof(reply));
+  /* LI=0, 版本号与请求一致(兼容v3客户端), Mode=4(server) */
+  reply.li_vn_mode = (0 << 6) | (version << 3) | NTP_MODE_SERVER;
+  reply.stratum = disciplined ? NTP_STRATUM_SYNCED : NTP_STRATUM_LOCAL;
+  reply.poll = request->poll;
+  reply.precision = (uint8_t)(int8_t)NTP_PRECISION_LOG2;
+  reply.root_delay = 0;
+  reply.root_dispersion = 0;
+  reply.reference_id =
+      htonl(disciplined ? NTP_REFID_UPSTREAM : NTP_REFID_LOCAL);
+
+  reply.reference_timestamp.seconds = htonl(reference.seconds);
+  reply.reference_timestamp.fraction = htonl(reference.fraction);
+
+  /* T1: 原样回填客户端的发送时间戳 */
+  reply.originate_timestamp = request->transmit_timestamp;
+
+  /* T2: 请求到达时间 */
+  put_timestamp(&reply.receive_timestamp, t2_ns);
+
+  /* T3: 尽量晚地取发送时间 */
+  put_timestamp(&reply.transmit_timestamp, get_served_time_ns(server));
+
+  int ret = sendto(server->socket_fd, (const char *)&reply, sizeof(reply), 0,
+                   (const struct sockaddr *)from, from_len);
+  if (ret < 0) {
+    ntp_server_log(LOG_WARNING, "sendto failed");
+    return;
+  }
+
+  server->requests_served++;
+}
+
+/* 服务线程 */
+static void *ntp_server_thread(void *data) {
+  ntp_server_t *server = data;
+  os_set_thread_name("sei-stamper: ntp server");
+
+  ntp_server_log(LOG_INFO, "Serving time on UDP port %u (%s, %s)",
+                 server->port,
+                 server->upstream_enabled ? "disciplined by upstream"
+                                          : "local clock",
+                 server->rx_timestamps ? "kernel software RX timestamps"
+                                       : "user-space RX timestamps");
+
+  while (server->thread_active) {
+    ntp_packet_t request;
+    struct sockaddr_storage from_addr;
+    socklen_t from_len = sizeof(from_addr);
+    uint64_t t2_ns = 0;
+
+    int ret =
+        receive_request(server, &request, &from_addr, &from_len, &t2_ns);
+    if (ret < 0) {
+      /* 超时,用于检查退出标志 */
+      continue;
+    }
+
+    handle_request(server, &request, ret, &from_addr, from_len, t2_ns);
+  }
+
+  return NULL;
+}
+
+static bool bind_port(int sock, uint16_t port) {
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+  return bind(sock, (struct sockaddr *)&addr, sizeof(addr)) == 0;
+}
+
+/* 启动NTP服务器 */
+bool ntp_server_start(ntp_server_t *server, uint16_t port,
+                      const char *upstream_server, uint16_t upstream_port) {
+  if (!server) {
+    ntp_server_log(LOG_ERROR, "Invalid parameters");
+    return false;
+  }
+
+  memset(server, 0, sizeof(ntp_server_t));
+  server->socket_fd = -1;
+  server->port = port ? port : NTP_SERVER_DEFAULT_PORT;
+  server->upstream_sync_interval_ms = 60000;
+
+#ifdef _WIN32
+  if (!init_winsock()) {
+    return false;
+  }
+#endif
+
+  int sock = (int)socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (sock < 0) {
+    ntp_server_log(LOG_ERROR, "socket creation failed");
+    return false;
+  }
+
+  if (!bind_port(sock, server->port)) {
+    /* 特权端口需要root, Windows上123被时间服务占用: 退回默认端口 */
+    if (server->port >= 1024 || !bind_port(sock, NTP_SERVER_DEFAULT_PORT)) {
+      ntp_server_log(LOG_ERROR, "bind to UDP port %u failed (port in use?)",
+                     server->port);
+      close_socket(sock);
+      return false;
+    }
+    ntp_server_log(LOG_WARNING,
+                   "bind to UDP port %u failed, serving on port %u instead",
+                   server->port, NTP_SERVER_DEFAULT_PORT);
+    server->port = NTP_SERVER_DEFAULT_PORT;
+  }
+
+  /* 接收超时,便于线程退出 */
+#ifdef _WIN32
+  DWORD timeout = NTP_SERVER_RECV_TIMEOUT_MS;
+#else
+  struct timeval timeout;
+  timeout.tv_sec = NTP_SERVER_RECV_TIMEOUT_MS / 1000;
+  timeout.tv_usec = (NTP_SERVER_RECV_TIMEOUT_MS % 1000) * 1000;
+#endif
+  setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (const char *)&timeout,
+             sizeof(timeout));
+
+#if defined(__linux__) && defined(SO_TIMESTAMPNS)
+  int enable = 1;
+  server->rx_timestamps = setsockopt(sock, SOL_SOCKET, SO_TIMESTAMPNS, &enable,
+                                     sizeof(enable)) == 0;
+#endif
+
+  server->socket_fd = sock;
+
+  /* 上游时钟(可选) */
+  if (upstream_server && upstream_server[0]) {
+    server->upstream_enabled =
+        ntp_client_init(&server->upstream, upstream_server, upstream_port);
+  }
+  ntp_timestamp_from_ns(ntp_get_wallclock_ns(), &server->reference_time);
+  pthread_mutex_init(&server->clock_mutex, NULL);
+
+  server->thread_active = true;
+  if (pthread_create(&server->thread, NULL, ntp_server_thread, server) != 0) {
+    ntp_server_log(LOG_ERROR, "Failed to create server thread");
+    server->thread_active = false;
+    if (server->upstream_enabled) {
+      ntp_client_destroy(&server->upstream);
+    }
+    pthread_mutex_destroy(&server->clock_mutex);
+    close_socket(sock);
+    server->socket_fd = -1;
+    return false;
+  }
+
+  if (server->upstream_enabled &&
+      pthread_create(&server->upstream_thread, NULL, ntp_upstream_thread,
+                     server) != 0) {
+    /* 没有上游线程时继续以本机时钟提供服务 */
+    ntp_server_log(LOG_WARNING, "Failed to create upstream sync thread");
+    ntp_client_destroy(&server->upstream);
+    server->upstream_enabled = false;
+  }
+
+  return true;
+}
+
+/* 停止NTP服务器 */
+void ntp_server_stop(ntp_server_t *server) {
+  if (!server || !server->thread_active) {
+    return;
+  }
+
+  server->thread_active = false;
+  pthread_join(server->thread, NULL);
+  if (server->upstream_enabled) {
+    pthread_join(server->upstream_thread, NULL);
+  }
+  pthread_mutex_destroy(&server->clock_mutex);
+
+  if (server->socket_fd >= 0) {
+    close_socket(server->socket_fd);
+    server->socket_fd = -1;
+  }
+
+  if (server->upstream_enabled) {
+    ntp_client_destroy(&server->upstream);
+    server->upstream_enabled = false;
+  }
+
+  ntp_server_log(LOG_INFO, "NTP server stopped (served: %u, invalid: %u)",
+                 server->requests_served, server->requests_invalid);
+}
+
+/*============================================================================
+ * 进程内共享实例
+ *============================================================================*/
+
+static pthread_mutex_t shared_server_mutex = PTHREAD_MUTEX_INITIALIZER;
+static ntp_server_t shared_server;
+static long shared_server_refs = 0;
+
+bool ntp_server_acquire(uint16_t port, const char *upstream_server,
+                        uint16_t upstream_port) {
+  bool running = true;
+
+  pthread_mutex_lock(&shared_server_mutex);
+  if (shared_server_refs == 0) {
+    running = ntp_server_start(&shared_server, port, upstream_server,
+                               upstream_port);
+  } else if (port && port != shared_server.port) {
+    ntp_server_log(LOG_WARNING,
+                   "Time master already running on port %u, ignoring %u",
+                   shared_server.port, port);
+  }
+
+  if (running) {
+    shared_server_refs++;
+  }
+  pthread_mutex_unlock(&shared_server_mutex);
+
+  return running;
+}
+
+void ntp_server_release(void) {
+  pthread_mutex_lock(&shared_server_mutex);
+  if (shared_server_refs > 0 && --shared_server_refs == 0) {
+    ntp_server_stop(&shared_server);
+  }
+  pthread_mutex_unlock(&shared_server_mutex);
+}
@@ -0,0 +1,84 @@
+/******************************************************************************
+    NTP Server Module - Header File
+    Copyright (C) 2026
+
+    Minimal NTPv4 server so one OBS instance can act as LAN time master
+******************************************************************************/
+
+#pragma once
+
+#include "ntp-client.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <util/threading.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 默认监听端口: 123需要root权限(Linux)且与Windows时间服务冲突,
+ * 使用非特权端口, 其他实例的NTP端口需设为相同值 */
+#define NTP_SERVER_DEFAULT_PORT 12300
+
+/* NTP服务器上下文 */
+typedef struct ntp_server {
+  uint16_t port;               /* 监听端口 */
+  int socket_fd;               /* UDP socket文件描述符 */
+  pthread_t thread;            /* 服务线程 */
+  volatile bool thread_active; /* 线程活动标志 */
+  bool rx_timestamps;          /* 内核软件接收时间戳(SO_TIMESTAMPNS) */
+
+  /* 上游时钟(可选): 若已同步则对外提供校准后的时间,否则提供本机时钟
+   * 由独立线程同步, 上游不可达时不会阻塞应答 */
+  ntp_client_t upstream; /* 仅上游线程访问 */
+  bool upstream_enabled;
+  uint32_t upstream_sync_interval_ms;
+  pthread_t upstream_thread;
+
+  /* 上游线程发布, 服务线程读取 */
+  pthread_mutex_t clock_mutex;
+  bool disciplined;               /* 上游已同步 */
+  int64_t upstream_offset_ns;     /* 上游时钟 - fast_clock */
+  ntp_timestamp_t reference_time; /* 最后一次校准的时间 */
+
+  /* 统计 */
+  uint32_t requests_served;  /* 已应答的请求数 */
+  uint32_t requests_invalid; /* 丢弃的无效请求数 */
+} ntp_server_t;
+
+/*
+ * 启动NTP服务器
+ * 参数:
+ *   server - NTP服务器上下文
+ *   port - 监听端口(0为NTP_SERVER_DEFAULT_PORT; 特权端口绑定失败时
+ *          退回NTP_SERVER_DEFAULT_PORT)
+ *   upstream_server - 上游NTP服务器(可以为NULL或空,表示直接使用本机时钟)
+ *   upstream_port - 上游NTP服务器端口
+ * 返回:
+ *   true - 成功
+ *   false - 失败(例如端口被占用)
+ */
+bool ntp_server_start(ntp_server_t *server, uint16_t port,
+                      const char *upstream_server, uint16_t upstream_port);
+
+/*
+ * 停止NTP服务器
+ * 参数:
+ *   server - NTP服务器上下文
+ */
+void ntp_server_stop(ntp_server_t *server);
+
+/*
+ * 获取/释放进程内共享的NTP服务器(引用计数)
+ * 编码器和接收源都可以开启"局域网时间主机"模式,但同一进程只运行一个服务线程
+ * 返回:
+ *   true - 服务器正在运行
+ *   false - 启动失败
+ */
+bool ntp_server_acquire(uint16_t port, const char *upstream_server,
+                        uint16_t upstream_port);
+void ntp_server_release(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,4 +1,7 @@
 #include "nvenc-encoder.h"
+#include "packet-pool.h"
+#include "sei-handler.h"
+#include "stage-trace.h"
 #include <util/dstr.h>
 #include <util/platform.h>
 
@@ -13,81 +16,6 @@
   blog(level, "[NVENC Encoder: '%s'] " format,                                 \
        obs_encoder_get_name(enc->encoder), ##__VA_ARGS__)
 
-/* NTP SEI 构建函数 (复用自 qsv-encoder.c) */
-static bool nvenc_build_ntp_sei_payload(int64_t pts, ntp_timestamp_t *ntp_time,
-                                        uint8_t **payload, size_t *size) {
-  /* UUID: 与 QSV 编码器使用相同的 UUID */
-  const uint8_t uuid[16] = {0xa5, 0xb3, 0xc2, 0xd1, 0xe4, 0xf5, 0x67, 0x89,
-                            0xab, 0xcd, 0xef, 0x01, 0x23, 0x45, 0x67, 0x89};
-
-  *size = 16 + 8; // UUID + 64bit NTP
-  *payload = bmalloc(*size);
-  if (!*payload)
-    return false;
-
-  memcpy(*payload, uuid, 16);
-
-  /* Big Endian NTP Timestamp */
-  uint32_t ntp_sec = ntp_time->seconds;
-  uint32_t ntp_frac = ntp_time->fraction;
-
-  uint8_t *data = *payload + 16;
-  data[0] = (ntp_sec >> 24) & 0xFF;
-  data[1] = (ntp_sec >> 16) & 0xFF;
-  data[2] = (ntp_sec >> 8) & 0xFF;
-  data[3] = (ntp_sec) & 0xFF;
-  data[4] = (ntp_frac >> 24) & 0xFF;
-  data[5] = (ntp_frac >> 16) & 0xFF;
-  data[6] = (ntp_frac >> 8) & 0xFF;
-  data[7] = (ntp_frac) & 0xFF;
-
-  return true;
-}
-
-static bool nvenc_build_sei_nal_unit(uint8_t *payload, size_t payload_size,
-                                     int payload_type, uint8_t **nal_unit,
-                                     size_t *nal_size) {
-  /* 标准 H.264 SEI NAL 构建 */
-  size_t size_bytes = 1;
-  if (payload_size >= 255)
-    size_bytes += (payload_size / 255);
-
-  size_t total_size = 4 + 1 + 1 + size_bytes + payload_size + 1;
-  *nal_unit = bmalloc(total_size);
-  if (!*nal_unit)
-    return false;
-
-  uint8_t *p = *nal_unit;
-  // Start Code
-  *p++ = 0x00;
-  *p++ = 0x00;
-  *p++ = 0x00;
-  *p++ = 0x01;
-  // NAL Header (SEI=6)
-  *p++ = 0x06;
-
-  // Payload Type (User Data Unregistered = 5)
-  *p++ = 0x05;
-
-  // Payload Size
-  size_t s = payload_size;
-  while (s >= 255) {
-    *p++ = 0xFF;
-    s -= 255;
-  }
-  *p++ = (uint8_t)s;
-
-  // Payload
-  memcpy(p, payload, payload_size);
-  p += payload_size;
-
-  // Trailing bits
-  *p++ = 0x80;
-
-  *nal_size = (p - *nal_unit);
-  return true;
-}
-
 /* 销毁编码器 */
 void nvenc_encoder_destroy(nvenc_encoder_t *enc) {
   if (!enc)
@@ -101,9 +29,7 @@ void nvenc_encoder_destroy(nvenc_encoder_t *enc) {
   if (enc->frame) {
     av_frame_free(&enc->frame);
   }
-  if (enc->packet) {
-    av_packet_free(&enc->packet);
-  }
+  encoder_packet_queue_free(&enc->packet_queue);
 
   if (enc->extra_data)
     bfree(enc->extra_data);
@@ -111,8 +37,7 @@ void nvenc_encoder_destroy(nvenc_encoder_t *enc) {
     bfree(enc->profile);
   if (enc->preset)
     bfree(enc->preset);
-  if (enc->packet_buffer)
-    bfree(enc->packet_buffer);
+  packet_pool_release(enc->packet_buffer);
 
   ntp_client_destroy(&enc->ntp_client);
   bfree(enc);
@@ -217,6 +142,12 @@ void *nvenc_encoder_create_internal(obs_data_t *settings,
   /* Rate control - CBR */
   av_dict_set(&opts, "rc", "cbr", 0);
 
+  /* 时间戳SEI: 编码器支持 udu_sei 时通过帧附加数据写入,否则编码后拼接 */
+  if (obs_data_get_bool(settings, "sei_side_data") && enc->codec_type != 2)
+    enc->sei_side_data = encoder_sei_enable_side_data(enc->codec_context);
+  encoder_log(LOG_INFO, enc, "Timestamp SEI: %s",
+              enc->sei_side_data ? "frame side data" : "spliced after encode");
+
   /* 打开编码器 */
   char errbuf[128];
   int ret = avcodec_open2(enc->codec_context, enc->codec, &opts);
@@ -234,7 +165,12 @@ void *nvenc_encoder_create_internal(obs_data_t *settings,
 
   /* 分配 Frame 和 Packet */
   enc->frame = av_frame_alloc();
-  enc->packet = av_packet_alloc();
+  capture_time_ring_init(&enc->capture_times, enc->fps_den);
+  if (!encoder_packet_queue_init(&enc->packet_queue)) {
+    encoder_log(LOG_ERROR, enc, "Failed to allocate packet queue");
+    nvenc_encoder_destroy(enc);
+    return NULL;
+  }
 
   /* 提取 Extra Data */
   if (enc->codec_context->extradata_size > 0) {
@@ -263,6 +199,27 @@ bool nvenc_encoder_encode_internal(void *data, struct encoder_frame *frame,
   if (!frame || !packet || !received_packet)
     return false;
 
+  /* OBS 已在上一次 encode 返回后复制了 packet, 归还 buffer */
+  packet_pool_release(enc->packet_buffer);
+  enc->packet_buffer = NULL;
+
+  /* NTP 时间更新 */
+  uint64_t now = fast_clock_now_ns();
+  uint64_t sync_interval_ns = (uint64_t)enc->ntp_sync_interval_ms * 1000000ULL;
+  if (enc->last_ntp_sync_time == 0 ||
+      (now - enc->last_ntp_sync_time) > sync_interval_ns) {
+    /* Always update last_sync_time to avoid retry storm on failure */
+    enc->last_ntp_sync_time = now;
+    TRACE_START(trace_sync);
+    ntp_client_sync(&enc->ntp_client);
+    TRACE_STAGE(trace_sync, "nvenc", "ntp_client_sync", frame->pts);
+  }
+  ntp_client_get_time_or_local(&enc->ntp_client, &enc->current_ntp_time);
+
+  /* 记录送入时间,输出时按 PTS 取回 (B 帧 / lookahead 会打乱顺序) */
+  capture_time_ring_put(&enc->capture_times, frame->pts,
+                        &enc->current_ntp_time);
+
   /* 清理上一帧 */
   av_frame_unref(enc->frame);
 
@@ -284,8 +241,18 @@ bool nvenc_encoder_encode_internal(void *data, struct encoder_frame *frame,
     return false;
   }
 
+  /* 由编码器写入SEI: 每帧都挂上时间戳, 关键帧由编码器自己决定 */
+  if (enc->sei_side_data &&
+      !encoder_sei_attach(enc->frame, &enc->current_ntp_time))
+    encoder_log(LOG_WARNING, enc, "Failed to attach SEI side data");
+
   /* 发送 Frame */
-  int ret = avcodec_send_frame(enc->codec_context, enc->frame);
+  TRACE_START(trace_send);
+  int ret = encoder_packet_queue_send_frame(
+      &enc->packet_queue, enc->codec_context, enc->frame,
+      &enc->current_ntp_time);
+  TRACE_STAGE(trace_send, "nvenc", "encoder_packet_queue_send_frame",
+              frame->pts);
   av_frame_unref(enc->frame);
 
   if (ret < 0) {
@@ -294,57 +261,63 @@ bool nvenc_encoder_encode_internal(void *data, struct encoder_frame *frame,
     return false;
   }
 
-  /* 接收 Packet */
-  ret = avcodec_receive_packet(enc->codec_context, enc->packet);
-  if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
-    *received_packet = false;
-    return true;
-  } else if (ret < 0) {
+  /* 取出所有就绪的 Packet (多包输出 / lookahead 突发) */
+  TRACE_START(trace_drain);
+  ret = encoder_packet_queue_drain(&enc->packet_queue, enc->codec_context,
+                                   &enc->current_ntp_time);
+  TRACE_STAGE(trace_drain, "nvenc", "encoder_packet_queue_drain",
+              frame->pts);
+  if (ret < 0) {
     av_strerror(ret, errbuf, sizeof(errbuf));
     encoder_log(LOG_ERROR, enc, "Error receiving packet: %s (%d)", errbuf, ret);
     return false;
   }
 
-  *received_packet = true;
-
-  /* NTP 时间更新 */
-  uint64_t now = os_gettime_ns();
-  uint64_t sync_interval_ns = (uint64_t)enc->ntp_sync_interval_ms * 1000000ULL;
-  if (enc->last_ntp_sync_time == 0 ||
-      (now - enc->last_ntp_sync_time) > sync_interval_ns) {
-    /* Always update last_sync_time to avoid retry storm on failure */
-    enc->last_ntp_sync_time = now;
-    ntp_client_sync(&enc->ntp_client);
+  /* 每次调用按顺序输出一个 */
+  const encoder_queued_packet_t *queued =
+      encoder_packet_queue_pop(&enc->packet_queue);
+  if (!queued) {
+    *received_packet = false;
+    return true;
   }
-  ntp_client_get_time(&enc->ntp_client, &enc->current_ntp_time);
 
-  /* SEI 插入 (关键帧) */
-  bool keyframe = (enc->packet->flags & AV_PKT_FLAG_KEY) != 0;
+  const AVPacket *pkt = queued->packet;
+  *received_packet = true;
+
+  /* SEI 插入 (关键帧, AV1 不使用 SEI; 编码器已按附加数据写入时跳过) */
+  bool keyframe = (pkt->flags & AV_PKT_FLAG_KEY) != 0;
+  bool has_stamp = enc->sei_side_data &&
+                   encoder_sei_packet_has_stamp(pkt, enc->codec_type == 1);
   uint8_t *sei_nal = NULL;
   size_t sei_nal_size = 0;
 
-  if (keyframe) {
+  if (keyframe && !has_stamp && enc->codec_type != 2) {
     uint8_t *payload = NULL;
     size_t payload_size = 0;
-    if (nvenc_build_ntp_sei_payload(frame->pts, &enc->current_ntp_time,
-                                    &payload, &payload_size)) {
-      nvenc_build_sei_nal_unit(payload, payload_size, 6, &sei_nal,
-                               &sei_nal_size);
+    sei_nal_type_t nal_type =
+        (enc->codec_type == 1) ? SEI_NAL_H265_PREFIX : SEI_NAL_H264;
+    ntp_timestamp_t stamp = queued->ntp_time;
+    capture_time_ring_get(&enc->capture_times, pkt->pts, &stamp);
+    if (build_ntp_sei_payload(pkt->pts, &stamp, &payload, &payload_size)) {
+      build_sei_nal_unit(payload, payload_size, nal_type, &sei_nal,
+                         &sei_nal_size);
       bfree(payload);
 
       encoder_log(LOG_DEBUG, enc,
                   "[NVENC] Inserted SEI: PTS=%lld NTP=%u.%u Size=%zu",
-                  frame->pts, enc->current_ntp_time.seconds,
-                  enc->current_ntp_time.fraction, sei_nal_size);
+                  pkt->pts, stamp.seconds, stamp.fraction, sei_nal_size);
     }
   }
 
-  /* 组装 Packet */
-  size_t total_size = enc->packet->size + sei_nal_size;
-  if (enc->packet_buffer_size < total_size) {
-    bfree(enc->packet_buffer);
-    enc->packet_buffer = bmalloc(total_size);
-    enc->packet_buffer_size = total_size;
+  enc->packet_stamped = has_stamp || sei_nal != NULL;
+
+  /* 组装 Packet (buffer 借自共享池) */
+  size_t total_size = pkt->size + sei_nal_size;
+  enc->packet_buffer = packet_pool_acquire(total_size);
+  if (!enc->packet_buffer) {
+    encoder_log(LOG_ERROR, enc, "Failed to allocate packet buffer");
+    bfree(sei_nal);
+    return false;
   }
 
   size_t offset = 0;
@@ -353,16 +326,15 @@ bool nvenc_encoder_encode_internal(void *data, struct encoder_frame *frame,
     offset += sei_nal_size;
     bfree(sei_nal);
   }
-  memcpy(enc->packet_buffer + offset, enc->packet->data, enc->packet->size);
+  memcpy(enc->packet_buffer + offset, pkt->data, pkt->size);
 
   packet->data = enc->packet_buffer;
   packet->size = total_size;
   packet->type = OBS_ENCODER_VIDEO;
-  packet->pts = enc->packet->pts;
-  packet->dts = enc->packet->dts;
+  packet->pts = pkt->pts;
+  packet->dts = pkt->dts;
   packet->keyframe = keyframe;
 
-  av_packet_unref(enc->packet);
   return true;
 }
 
@@ -375,6 +347,7 @@ static void nvenc_get_defaults(obs_data_t *settings) {
   obs_data_set_default_string(settings, "profile", "high");
   obs_data_set_default_string(settings, "ntp_server", "time.windows.com");
   obs_data_set_default_int(settings, "ntp_sync_interval", 60000); // 60 秒
+  obs_data_set_default_bool(settings, "sei_side_data", true);
 }
 
 /* 属性 */
@@ -397,6 +370,8 @@ static obs_properties_t *nvenc_properties(void *unused) {
   obs_property_list_add_string(list, "P7 (Slowest)", "p7");
 
   obs_properties_add_text(props, "profile", "Profile", OBS_TEXT_DEFAULT);
+  obs_properties_add_bool(props, "sei_side_data",
+                          "Let Encoder Write Timestamp SEI");
   obs_properties_add_text(props, "ntp_server", "NTP Server", OBS_TEXT_DEFAULT);
   obs_properties_add_int(props, "ntp_sync_interval", "NTP Sync Interval (ms)",
                          1000, 600000, 1000); // 1秒 到 10分钟
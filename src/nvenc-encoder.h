@@ -5,6 +5,9 @@
 
 #ifdef ENABLE_NVENC
 
+#include "capture-time-ring.h"
+#include "encoder-packet-queue.h"
+#include "encoder-sei.h"
 #include "ntp-client.h"
 #include <libavcodec/avcodec.h>
 #include <libavutil/opt.h>
@@ -16,7 +19,7 @@ typedef struct nvenc_encoder {
   const AVCodec *codec;
   AVCodecContext *codec_context;
   AVFrame *frame;
-  AVPacket *packet;
+  encoder_packet_queue_t packet_queue; /* 已取出、尚未输出的 Packet */
 
   /* 配置 */
   int width;
@@ -38,15 +41,19 @@ typedef struct nvenc_encoder {
   size_t extra_data_size;
 
   /* NTP 同步 */
-  struct ntp_client ntp_client;
+  ntp_client_t ntp_client;
   uint64_t last_ntp_sync_time;
   ntp_timestamp_t current_ntp_time;
   bool ntp_enabled;
   uint32_t ntp_sync_interval_ms; /* NTP同步间隔（毫秒） */
+  capture_time_ring_t capture_times; /* PTS -> 送入编码器时的NTP时间 */
+
+  /* 时间戳SEI由编码器写入(udu_sei) */
+  bool sei_side_data;
 
   /* Packet 缓冲区 */
-  uint8_t *packet_buffer;    // 临时packet缓冲区
-  size_t packet_buffer_size; // packet缓冲区大小
+  uint8_t *packet_buffer;    // 交给OBS的数据,下次encode时归还到池
+  bool packet_stamped;       // 交给OBS的Packet带有时间戳SEI(统计用)
 } nvenc_encoder_t;
 
 /* Public API functions for unified encoder */
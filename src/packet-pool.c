@@ -0,0 +1,127 @@
+/******************************************************************************
+    Packet Buffer Pool - Implementation
+    Copyright (C) 2026
+
+    Size-class buffer pool shared by all encoder backends for the packet data
+    handed to OBS, so long streams run without per-frame allocation
+******************************************************************************/
+
+#include "packet-pool.h"
+#include <obs-module.h>
+#include <util/bmem.h>
+#include <util/threading.h>
+
+/* 每个buffer前的头部(保持数据按32字节对齐) */
+#define PACKET_POOL_HEADER_SIZE 32
+
+typedef struct pool_header {
+  size_t capacity;
+  int size_class; /* -1: 超出最大档位,不缓存 */
+} pool_header_t;
+
+typedef struct pool_class {
+  pool_header_t *free_list[PACKET_POOL_CACHE_PER_CLASS];
+  size_t count;
+} pool_class_t;
+
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pool_class_t pool_classes[PACKET_POOL_CLASSES];
+static packet_pool_stats_t pool_stats;
+
+static int size_class_of(size_t size) {
+  for (int shift = PACKET_POOL_MIN_SHIFT; shift <= PACKET_POOL_MAX_SHIFT;
+       shift++) {
+    if (size <= ((size_t)1 << shift))
+      return shift - PACKET_POOL_MIN_SHIFT;
+  }
+  return -1;
+}
+
+static inline uint8_t *data_of(pool_header_t *header) {
+  return (uint8_t *)header + PACKET_POOL_HEADER_SIZE;
+}
+
+static inline pool_header_t *header_of(uint8_t *data) {
+  return (pool_header_t *)(data - PACKET_POOL_HEADER_SIZE);
+}
+
+uint8_t *packet_pool_acquire(size_t size) {
+  int size_class = size_class_of(size);
+  pool_header_t *header = NULL;
+
+  pthread_mutex_lock(&pool_mutex);
+
+  if (size_class >= 0 && pool_classes[size_class].count > 0) {
+    pool_class_t *cls = &pool_classes[size_class];
+    header = cls->free_list[--cls->count];
+    pool_stats.cached_bytes -= header->capacity;
+    pool_stats.reuses++;
+  } else {
+    size_t capacity = size_class >= 0
+                          ? (size_t)1 << (size_class + PACKET_POOL_MIN_SHIFT)
+                          : size;
+    header = bmalloc(PACKET_POOL_HEADER_SIZE + capacity);
+    if (!header) {
+      pthread_mutex_unlock(&pool_mutex);
+      return NULL;
+    }
+    header->capacity = capacity;
+    header->size_class = size_class;
+    pool_stats.allocations++;
+  }
+
+  pool_stats.outstanding_bytes += header->capacity;
+  pool_stats.outstanding_buffers++;
+  if (pool_stats.outstanding_bytes > pool_stats.high_water_bytes)
+    pool_stats.high_water_bytes = pool_stats.outstanding_bytes;
+
+  pthread_mutex_unlock(&pool_mutex);
+  return data_of(header);
+}
+
+void packet_pool_release(uint8_t *data) {
+  if (!data)
+    return;
+
+  pool_header_t *header = header_of(data);
+
+  pthread_mutex_lock(&pool_mutex);
+
+  pool_stats.outstanding_bytes -= header->capacity;
+  pool_stats.outstanding_buffers--;
+
+  if (header->size_class >= 0 &&
+      pool_classes[header->size_class].count < PACKET_POOL_CACHE_PER_CLASS) {
+    pool_class_t *cls = &pool_classes[header->size_class];
+    cls->free_list[cls->count++] = header;
+    pool_stats.cached_bytes += header->capacity;
+    header = NULL;
+  }
+
+  pthread_mutex_unlock(&pool_mutex);
+
+  /* 池已满或超大buffer: 直接释放 */
+  bfree(header);
+}
+
+void packet_pool_trim(void) {
+  pthread_mutex_lock(&pool_mutex);
+
+  for (int i = 0; i < PACKET_POOL_CLASSES; i++) {
+    pool_class_t *cls = &pool_classes[i];
+    while (cls->count > 0)
+      bfree(cls->free_list[--cls->count]);
+  }
+  pool_stats.cached_bytes = 0;
+
+  pthread_mutex_unlock(&pool_mutex);
+}
+
+void packet_pool_get_stats(packet_pool_stats_t *stats) {
+  if (!stats)
+    return;
+
+  pthread_mutex_lock(&pool_mutex);
+  *stats = pool_stats;
+  pthread_mutex_unlock(&pool_mutex);
+}
@@ -0,0 +1,62 @@
+/******************************************************************************
+    Packet Buffer Pool - Header File
+    Copyright (C) 2026
+
+    Size-class buffer pool shared by all encoder backends for the packet data
+    handed to OBS, so long streams run without per-frame allocation
+******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 尺寸档位: 16KiB, 32KiB, ... 64MiB (2的幂); 更大的请求直接分配,不缓存 */
+#define PACKET_POOL_MIN_SHIFT 14
+#define PACKET_POOL_MAX_SHIFT 26
+#define PACKET_POOL_CLASSES (PACKET_POOL_MAX_SHIFT - PACKET_POOL_MIN_SHIFT + 1)
+
+/* 每个档位最多缓存的空闲buffer数 */
+#define PACKET_POOL_CACHE_PER_CLASS 4
+
+/* 统计信息 */
+typedef struct packet_pool_stats {
+  size_t outstanding_bytes;   /* 已借出(OBS尚未消费完)的容量 */
+  size_t outstanding_buffers; /* 已借出的buffer数 */
+  size_t high_water_bytes;    /* outstanding_bytes 的峰值 */
+  size_t cached_bytes;        /* 池中空闲buffer的容量 */
+  uint64_t allocations;       /* 实际分配次数 */
+  uint64_t reuses;            /* 从池中复用的次数 */
+} packet_pool_stats_t;
+
+/*
+ * 借出一个至少 size 字节的buffer
+ * 返回:
+ *   buffer指针, 失败返回NULL
+ */
+uint8_t *packet_pool_acquire(size_t size);
+
+/*
+ * 归还buffer(可以为NULL)
+ * 交给OBS的packet数据在下一次encode调用前有效,因此在下一次encode或销毁时归还
+ */
+void packet_pool_release(uint8_t *data);
+
+/*
+ * 释放池中所有空闲buffer(模块卸载时调用)
+ */
+void packet_pool_trim(void);
+
+/*
+ * 获取统计信息
+ */
+void packet_pool_get_stats(packet_pool_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,52 @@
+/******************************************************************************
+    PTS Timeline - Header File
+    Copyright (C) 2026
+
+    Unwraps stream PTS (33-bit in MPEG-TS) with the stream's real time base
+    and fits PTS against the sender's NTP stamps, so frames without a stamp
+    still get a smooth display time. The estimator is implemented in
+    libseistamp.
+******************************************************************************/
+
+#pragma once
+
+#include <seistamp.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef seistamp_pts_unwrap_t pts_unwrap_t;
+typedef seistamp_pts_timeline_t pts_timeline_t;
+
+static inline void pts_unwrap_init(pts_unwrap_t *unwrap, int wrap_bits,
+                                   int32_t time_base_num,
+                                   int32_t time_base_den) {
+  seistamp_pts_unwrap_init(unwrap, wrap_bits, time_base_num, time_base_den);
+}
+
+static inline int64_t pts_unwrap_ns(pts_unwrap_t *unwrap, int64_t pts) {
+  return seistamp_pts_unwrap_ns(unwrap, pts);
+}
+
+static inline void pts_timeline_init(pts_timeline_t *timeline) {
+  seistamp_pts_timeline_init(timeline);
+}
+
+static inline void pts_timeline_add_sample(pts_timeline_t *timeline,
+                                           int64_t pts_ns, uint64_t ntp_ns) {
+  seistamp_pts_timeline_add_sample(timeline, pts_ns, ntp_ns);
+}
+
+static inline bool pts_timeline_to_ntp(const pts_timeline_t *timeline,
+                                       int64_t pts_ns, uint64_t *ntp_out) {
+  return seistamp_pts_timeline_to_ntp(timeline, pts_ns, ntp_out);
+}
+
+static inline double pts_timeline_rate_ppm(const pts_timeline_t *timeline) {
+  return seistamp_pts_timeline_rate_ppm(timeline);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,12 +1,10 @@
 #include "qsv-encoder.h"
-#include "sei-stamper-encoder.h" /* For NAL unit helpers if we move them, or redefine */
+#include "packet-pool.h"
+#include "sei-handler.h"
+#include "stage-trace.h"
 #include <util/dstr.h>
 #include <util/platform.h>
 
-// Re-implementing simplified SEI helpers valid for this module to avoid linking
-// issues or we can expose them from sei-stamper-encoder.h if we modify it. For
-// safety, providing local versions.
-
 #ifdef ENABLE_VPL
 
 #include <stdio.h>
@@ -16,97 +14,6 @@
 #define ALIGN16(value) (((value + 15) >> 4) << 4)
 #define ALIGN32(value) (((value + 31) >> 5) << 5)
 
-/* NTP Helpers (Copied/Adapted) */
-static bool qsv_build_ntp_sei_payload(int64_t pts, ntp_timestamp_t *ntp_time,
-                                      uint8_t **payload, size_t *size) {
-  /* UUID: 2f2f2f53-4549-2f2f-2f53-45492f2f2f53 (Example user data unregistered)
-   */
-  /* Using generic UUID for our stamper (Matches sei-handler.c) */
-  const uint8_t uuid[16] = {0xa5, 0xb3, 0xc2, 0xd1, 0xe4, 0xf5, 0x67, 0x89,
-                            0xab, 0xcd, 0xef, 0x01, 0x23, 0x45, 0x67, 0x89};
-
-  *size = 16 + 8; // UUID + 64bit NTP
-  *payload = bmalloc(*size);
-  if (!*payload)
-    return false;
-
-  memcpy(*payload, uuid, 16);
-
-  /* Big Endian NTP Timestamp from struct */
-  uint32_t ntp_sec = ntp_time->seconds;
-  uint32_t ntp_frac = ntp_time->fraction;
-
-  uint8_t *data = *payload + 16;
-  data[0] = (ntp_sec >> 24) & 0xFF;
-  data[1] = (ntp_sec >> 16) & 0xFF;
-  data[2] = (ntp_sec >> 8) & 0xFF;
-  data[3] = (ntp_sec) & 0xFF;
-  data[4] = (ntp_frac >> 24) & 0xFF;
-  data[5] = (ntp_frac >> 16) & 0xFF;
-  data[6] = (ntp_frac >> 8) & 0xFF;
-  data[7] = (ntp_frac) & 0xFF;
-
-  return true;
-}
-
-static bool qsv_build_sei_nal_unit(uint8_t *payload, size_t payload_size,
-                                   int payload_type, uint8_t **nal_unit,
-                                   size_t *nal_size) {
-  /* Standard H.264 SEI NAL construction */
-  /* Start Code (00 00 00 01) + NAL Header (SEI=6) */
-  /* Payload Type + Payload Size + Payload + Trailing Bits */
-
-  // Simplified RBSP handling (no emulation prevention for simplicity, though
-  // required for robust) For fixed UUIDs and Timestamps it's usually fine, but
-  // let's be careful.
-  size_t rbsp_size = 0;
-
-  // Payload Type
-  uint8_t type_byte = 5; // User Data Unregistered
-  // Payload Size
-  // If size < 255.
-
-  size_t size_bytes = 1;
-  if (payload_size >= 255)
-    size_bytes += (payload_size / 255);
-
-  size_t total_size =
-      4 + 1 + 1 + size_bytes + payload_size + 1; // +1 for trailing
-  *nal_unit = bmalloc(total_size);
-  if (!*nal_unit)
-    return false;
-
-  uint8_t *p = *nal_unit;
-  // Start Code
-  *p++ = 0x00;
-  *p++ = 0x00;
-  *p++ = 0x00;
-  *p++ = 0x01;
-  // NAL Header (Forbidden=0, RefIdc=0, Type=SEI(6))
-  *p++ = 0x06;
-
-  // Payload Type (User Data Unregistered = 5)
-  *p++ = 0x05;
-
-  // Payload Size
-  size_t s = payload_size;
-  while (s >= 255) {
-    *p++ = 0xFF;
-    s -= 255;
-  }
-  *p++ = (uint8_t)s;
-
-  // Payload
-  memcpy(p, payload, payload_size);
-  p += payload_size;
-
-  // Trailing bits (rbsp_trailing_bits) -> 1 followed by 0s to byte align
-  *p++ = 0x80;
-
-  *nal_size = (p - *nal_unit);
-  return true;
-}
-
 /* ------------------------------------------------------------------------- */
 
 void qsv_encoder_destroy(qsv_encoder_t *enc) {
@@ -131,6 +38,7 @@ void qsv_encoder_destroy(qsv_encoder_t *enc) {
     bfree(enc->profile);
   if (enc->preset)
     bfree(enc->preset);
+  packet_pool_release(enc->packet_buffer);
 
   ntp_client_destroy(&enc->ntp_client);
   bfree(enc);
@@ -206,6 +114,7 @@ void *qsv_encoder_create_internal(obs_data_t *settings,
       (uint32_t)obs_data_get_int(settings, "ntp_sync_interval");
   if (enc->ntp_sync_interval_ms == 0)
     enc->ntp_sync_interval_ms = 60000; // 默认 60 秒
+  capture_time_ring_init(&enc->capture_times, enc->fps_den);
 
   if (!init_vpl_session(enc)) {
     qsv_encoder_destroy(enc);
@@ -395,6 +304,27 @@ bool qsv_encoder_encode_internal(void *data, struct encoder_frame *frame,
                                  bool *received_packet) {
   qsv_encoder_t *enc = data;
 
+  /* OBS has copied the previous packet by now; return its buffer */
+  packet_pool_release(enc->packet_buffer);
+  enc->packet_buffer = NULL;
+
+  /* NTP Time Update */
+  uint64_t now = fast_clock_now_ns();
+  uint64_t sync_interval_ns = (uint64_t)enc->ntp_sync_interval_ms * 1000000ULL;
+  if (enc->last_ntp_sync_time == 0 ||
+      (now - enc->last_ntp_sync_time) > sync_interval_ns) {
+    /* Always update last_sync_time to avoid retry storm on failure */
+    enc->last_ntp_sync_time = now;
+    TRACE_START(trace_sync);
+    ntp_client_sync(&enc->ntp_client);
+    TRACE_STAGE(trace_sync, "qsv", "ntp_client_sync", frame->pts);
+  }
+  ntp_client_get_time_or_local(&enc->ntp_client, &enc->current_ntp_time);
+
+  /* Remember when this frame entered the encoder; looked up by output PTS */
+  capture_time_ring_put(&enc->capture_times, frame->pts,
+                        &enc->current_ntp_time);
+
   /* Find Free Surface */
   int nIndex = -1;
   for (int i = 0; i < enc->nSurfNum; i++) {
@@ -434,6 +364,7 @@ bool qsv_encoder_encode_internal(void *data, struct encoder_frame *frame,
   }
 
   // Y Plane
+  TRACE_START(trace_upload);
   for (int i = 0; i < enc->height; i++) { // Use input height
     memcpy(pSurface->Data.Y + i * pSurface->Data.Pitch,
            frame->data[0] + i * frame->linesize[0], enc->width);
@@ -448,16 +379,17 @@ bool qsv_encoder_encode_internal(void *data, struct encoder_frame *frame,
     // NV12 expects UV. If missing, log?
     // blog(LOG_WARNING, "UV data missing?");
   }
+  TRACE_STAGE(trace_upload, "qsv", "surface_upload", frame->pts);
 
-  pSurface->Data.TimeStamp =
-      (mfxU64)frame->pts * 90000 / 1000000; // Rescale? OBS is ns?
-  // OBS PTS is ns? No, obs_encoder_frame pts is usually relative to start.
-  // Let's assume passed frame->pts needs conversion to 90kHz if MFX expects it.
-  // Actually MFX timestamp is arbitrary ticks roughly 90kHz usually.
+  /* Pass the OBS PTS through unchanged: the bitstream carries it back out in
+   * output order, which is what the capture-time lookup is keyed on */
+  pSurface->Data.TimeStamp = (mfxU64)frame->pts;
 
   mfxSyncPoint syncp;
+  TRACE_START(trace_encode);
   mfxStatus sts = MFXVideoENCODE_EncodeFrameAsync(enc->session, NULL, pSurface,
                                                   &enc->mfxBS, &syncp);
+  TRACE_STAGE(trace_encode, "qsv", "EncodeFrameAsync", frame->pts);
 
   if (sts > MFX_ERR_NONE && enc->mfxBS.DataLength > 0) {
     // Ignore warnings
@@ -473,7 +405,9 @@ bool qsv_encoder_encode_internal(void *data, struct encoder_frame *frame,
     return false;
   }
 
+  TRACE_START(trace_wait);
   sts = MFXVideoCORE_SyncOperation(enc->session, syncp, 60000);
+  TRACE_STAGE(trace_wait, "qsv", "SyncOperation", frame->pts);
   if (sts != MFX_ERR_NONE) {
     blog(LOG_ERROR, "[QSV Native] Sync failed: %d", sts);
     return false;
@@ -482,45 +416,49 @@ bool qsv_encoder_encode_internal(void *data, struct encoder_frame *frame,
   /* Packet Ready */
   *received_packet = true;
 
-  /* NTP Time Update */
-  uint64_t now = os_gettime_ns();
-  uint64_t sync_interval_ns = (uint64_t)enc->ntp_sync_interval_ms * 1000000ULL;
-  if (enc->last_ntp_sync_time == 0 ||
-      (now - enc->last_ntp_sync_time) > sync_interval_ns) {
-    /* Always update last_sync_time to avoid retry storm on failure */
-    enc->last_ntp_sync_time = now;
-    ntp_client_sync(&enc->ntp_client);
-  }
-  ntp_client_get_time(&enc->ntp_client, &enc->current_ntp_time);
-
   /* SEI Insertion */
   // Check if IDR/I frame to insert SEI.
   // MFXBS FrameType check.
   bool keyframe = (enc->mfxBS.FrameType & MFX_FRAMETYPE_I) ||
                   (enc->mfxBS.FrameType & MFX_FRAMETYPE_IDR);
 
+  /* With B-frames the output is not the frame just submitted */
+  int64_t out_pts = (int64_t)enc->mfxBS.TimeStamp;
+
   uint8_t *sei_nal = NULL;
   size_t sei_nal_size = 0;
 
-  if (keyframe) {
+  if (keyframe && enc->codec_type != 2) {
     uint8_t *payload = NULL;
     size_t payload_size = 0;
-    if (qsv_build_ntp_sei_payload(frame->pts, &enc->current_ntp_time, &payload,
-                                  &payload_size)) {
-      qsv_build_sei_nal_unit(payload, payload_size, 6, &sei_nal, &sei_nal_size);
+    ntp_timestamp_t stamp = enc->current_ntp_time;
+    capture_time_ring_get(&enc->capture_times, out_pts, &stamp);
+    sei_nal_type_t nal_type =
+        (enc->codec_type == 1) ? SEI_NAL_H265_PREFIX : SEI_NAL_H264;
+    if (build_ntp_sei_payload(out_pts, &stamp, &payload, &payload_size)) {
+      build_sei_nal_unit(payload, payload_size, nal_type, &sei_nal,
+                         &sei_nal_size);
       bfree(payload);
 
       blog(LOG_DEBUG, "[QSV Native] Inserted SEI: PTS=%lld NTP=%u.%u Size=%zu",
-           frame->pts, enc->current_ntp_time.seconds,
-           enc->current_ntp_time.fraction, sei_nal_size);
+           out_pts, stamp.seconds, stamp.fraction, sei_nal_size);
     } else {
       blog(LOG_WARNING, "[QSV Native] Failed to build NTP SEI payload");
     }
   }
+  enc->packet_stamped = sei_nal != NULL;
 
   /* Copy to OBS packet */
   size_t total_size = enc->mfxBS.DataLength + sei_nal_size;
-  packet->data = bmalloc(total_size);
+  enc->packet_buffer = packet_pool_acquire(total_size);
+  if (!enc->packet_buffer) {
+    blog(LOG_ERROR, "[QSV Native] Failed to allocate packet buffer");
+    bfree(sei_nal);
+    enc->mfxBS.DataLength = 0;
+    enc->mfxBS.DataOffset = 0;
+    return false;
+  }
+  packet->data = enc->packet_buffer;
 
   size_t offset = 0;
   if (sei_nal) {
@@ -533,8 +471,8 @@ bool qsv_encoder_encode_internal(void *data, struct encoder_frame *frame,
 
   packet->size = total_size;
   packet->type = OBS_ENCODER_VIDEO;
-  packet->pts = frame->pts;
-  packet->dts = frame->pts; // Approximate
+  packet->pts = out_pts;
+  packet->dts = out_pts; // Approximate
   packet->keyframe = keyframe;
 
   /* Reset BS */
@@ -9,6 +9,7 @@
 #include <vpl/mfxdispatcher.h>
 #include <vpl/mfxvideo.h>
 
+#include "capture-time-ring.h"
 #include "ntp-client.h"
 
 typedef struct qsv_encoder {
@@ -40,6 +41,8 @@ typedef struct qsv_encoder {
   /* Bitstream Buffer */
   mfxBitstream mfxBS;
   uint8_t *bs_buffer;
+  uint8_t *packet_buffer; /* Leased from packet pool until next encode */
+  bool packet_stamped;    /* Packet handed to OBS carries a timestamp SEI */
 
   /* VPL Params */
   mfxVideoParam mfxParams;
@@ -49,11 +52,12 @@ typedef struct qsv_encoder {
   size_t extra_data_size;
 
   /* NTP Synchronization */
-  struct ntp_client ntp_client;     // NTP客户端
+  ntp_client_t ntp_client;     // NTP客户端
   uint64_t last_ntp_sync_time;      // 上次NTP同步时间
   ntp_timestamp_t current_ntp_time; // 当前编码帧的NTP时间戳
   bool ntp_enabled;                 // NTP是否启用
   uint32_t ntp_sync_interval_ms;    /* NTP同步间隔（毫秒）*/
+  capture_time_ring_t capture_times; /* PTS -> 送入编码器时的NTP时间 */
 
 } qsv_encoder_t;
 
@@ -3,23 +3,24 @@
     Copyright (C) 2026
 
     Handles SEI (Supplemental Enhancement Information) construction and parsing
-    for NTP timestamp embedding in H.264/H.265 video streams
+    for NTP timestamp embedding in H.264/H.265 video streams. The bitstream
+    work is done by libseistamp; these wrappers allocate with bmalloc.
 ******************************************************************************/
 
 #pragma once
 
 #include "ntp-client.h"
+#include <seistamp.h>
 #include <stdbool.h>
 #include <stdint.h>
 
-
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 /* UUID for our custom SEI (用于识别我们的自定义SEI) */
 /* 格式: a5b3c2d1-e4f5-6789-abcd-ef0123456789 */
-extern const uint8_t SEI_STAMPER_UUID[16];
+#define SEI_STAMPER_UUID SEISTAMP_UUID
 
 /* NTP时间戳SEI数据结构 */
 typedef struct ntp_sei_data {
@@ -30,13 +31,26 @@ typedef struct ntp_sei_data {
 
 /* SEI NAL单元类型 */
 typedef enum sei_nal_type {
-  SEI_NAL_H264 = 6,         /* H.264 SEI NAL单元类型 */
-  SEI_NAL_H265_PREFIX = 39, /* H.265 PREFIX_SEI_NUT */
-  SEI_NAL_H265_SUFFIX = 40  /* H.265 SUFFIX_SEI_NUT */
+  SEI_NAL_H264 = SEISTAMP_NAL_H264_SEI,                /* H.264 SEI */
+  SEI_NAL_H265_PREFIX = SEISTAMP_NAL_H265_PREFIX_SEI, /* PREFIX_SEI_NUT */
+  SEI_NAL_H265_SUFFIX = SEISTAMP_NAL_H265_SUFFIX_SEI  /* SUFFIX_SEI_NUT */
 } sei_nal_type_t;
 
 /* SEI payload类型 */
-#define SEI_TYPE_USER_DATA_UNREGISTERED 5
+#define SEI_TYPE_USER_DATA_UNREGISTERED SEISTAMP_SEI_USER_DATA_UNREGISTERED
+
+/* NTP时间戳payload大小: UUID(16) + PTS(8) + NTP(8) */
+#define NTP_SEI_PAYLOAD_SIZE SEISTAMP_PAYLOAD_SIZE
+
+/*
+ * 将NTP时间戳SEI payload写入调用者提供的缓冲区
+ * 参数:
+ *   payload - 输出缓冲区(至少 NTP_SEI_PAYLOAD_SIZE 字节)
+ *   pts - 当前帧的PTS
+ *   ntp_time - NTP时间戳
+ */
+void write_ntp_sei_payload(uint8_t *payload, int64_t pts,
+                           const ntp_timestamp_t *ntp_time);
 
 /*
  * 构建NTP时间戳SEI payload
@@ -53,7 +67,7 @@ bool build_ntp_sei_payload(int64_t pts, const ntp_timestamp_t *ntp_time,
                            uint8_t **payload_out, size_t *payload_size);
 
 /*
- * 构建完整的SEI NAL单元(包含起始码)
+ * 构建完整的SEI NAL单元(包含起始码和防竞争字节)
  * 参数:
  *   payload - SEI payload数据
  *   payload_size - payload大小
@@ -6,8 +6,13 @@
 ******************************************************************************/
 
 #include "sei-receiver-source.h"
+#include "metrics-server.h"
+#include "ntp-server.h"
+#include "stage-trace.h"
 #include <media-io/video-io.h>
 #include <obs-module.h>
+#include <limits.h>
+#include <stdlib.h>
 #include <util/platform.h>
 #include <util/threading.h>
 
@@ -18,13 +23,6 @@
 #include <libavutil/imgutils.h>
 #include <libswscale/swscale.h>
 
-/* SRT Headers */
-#ifdef _WIN32
-#include <srt/srt.h>
-#else
-#include <srt.h>
-#endif
-
 /* 日志宏 */
 #define receiver_log(level, src, format, ...)                                  \
   blog(level, "[SEI Receiver: '%s'] " format,                                  \
@@ -33,6 +31,19 @@
 /* SRT接收缓冲区大小 */
 #define SRT_BUFFER_SIZE (1024 * 1024) /* 1MB */
 
+/* SRT默认接收延迟(TSBPD),单位微秒 */
+#define SRT_DEFAULT_LATENCY_US 120000
+
+/* 快速启动的探测量: 只需读到TS节目表(PAT/PMT, 通常每100ms一次) */
+#define FAST_START_PROBESIZE "262144"
+/* FFmpeg默认探测量, 完整探测时使用 */
+#define DEFAULT_PROBESIZE 5000000
+/* 等待关键帧的上限(包数), 容器不标记关键帧时不会一直丢包 */
+#define KEYFRAME_WAIT_LIMIT 300
+
+/* 迟到帧警告的最小间隔 */
+#define LATE_WARNING_INTERVAL_NS 10000000000ULL
+
 /*============================================================================
  * 帧缓冲区管理
  *============================================================================*/
@@ -158,31 +169,54 @@ size_t frame_buffer_size(frame_buffer_t *buffer) {
 static enum AVPixelFormat get_hw_format(AVCodecContext *ctx,
                                         const enum AVPixelFormat *pix_fmts);
 
-/* 更新实时统计信息 */
+/* 更新实时统计信息 (接收线程, 结果以原子值发布) */
 static void update_statistics(sei_receiver_source_t *source) {
-  uint64_t current_time = os_gettime_ns();
+  uint64_t current_time = fast_clock_now_ns();
 
   /* 每秒更新一次统计 */
   if (source->last_stats_update_time == 0 ||
       (current_time - source->last_stats_update_time) >= 1000000000ULL) {
+    long rendered = live_stat_get(&source->frames_rendered);
 
     if (source->last_stats_update_time > 0) {
       /* 计算帧率 */
-      uint64_t frames_in_period =
-          source->frames_rendered - source->stats_frame_count;
+      long frames_in_period = rendered - source->stats_frame_count;
       double time_elapsed =
           (current_time - source->last_stats_update_time) / 1000000000.0;
-      source->current_fps = (float)(frames_in_period / time_elapsed);
+      live_stat_set(&source->fps_centi,
+                    (long)(frames_in_period * 100.0 / time_elapsed));
 
       /* 计算SEI检测率 */
-      if (source->frames_rendered > 0) {
-        source->sei_detection_rate =
-            (float)(source->sei_found_count * 100.0 / source->frames_rendered);
+      if (rendered > 0) {
+        live_stat_set(&source->sei_rate_centi,
+                      (long)(live_stat_get(&source->sei_found_count) *
+                             10000.0 / rendered));
+      }
+    }
+
+    /* NTP偏移 (链路模式的偏移含两种时钟的纪元差, 没有可读的意义) */
+    int64_t offset_us = 0;
+    if (source->ntp_enabled && !source->link_sync_enabled &&
+        source->ntp_client.is_synced) {
+      int64_t offset_ns = ntp_client_get_offset(&source->ntp_client);
+      if (source->has_ntp_offset && offset_ns != source->last_ntp_offset_ns) {
+        source->ntp_jitter_ns = live_jitter_update(
+            source->ntp_jitter_ns, offset_ns - source->last_ntp_offset_ns);
+        live_stat_set(&source->ntp_jitter_us,
+                      (long)(source->ntp_jitter_ns / 1000));
       }
+      source->has_ntp_offset = true;
+      source->last_ntp_offset_ns = offset_ns;
+      offset_us = offset_ns / 1000;
     }
+    if (offset_us > LONG_MAX)
+      offset_us = LONG_MAX;
+    else if (offset_us < LONG_MIN)
+      offset_us = LONG_MIN;
+    live_stat_set(&source->ntp_offset_us, (long)offset_us);
 
     source->last_stats_update_time = current_time;
-    source->stats_frame_count = source->frames_rendered;
+    source->stats_frame_count = rendered;
   }
 }
 
@@ -209,6 +243,7 @@ static bool reset_decoder(sei_receiver_source_t *source) {
 
     AVCodecContext *cctx = avcodec_alloc_context3(codec);
     avcodec_parameters_to_context(cctx, vstream->codecpar);
+    cctx->flags |= AV_CODEC_FLAG_COPY_OPAQUE;
 
     /* 重新配置硬件解码 */
     if (source->hw_decode_enabled && source->hw_device_ctx) {
@@ -293,6 +328,43 @@ static bool init_hw_device(sei_receiver_source_t *source) {
  * 视频解码和SEI提取
  *============================================================================*/
 
+/* 接收线程的阶段追踪, 以已接收的视频帧数作为帧序号 */
+#define TRACE_RECEIVE(var, source, stage)                                      \
+  TRACE_STAGE(var, "receive", stage, live_stat_get(&(source)->frames_received))
+
+/* 无时间戳的帧按PTS从上一个带时间戳的帧推算采集时间, 最多推算10秒 */
+#define CAPTURE_EXTRAPOLATE_MAX_NS 10000000000LL
+
+/*
+ * 帧在发送端的采集时间(本地时钟), 用于端到端延迟
+ * 只在NTP模式且已同步时有效: 链路模式的时钟偏移本身由到达时间估计,
+ * 算出的延迟恒为约定的传输延迟, 没有意义
+ */
+static bool frame_capture_time(sei_receiver_source_t *source,
+                               const video_frame_data_t *frame, int64_t pts_ns,
+                               bool has_pts, int64_t *capture_ns) {
+  if (!source->ntp_enabled || source->link_sync_enabled ||
+      !source->ntp_client.is_synced)
+    return false;
+
+  if (frame->has_ntp) {
+    *capture_ns = (int64_t)ntp_timestamp_to_ns(&frame->ntp_time) -
+                  ntp_client_get_offset(&source->ntp_client);
+    source->has_capture_anchor = has_pts;
+    source->capture_anchor_ns = *capture_ns;
+    source->capture_anchor_pts = pts_ns;
+    return true;
+  }
+
+  if (!source->has_capture_anchor || !has_pts)
+    return false;
+  int64_t delta = pts_ns - source->capture_anchor_pts;
+  if (delta < 0 || delta > CAPTURE_EXTRAPOLATE_MAX_NS)
+    return false;
+  *capture_ns = source->capture_anchor_ns + delta;
+  return true;
+}
+
 /* 解码并提取SEI */
 bool decode_and_extract_sei(sei_receiver_source_t *source, AVPacket *packet,
                             video_frame_data_t *frame_out) {
@@ -305,8 +377,15 @@ bool decode_and_extract_sei(sei_receiver_source_t *source, AVPacket *packet,
     return false;
   }
 
+  /* 解码器有延迟(帧线程/重排)时输出的帧不属于当前数据包,
+   * 把到达时间放在opaque中随帧带出 (AV_CODEC_FLAG_COPY_OPAQUE);
+   * OBS只支持64位平台, 指针足以容纳纳秒时间 */
+  packet->opaque = (void *)(uintptr_t)source->packet_arrival_time;
+
   /* 发送数据包到解码器 */
+  uint64_t decode_start = fast_clock_now_ns();
   int ret = avcodec_send_packet(codec_ctx, packet);
+  TRACE_RECEIVE(decode_start, source, "avcodec_send_packet");
   if (ret < 0) {
     receiver_log(LOG_ERROR, source, "Failed to send packet to decoder: %d",
                  ret);
@@ -319,19 +398,27 @@ bool decode_and_extract_sei(sei_receiver_source_t *source, AVPacket *packet,
     return false;
   }
 
+  TRACE_START(trace_receive);
   ret = avcodec_receive_frame(codec_ctx, av_frame);
+  TRACE_RECEIVE(trace_receive, source, "avcodec_receive_frame");
   if (ret < 0) {
     av_frame_free(&av_frame);
     if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF) {
       receiver_log(LOG_ERROR, source, "Failed to receive frame: %d", ret);
 
       /* 错误恢复：增加错误计数 */
+      live_stat_inc(&source->decode_errors);
+      live_stat_inc(&source->frames_dropped);
       source->decode_error_count++;
       if (source->decode_error_count >= source->decode_error_threshold) {
         receiver_log(LOG_WARNING, source,
                      "Decoder error threshold reached (%u), attempting reset",
                      source->decode_error_count);
         reset_decoder(source);
+
+        /* 快速启动后一直解不出帧: 缓存的参数可能已失效 */
+        if (source->fast_start && !source->first_frame_decoded)
+          stream_param_cache_remove(source->srt_url);
       }
     }
     return false;
@@ -340,6 +427,13 @@ bool decode_and_extract_sei(sei_receiver_source_t *source, AVPacket *packet,
   /* 解码成功，重置错误计数 */
   source->decode_error_count = 0;
 
+  /* 该帧所属数据包的到达时间 (解码器未带出opaque时退回当前数据包) */
+  uint64_t arrival_time = (uint64_t)(uintptr_t)av_frame->opaque;
+  if (!arrival_time)
+    arrival_time = source->packet_arrival_time;
+  uint64_t convert_start = fast_clock_now_ns();
+  live_histogram_observe(&source->decode_time, convert_start - decode_start);
+
   /* 处理硬件帧：如果是硬件格式，转换到系统内存 */
   if (av_frame->format == AV_PIX_FMT_QSV ||
       av_frame->format == AV_PIX_FMT_CUDA ||
@@ -351,7 +445,9 @@ bool decode_and_extract_sei(sei_receiver_source_t *source, AVPacket *packet,
     }
 
     /* 硬件帧 -> 系统内存 */
+    TRACE_START(trace_transfer);
     ret = av_hwframe_transfer_data(sw_frame, av_frame, 0);
+    TRACE_RECEIVE(trace_transfer, source, "av_hwframe_transfer_data");
     if (ret < 0) {
       receiver_log(LOG_ERROR, source, "Failed to transfer HW frame to SW: %d",
                    ret);
@@ -367,19 +463,20 @@ bool decode_and_extract_sei(sei_receiver_source_t *source, AVPacket *packet,
 
   /* 从AVFrame获取PTS（FFmpeg已经从packet转换） */
   int64_t pts = av_frame->pts;
-  if (pts == AV_NOPTS_VALUE) {
+  bool has_pts = pts != AV_NOPTS_VALUE;
+  if (!has_pts) {
     /* 如果没有PTS，使用当前时间 */
     pts = os_gettime_ns();
   } else {
-    /* 转换PTS从stream timebase到纳秒 */
-    AVRational time_base = {1, 90000}; // 通常MPEG-TS使用90kHz
-    pts = av_rescale_q(pts, time_base, (AVRational){1, 1000000000});
+    /* 按流的time_base转换为纳秒, 并展开33位回绕 (约26.5小时一次) */
+    pts = pts_unwrap_ns(&source->video_pts, pts);
   }
 
   /* 填充帧信息 */
   frame_out->width = av_frame->width;
   frame_out->height = av_frame->height;
-  frame_out->pts = av_frame->pts;
+  frame_out->pts = pts;
+  frame_out->has_pts = has_pts;
   frame_out->format = VIDEO_FORMAT_I420; /* 默认YUV420P */
 
   /* 计算帧大小并分配内存 (Align 32 for OBS) */
@@ -421,8 +518,12 @@ bool decode_and_extract_sei(sei_receiver_source_t *source, AVPacket *packet,
   av_image_fill_arrays(dest, linesize, frame_out->data, AV_PIX_FMT_BGRA,
                        av_frame->width, av_frame->height, 32);
 
+  TRACE_START(trace_scale);
   sws_scale(source->sws_ctx, (const uint8_t *const *)av_frame->data,
             av_frame->linesize, 0, av_frame->height, dest, linesize);
+  TRACE_RECEIVE(trace_scale, source, "sws_scale");
+  live_histogram_observe(&source->convert_time,
+                         fast_clock_now_ns() - convert_start);
 
   /* 尝试从side data中提取SEI */
   frame_out->has_ntp = false;
@@ -436,95 +537,103 @@ bool decode_and_extract_sei(sei_receiver_source_t *source, AVPacket *packet,
     if (parse_ntp_sei(sei_data->data, sei_data->size, &ntp_data)) {
       frame_out->ntp_time = ntp_data.ntp_time;
       frame_out->has_ntp = true;
-      source->sei_found_count++;
+      live_stat_inc(&source->sei_found_count);
 
       receiver_log(LOG_DEBUG, source,
                    "Extracted NTP SEI: seconds=%u, fraction=%u",
                    ntp_data.ntp_time.seconds, ntp_data.ntp_time.fraction);
     }
   } else {
-    /* 如果side data中没有，尝试从原始数据中查找 */
-    const uint8_t *payload = NULL;
-    size_t payload_size = 0;
-
-    if (extract_sei_payload(packet->data, packet->size, &payload,
-                            &payload_size)) {
-      ntp_sei_data_t ntp_data;
-      if (parse_ntp_sei(payload, payload_size, &ntp_data)) {
-        frame_out->ntp_time = ntp_data.ntp_time;
-        frame_out->has_ntp = true;
-        source->sei_found_count++;
-      }
+    /* 如果side data中没有，扫描整个访问单元中的SEI NAL */
+    seistamp_codec_t codec = (codec_ctx->codec_id == AV_CODEC_ID_HEVC)
+                                 ? SEISTAMP_CODEC_H265
+                                 : SEISTAMP_CODEC_H264;
+    seistamp_stamp_t stamp;
+    if (seistamp_scan_access_unit(packet->data, packet->size, codec,
+                                  &stamp)) {
+      frame_out->ntp_time = stamp.ntp_time;
+      frame_out->has_ntp = true;
+      live_stat_inc(&source->sei_found_count);
     }
   }
 
-  /* 智能 NTP 同步策略：
+  /* 链路模式: 每个带时间戳的帧都是一个时钟偏移样本 */
+  if (frame_out->has_ntp && source->link_sync_enabled) {
+    link_clock_add_sample(&source->link_clock,
+                          ntp_timestamp_to_ns(&frame_out->ntp_time),
+                          arrival_time);
+  }
+
+  /* 每个带时间戳的帧都是PTS时间线的一个回归样本 */
+  if (frame_out->has_ntp && has_pts) {
+    uint32_t resets = source->pts_timeline.reset_count;
+    pts_timeline_add_sample(&source->pts_timeline, pts,
+                            ntp_timestamp_to_ns(&frame_out->ntp_time));
+    if (source->pts_timeline.reset_count != resets)
+      receiver_log(LOG_INFO, source,
+                   "PTS timeline restarted (PTS or sender clock jumped)");
+  }
+
+  /* 到达延迟 (与传输统计关联, 判断迟到帧是否由链路引起);
+   * NTP模式下换算到本地时钟后为真实的单向延迟 */
+  if (frame_out->has_ntp) {
+    bool absolute = source->ntp_enabled && !source->link_sync_enabled &&
+                    source->ntp_client.is_synced;
+    int64_t sender_ns = (int64_t)ntp_timestamp_to_ns(&frame_out->ntp_time);
+    if (absolute)
+      sender_ns -= ntp_client_get_offset(&source->ntp_client);
+    srt_stats_add_frame(&source->srt_stats,
+                        (int64_t)arrival_time - sender_ns,
+                        absolute);
+  }
+
+  /* 端到端延迟: 发送端采集 -> 数据包到达 / 解码完成 */
+  int64_t capture_ns = 0;
+  bool has_capture =
+      frame_capture_time(source, frame_out, pts, has_pts, &capture_ns);
+  if (has_capture) {
+    e2e_latency_add(&source->e2e_latency, E2E_STAGE_ARRIVAL,
+                    (int64_t)arrival_time - capture_ns);
+    e2e_latency_add(&source->e2e_latency, E2E_STAGE_DECODED,
+                    (int64_t)convert_start - capture_ns);
+  }
+
+  /* 智能 NTP 同步策略 (见 ntp_client_check_resync)：
    * 1. 如果是关键帧（IDR）且有 SEI 时间戳，进行 NTP 同步
-   * 2. 如果本地时间与 NTP 时间差超过 50ms，进行 NTP 同步
+   * 2. 如果帧时间与本地 NTP 时间差超过漂移阈值，进行 NTP 同步
+   * 两者都受最小同步间隔限制
    */
-  if (frame_out->has_ntp && source->ntp_enabled) {
-    bool should_sync = false;
-    uint64_t now = os_gettime_ns();
-
-    /* 条件1: 关键帧同步（但需满足最小10秒间隔，避免过于频繁） */
+  if (frame_out->has_ntp && source->ntp_enabled &&
+      !source->link_sync_enabled) {
+    uint64_t now = fast_clock_now_ns();
     bool is_keyframe =
         (av_frame->key_frame != 0) || (av_frame->flags & AV_FRAME_FLAG_KEY);
 
-    /* 计算距离上次同步的时间*/
-    uint64_t time_since_last_sync = 0;
-    if (source->last_ntp_sync_time > 0) {
-      time_since_last_sync = now - source->last_ntp_sync_time;
-    }
-
-    /* 使用用户配置的最小同步间隔 */
-    uint64_t min_interval_ns =
-        (uint64_t)source->ntp_sync_interval_ms * 1000000ULL;
+    ntp_resync_policy_t policy = {
+        .min_interval_ns = (uint64_t)source->ntp_sync_interval_ms * 1000000ULL,
+        .drift_threshold_ns =
+            (int64_t)source->ntp_drift_threshold_ms * 1000000LL,
+    };
 
-    if (is_keyframe && time_since_last_sync >= min_interval_ns) {
-      should_sync = true;
-      receiver_log(LOG_DEBUG, source,
-                   "Keyframe + interval met, triggering NTP sync");
-    }
-
-    /* 条件2: 时间差检测 (同样受最小间隔限制) */
-    if (!should_sync && source->ntp_client.is_synced &&
-        time_since_last_sync >= min_interval_ns) {
-      /* 计算当前帧的 NTP 时间戳对应的纳秒 */
-      uint64_t frame_ntp_ns =
-          ((uint64_t)frame_out->ntp_time.seconds * 1000000000ULL) +
-          (((uint64_t)frame_out->ntp_time.fraction * 1000000000ULL) >> 32);
-
-      /* 获取当前本地时间对应的 NTP 时间 */
-      ntp_timestamp_t current_ntp;
-      if (ntp_client_get_time(&source->ntp_client, &current_ntp)) {
-        uint64_t current_ntp_ns =
-            ((uint64_t)current_ntp.seconds * 1000000000ULL) +
-            (((uint64_t)current_ntp.fraction * 1000000000ULL) >> 32);
-
-        /* 计算时间差 */
-        int64_t time_diff = (int64_t)(frame_ntp_ns - current_ntp_ns);
-        if (time_diff < 0)
-          time_diff = -time_diff; // 取绝对值
-
-        /* 使用配置的漂移阈值 */
-        uint64_t drift_threshold_ns =
-            (uint64_t)source->ntp_drift_threshold_ms * 1000000ULL;
-        if (time_diff > (int64_t)drift_threshold_ns) {
-          should_sync = true;
-          receiver_log(LOG_DEBUG, source,
-                       "Time drift detected: %lld ms, triggering NTP sync",
-                       time_diff / 1000000);
-        }
-      }
-    }
+    ntp_resync_reason_t reason = ntp_client_check_resync(
+        &source->ntp_client, &policy, now, source->last_ntp_sync_time,
+        is_keyframe, &frame_out->ntp_time);
 
     /* 执行 NTP 同步 */
-    if (should_sync) {
+    if (reason != NTP_RESYNC_NONE) {
+      receiver_log(LOG_DEBUG, source, "Triggering NTP sync (reason: %s)",
+                   reason == NTP_RESYNC_INITIAL    ? "initial"
+                   : reason == NTP_RESYNC_KEYFRAME ? "keyframe"
+                                                   : "drift");
+
       /* 无论成功与否，都更新时间，防止在网络故障时每帧都重试导致卡顿 (Backoff)
        */
       source->last_ntp_sync_time = now;
 
-      if (ntp_client_sync(&source->ntp_client)) {
+      TRACE_START(trace_sync);
+      bool synced = ntp_client_sync(&source->ntp_client);
+      TRACE_RECEIVE(trace_sync, source, "ntp_client_sync");
+      if (synced) {
         receiver_log(LOG_INFO, source, "NTP synchronized (syncs: %u)",
                      source->ntp_client.sync_count);
       } else {
@@ -552,7 +661,12 @@ bool decode_and_extract_sei(sei_receiver_source_t *source, AVPacket *packet,
       obs_frame.width, obs_frame.height, packet->pts, obs_frame.timestamp);
 
   /* 输出帧到OBS */
+  TRACE_START(trace_output);
   obs_source_output_video(source->context, &obs_frame);
+  TRACE_RECEIVE(trace_output, source, "obs_source_output_video");
+  if (has_capture)
+    e2e_latency_add(&source->e2e_latency, E2E_STAGE_OUTPUT,
+                    (int64_t)fast_clock_now_ns() - capture_ns);
 
   /* 更新统计信息 */
   update_statistics(source);
@@ -577,13 +691,9 @@ int64_t get_sync_timestamp(sei_receiver_source_t *source, int64_t pts) {
   if (!source)
     return 0;
 
-  int64_t current_time = os_gettime_ns();
-
-  /* 转换PTS到纳秒: FFmpeg PTS通常基于timebase, 这里假设90kHz (SRT默认/MPEGTS)
-   */
-  /* 如果PTS已经是纳秒(例如AV_NOPTS_VALUE处理后)，需要注意 */
-  /* 通常调用者会传入处理过的纳秒PTS */
+  int64_t current_time = fast_clock_now_ns();
 
+  /* 调用者传入已展开回绕并换算为纳秒的PTS (pts_unwrap_ns) */
   if (!source->has_pts_offset) {
     source->pts_offset = current_time - pts;
     source->has_pts_offset = true;
@@ -596,6 +706,31 @@ int64_t get_sync_timestamp(sei_receiver_source_t *source, int64_t pts) {
   return pts + source->pts_offset;
 }
 
+/*
+ * 发送端时间 -> 本地时钟
+ * 链路模式: 加上由本链路估计的时钟偏移
+ * NTP模式: 减去NTP Client计算出的全局偏移 (Offset = NTP_Server - Local)
+ */
+static bool sender_to_local(sei_receiver_source_t *source, uint64_t sender_ns,
+                            int64_t *local_ns) {
+  if (source->link_sync_enabled)
+    return link_clock_to_local(&source->link_clock, sender_ns, local_ns);
+  if (source->ntp_enabled) {
+    *local_ns = (int64_t)sender_ns - ntp_client_get_offset(&source->ntp_client);
+    return true;
+  }
+  return false;
+}
+
+/* 按PTS时间线的回归把PTS映射到本地时钟 (音视频共用节目时钟) */
+static bool timeline_to_local(sei_receiver_source_t *source, int64_t pts_ns,
+                              int64_t *local_ns) {
+  uint64_t sender_ns;
+  if (!pts_timeline_to_ntp(&source->pts_timeline, pts_ns, &sender_ns))
+    return false;
+  return sender_to_local(source, sender_ns, local_ns);
+}
+
 /* 计算视频显示时间 */
 int64_t calculate_display_time(sei_receiver_source_t *source,
                                video_frame_data_t *frame) {
@@ -603,39 +738,30 @@ int64_t calculate_display_time(sei_receiver_source_t *source,
     return 0;
   }
 
-  /* 如果有NTP时间戳，且启用了NTP同步 */
-  if (frame->has_ntp && source->ntp_enabled) {
-    /* 计算NTP时间戳对应的纳秒 */
-    uint64_t ntp_ns =
-        ((uint64_t)frame->ntp_time.seconds * 1000000000ULL) +
-        (((uint64_t)frame->ntp_time.fraction * 1000000000ULL) >> 32);
-
-    /* NTP模式: 使用绝对时间同步 (Absolute NTP Time) */
-    /* 我们不再依赖 "首帧对齐"，而是依赖 NTP Client 计算出的全局偏移 */
-    /* Offset = NTP_Server - Local_System */
-    /* Local_Render_Time = Frame_NTP - Offset */
-
-    int64_t ntp_offset = ntp_client_get_offset(&source->ntp_client);
-    int64_t display_time = (int64_t)ntp_ns - ntp_offset;
+  /* 优先使用回归结果: 带不带时间戳的帧都平滑, 丢失SEI也不会跳变;
+   * 时间线还未建立(或帧没有PTS)时直接使用本帧的时间戳 */
+  int64_t display_time;
+  bool mapped = frame->has_pts &&
+                timeline_to_local(source, frame->pts, &display_time);
+  if (!mapped && frame->has_ntp)
+    mapped = sender_to_local(source, ntp_timestamp_to_ns(&frame->ntp_time),
+                             &display_time);
 
+  if (mapped) {
     /* 记录日志(仅定期，避免刷屏) */
-    if (source->sei_found_count % 300 == 0) {
+    if (live_stat_get(&source->frames_received) % 300 == 0) {
       receiver_log(LOG_DEBUG, source,
-                   "Absolute Sync: NTP=%llu, Offset=%lld, Display=%lld", ntp_ns,
-                   ntp_offset, display_time);
+                   "Timeline Sync: PTS=%lld, Display=%lld, Rate=%.1f ppm, "
+                   "Samples=%llu, Resets=%u",
+                   frame->pts, display_time,
+                   pts_timeline_rate_ppm(&source->pts_timeline),
+                   source->pts_timeline.total_samples,
+                   source->pts_timeline.reset_count);
     }
 
-    /* 更新通用PTS偏移，以便音频能跟随视频的节奏 */
-    /* 这一点很重要，因为音频仍然可能使用 PTS */
-    /* AudioTarget = VideoDisplayTime */
-    /* VideoPTS + PTSOffset = VideoDisplayTime */
-    /* PTSOffset = VideoDisplayTime - VideoPTS */
-
-    /* 每次收到SEI(关键帧/IDR)都更新PTS Offset (按用户要求每帧校准) */
-    // if (source->sei_found_count % 1 == 0) // Always
+    /* 更新通用PTS偏移: 时间线失效时, 没有PTS的帧仍跟随视频的节奏 */
     source->pts_offset = display_time - frame->pts;
     source->has_pts_offset = true;
-
     return display_time;
   }
 
@@ -670,52 +796,27 @@ bool decode_audio(sei_receiver_source_t *source, AVPacket *packet) {
       break;
     }
 
-    struct obs_source_audio audio = {0};
-    int channels = frame->ch_layout.nb_channels;
-    for (int i = 0; i < MAX_AUDIO_CHANNELS && i < channels; i++) {
-      audio.data[i] = frame->data[i];
-    }
-
-    audio.frames = frame->nb_samples;
-
-    if (channels == 1)
-      audio.speakers = SPEAKERS_MONO;
-    else if (channels == 2)
-      audio.speakers = SPEAKERS_STEREO;
-    else if (channels == 4)
-      audio.speakers = SPEAKERS_4POINT0;
-    else if (channels == 6)
-      audio.speakers = SPEAKERS_5POINT1;
-    else
-      audio.speakers = SPEAKERS_UNKNOWN;
-
-    audio.format = source->audio_format;
-    audio.samples_per_sec = source->audio_sample_rate;
-
-    /* 时间戳同步 */
-    /* 获取audio pts (time_base based) */
+    /* 时间戳同步: 帧首样本在视频时间线上的时间作为重采样的目标,
+     * 输出时间戳由重采样器保持连续 (没有PTS的帧沿用当前速率) */
     int64_t pts = frame->pts;
-    int64_t pts_ns = 0;
-
-    if (pts != AV_NOPTS_VALUE) {
-      AVRational tb = ctx->time_base;
-      /* 如果timebase是0，尝试使用 1/sample_rate */
-      if (tb.num == 0 || tb.den == 0) {
-        tb.num = 1;
-        tb.den = ctx->sample_rate;
-      }
-      pts_ns = av_rescale_q(pts, tb, (AVRational){1, 1000000000});
-    } else {
-      /* 如果没有PTS，使用当前Offset推算 */
-      pts_ns = (int64_t)audio.timestamp - source->pts_offset;
-      if (!source->has_pts_offset)
-        pts_ns = 0;
-    }
+    bool has_target = pts != AV_NOPTS_VALUE;
+    int64_t target_ns = 0;
 
-    /* 使用统一的 timestamp sync */
-    audio.timestamp = (uint64_t)get_sync_timestamp(source, pts_ns);
+    if (has_target) {
+      int64_t pts_ns = pts_unwrap_ns(&source->audio_pts, pts);
+      if (!timeline_to_local(source, pts_ns, &target_ns))
+        target_ns = get_sync_timestamp(source, pts_ns);
+    }
 
-    obs_source_output_audio(source->context, &audio);
+    struct obs_source_audio audio = {0};
+    long resyncs = live_stat_get(&source->audio_resampler.resyncs);
+    if (audio_resampler_process(&source->audio_resampler, frame, has_target,
+                                target_ns, &audio))
+      obs_source_output_audio(source->context, &audio);
+    if (live_stat_get(&source->audio_resampler.resyncs) != resyncs)
+      receiver_log(LOG_INFO, source,
+                   "Audio timeline reset (off by more than %lld ms)",
+                   AUDIO_RESAMPLER_RESYNC_NS / 1000000);
   }
 
   av_frame_free(&frame);
@@ -741,6 +842,226 @@ static const char *receiver_source_getname(void *unused) {
 static void start_receiver(void *data);
 static void stop_receiver(void *data);
 
+/* 局域网时间主机: 按设置获取或释放共享NTP服务器 */
+static void update_ntp_master(sei_receiver_source_t *ctx,
+                              obs_data_t *settings) {
+  bool enabled = obs_data_get_bool(settings, "ntp_master_enabled");
+  uint16_t port = (uint16_t)obs_data_get_int(settings, "ntp_master_port");
+
+  if (ctx->ntp_master_active && (!enabled || port != ctx->ntp_master_port)) {
+    ntp_server_release();
+    ctx->ntp_master_active = false;
+  }
+
+  if (enabled && !ctx->ntp_master_active) {
+    /* 上游使用本源的NTP服务器设置(若启用),否则直接提供本机时钟 */
+    ctx->ntp_master_active = ntp_server_acquire(
+        port, ctx->ntp_enabled ? ctx->ntp_server : NULL, ctx->ntp_port);
+    ctx->ntp_master_port = port;
+    if (ctx->ntp_master_active) {
+      receiver_log(LOG_INFO, ctx, "Acting as LAN time master on port %u",
+                   port);
+    }
+  }
+}
+
+/* 指标端点: 按设置获取或释放共享指标服务器 */
+static void update_metrics_server(sei_receiver_source_t *ctx,
+                                  obs_data_t *settings) {
+  bool enabled = obs_data_get_bool(settings, "metrics_enabled");
+  const char *bind = obs_data_get_string(settings, "metrics_bind");
+  uint16_t port = (uint16_t)obs_data_get_int(settings, "metrics_port");
+  if (!bind)
+    bind = "";
+
+  if (ctx->metrics_active &&
+      (!enabled || port != ctx->metrics_port ||
+       strcmp(bind, ctx->metrics_bind) != 0)) {
+    metrics_server_release();
+    ctx->metrics_active = false;
+  }
+
+  if (enabled && !ctx->metrics_active) {
+    ctx->metrics_active = metrics_server_acquire(bind, port);
+    ctx->metrics_port = port;
+    snprintf(ctx->metrics_bind, sizeof(ctx->metrics_bind), "%s", bind);
+  }
+}
+
+/* 从SRT URL读取接收延迟 (FFmpeg srt协议的 latency/rcvlatency 以微秒为单位) */
+static int64_t get_srt_latency_ns(const char *url) {
+  static const char *keys[] = {"rcvlatency=", "latency="};
+  const char *query = strchr(url, '?');
+
+  for (size_t i = 0; query && i < sizeof(keys) / sizeof(keys[0]); i++) {
+    const char *p = query;
+    while ((p = strstr(p, keys[i])) != NULL) {
+      if (p[-1] == '?' || p[-1] == '&') {
+        return strtoll(p + strlen(keys[i]), NULL, 10) * 1000;
+      }
+      p++;
+    }
+  }
+
+  return (int64_t)SRT_DEFAULT_LATENCY_US * 1000;
+}
+
+/* 原生SRT接收设置, 返回是否有变化(需要重新连接) */
+static bool update_srt_options(sei_receiver_source_t *ctx,
+                               obs_data_t *settings) {
+  bool native = obs_data_get_bool(settings, "srt_native");
+  srt_input_options_t options = {
+      .latency_ms = (int)obs_data_get_int(settings, "srt_latency"),
+      .rcvbuf_bytes = (int)obs_data_get_int(settings, "srt_rcvbuf") * 1024,
+      .payload_size = (int)obs_data_get_int(settings, "srt_payload_size"),
+      .timeout_ms = 2000,
+  };
+
+  bool changed = native != ctx->srt_native ||
+                 memcmp(&options, &ctx->srt_options, sizeof(options)) != 0;
+  ctx->srt_native = native;
+  ctx->srt_options = options;
+  return changed;
+}
+
+/* 同步模式: ntp 使用NTP服务器, srt_link 由本链路的SEI时间戳估计时钟偏移 */
+static void update_sync_mode(sei_receiver_source_t *ctx,
+                             obs_data_t *settings) {
+  const char *mode = obs_data_get_string(settings, "sync_mode");
+  bool link_sync = mode && strcmp(mode, "srt_link") == 0;
+
+  if (link_sync && !ctx->link_sync_enabled) {
+    link_clock_init(&ctx->link_clock, get_srt_latency_ns(ctx->srt_url));
+    receiver_log(LOG_INFO, ctx, "Link clock sync enabled (latency: %lld ms)",
+                 ctx->link_clock.transport_delay_ns / 1000000);
+  }
+
+  ctx->link_sync_enabled = link_sync;
+}
+
+void receiver_get_stats(sei_receiver_source_t *source,
+                        receiver_stats_t *stats) {
+  stats->connected = source->is_connected;
+  stats->frames_received = live_stat_get(&source->frames_received);
+  stats->frames_rendered = live_stat_get(&source->frames_rendered);
+  stats->frames_dropped = live_stat_get(&source->frames_dropped);
+  stats->sei_found = live_stat_get(&source->sei_found_count);
+  stats->decode_errors = live_stat_get(&source->decode_errors);
+  stats->connect_count = live_stat_get(&source->connect_count);
+  stats->fps = live_stat_get(&source->fps_centi) / 100.0;
+  stats->sei_rate = live_stat_get(&source->sei_rate_centi) / 100.0;
+  stats->ntp_offset_ms = live_stat_get(&source->ntp_offset_us) / 1000.0;
+  stats->ntp_jitter_ms = live_stat_get(&source->ntp_jitter_us) / 1000.0;
+  live_histogram_snapshot(&source->decode_time, &stats->decode_time);
+  live_histogram_snapshot(&source->convert_time, &stats->convert_time);
+  srt_stats_snapshot(&source->srt_stats, &stats->srt);
+  e2e_latency_snapshot(&source->e2e_latency, &stats->latency);
+  stats->audio_correction_ppm =
+      (double)live_stat_get(&source->audio_resampler.correction_ppm);
+  stats->audio_error_ms =
+      live_stat_get(&source->audio_resampler.error_us) / 1000.0;
+  stats->audio_resyncs = live_stat_get(&source->audio_resampler.resyncs);
+}
+
+/* 所有接收源 (只在创建/销毁/导出时加锁, 接收线程不访问) */
+static pthread_mutex_t registry_mutex = PTHREAD_MUTEX_INITIALIZER;
+static sei_receiver_source_t *registry_head;
+
+static void register_source(sei_receiver_source_t *ctx) {
+  pthread_mutex_lock(&registry_mutex);
+  ctx->next_registered = registry_head;
+  registry_head = ctx;
+  pthread_mutex_unlock(&registry_mutex);
+}
+
+static void unregister_source(sei_receiver_source_t *ctx) {
+  pthread_mutex_lock(&registry_mutex);
+  for (sei_receiver_source_t **link = &registry_head; *link;
+       link = &(*link)->next_registered) {
+    if (*link == ctx) {
+      *link = ctx->next_registered;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&registry_mutex);
+}
+
+size_t receiver_stats_collect(receiver_stats_entry_t **entries) {
+  *entries = NULL;
+
+  pthread_mutex_lock(&registry_mutex);
+  size_t count = 0;
+  for (sei_receiver_source_t *ctx = registry_head; ctx;
+       ctx = ctx->next_registered)
+    count++;
+  if (count)
+    *entries = bzalloc(count * sizeof(receiver_stats_entry_t));
+
+  size_t i = 0;
+  for (sei_receiver_source_t *ctx = registry_head; ctx && *entries;
+       ctx = ctx->next_registered, i++) {
+    const char *name = obs_source_get_name(ctx->context);
+    snprintf((*entries)[i].name, sizeof((*entries)[i].name), "%s",
+             name ? name : "");
+    receiver_get_stats(ctx, &(*entries)[i].stats);
+  }
+  pthread_mutex_unlock(&registry_mutex);
+  return i;
+}
+
+/* 源的proc handler: 控制室面板等按源名轮询, 只读取原子值, 不影响接收线程 */
+static const char *get_stats_decl =
+    "void get_stats(out bool connected, out int frames_received, "
+    "out int frames_rendered, out int frames_dropped, out int sei_found, "
+    "out int decode_errors, out int connect_count, out float fps, "
+    "out float sei_rate, out float ntp_offset_ms, out float ntp_jitter_ms, "
+    "out float srt_rtt_ms, out float srt_loss_percent, out int srt_retrans, "
+    "out int srt_dropped, out int srt_rcv_buf_ms, out float srt_mbps, "
+    "out float arrival_ms, out float arrival_excess_ms, "
+    "out int late_transport, out int late_other, out float g2g_p50_ms, "
+    "out float g2g_p99_ms, out float g2g_p999_ms, out float g2g_max_ms, "
+    "out float audio_correction_ppm, out float audio_error_ms, "
+    "out int audio_resyncs)";
+
+static void get_stats_proc(void *data, calldata_t *cd) {
+  receiver_stats_t stats;
+  receiver_get_stats((sei_receiver_source_t *)data, &stats);
+
+  calldata_set_bool(cd, "connected", stats.connected);
+  calldata_set_int(cd, "frames_received", stats.frames_received);
+  calldata_set_int(cd, "frames_rendered", stats.frames_rendered);
+  calldata_set_int(cd, "frames_dropped", stats.frames_dropped);
+  calldata_set_int(cd, "sei_found", stats.sei_found);
+  calldata_set_int(cd, "decode_errors", stats.decode_errors);
+  calldata_set_int(cd, "connect_count", stats.connect_count);
+  calldata_set_float(cd, "fps", stats.fps);
+  calldata_set_float(cd, "sei_rate", stats.sei_rate);
+  calldata_set_float(cd, "ntp_offset_ms", stats.ntp_offset_ms);
+  calldata_set_float(cd, "ntp_jitter_ms", stats.ntp_jitter_ms);
+  calldata_set_float(cd, "srt_rtt_ms", stats.srt.rtt_ms);
+  calldata_set_float(cd, "srt_loss_percent", stats.srt.loss_percent);
+  calldata_set_int(cd, "srt_retrans", stats.srt.retrans_total);
+  calldata_set_int(cd, "srt_dropped", stats.srt.dropped_total);
+  calldata_set_int(cd, "srt_rcv_buf_ms", stats.srt.rcv_buf_ms);
+  calldata_set_float(cd, "srt_mbps", stats.srt.recv_mbps);
+  calldata_set_float(cd, "arrival_ms", stats.srt.arrival_ms);
+  calldata_set_float(cd, "arrival_excess_ms", stats.srt.excess_ms);
+  calldata_set_int(cd, "late_transport", stats.srt.late_transport);
+  calldata_set_int(cd, "late_other", stats.srt.late_other);
+
+  /* 端到端延迟: 交给OBS为止, 最近10秒 */
+  const e2e_window_snapshot_t *g2g =
+      &stats.latency.windows[E2E_STAGE_OUTPUT][E2E_WINDOW_10S];
+  calldata_set_float(cd, "g2g_p50_ms", g2g->p50_ms);
+  calldata_set_float(cd, "g2g_p99_ms", g2g->p99_ms);
+  calldata_set_float(cd, "g2g_p999_ms", g2g->p999_ms);
+  calldata_set_float(cd, "g2g_max_ms", g2g->max_ms);
+
+  calldata_set_float(cd, "audio_correction_ppm", stats.audio_correction_ppm);
+  calldata_set_float(cd, "audio_error_ms", stats.audio_error_ms);
+  calldata_set_int(cd, "audio_resyncs", stats.audio_resyncs);
+}
+
 /* 创建源 */
 static void *receiver_source_create(obs_data_t *settings,
                                     obs_source_t *source) {
@@ -776,6 +1097,13 @@ static void *receiver_source_create(obs_data_t *settings,
 
   /* codec_type已移除 - 接收端自动检测流的编码格式 */
 
+  const char *record_dir = obs_data_get_string(settings, "record_dir");
+  if (record_dir && record_dir[0]) {
+    strncpy(ctx->record_dir, record_dir, sizeof(ctx->record_dir) - 1);
+  }
+
+  update_srt_options(ctx, settings);
+
   const char *ntp_server = obs_data_get_string(settings, "ntp_server");
   if (ntp_server && ntp_server[0]) {
     strncpy(ctx->ntp_server, ntp_server, sizeof(ctx->ntp_server) - 1);
@@ -804,8 +1132,6 @@ static void *receiver_source_create(obs_data_t *settings,
   /* 初始化统计和错误恢复 */
   ctx->last_stats_update_time = 0;
   ctx->stats_frame_count = 0;
-  ctx->current_fps = 0.0f;
-  ctx->sei_detection_rate = 0.0f;
   ctx->decode_error_count = 0;
   ctx->decode_error_threshold = 10; /* 连续10次错误后重置 */
 
@@ -822,8 +1148,16 @@ static void *receiver_source_create(obs_data_t *settings,
     }
   }
 
+  update_ntp_master(ctx, settings);
+  update_metrics_server(ctx, settings);
+  update_sync_mode(ctx, settings);
+
   receiver_log(LOG_INFO, ctx, "SEI Receiver source created");
 
+  proc_handler_add(obs_source_get_proc_handler(ctx->context), get_stats_decl,
+                   get_stats_proc, ctx);
+  register_source(ctx);
+
   /* 在后台立即启动 */
   start_receiver(ctx);
 
@@ -834,10 +1168,13 @@ static void *receiver_source_create(obs_data_t *settings,
 static void receiver_source_destroy(void *data) {
   sei_receiver_source_t *ctx = (sei_receiver_source_t *)data;
 
+  /* 先注销, 之后的指标导出不再访问本源 */
+  unregister_source(ctx);
+
   /* 停止接收器 */
   stop_receiver(ctx);
 
-  /* SRT连接由avformat管理，无需手动关闭socket */
+  /* SRT连接(FFmpeg或原生)由接收线程在退出时关闭 */
 
   /* 销毁解码器 */
   if (ctx->codec_context) {
@@ -855,6 +1192,18 @@ static void receiver_source_destroy(void *data) {
   /* 销毁NTP客户端 */
   ntp_client_destroy(&ctx->ntp_client);
 
+  /* 释放时间主机引用 */
+  if (ctx->ntp_master_active) {
+    ntp_server_release();
+    ctx->ntp_master_active = false;
+  }
+
+  /* 释放指标服务器引用 */
+  if (ctx->metrics_active) {
+    metrics_server_release();
+    ctx->metrics_active = false;
+  }
+
   /* 销毁帧缓冲区 */
   frame_buffer_destroy(&ctx->frame_buffer);
 
@@ -864,11 +1213,16 @@ static void receiver_source_destroy(void *data) {
     ctx->sws_ctx = NULL;
   }
 
+  e2e_latency_free(&ctx->e2e_latency);
+  audio_resampler_free(&ctx->audio_resampler);
+
   receiver_log(LOG_INFO, ctx,
-               "SEI Receiver destroyed (received: %llu, rendered: %llu, "
-               "dropped: %llu, SEI found: %llu)",
-               ctx->frames_received, ctx->frames_rendered, ctx->frames_dropped,
-               ctx->sei_found_count);
+               "SEI Receiver destroyed (received: %ld, rendered: %ld, "
+               "dropped: %ld, SEI found: %ld)",
+               live_stat_get(&ctx->frames_received),
+               live_stat_get(&ctx->frames_rendered),
+               live_stat_get(&ctx->frames_dropped),
+               live_stat_get(&ctx->sei_found_count));
 
   bfree(ctx);
 }
@@ -876,6 +1230,10 @@ static void receiver_source_destroy(void *data) {
 /* 获取默认设置 */
 static void receiver_source_defaults(obs_data_t *settings) {
   obs_data_set_default_string(settings, "srt_url", "srt://127.0.0.1:9000");
+  obs_data_set_default_bool(settings, "srt_native", true);
+  obs_data_set_default_int(settings, "srt_latency", 0);
+  obs_data_set_default_int(settings, "srt_rcvbuf", 0);
+  obs_data_set_default_int(settings, "srt_payload_size", 0);
   obs_data_set_default_string(settings, "ntp_server", "time.windows.com");
   obs_data_set_default_int(settings, "ntp_port", 123);
   obs_data_set_default_bool(settings, "ntp_enabled", true);
@@ -884,18 +1242,79 @@ static void receiver_source_defaults(obs_data_t *settings) {
   obs_data_set_default_int(settings, "ntp_drift_threshold", 50); // 默认 50ms
   obs_data_set_default_int(settings, "ntp_sync_interval",
                            10000); // 默认 10000ms (10秒)
+  obs_data_set_default_bool(settings, "ntp_master_enabled", false);
+  obs_data_set_default_int(settings, "ntp_master_port",
+                           NTP_SERVER_DEFAULT_PORT);
+  obs_data_set_default_bool(settings, "metrics_enabled", false);
+  obs_data_set_default_string(settings, "metrics_bind",
+                              METRICS_SERVER_DEFAULT_BIND);
+  obs_data_set_default_int(settings, "metrics_port",
+                           METRICS_SERVER_DEFAULT_PORT);
+  obs_data_set_default_string(settings, "sync_mode", "ntp");
+}
+
+/* 状态文本(写入设置的status, 由属性对话框显示): 连接, 帧率/SEI, 链路统计 */
+static void update_status_text(sei_receiver_source_t *ctx) {
+  receiver_stats_t stats;
+  receiver_get_stats(ctx, &stats);
+  char transport[256];
+  srt_stats_format(&stats.srt, transport, sizeof(transport));
+
+  /* 端到端延迟 (最近10秒有样本时才显示) */
+  char latency[128] = "";
+  const e2e_window_snapshot_t *g2g =
+      &stats.latency.windows[E2E_STAGE_OUTPUT][E2E_WINDOW_10S];
+  if (g2g->count > 0)
+    snprintf(latency, sizeof(latency),
+             "\nGlass-to-glass %.1f / %.1f / %.1f ms (p50/p99/max, 10 s)",
+             g2g->p50_ms, g2g->p99_ms, g2g->max_ms);
+
+  char status[640];
+  if (stats.connected)
+    snprintf(status, sizeof(status), "%s, %.1f fps, SEI %.0f%%\n%s%s",
+             obs_module_text("Status.Connected"), stats.fps, stats.sei_rate,
+             transport, latency);
+  else
+    snprintf(status, sizeof(status), "%s",
+             obs_module_text("Status.Connecting"));
+
+  obs_data_t *settings = obs_source_get_settings(ctx->context);
+  obs_data_set_string(settings, "status", status);
+  obs_data_release(settings);
+}
+
+static bool refresh_status_clicked(obs_properties_t *props,
+                                   obs_property_t *property, void *data) {
+  UNUSED_PARAMETER(props);
+  UNUSED_PARAMETER(property);
+  update_status_text((sei_receiver_source_t *)data);
+  return true;
 }
 
 /* 获取属性 */
 static obs_properties_t *receiver_source_properties(void *data) {
-  UNUSED_PARAMETER(data);
-
   obs_properties_t *props = obs_properties_create();
 
   /* SRT URL */
   obs_properties_add_text(props, "srt_url", obs_module_text("SRTUrl"),
                           OBS_TEXT_DEFAULT);
 
+  /* 原生SRT接收参数 (0: 使用URL中的值或libsrt默认值) */
+  obs_property_t *native = obs_properties_add_bool(
+      props, "srt_native", obs_module_text("SRTNative"));
+  obs_property_set_long_description(native,
+                                    obs_module_text("SRTNative.Description"));
+  obs_property_int_set_suffix(
+      obs_properties_add_int(props, "srt_latency",
+                             obs_module_text("SRTLatency"), 0, 10000, 10),
+      " ms");
+  obs_property_int_set_suffix(
+      obs_properties_add_int(props, "srt_rcvbuf", obs_module_text("SRTRcvBuf"),
+                             0, 1048576, 256),
+      " KiB");
+  obs_properties_add_int(props, "srt_payload_size",
+                         obs_module_text("SRTPayloadSize"), 0, 1456, 188);
+
   /* 硬件解码器选择 */
   obs_property_t *hw_list =
       obs_properties_add_list(props, "hw_decoder", obs_module_text("HWDecoder"),
@@ -911,6 +1330,22 @@ static obs_properties_t *receiver_source_properties(void *data) {
 
   /* Codec Format已移除 - 接收端自动检测流的编码格式 */
 
+  /* 录像目录 (空: 不录制) */
+  obs_property_t *record_dir =
+      obs_properties_add_path(props, "record_dir", obs_module_text("RecordDir"),
+                              OBS_PATH_DIRECTORY, NULL, NULL);
+  obs_property_set_long_description(record_dir,
+                                    obs_module_text("RecordDir.Description"));
+
+  /* 同步模式 */
+  obs_property_t *sync_list =
+      obs_properties_add_list(props, "sync_mode", obs_module_text("SyncMode"),
+                              OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_STRING);
+  obs_property_list_add_string(sync_list, obs_module_text("SyncMode.NTP"),
+                               "ntp");
+  obs_property_list_add_string(sync_list, obs_module_text("SyncMode.SRTLink"),
+                               "srt_link");
+
   /* NTP设置组 */
   obs_properties_add_group(props, "ntp_group", obs_module_text("NTPSettings"),
                            OBS_GROUP_NORMAL, NULL);
@@ -931,6 +1366,19 @@ static obs_properties_t *receiver_source_properties(void *data) {
   obs_properties_add_int(props, "ntp_sync_interval", "NTP Sync Interval (ms)",
                          100, 3600000, 100); // 100ms 到 1小时
 
+  /* 局域网时间主机 */
+  obs_properties_add_bool(props, "ntp_master_enabled",
+                          obs_module_text("NTPMaster"));
+  obs_properties_add_int(props, "ntp_master_port",
+                         obs_module_text("NTPMasterPort"), 1, 65535, 1);
+
+  /* Prometheus指标端点 */
+  obs_properties_add_bool(props, "metrics_enabled", obs_module_text("Metrics"));
+  obs_properties_add_text(props, "metrics_bind", obs_module_text("MetricsBind"),
+                          OBS_TEXT_DEFAULT);
+  obs_properties_add_int(props, "metrics_port", obs_module_text("MetricsPort"),
+                         1, 65535, 1);
+
   /* 警告说明 */
   obs_properties_add_text(props, "ntp_interval_warning",
                           "⚠️ Warning: Setting interval < 1000ms may cause "
@@ -938,8 +1386,13 @@ static obs_properties_t *receiver_source_properties(void *data) {
                           OBS_TEXT_INFO);
 
   /* 状态信息(只读) */
+  if (data)
+    update_status_text((sei_receiver_source_t *)data);
   obs_properties_add_text(props, "status", obs_module_text("Status"),
                           OBS_TEXT_INFO);
+  obs_properties_add_button(props, "status_refresh",
+                            obs_module_text("Status.Refresh"),
+                            refresh_status_clicked);
 
   return props;
 }
@@ -981,6 +1434,13 @@ static void receiver_source_update(void *data, obs_data_t *settings) {
     }
   }
 
+  /* 更新时间主机设置 */
+  update_ntp_master(ctx, settings);
+  update_metrics_server(ctx, settings);
+
+  /* 更新同步模式 */
+  update_sync_mode(ctx, settings);
+
   /* 更新硬件解码器设置 */
   const char *hw_decoder = obs_data_get_string(settings, "hw_decoder");
   if (hw_decoder && hw_decoder[0] &&
@@ -1006,6 +1466,22 @@ static void receiver_source_update(void *data, obs_data_t *settings) {
     settings_changed = true;
   }
 
+  /* 更新录像目录: 重新连接以在新目录中开始新文件 */
+  const char *record_dir = obs_data_get_string(settings, "record_dir");
+  if (record_dir && strcmp(ctx->record_dir, record_dir) != 0) {
+    receiver_log(LOG_INFO, ctx, "Record directory changed, restarting...");
+    stop_receiver(ctx);
+    snprintf(ctx->record_dir, sizeof(ctx->record_dir), "%s", record_dir);
+    settings_changed = true;
+  }
+
+  /* 更新原生SRT接收设置: 延迟等需要重新握手 */
+  if (update_srt_options(ctx, settings)) {
+    receiver_log(LOG_INFO, ctx, "SRT options changed, restarting...");
+    stop_receiver(ctx);
+    settings_changed = true;
+  }
+
   /* codec_type检测已移除 - 自动检测 */
 
   /* 如果因为设置改变而停止了，现在重新启动 */
@@ -1020,10 +1496,14 @@ static void receiver_source_update(void *data, obs_data_t *settings) {
 }
 /* 辅助: 清理连接资源 */
 static void cleanup_connection(sei_receiver_source_t *source) {
+  stream_recorder_close(&source->recorder);
   if (source->format_context) {
     avformat_close_input((AVFormatContext **)&source->format_context);
     source->format_context = NULL;
   }
+  /* 自定义AVIO不由avformat释放 */
+  srt_input_close(source->srt_input);
+  source->srt_input = NULL;
   if (source->codec_context) {
     avcodec_free_context((AVCodecContext **)&source->codec_context);
     source->codec_context = NULL;
@@ -1036,10 +1516,85 @@ static void cleanup_connection(sei_receiver_source_t *source) {
     avcodec_free_context((AVCodecContext **)&source->audio_codec_context);
     source->audio_codec_context = NULL;
   }
+  audio_resampler_free(&source->audio_resampler);
   source->is_connected = false;
   receiver_log(LOG_INFO, source, "Connection closed and resources freed");
 }
 
+/* 辅助: 连接失败时关闭输入 (自定义AVIO不由avformat释放) */
+static void close_input(sei_receiver_source_t *source,
+                        AVFormatContext **fmt_ctx) {
+  avformat_close_input(fmt_ctx);
+  srt_input_close(source->srt_input);
+  source->srt_input = NULL;
+}
+
+/* 辅助: 第一个指定类型的流, 没有时返回-1 */
+static int find_first_stream(const AVFormatContext *fmt_ctx,
+                             enum AVMediaType type) {
+  for (unsigned int i = 0; i < fmt_ctx->nb_streams; i++) {
+    if (fmt_ctx->streams[i]->codecpar->codec_type == type)
+      return (int)i;
+  }
+  return -1;
+}
+
+/* 辅助: 流与缓存一致时, 用缓存补全流参数
+ * (TS的节目表只给出编码类型, 分辨率/声道等原本要靠探测得到) */
+static bool apply_cached_params(AVFormatContext *fmt_ctx,
+                                const stream_params_t *cached) {
+  int video_idx = find_first_stream(fmt_ctx, AVMEDIA_TYPE_VIDEO);
+  int audio_idx = find_first_stream(fmt_ctx, AVMEDIA_TYPE_AUDIO);
+
+  /* 节目表不在探测范围内时还没有流 */
+  if (video_idx < 0 || fmt_ctx->streams[video_idx]->codecpar->codec_id !=
+                           cached->video->codec_id)
+    return false;
+  if ((audio_idx >= 0) != (cached->audio != NULL))
+    return false;
+  if (audio_idx >= 0 && fmt_ctx->streams[audio_idx]->codecpar->codec_id !=
+                            cached->audio->codec_id)
+    return false;
+
+  if (avcodec_parameters_copy(fmt_ctx->streams[video_idx]->codecpar,
+                              cached->video) < 0)
+    return false;
+  if (audio_idx >= 0 &&
+      avcodec_parameters_copy(fmt_ctx->streams[audio_idx]->codecpar,
+                              cached->audio) < 0)
+    return false;
+  return true;
+}
+
+/* 辅助: 开始录制本次连接 (文件名: 源名称 + 连接时间) */
+static void start_recording(sei_receiver_source_t *source) {
+  if (!source->record_dir[0])
+    return;
+  if (os_mkdirs(source->record_dir) == MKDIR_ERROR) {
+    receiver_log(LOG_WARNING, source, "Cannot create record directory %s",
+                 source->record_dir);
+    return;
+  }
+
+  /* 源名称中不能用于文件名的字符替换为'_' */
+  char name[128];
+  snprintf(name, sizeof(name), "%s", obs_source_get_name(source->context));
+  for (char *c = name; *c; c++) {
+    if (strchr("\\/:*?\"<>|", *c))
+      *c = '_';
+  }
+
+  char *stamp =
+      os_generate_formatted_filename("ts", true, "%CCYY-%MM-%DD_%hh-%mm-%ss");
+  char path[512];
+  snprintf(path, sizeof(path), "%s/%s_%s", source->record_dir, name, stamp);
+  bfree(stamp);
+
+  stream_recorder_open(&source->recorder, path,
+                       (AVFormatContext *)source->format_context,
+                       source->video_stream_index, source->audio_stream_index);
+}
+
 /* 辅助: 尝试建立连接 */
 static bool try_connect(sei_receiver_source_t *source) {
   receiver_log(LOG_INFO, source, "Attempting to connect to: %s",
@@ -1049,40 +1604,80 @@ static bool try_connect(sei_receiver_source_t *source) {
   if (!fmt_ctx)
     return false;
 
+  /* 该URL解码成功过时使用缓存的参数, 跳过耗时数秒的完整探测 */
+  stream_params_t cached;
+  source->fast_start = stream_param_cache_get(source->srt_url, &cached);
+  source->connect_start_time = fast_clock_now_ns();
+  source->first_frame_decoded = false;
+  source->wait_keyframe = true;
+  source->keyframe_wait_packets = 0;
+
+  /* 原生libsrt接收: 连接后由自定义AVIO提供TS数据 */
+  const AVInputFormat *input_format = NULL;
+  if (source->srt_native && srt_input_available() &&
+      strncmp(source->srt_url, "srt://", 6) == 0) {
+    source->srt_input = srt_input_open(source->srt_url, &source->srt_options,
+                                       &source->thread_active);
+    if (!source->srt_input) {
+      receiver_log(LOG_WARNING, source,
+                   "Failed to connect (sender might be offline)");
+      avformat_free_context(fmt_ctx);
+      stream_params_free(&cached);
+      return false;
+    }
+    fmt_ctx->pb = srt_input_avio(source->srt_input);
+    fmt_ctx->flags |= AVFMT_FLAG_CUSTOM_IO;
+    input_format = av_find_input_format("mpegts");
+  }
+
   /* 设置超时，避免长时间阻塞 */
   AVDictionary *options = NULL;
   av_dict_set(&options, "timeout", "2000000", 0); /* 2秒超时 */
+  if (source->fast_start)
+    av_dict_set(&options, "probesize", FAST_START_PROBESIZE, 0);
 
   /* 直接使用配置的SRT URL (用户可以在URL中包含 ?streamid=xxx 等参数) */
-  if (avformat_open_input(&fmt_ctx, source->srt_url, NULL, &options) < 0) {
+  if (avformat_open_input(&fmt_ctx, source->srt_url, input_format,
+                          &options) < 0) {
     receiver_log(LOG_WARNING, source,
                  "Failed to open input (sender might be offline)");
     avformat_free_context(fmt_ctx);
     if (options)
       av_dict_free(&options);
+    stream_params_free(&cached);
+    srt_input_close(source->srt_input);
+    source->srt_input = NULL;
     return false;
   }
   if (options)
     av_dict_free(&options);
 
-  if (avformat_find_stream_info(fmt_ctx, NULL) < 0) {
-    receiver_log(LOG_ERROR, source, "Failed to find stream info");
-    avformat_close_input(&fmt_ctx);
-    return false;
+  if (source->fast_start) {
+    if (apply_cached_params(fmt_ctx, &cached)) {
+      receiver_log(LOG_INFO, source,
+                   "Fast start: using cached stream parameters");
+    } else {
+      receiver_log(LOG_INFO, source,
+                   "Streams differ from the cached parameters, probing");
+      source->fast_start = false;
+    }
+    stream_params_free(&cached);
   }
 
-  /* 查找视频流 */
-  int video_idx = -1;
-  for (unsigned int i = 0; i < fmt_ctx->nb_streams; i++) {
-    if (fmt_ctx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
-      video_idx = i;
-      break;
+  if (!source->fast_start) {
+    fmt_ctx->probesize = DEFAULT_PROBESIZE; /* 快速启动失败时恢复 */
+    if (avformat_find_stream_info(fmt_ctx, NULL) < 0) {
+      receiver_log(LOG_ERROR, source, "Failed to find stream info");
+      close_input(source, &fmt_ctx);
+      return false;
     }
   }
 
+  /* 查找视频流 */
+  int video_idx = find_first_stream(fmt_ctx, AVMEDIA_TYPE_VIDEO);
   if (video_idx == -1) {
     receiver_log(LOG_ERROR, source, "No video stream found");
-    avformat_close_input(&fmt_ctx);
+    close_input(source, &fmt_ctx);
     return false;
   }
 
@@ -1105,12 +1700,14 @@ static bool try_connect(sei_receiver_source_t *source) {
   if (!codec) {
     receiver_log(LOG_ERROR, source, "Video decoder not found for codec: %s",
                  codec_name);
-    avformat_close_input(&fmt_ctx);
+    close_input(source, &fmt_ctx);
     return false;
   }
 
   AVCodecContext *cctx = avcodec_alloc_context3(codec);
   avcodec_parameters_to_context(cctx, vstream->codecpar);
+  /* 数据包的opaque(到达时间)随解码帧输出, 见decode_and_extract_sei */
+  cctx->flags |= AV_CODEC_FLAG_COPY_OPAQUE;
 
   /* 配置硬件解码 */
   if (source->hw_decode_enabled && source->hw_device_ctx) {
@@ -1122,7 +1719,7 @@ static bool try_connect(sei_receiver_source_t *source) {
   if (avcodec_open2(cctx, codec, NULL) < 0) {
     receiver_log(LOG_ERROR, source, "Failed to open video codec");
     avcodec_free_context(&cctx);
-    avformat_close_input(&fmt_ctx);
+    close_input(source, &fmt_ctx);
     return false;
   }
 
@@ -1133,14 +1730,7 @@ static bool try_connect(sei_receiver_source_t *source) {
 
   /* 查找音频流 (可选) */
   source->audio_stream_index = -1;
-  int audio_idx = -1;
-  for (unsigned int i = 0; i < fmt_ctx->nb_streams; i++) {
-    if (fmt_ctx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_AUDIO) {
-      audio_idx = i;
-      break;
-    }
-  }
-
+  int audio_idx = find_first_stream(fmt_ctx, AVMEDIA_TYPE_AUDIO);
   if (audio_idx != -1) {
     AVStream *astream = fmt_ctx->streams[audio_idx];
     const AVCodec *acodec = avcodec_find_decoder(astream->codecpar->codec_id);
@@ -1153,39 +1743,141 @@ static bool try_connect(sei_receiver_source_t *source) {
         /* Audio format mapping simplified for brevity, assume valid */
         source->audio_channels = actx->ch_layout.nb_channels;
         source->audio_sample_rate = actx->sample_rate;
-        source->audio_format = AUDIO_FORMAT_FLOAT_PLANAR; /* Default safe */
-
-        switch (actx->sample_fmt) {
-        case AV_SAMPLE_FMT_S16:
-          source->audio_format = AUDIO_FORMAT_16BIT;
-          break;
-        case AV_SAMPLE_FMT_S16P:
-          source->audio_format = AUDIO_FORMAT_16BIT_PLANAR;
-          break;
-        case AV_SAMPLE_FMT_FLT:
-          source->audio_format = AUDIO_FORMAT_FLOAT;
-          break;
-        default:
-          break;
-        }
+        /* 样本格式由audio_resampler统一转换为平面float */
 
-        receiver_log(LOG_INFO, source, "Audio stream opened (idx: %d)",
-                     audio_idx);
+        receiver_log(LOG_INFO, source,
+                     "Audio stream opened (idx: %d, %u ch, %u Hz)", audio_idx,
+                     source->audio_channels, source->audio_sample_rate);
       } else {
         avcodec_free_context(&actx);
       }
     }
   }
 
+  /* 新连接可能对应重启过的发送端,链路时钟重新收敛;
+   * 原生接收时使用握手协商后的实际延迟 */
+  if (source->link_sync_enabled) {
+    int latency_ms = srt_input_latency_ms(source->srt_input);
+    link_clock_init(&source->link_clock,
+                    latency_ms > 0 ? (int64_t)latency_ms * 1000000
+                                   : get_srt_latency_ns(source->srt_url));
+  }
+
+  start_recording(source);
+
+  srt_stats_reset(&source->srt_stats);
+  source->last_srt_stats_time = fast_clock_now_ns();
+  source->has_capture_anchor = false;
+  live_stat_inc(&source->connect_count);
+
+  /* 新连接的PTS可能从新的起点开始: 按流的time_base和回绕位数重新展开,
+   * PTS时间线重新拟合 */
+  pts_unwrap_init(&source->video_pts, vstream->pts_wrap_bits,
+                  vstream->time_base.num, vstream->time_base.den);
+  if (source->audio_stream_index >= 0) {
+    AVStream *astream = fmt_ctx->streams[source->audio_stream_index];
+    pts_unwrap_init(&source->audio_pts, astream->pts_wrap_bits,
+                    astream->time_base.num, astream->time_base.den);
+  }
+  pts_timeline_init(&source->pts_timeline);
+  source->has_pts_offset = false;
+  receiver_log(LOG_INFO, source, "Video time base %d/%d, PTS wraps at %d bits",
+               vstream->time_base.num, vstream->time_base.den,
+               vstream->pts_wrap_bits);
+
   source->is_connected = true;
   receiver_log(LOG_INFO, source, "Connected successfully!");
   return true;
 }
 
+/* 本次连接的第一帧: 记录启动耗时, 校验并刷新参数缓存 */
+static void on_first_frame(sei_receiver_source_t *source) {
+  source->first_frame_decoded = true;
+  receiver_log(LOG_INFO, source,
+               "First frame %.0f ms after connect (%s, %u packets skipped "
+               "before keyframe)",
+               (double)(fast_clock_now_ns() - source->connect_start_time) /
+                   1e6,
+               source->fast_start ? "cached parameters" : "full probe",
+               source->keyframe_wait_packets);
+
+  /* 解码器已按码流内的参数集更新了分辨率等, 以它为准 */
+  AVFormatContext *fmt_ctx = (AVFormatContext *)source->format_context;
+  AVCodecContext *actx = (AVCodecContext *)source->audio_codec_context;
+  int audio_idx = find_first_stream(fmt_ctx, AVMEDIA_TYPE_AUDIO);
+
+  AVCodecParameters *video = avcodec_parameters_alloc();
+  AVCodecParameters *audio = NULL;
+  bool ok = video && avcodec_parameters_from_context(
+                         video, (AVCodecContext *)source->codec_context) >= 0;
+  if (ok && audio_idx >= 0) {
+    /* 音频解码器未能打开时保存流参数, 保持与节目表一致 */
+    audio = avcodec_parameters_alloc();
+    ok = audio &&
+         (actx ? avcodec_parameters_from_context(audio, actx)
+               : avcodec_parameters_copy(
+                     audio, fmt_ctx->streams[audio_idx]->codecpar)) >= 0;
+  }
+
+  if (ok) {
+    stream_params_t cached;
+    if (source->fast_start &&
+        stream_param_cache_get(source->srt_url, &cached)) {
+      if (cached.video->width != video->width ||
+          cached.video->height != video->height)
+        receiver_log(LOG_INFO, source,
+                     "Stream changed from %dx%d to %dx%d since the last "
+                     "connection",
+                     cached.video->width, cached.video->height,
+                     video->width, video->height);
+      stream_params_free(&cached);
+    }
+    stream_param_cache_put(source->srt_url, video, audio);
+  }
+
+  avcodec_parameters_free(&video);
+  avcodec_parameters_free(&audio);
+}
+
+/* 每秒采样一次传输统计; 有迟到帧时说明是否由链路引起(限频) */
+static void sample_srt_stats(sei_receiver_source_t *source) {
+  uint64_t now = fast_clock_now_ns();
+  if (now - source->last_srt_stats_time < SRT_STATS_INTERVAL_NS)
+    return;
+  source->last_srt_stats_time = now;
+
+  srt_input_stats_t transport;
+  bool has_transport = srt_input_get_stats(source->srt_input, &transport);
+  srt_late_cause_t cause = srt_stats_update(
+      &source->srt_stats, has_transport ? &transport : NULL);
+  if (cause == SRT_LATE_NONE ||
+      (source->last_late_warning_time &&
+       now - source->last_late_warning_time < LATE_WARNING_INTERVAL_NS))
+    return;
+  source->last_late_warning_time = now;
+
+  srt_stats_snapshot_t snapshot;
+  srt_stats_snapshot(&source->srt_stats, &snapshot);
+  if (cause == SRT_LATE_TRANSPORT)
+    receiver_log(LOG_WARNING, source,
+                 "Late frames caused by the SRT link: arrival +%.1f ms, "
+                 "RTT %.1f ms, loss %.2f%%, buffer %ld/%ld ms",
+                 snapshot.excess_ms, snapshot.rtt_ms, snapshot.loss_percent,
+                 snapshot.rcv_buf_ms, snapshot.latency_ms);
+  else
+    receiver_log(LOG_WARNING, source,
+                 "Late frames %s: arrival +%.1f ms, check the sender or "
+                 "clock sync",
+                 has_transport ? "without SRT loss or retransmits"
+                               : "(no SRT transport stats)",
+                 snapshot.excess_ms);
+}
+
 /* SRT接收线程 (负责连接管理及数据接收) */
 static void *srt_receive_thread(void *data) {
   sei_receiver_source_t *source = (sei_receiver_source_t *)data;
   receiver_log(LOG_INFO, source, "Thread started (Auto-Reconnect Mode)");
+  TRACE_THREAD_BEGIN(obs_source_get_name(source->context));
 
   // struct os_timespec ts; // Removed unused variable
   // ts.tv_sec = 1;
@@ -1209,8 +1901,10 @@ static void *srt_receive_thread(void *data) {
 
     /* 2. 读取数据 (已连接状态) */
     if (source->is_connected && source->format_context) {
+      TRACE_START(trace_read);
       int ret =
           av_read_frame((AVFormatContext *)source->format_context, packet);
+      TRACE_RECEIVE(trace_read, source, "av_read_frame");
 
       if (ret < 0) {
         /* 读取错误或EOF -> 断开连接，准备重连 */
@@ -1222,24 +1916,46 @@ static void *srt_receive_thread(void *data) {
         cleanup_connection(source);
         continue; /* 回到循环顶部，触发重连 */
       }
+      source->packet_arrival_time = fast_clock_now_ns();
+
+      /* 录像在解码之前, 解码失败的包也会被保存 */
+      TRACE_START(trace_record);
+      stream_recorder_write(&source->recorder, packet);
+      TRACE_RECEIVE(trace_record, source, "stream_recorder_write");
 
       /* 3. 处理数据包 */
       if (packet->stream_index == source->video_stream_index) {
-        video_frame_data_t frame = {0};
-        if (decode_and_extract_sei(source, packet, &frame)) {
-          source->frames_rendered++;
+        live_stat_inc(&source->frames_received);
+        /* 从关键帧开始解码, 之前的帧缺少参考帧只会产生解码错误 */
+        if (source->wait_keyframe && !(packet->flags & AV_PKT_FLAG_KEY) &&
+            source->keyframe_wait_packets < KEYFRAME_WAIT_LIMIT) {
+          source->keyframe_wait_packets++;
+          live_stat_inc(&source->frames_dropped);
+        } else {
+          source->wait_keyframe = false;
+          video_frame_data_t frame = {0};
+          if (decode_and_extract_sei(source, packet, &frame)) {
+            live_stat_inc(&source->frames_rendered);
+            if (!source->first_frame_decoded)
+              on_first_frame(source);
+          }
         }
       } else if (source->audio_stream_index >= 0 &&
                  packet->stream_index == source->audio_stream_index) {
+        TRACE_START(trace_audio);
         decode_audio(source, packet);
+        TRACE_RECEIVE(trace_audio, source, "decode_audio");
       }
 
       av_packet_unref(packet);
+      sample_srt_stats(source);
+      e2e_latency_update(&source->e2e_latency, source->packet_arrival_time);
     }
   }
 
   av_packet_free(&packet);
   cleanup_connection(source);
+  TRACE_THREAD_END();
   receiver_log(LOG_INFO, source, "Thread stopped");
   return NULL;
 }
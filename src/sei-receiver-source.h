@@ -7,8 +7,17 @@
 
 #pragma once
 
+#include "audio-resampler.h"
+#include "e2e-latency.h"
+#include "link-clock.h"
+#include "live-stats.h"
 #include "ntp-client.h"
+#include "pts-timeline.h"
 #include "sei-handler.h"
+#include "srt-input.h"
+#include "srt-stats.h"
+#include "stream-param-cache.h"
+#include "stream-recorder.h"
 #include <libavcodec/avcodec.h> /* AVPacket */
 #include <obs-module.h>
 #include <util/threading.h> /* OBS线程API */
@@ -31,7 +40,8 @@ typedef enum {
 typedef struct video_frame_data {
   uint8_t *data;            /* 帧数据 */
   size_t size;              /* 数据大小 */
-  int64_t pts;              /* 显示时间戳 */
+  int64_t pts;              /* 显示时间戳(纳秒, 已展开回绕) */
+  bool has_pts;             /* 解码器给出了PTS(否则pts为本地时间) */
   ntp_timestamp_t ntp_time; /* NTP时间戳(从SEI提取) */
   bool has_ntp;             /* 是否包含NTP时间戳 */
   uint32_t width;           /* 视频宽度 */
@@ -58,6 +68,11 @@ typedef struct sei_receiver_source {
   pthread_t receive_thread;    /* 接收线程 */
   volatile bool thread_active; /* 线程活动标志 */
 
+  /* 原生libsrt接收 (关闭时使用FFmpeg的srt://协议) */
+  bool srt_native;                 /* 是否使用原生接收 */
+  srt_input_options_t srt_options; /* 延迟/缓冲区/载荷设置 */
+  srt_input_t *srt_input;          /* 当前连接, 由接收线程管理 */
+
   /* 视频解码 */
   void *format_context;       /* FFmpeg format上下文（demux） */
   void *decoder_context;      /* FFmpeg解码器上下文 */
@@ -76,6 +91,17 @@ typedef struct sei_receiver_source {
   /* 编码格式 */
   char codec_type[16]; /* 编码格式类型 (h264/h265/av1) */
 
+  /* 录像 (收到的码流直接复制为TS, 并写入.ssix时间戳索引) */
+  char record_dir[512];       /* 录像目录, 空表示不录制 */
+  stream_recorder_t recorder; /* 每次连接一个文件 */
+
+  /* 快速启动 (重连时用缓存的流参数代替完整探测) */
+  bool fast_start;                /* 本次连接使用了缓存的参数 */
+  bool wait_keyframe;             /* 丢弃首个关键帧之前的视频包 */
+  uint32_t keyframe_wait_packets; /* 等待关键帧期间丢弃的包数 */
+  uint64_t connect_start_time;    /* 开始连接的时间(纳秒) */
+  bool first_frame_decoded;       /* 本次连接已解码出第一帧 */
+
   /* NTP同步 */
   ntp_client_t ntp_client;         /* NTP客户端 */
   bool ntp_enabled;                /* NTP是否启用 */
@@ -84,6 +110,18 @@ typedef struct sei_receiver_source {
   uint64_t last_ntp_sync_time;     /* 上次NTP同步的本地时间(纳秒) */
   uint32_t ntp_drift_threshold_ms; /* NTP漂移阈值（毫秒） */
   uint32_t ntp_sync_interval_ms;   /* NTP最小同步间隔（毫秒） */
+  bool ntp_master_active;          /* 是否作为局域网时间主机运行 */
+  uint16_t ntp_master_port;        /* 时间主机监听端口 */
+
+  /* Prometheus指标端点 (进程内共享的HTTP服务器) */
+  bool metrics_active;   /* 是否持有共享指标服务器的引用 */
+  char metrics_bind[64]; /* 监听地址 */
+  uint16_t metrics_port; /* 监听端口 */
+
+  /* 链路时钟同步(无需NTP服务器,由SEI时间戳估计发送端时钟偏移) */
+  bool link_sync_enabled;       /* 同步模式是否为 srt_link */
+  link_clock_t link_clock;      /* 链路时钟估计器 */
+  uint64_t packet_arrival_time; /* 当前数据包到达的本地时间(纳秒) */
 
   /* 帧同步 */
   frame_buffer_t frame_buffer; /* 帧缓冲区 */
@@ -93,28 +131,54 @@ typedef struct sei_receiver_source {
   uint64_t first_local_time;   /* 第一帧本地时间 */
 
   /* PTS同步 */
-  int64_t pts_offset;  /* PTS 到 SystemTime 的偏移量 */
-  bool has_pts_offset; /* 是否已计算偏移量 */
+  int64_t pts_offset;          /* PTS 到 SystemTime 的偏移量 */
+  bool has_pts_offset;         /* 是否已计算偏移量 */
+  pts_unwrap_t video_pts;      /* 视频PTS回绕展开(按流的time_base) */
+  pts_unwrap_t audio_pts;      /* 音频PTS回绕展开 */
+  pts_timeline_t pts_timeline; /* PTS到发送端NTP时间的回归 */
 
   /* 音频解码 */
-  void *audio_codec_context;      /* FFmpeg音频相关codec上下文 */
-  int audio_stream_index;         /* 音频流索引 */
-  enum audio_format audio_format; /* OBS音频格式 */
-  uint32_t audio_channels;        /* 声道数 */
-  uint32_t audio_sample_rate;     /* 采样率 */
-
-  /* 统计信息 */
-  uint64_t frames_received;       /* 接收的总帧数 */
-  uint64_t frames_rendered;       /* 渲染的总帧数 */
-  uint64_t frames_dropped;        /* 丢弃的帧数 */
-  uint64_t sei_found_count;       /* 找到SEI的帧数 */
+  void *audio_codec_context;         /* FFmpeg音频相关codec上下文 */
+  int audio_stream_index;            /* 音频流索引 */
+  uint32_t audio_channels;           /* 声道数 */
+  uint32_t audio_sample_rate;        /* 采样率 */
+  audio_resampler_t audio_resampler; /* 转为平面float并补偿时钟漂移 */
+
+  /* 统计信息 (只由接收线程写入, os_atomic发布, 任意线程可随时读取) */
+  volatile long frames_received;  /* 收到的视频包数 */
+  volatile long frames_rendered;  /* 输出到OBS的帧数 */
+  volatile long frames_dropped;   /* 丢弃的包(等待关键帧/解码失败) */
+  volatile long sei_found_count;  /* 找到SEI的帧数 */
+  volatile long decode_errors;    /* 累计解码错误 */
+  volatile long connect_count;    /* 成功连接的次数 */
+  volatile long fps_centi;        /* 当前帧率 x100 */
+  volatile long sei_rate_centi;   /* SEI检测率(%) x100 */
+  volatile long ntp_offset_us;    /* NTP时间 - 本地时间 (NTP模式) */
+  volatile long ntp_jitter_us;    /* NTP偏移变化的平滑平均 */
   uint64_t last_sync_frame_count; /* 上次同步时的帧数 */
+  live_histogram_t decode_time;   /* 送入解码器到取出帧 */
+  live_histogram_t convert_time;  /* 硬件帧下载 + 转换为BGRA */
 
-  /* 实时统计 */
+  /* 实时统计 (接收线程私有) */
   uint64_t last_stats_update_time; /* 上次统计更新时间(ns) */
-  uint64_t stats_frame_count;      /* 统计周期内的帧数 */
-  float current_fps;               /* 当前帧率 */
-  float sei_detection_rate;        /* SEI检测率(%) */
+  long stats_frame_count;          /* 上次统计时的渲染帧数 */
+  bool has_ntp_offset;             /* last_ntp_offset_ns有效 */
+  int64_t last_ntp_offset_ns;      /* 上次统计时的NTP偏移 */
+  int64_t ntp_jitter_ns;           /* ntp_jitter_us的完整精度 */
+
+  /* 所有接收源的链表 (指标导出用, 由模块内的互斥锁保护) */
+  struct sei_receiver_source *next_registered;
+
+  /* SRT传输统计 (接收线程每秒采样, 原子发布) */
+  srt_stats_t srt_stats;           /* 链路状态及迟到帧归因 */
+  uint64_t last_srt_stats_time;    /* 上次采样时间(ns) */
+  uint64_t last_late_warning_time; /* 上次迟到帧警告时间(ns) */
+
+  /* 端到端延迟 (发送端采集 -> 到达/解码完成/交给OBS, 仅NTP模式) */
+  e2e_latency_t e2e_latency;  /* 滑动窗口直方图, 接收线程写入 */
+  bool has_capture_anchor;    /* 最近一个带时间戳帧的采集时间有效 */
+  int64_t capture_anchor_ns;  /* 其采集时间(已换算到本地时钟) */
+  int64_t capture_anchor_pts; /* 其PTS(纳秒), 用于推算无时间戳的帧 */
 
   /* 错误恢复 */
   uint32_t decode_error_count;     /* 连续解码错误计数 */
@@ -122,6 +186,34 @@ typedef struct sei_receiver_source {
 
 } sei_receiver_source_t;
 
+/* 统计快照 (见receiver_get_stats) */
+typedef struct receiver_stats {
+  bool connected;
+  long frames_received;
+  long frames_rendered;
+  long frames_dropped;
+  long sei_found;
+  long decode_errors;
+  long connect_count;
+  double fps;
+  double sei_rate;      /* % */
+  double ntp_offset_ms; /* NTP时间 - 本地时间 */
+  double ntp_jitter_ms;
+  live_histogram_snapshot_t decode_time;
+  live_histogram_snapshot_t convert_time;
+  srt_stats_snapshot_t srt;
+  e2e_latency_snapshot_t latency;
+  double audio_correction_ppm; /* 音频速率调整 */
+  double audio_error_ms;       /* 音频时间线误差 */
+  long audio_resyncs;          /* 音频时间线重置次数 */
+} receiver_stats_t;
+
+/* 按源名复制的快照 (见receiver_stats_collect) */
+typedef struct receiver_stats_entry {
+  char name[128];
+  receiver_stats_t stats;
+} receiver_stats_entry_t;
+
 /* 源插件信息 */
 extern struct obs_source_info sei_receiver_source_info;
 
@@ -163,6 +255,17 @@ void *srt_receive_thread(void *data);
 bool decode_and_extract_sei(sei_receiver_source_t *source, AVPacket *packet,
                             video_frame_data_t *frame_out);
 
+/**
+ * 读取统计快照 (任意线程, 不加锁; 源的proc handler "get_stats"同样提供)
+ */
+void receiver_get_stats(sei_receiver_source_t *source,
+                        receiver_stats_t *stats);
+
+/**
+ * 复制所有接收源的名字和统计快照 (entries由调用者bfree), 返回数量
+ */
+size_t receiver_stats_collect(receiver_stats_entry_t **entries);
+
 /**
  * 计算帧显示时间
  */
@@ -6,6 +6,7 @@
 ******************************************************************************/
 
 #include "sei-stamper-encoder.h"
+#include "packet-pool.h"
 #include <obs-avc.h>
 #include <util/bmem.h>
 #include <util/dstr.h>
@@ -32,6 +33,98 @@ static const char *av1_encoder_getname(void *unused) {
   return "SEI Stamper (AV1)";
 }
 
+/* OBS原生格式与libavcodec像素格式的对应关系 (平面布局相同,可直接包装) */
+static const struct {
+  enum video_format obs_format;
+  enum AVPixelFormat av_format;
+} format_map[] = {
+    {VIDEO_FORMAT_NV12, AV_PIX_FMT_NV12},
+    {VIDEO_FORMAT_I420, AV_PIX_FMT_YUV420P},
+    {VIDEO_FORMAT_I444, AV_PIX_FMT_YUV444P},
+    {VIDEO_FORMAT_P010, AV_PIX_FMT_P010LE},
+    {VIDEO_FORMAT_I010, AV_PIX_FMT_YUV420P10LE},
+};
+
+static enum AVPixelFormat obs_to_av_format(enum video_format format) {
+  for (size_t i = 0; i < sizeof(format_map) / sizeof(format_map[0]); i++) {
+    if (format_map[i].obs_format == format)
+      return format_map[i].av_format;
+  }
+  return AV_PIX_FMT_NONE;
+}
+
+static bool codec_supports_format(const AVCodec *codec,
+                                  enum AVPixelFormat format) {
+  /* 未列出格式的编码器: 交给avcodec_open2判断 */
+  if (!codec->pix_fmts)
+    return true;
+
+  for (const enum AVPixelFormat *p = codec->pix_fmts; *p != AV_PIX_FMT_NONE;
+       p++) {
+    if (*p == format)
+      return true;
+  }
+  return false;
+}
+
+/* 选择输入格式: 优先OBS当前输出格式,其次同位深的另一种布局,最后回退到8位 */
+static enum video_format select_input_format(const AVCodec *codec,
+                                             enum video_format native) {
+  enum video_format candidates[4];
+  size_t count = 0;
+
+  candidates[count++] = native;
+  if (native == VIDEO_FORMAT_P010)
+    candidates[count++] = VIDEO_FORMAT_I010;
+  else if (native == VIDEO_FORMAT_I010)
+    candidates[count++] = VIDEO_FORMAT_P010;
+  candidates[count++] = VIDEO_FORMAT_NV12;
+  candidates[count++] = VIDEO_FORMAT_I420;
+
+  for (size_t i = 0; i < count; i++) {
+    enum AVPixelFormat av_format = obs_to_av_format(candidates[i]);
+    if (av_format != AV_PIX_FMT_NONE &&
+        codec_supports_format(codec, av_format))
+      return candidates[i];
+  }
+  return VIDEO_FORMAT_NONE;
+}
+
+/* 色彩信息 (HDR需要正确的原色和传输特性) */
+static void set_color_info(AVCodecContext *ctx,
+                           const struct video_output_info *voi) {
+  ctx->color_range =
+      voi->range == VIDEO_RANGE_FULL ? AVCOL_RANGE_JPEG : AVCOL_RANGE_MPEG;
+
+  switch (voi->colorspace) {
+  case VIDEO_CS_601:
+    ctx->color_primaries = AVCOL_PRI_SMPTE170M;
+    ctx->color_trc = AVCOL_TRC_SMPTE170M;
+    ctx->colorspace = AVCOL_SPC_SMPTE170M;
+    break;
+  case VIDEO_CS_SRGB:
+    ctx->color_primaries = AVCOL_PRI_BT709;
+    ctx->color_trc = AVCOL_TRC_IEC61966_2_1;
+    ctx->colorspace = AVCOL_SPC_BT709;
+    break;
+  case VIDEO_CS_2100_PQ:
+    ctx->color_primaries = AVCOL_PRI_BT2020;
+    ctx->color_trc = AVCOL_TRC_SMPTE2084;
+    ctx->colorspace = AVCOL_SPC_BT2020_NCL;
+    break;
+  case VIDEO_CS_2100_HLG:
+    ctx->color_primaries = AVCOL_PRI_BT2020;
+    ctx->color_trc = AVCOL_TRC_ARIB_STD_B67;
+    ctx->colorspace = AVCOL_SPC_BT2020_NCL;
+    break;
+  default:
+    ctx->color_primaries = AVCOL_PRI_BT709;
+    ctx->color_trc = AVCOL_TRC_BT709;
+    ctx->colorspace = AVCOL_SPC_BT709;
+    break;
+  }
+}
+
 /* 销毁编码器 */
 static void sei_stamper_encoder_destroy(void *data) {
   struct sei_stamper_encoder *enc = data;
@@ -46,16 +139,14 @@ static void sei_stamper_encoder_destroy(void *data) {
   if (enc->frame) {
     av_frame_free(&enc->frame);
   }
-  if (enc->packet) {
-    av_packet_free(&enc->packet);
-  }
+  encoder_packet_queue_free(&enc->packet_queue);
 
   if (enc->ntp_enabled) {
     ntp_client_destroy(&enc->ntp_client);
   }
 
   bfree(enc->merged_sei_buffer);
-  bfree(enc->packet_buffer);
+  packet_pool_release(enc->packet_buffer);
   bfree(enc->preset);
   bfree(enc->profile);
   bfree(enc->rate_control);
@@ -124,35 +215,29 @@ static void *sei_stamper_encoder_create(obs_data_t *settings,
   enc->codec_context->height = (int)obs_encoder_get_height(encoder);
   enc->codec_context->time_base = (AVRational){voi->fps_den, voi->fps_num};
   enc->codec_context->framerate = (AVRational){voi->fps_num, voi->fps_den};
-  enc->codec_context->pix_fmt = AV_PIX_FMT_NV12; /* Default to NV12 for now */
-
-  /* 检查像素格式支持 */
-  if (enc->codec->pix_fmts) {
-    const enum AVPixelFormat *p = enc->codec->pix_fmts;
-    bool nv12_supported = false;
-
-    encoder_log(LOG_INFO, enc, "Checking supported pixel formats:");
-    while (*p != AV_PIX_FMT_NONE) {
-      encoder_log(LOG_INFO, enc, "  - %d", *p);
-      if (*p == AV_PIX_FMT_NV12)
-        nv12_supported = true;
-      p++;
-    }
 
-    if (nv12_supported) {
-      enc->codec_context->pix_fmt = AV_PIX_FMT_NV12;
-    } else {
-      enc->codec_context->pix_fmt =
-          enc->codec->pix_fmts[0]; /* Use first supported */
-      encoder_log(LOG_WARNING, enc, "NV12 not supported, using format %d",
-                  enc->codec_context->pix_fmt);
-    }
+  /* 选择输入格式: 让OBS直接输出编码器支持的格式,编码时无需逐帧转换 */
+  enc->obs_format = select_input_format(enc->codec, voi->format);
+  if (enc->obs_format == VIDEO_FORMAT_NONE) {
+    encoder_log(LOG_ERROR, enc,
+                "Encoder supports none of NV12/I420/I444/P010/I010");
+    sei_stamper_encoder_destroy(enc);
+    return NULL;
+  }
+  enc->codec_context->pix_fmt = obs_to_av_format(enc->obs_format);
+
+  if (enc->obs_format != voi->format) {
+    encoder_log(LOG_WARNING, enc,
+                "%s does not accept %s, OBS will convert to %s", codec_name,
+                get_video_format_name(voi->format),
+                get_video_format_name(enc->obs_format));
   } else {
-    /* Some encoders don't list fmts, assume NV12 or YUV420P */
-    enc->codec_context->pix_fmt = AV_PIX_FMT_NV12;
-    encoder_log(LOG_WARNING, enc, "Encoder didn't list formats, assuming NV12");
+    encoder_log(LOG_INFO, enc, "Using native input format: %s",
+                get_video_format_name(enc->obs_format));
   }
 
+  set_color_info(enc->codec_context, voi);
+
   /* 设置编码参数 */
   enc->codec_context->bit_rate = enc->bitrate * 1000;
   enc->codec_context->gop_size = enc->keyint_sec * voi->fps_num / voi->fps_den;
@@ -223,6 +308,14 @@ static void *sei_stamper_encoder_create(obs_data_t *settings,
         enc->codec_context->bit_rate; /* 1s buffer */
   }
 
+  /* 优先让编码器通过帧附加数据写入时间戳SEI,省去编码后的整包拷贝 */
+  if (obs_data_get_bool(settings, "sei_side_data") &&
+      enc->codec_type != SEI_STAMPER_CODEC_AV1) {
+    enc->sei_side_data = encoder_sei_enable_side_data(enc->codec_context);
+  }
+  encoder_log(LOG_INFO, enc, "Timestamp SEI: %s",
+              enc->sei_side_data ? "frame side data" : "spliced after encode");
+
   /* 打印错误信息 (Helper) */
   char errbuf[128];
   int ret;
@@ -241,7 +334,13 @@ static void *sei_stamper_encoder_create(obs_data_t *settings,
 
   /* 分配Frame和Packet */
   enc->frame = av_frame_alloc();
-  enc->packet = av_packet_alloc();
+  capture_time_ring_init(&enc->capture_times,
+                         enc->codec_context->time_base.num);
+  if (!encoder_packet_queue_init(&enc->packet_queue)) {
+    encoder_log(LOG_ERROR, enc, "Failed to allocate packet queue");
+    sei_stamper_encoder_destroy(enc);
+    return NULL;
+  }
 
   /* 初始化NTP */
   const char *ntp_server = obs_data_get_string(settings, "ntp_server");
@@ -287,6 +386,25 @@ static bool sei_stamper_encoder_encode(void *data, struct encoder_frame *frame,
   if (!frame || !packet || !received_packet)
     return false;
 
+  /* OBS在上一次encode返回后已复制packet数据,把buffer归还到池 */
+  packet_pool_release(enc->packet_buffer);
+  enc->packet_buffer = NULL;
+
+  /* 更新NTP时间 */
+  if (enc->ntp_enabled) {
+    uint64_t now = fast_clock_now_ns();
+    if (enc->last_ntp_sync_time == 0 ||
+        (now - enc->last_ntp_sync_time) > 60000000000ULL) { // 1 min sync
+      if (ntp_client_sync(&enc->ntp_client))
+        enc->last_ntp_sync_time = now;
+    }
+    ntp_client_get_time_or_local(&enc->ntp_client, &enc->current_ntp_time);
+
+    /* 记录该帧送入编码器的时间,输出时按PTS取回(B帧/lookahead会打乱顺序) */
+    capture_time_ring_put(&enc->capture_times, frame->pts,
+                          &enc->current_ntp_time);
+  }
+
   /* 清理上一帧的状态（如果有）- 重要：防止引用泄露，也防止脏数据 */
   av_frame_unref(enc->frame);
 
@@ -299,22 +417,22 @@ static bool sei_stamper_encoder_encode(void *data, struct encoder_frame *frame,
   enc->frame->height = enc->codec_context->height;
   enc->frame->pts = frame->pts;
 
-  /* 只有NV12支持目前 */
-  if (enc->codec_context->pix_fmt == AV_PIX_FMT_NV12) {
-    enc->frame->linesize[0] = frame->linesize[0];
-    enc->frame->linesize[1] = frame->linesize[1];
-    enc->frame->data[0] = frame->data[0];
-    enc->frame->data[1] = frame->data[1];
-  } else {
-    /* Try generic copy if linesizes match, but safest is assume NV12 or copy
-     * plane by plane */
-    encoder_log(LOG_ERROR, enc, "Unsupported pixel format in encode: %d",
-                enc->codec_context->pix_fmt);
-    return false;
+  /* OBS已按选定格式输出,平面布局与pix_fmt一致,直接包装
+     (NV12/P010为2个平面, I420/I444/I010为3个平面) */
+  for (int i = 0; i < MAX_AV_PLANES && frame->data[i]; i++) {
+    enc->frame->data[i] = frame->data[i];
+    enc->frame->linesize[i] = frame->linesize[i];
   }
 
+  /* 由编码器写入SEI: 每帧都挂上时间戳, 关键帧由编码器自己决定 */
+  if (enc->ntp_enabled && enc->sei_side_data &&
+      !encoder_sei_attach(enc->frame, &enc->current_ntp_time))
+    encoder_log(LOG_WARNING, enc, "Failed to attach SEI side data");
+
   /* 发送Frame给编码器 */
-  int ret = avcodec_send_frame(enc->codec_context, enc->frame);
+  int ret = encoder_packet_queue_send_frame(
+      &enc->packet_queue, enc->codec_context, enc->frame,
+      &enc->current_ntp_time);
 
   /* 发送后立即解除引用，不仅是为了清理，也是为了断开与OBS数据的关联
      FFmpeg如果内部需要保留数据（异步编码），它在send_frame时已经做了深拷贝（因为buf为NULL）
@@ -328,41 +446,49 @@ static bool sei_stamper_encoder_encode(void *data, struct encoder_frame *frame,
     return false;
   }
 
-  /* 接收Packets */
-  ret = avcodec_receive_packet(enc->codec_context, enc->packet);
-  if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
-    *received_packet = false;
-    return true;
-  } else if (ret < 0) {
+  /* 取出编码器中所有就绪的Packet,避免在libavcodec内部堆积 */
+  ret = encoder_packet_queue_drain(&enc->packet_queue, enc->codec_context,
+                                   &enc->current_ntp_time);
+  if (ret < 0) {
     av_strerror(ret, errbuf, sizeof(errbuf));
     encoder_log(LOG_ERROR, enc, "Error receiving packet from encoder: %s (%d)",
                 errbuf, ret);
     return false;
   }
 
-  *received_packet = true;
+  /* 每次调用按顺序交给OBS一个 */
+  const encoder_queued_packet_t *queued =
+      encoder_packet_queue_pop(&enc->packet_queue);
+  if (!queued) {
+    *received_packet = false;
+    return true;
+  }
 
-  /* 更新NTP时间 */
-  if (enc->ntp_enabled) {
-    uint64_t now = os_gettime_ns();
-    if (enc->last_ntp_sync_time == 0 ||
-        (now - enc->last_ntp_sync_time) > 60000000000ULL) { // 1 min sync
-      if (ntp_client_sync(&enc->ntp_client))
-        enc->last_ntp_sync_time = now;
-    }
-    ntp_client_get_time(&enc->ntp_client, &enc->current_ntp_time);
+  if (enc->packet_queue.count > 0) {
+    encoder_log(LOG_DEBUG, enc, "%zu packet(s) still queued",
+                enc->packet_queue.count);
   }
 
-  /* 处理SEI插入 (仅对关键帧插入时间戳) */
+  const AVPacket *pkt = queued->packet;
+  *received_packet = true;
+
+  /* 编码后拼接SEI (仅对关键帧插入时间戳; 编码器已按附加数据写入时跳过) */
+  bool keyframe = (pkt->flags & AV_PKT_FLAG_KEY) != 0;
+  bool has_stamp =
+      keyframe && enc->sei_side_data &&
+      encoder_sei_packet_has_stamp(pkt,
+                                   enc->codec_type == SEI_STAMPER_CODEC_H265);
   bool has_sei = false;
   uint8_t *sei_nal = NULL;
   size_t sei_nal_size = 0;
 
-  if (enc->ntp_enabled && (enc->packet->flags & AV_PKT_FLAG_KEY)) {
+  if (enc->ntp_enabled && keyframe && !has_stamp) {
     uint8_t *payload = NULL;
     size_t payload_size = 0;
-    if (build_ntp_sei_payload(frame->pts, &enc->current_ntp_time, &payload,
-                              &payload_size)) {
+    /* 使用Packet自身的PTS及其送入时间: 有B帧时与当前输入帧不同 */
+    ntp_timestamp_t stamp = queued->ntp_time;
+    capture_time_ring_get(&enc->capture_times, pkt->pts, &stamp);
+    if (build_ntp_sei_payload(pkt->pts, &stamp, &payload, &payload_size)) {
       /* 根据编码器类型选择SEI NAL类型 */
       sei_nal_type_t nal_type = SEI_NAL_H264;
       if (enc->codec_type == SEI_STAMPER_CODEC_H265) {
@@ -380,12 +506,13 @@ static bool sei_stamper_encoder_encode(void *data, struct encoder_frame *frame,
   }
 
   /* 组装最终Packet数据 */
-  size_t total_size = enc->packet->size + (has_sei ? sei_nal_size : 0);
+  size_t total_size = pkt->size + (has_sei ? sei_nal_size : 0);
 
-  if (enc->packet_buffer_size < total_size) {
-    bfree(enc->packet_buffer);
-    enc->packet_buffer = bmalloc(total_size);
-    enc->packet_buffer_size = total_size;
+  enc->packet_buffer = packet_pool_acquire(total_size);
+  if (!enc->packet_buffer) {
+    encoder_log(LOG_ERROR, enc, "Failed to allocate packet buffer");
+    bfree(sei_nal);
+    return false;
   }
 
   size_t offset = 0;
@@ -396,16 +523,15 @@ static bool sei_stamper_encoder_encode(void *data, struct encoder_frame *frame,
     bfree(sei_nal);
   }
 
-  memcpy(enc->packet_buffer + offset, enc->packet->data, enc->packet->size);
+  memcpy(enc->packet_buffer + offset, pkt->data, pkt->size);
 
   packet->data = enc->packet_buffer;
   packet->size = total_size;
   packet->type = OBS_ENCODER_VIDEO;
-  packet->pts = enc->packet->pts;
-  packet->dts = enc->packet->dts;
-  packet->keyframe = (enc->packet->flags & AV_PKT_FLAG_KEY) != 0;
+  packet->pts = pkt->pts;
+  packet->dts = pkt->dts;
+  packet->keyframe = keyframe;
 
-  av_packet_unref(enc->packet);
   return true;
 }
 
@@ -432,6 +558,8 @@ static void sei_stamper_encoder_defaults(obs_data_t *settings) {
   obs_data_set_default_string(settings, "profile", "high");
   obs_data_set_default_string(settings, "rate_control", "CBR");
 
+  obs_data_set_default_bool(settings, "sei_side_data", true);
+
   obs_data_set_default_bool(settings, "ntp_enabled", true);
   obs_data_set_default_string(settings, "ntp_server", "time.windows.com");
   obs_data_set_default_int(settings, "ntp_port", 123);
@@ -472,6 +600,8 @@ static obs_properties_t *sei_stamper_encoder_properties(void *unused) {
 
   obs_properties_add_text(props, "profile", "Profile (e.g. high, main)",
                           OBS_TEXT_DEFAULT);
+  obs_properties_add_bool(props, "sei_side_data",
+                          "Let Encoder Write Timestamp SEI");
 
   /* NTP设置 */
   obs_properties_add_bool(props, "ntp_enabled", "Enable NTP Sync");
@@ -481,11 +611,19 @@ static obs_properties_t *sei_stamper_encoder_properties(void *unused) {
   return props;
 }
 
+/* 告诉OBS按选定的格式输出帧 */
+static void sei_stamper_encoder_video_info(void *data,
+                                           struct video_scale_info *info) {
+  struct sei_stamper_encoder *enc = data;
+  info->format = enc->obs_format;
+}
+
 /* H.264 编码器回调 */
-static void sei_stamper_encoder_update(void *data, obs_data_t *settings) {
+static bool sei_stamper_encoder_update(void *data, obs_data_t *settings) {
   /* 更新编码器设置（如果需要运行时更新）*/
   UNUSED_PARAMETER(data);
   UNUSED_PARAMETER(settings);
+  return true;
 }
 
 struct obs_encoder_info sei_stamper_h264_encoder_info = {
@@ -500,6 +638,7 @@ struct obs_encoder_info sei_stamper_h264_encoder_info = {
     .get_defaults = sei_stamper_encoder_defaults,
     .get_properties = sei_stamper_encoder_properties,
     .get_extra_data = sei_stamper_encoder_extra_data,
+    .get_video_info = sei_stamper_encoder_video_info,
     .caps = OBS_ENCODER_CAP_DEPRECATED | OBS_ENCODER_CAP_PASS_TEXTURE,
 };
 
@@ -515,6 +654,7 @@ struct obs_encoder_info sei_stamper_h265_encoder_info = {
     .get_defaults = sei_stamper_encoder_defaults,
     .get_properties = sei_stamper_encoder_properties,
     .get_extra_data = sei_stamper_encoder_extra_data,
+    .get_video_info = sei_stamper_encoder_video_info,
     .caps = OBS_ENCODER_CAP_DEPRECATED | OBS_ENCODER_CAP_PASS_TEXTURE,
 };
 
@@ -530,5 +670,6 @@ struct obs_encoder_info sei_stamper_av1_encoder_info = {
     .get_defaults = sei_stamper_encoder_defaults,
     .get_properties = sei_stamper_encoder_properties,
     .get_extra_data = sei_stamper_encoder_extra_data,
+    .get_video_info = sei_stamper_encoder_video_info,
     .caps = OBS_ENCODER_CAP_DEPRECATED | OBS_ENCODER_CAP_PASS_TEXTURE,
 };
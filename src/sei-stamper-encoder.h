@@ -7,6 +7,9 @@
 
 #pragma once
 
+#include "capture-time-ring.h"
+#include "encoder-packet-queue.h"
+#include "encoder-sei.h"
 #include "ntp-client.h"
 #include "sei-handler.h"
 #include <obs-module.h>
@@ -18,6 +21,13 @@ extern "C" {
 #include <libavcodec/avcodec.h>
 #include <libavutil/opt.h>
 
+/* 编码器类型 */
+enum sei_stamper_codec_type {
+  SEI_STAMPER_CODEC_H264,
+  SEI_STAMPER_CODEC_H265,
+  SEI_STAMPER_CODEC_AV1
+};
+
 /* 编码器包装器上下文 */
 struct sei_stamper_encoder {
   obs_encoder_t *context; /* OBS编码器上下文 */
@@ -26,7 +36,7 @@ struct sei_stamper_encoder {
   const AVCodec *codec;
   AVCodecContext *codec_context;
   AVFrame *frame;
-  AVPacket *packet;
+  encoder_packet_queue_t packet_queue; /* 已取出、尚未交给OBS的Packet */
 
   /* 编码器设置 */
   int bitrate;
@@ -39,6 +49,9 @@ struct sei_stamper_encoder {
   /* 编码器类型 */
   enum sei_stamper_codec_type codec_type;
 
+  /* 输入格式: OBS直接按该格式输出,编码时只包装平面指针 */
+  enum video_format obs_format;
+
   /* NTP客户端 */
   ntp_client_t ntp_client;
   bool ntp_enabled;
@@ -48,20 +61,16 @@ struct sei_stamper_encoder {
   uint8_t *merged_sei_buffer;
   size_t merged_sei_size;
 
+  /* 时间戳SEI由编码器根据帧附加数据写入(否则编码后拼接) */
+  bool sei_side_data;
+
   /* 当前帧信息 */
   int64_t current_pts;
   ntp_timestamp_t current_ntp_time;
+  capture_time_ring_t capture_times; /* PTS -> 送入编码器时的NTP时间 */
 
-  /* packet数据缓冲 (用于重组packet) */
+  /* packet数据缓冲 (借自共享池,下次encode时归还) */
   uint8_t *packet_buffer;
-  size_t packet_buffer_size;
-};
-
-/* 编码器类型 */
-enum sei_stamper_codec_type {
-  SEI_STAMPER_CODEC_H264,
-  SEI_STAMPER_CODEC_H265,
-  SEI_STAMPER_CODEC_AV1
 };
 
 /* 外部声明编码器info结构 */
@@ -13,7 +13,13 @@
     GNU General Public License for more details.
 ******************************************************************************/
 
+#include "encoder-stats.h"
+#include "fast-clock.h"
+#include "packet-pool.h"
+#include "stage-trace.h"
+#include "stream-param-cache.h"
 #include <obs-module.h>
+#include <seistamp.h>
 #include <util/platform.h>
 
 OBS_DECLARE_MODULE()
@@ -36,10 +42,26 @@ extern struct obs_encoder_info unified_encoder_info_av1;
 // 前向声明 - 源
 extern struct obs_source_info sei_receiver_source_info;
 
+// libseistamp日志转发到OBS (日志级别数值与LOG_*相同)
+static void seistamp_log_to_obs(int level, const char *format, va_list args,
+                                void *param) {
+  UNUSED_PARAMETER(param);
+  blogva(level, format, args);
+}
+
 // 模块加载
 bool obs_module_load(void) {
   blog(LOG_INFO, "SEI Stamper Plugin loaded");
 
+  /* 尽早开始TSC校准,第一路输出开始前通常已完成 */
+  fast_clock_init();
+
+  /* libseistamp使用OBS的内存、日志和时钟 */
+  static const seistamp_allocator_t allocator = {bmalloc, bfree};
+  seistamp_set_allocator(&allocator);
+  seistamp_set_log_handler(seistamp_log_to_obs, NULL);
+  seistamp_set_clock(fast_clock_now_ns);
+
   /* 注册三个独立的SEI Stamper编码器（每种codec一个） */
   blog(LOG_INFO, "Registering SEI Stamper H.264 encoder");
   obs_register_encoder(&unified_encoder_info_h264);
@@ -50,6 +72,12 @@ bool obs_module_load(void) {
   blog(LOG_INFO, "Registering SEI Stamper AV1 encoder");
   obs_register_encoder(&unified_encoder_info_av1);
 
+  /* 编码器统计查询 (sei_stamper_list_encoders / sei_stamper_encoder_stats) */
+  encoder_stats_add_procs();
+
+  /* 阶段追踪导出 (sei_stamper_trace_dump, 仅ENABLE_TRACE构建) */
+  stage_trace_add_procs();
+
   /* 注册SEI接收器源 */
   blog(LOG_INFO, "Registering SEI Receiver source");
   obs_register_source(&sei_receiver_source_info);
@@ -59,5 +87,17 @@ bool obs_module_load(void) {
 
 // 模块卸载
 void obs_module_unload(void) {
+  packet_pool_stats_t pool_stats;
+  packet_pool_get_stats(&pool_stats);
+  blog(LOG_INFO,
+       "[SEI Stamper] Packet pool: peak %zu KiB, %llu allocations, "
+       "%llu reuses",
+       pool_stats.high_water_bytes / 1024,
+       (unsigned long long)pool_stats.allocations,
+       (unsigned long long)pool_stats.reuses);
+  packet_pool_trim();
+  stream_param_cache_clear();
+  stage_trace_free();
+
   blog(LOG_INFO, "[SEI Stamper] Plugin unloaded");
 }
@@ -0,0 +1,386 @@
+#include "software-encoder.h"
+#include "packet-pool.h"
+#include "sei-handler.h"
+#include "stage-trace.h"
+#include <util/dstr.h>
+#include <util/platform.h>
+
+#ifdef ENABLE_SOFTWARE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* 日志宏 */
+#define encoder_log(level, enc, format, ...)                                   \
+  blog(level, "[Software Encoder: '%s'] " format,                              \
+       obs_encoder_get_name(enc->encoder), ##__VA_ARGS__)
+
+/* 将统一编码器的 preset (fast / balanced / quality) 映射到各库的 preset
+ * CPU 实时编码时 x265 / SVT-AV1 比 x264 慢得多, 所以各自取更快的档位 */
+static const char *map_preset(int codec_type, const char *preset) {
+  int level = 1; /* balanced */
+  if (preset && strcmp(preset, "fast") == 0)
+    level = 0;
+  else if (preset && strcmp(preset, "quality") == 0)
+    level = 2;
+
+  static const char *x264_presets[] = {"superfast", "veryfast", "medium"};
+  static const char *x265_presets[] = {"ultrafast", "superfast", "fast"};
+  static const char *svtav1_presets[] = {"12", "10", "8"};
+
+  switch (codec_type) {
+  case 1:
+    return x265_presets[level];
+  case 2:
+    return svtav1_presets[level];
+  default:
+    return x264_presets[level];
+  }
+}
+
+/* 销毁编码器 */
+void software_encoder_destroy(software_encoder_t *enc) {
+  if (!enc)
+    return;
+
+  encoder_log(LOG_INFO, enc, "Destroying software encoder");
+
+  if (enc->codec_context) {
+    avcodec_free_context(&enc->codec_context);
+  }
+  if (enc->frame) {
+    av_frame_free(&enc->frame);
+  }
+  encoder_packet_queue_free(&enc->packet_queue);
+
+  if (enc->extra_data)
+    bfree(enc->extra_data);
+  if (enc->profile)
+    bfree(enc->profile);
+  if (enc->preset)
+    bfree(enc->preset);
+  packet_pool_release(enc->packet_buffer);
+
+  ntp_client_destroy(&enc->ntp_client);
+  bfree(enc);
+}
+
+/* 创建编码器 - Internal (public for unified encoder) */
+void *software_encoder_create_internal(obs_data_t *settings,
+                                       obs_encoder_t *encoder) {
+  software_encoder_t *enc = bzalloc(sizeof(software_encoder_t));
+  enc->encoder = encoder;
+
+  video_t *video = obs_encoder_video(encoder);
+  const struct video_output_info *voi = video_output_get_info(video);
+
+  enc->width = voi->width;
+  enc->height = voi->height;
+  enc->fps_num = voi->fps_num;
+  enc->fps_den = voi->fps_den;
+  enc->bitrate = (int)obs_data_get_int(settings, "bitrate");
+  enc->keyint = (int)obs_data_get_int(settings, "keyint_sec") * enc->fps_num /
+                enc->fps_den;
+  enc->bframes = (int)obs_data_get_int(settings, "bframes");
+  enc->threads = (int)obs_data_get_int(settings, "sw_threads");
+  enc->low_latency = obs_data_get_bool(settings, "sw_low_latency");
+  enc->preset = bstrdup(obs_data_get_string(settings, "preset"));
+  enc->profile = bstrdup(obs_data_get_string(settings, "profile"));
+
+  /* Codec Type */
+  enc->codec_type = (int)obs_data_get_int(settings, "codec_type");
+  if (enc->codec_type < 0 || enc->codec_type > 2)
+    enc->codec_type = 0; // Default to H.264
+
+  /* 根据 codec_type 设置编码器名称 */
+  switch (enc->codec_type) {
+  case 1: // H.265
+    snprintf(enc->codec_name, sizeof(enc->codec_name), "libx265");
+    break;
+  case 2: // AV1
+    snprintf(enc->codec_name, sizeof(enc->codec_name), "libsvtav1");
+    break;
+  default: // H.264
+    snprintf(enc->codec_name, sizeof(enc->codec_name), "libx264");
+    break;
+  }
+
+  /* NTP 初始化 */
+  const char *ntp_server = obs_data_get_string(settings, "ntp_server");
+  ntp_client_init(&enc->ntp_client, ntp_server,
+                  (uint16_t)obs_data_get_int(settings, "ntp_port"));
+  enc->ntp_sync_interval_ms =
+      (uint32_t)obs_data_get_int(settings, "ntp_sync_interval_ms");
+  if (enc->ntp_sync_interval_ms == 0)
+    enc->ntp_sync_interval_ms = 60000; // 默认 60 秒
+
+  encoder_log(LOG_INFO, enc, "Creating software encoder: %s", enc->codec_name);
+
+  /* 查找 FFmpeg 编码器 */
+  enc->codec = avcodec_find_encoder_by_name(enc->codec_name);
+  if (!enc->codec) {
+    encoder_log(LOG_ERROR, enc, "Software encoder not found (%s)",
+                enc->codec_name);
+    encoder_log(LOG_ERROR, enc,
+                "Make sure FFmpeg is built with libx264/libx265/libsvtav1");
+    software_encoder_destroy(enc);
+    return NULL;
+  }
+
+  enc->codec_context = avcodec_alloc_context3(enc->codec);
+  if (!enc->codec_context) {
+    encoder_log(LOG_ERROR, enc, "Failed to allocate codec context");
+    software_encoder_destroy(enc);
+    return NULL;
+  }
+
+  /* 配置编码参数: 三个库都支持 yuv420p */
+  enc->codec_context->width = enc->width;
+  enc->codec_context->height = enc->height;
+  enc->codec_context->time_base = (AVRational){voi->fps_den, voi->fps_num};
+  enc->codec_context->framerate = (AVRational){voi->fps_num, voi->fps_den};
+  enc->codec_context->pix_fmt = AV_PIX_FMT_YUV420P;
+  enc->codec_context->bit_rate = enc->bitrate * 1000;
+  enc->codec_context->rc_max_rate = enc->codec_context->bit_rate;
+  enc->codec_context->rc_buffer_size = (int)enc->codec_context->bit_rate;
+  enc->codec_context->gop_size = enc->keyint;
+  enc->codec_context->max_b_frames = enc->low_latency ? 0 : enc->bframes;
+  enc->codec_context->thread_count = enc->threads;
+  enc->codec_context->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+
+  AVDictionary *opts = NULL;
+
+  const char *preset = map_preset(enc->codec_type, enc->preset);
+  av_dict_set(&opts, "preset", preset, 0);
+  encoder_log(LOG_INFO, enc, "Using preset: %s (mapped from %s)", preset,
+              enc->preset);
+
+  /* 延迟调优: 切片线程代替帧线程, 关闭 lookahead 和 B 帧 */
+  if (enc->low_latency) {
+    if (enc->codec_type == 2) {
+      av_dict_set(&opts, "svtav1-params", "pred-struct=1:lookahead=0", 0);
+    } else {
+      av_dict_set(&opts, "tune", "zerolatency", 0);
+      enc->codec_context->thread_type = FF_THREAD_SLICE;
+    }
+  }
+
+  /* x264 的 profile 名与 UI 一致; x265 / SVT-AV1 使用默认 */
+  if (enc->codec_type == 0) {
+    if (enc->profile && strlen(enc->profile) > 0)
+      av_dict_set(&opts, "profile", enc->profile, 0);
+    av_dict_set(&opts, "nal-hrd", "cbr", 0);
+  }
+
+  /* 时间戳SEI: libx264 / libx265 支持 udu_sei */
+  if (obs_data_get_bool(settings, "sei_side_data") && enc->codec_type != 2)
+    enc->sei_side_data = encoder_sei_enable_side_data(enc->codec_context);
+  encoder_log(LOG_INFO, enc, "Timestamp SEI: %s",
+              enc->sei_side_data ? "frame side data" : "spliced after encode");
+
+  /* 打开编码器 */
+  char errbuf[128];
+  int ret = avcodec_open2(enc->codec_context, enc->codec, &opts);
+  if (ret < 0) {
+    av_strerror(ret, errbuf, sizeof(errbuf));
+    encoder_log(LOG_ERROR, enc, "Failed to open software encoder: %s (%d)",
+                errbuf, ret);
+    if (opts)
+      av_dict_free(&opts);
+    software_encoder_destroy(enc);
+    return NULL;
+  }
+  if (opts)
+    av_dict_free(&opts);
+
+  /* 分配 Frame 和 Packet */
+  enc->frame = av_frame_alloc();
+  capture_time_ring_init(&enc->capture_times, enc->fps_den);
+  if (!encoder_packet_queue_init(&enc->packet_queue)) {
+    encoder_log(LOG_ERROR, enc, "Failed to allocate packet queue");
+    software_encoder_destroy(enc);
+    return NULL;
+  }
+
+  /* 提取 Extra Data */
+  if (enc->codec_context->extradata_size > 0) {
+    enc->extra_data_size = enc->codec_context->extradata_size;
+    enc->extra_data = bmalloc(enc->extra_data_size);
+    memcpy(enc->extra_data, enc->codec_context->extradata,
+           enc->extra_data_size);
+    encoder_log(LOG_INFO, enc, "Extra data size: %zu bytes",
+                enc->extra_data_size);
+  }
+
+  encoder_log(LOG_INFO, enc,
+              "Software encoder created successfully (%dx%d @ %d kbps, "
+              "threads=%d%s)",
+              enc->width, enc->height, enc->bitrate, enc->threads,
+              enc->low_latency ? ", low latency" : "");
+
+  return enc;
+}
+
+/* 编码函数 - Internal (public for unified encoder) */
+bool software_encoder_encode_internal(void *data, struct encoder_frame *frame,
+                                      struct encoder_packet *packet,
+                                      bool *received_packet) {
+  software_encoder_t *enc = data;
+  char errbuf[128];
+
+  if (!frame || !packet || !received_packet)
+    return false;
+
+  /* OBS 已在上一次 encode 返回后复制了 packet, 归还 buffer */
+  packet_pool_release(enc->packet_buffer);
+  enc->packet_buffer = NULL;
+
+  /* NTP 时间更新 */
+  uint64_t now = fast_clock_now_ns();
+  uint64_t sync_interval_ns = (uint64_t)enc->ntp_sync_interval_ms * 1000000ULL;
+  if (enc->last_ntp_sync_time == 0 ||
+      (now - enc->last_ntp_sync_time) > sync_interval_ns) {
+    /* Always update last_sync_time to avoid retry storm on failure */
+    enc->last_ntp_sync_time = now;
+    TRACE_START(trace_sync);
+    ntp_client_sync(&enc->ntp_client);
+    TRACE_STAGE(trace_sync, "software", "ntp_client_sync", frame->pts);
+  }
+  ntp_client_get_time_or_local(&enc->ntp_client, &enc->current_ntp_time);
+
+  /* 记录送入时间,输出时按 PTS 取回 (B 帧 / lookahead 会打乱顺序) */
+  capture_time_ring_put(&enc->capture_times, frame->pts,
+                        &enc->current_ntp_time);
+
+  /* 清理上一帧 */
+  av_frame_unref(enc->frame);
+
+  /* 设置 Frame 参数 */
+  enc->frame->format = enc->codec_context->pix_fmt;
+  enc->frame->width = enc->codec_context->width;
+  enc->frame->height = enc->codec_context->height;
+  enc->frame->pts = frame->pts;
+
+  /* I420: 三个平面, 直接包装 OBS 的数据 */
+  for (int i = 0; i < 3; i++) {
+    enc->frame->data[i] = frame->data[i];
+    enc->frame->linesize[i] = frame->linesize[i];
+  }
+
+  /* 由编码器写入SEI: 每帧都挂上时间戳, 关键帧由编码器自己决定 */
+  if (enc->sei_side_data &&
+      !encoder_sei_attach(enc->frame, &enc->current_ntp_time))
+    encoder_log(LOG_WARNING, enc, "Failed to attach SEI side data");
+
+  /* 发送 Frame */
+  TRACE_START(trace_send);
+  int ret = encoder_packet_queue_send_frame(
+      &enc->packet_queue, enc->codec_context, enc->frame,
+      &enc->current_ntp_time);
+  TRACE_STAGE(trace_send, "software", "encoder_packet_queue_send_frame",
+              frame->pts);
+  av_frame_unref(enc->frame);
+
+  if (ret < 0) {
+    av_strerror(ret, errbuf, sizeof(errbuf));
+    encoder_log(LOG_ERROR, enc, "Error sending frame: %s (%d)", errbuf, ret);
+    return false;
+  }
+
+  /* 取出所有就绪的 Packet (多包输出 / lookahead 突发) */
+  TRACE_START(trace_drain);
+  ret = encoder_packet_queue_drain(&enc->packet_queue, enc->codec_context,
+                                   &enc->current_ntp_time);
+  TRACE_STAGE(trace_drain, "software", "encoder_packet_queue_drain",
+              frame->pts);
+  if (ret < 0) {
+    av_strerror(ret, errbuf, sizeof(errbuf));
+    encoder_log(LOG_ERROR, enc, "Error receiving packet: %s (%d)", errbuf, ret);
+    return false;
+  }
+
+  /* 每次调用按顺序输出一个 */
+  const encoder_queued_packet_t *queued =
+      encoder_packet_queue_pop(&enc->packet_queue);
+  if (!queued) {
+    *received_packet = false;
+    return true;
+  }
+
+  const AVPacket *pkt = queued->packet;
+  *received_packet = true;
+
+  /* SEI 插入 (关键帧, AV1 不使用 SEI; 编码器已按附加数据写入时跳过) */
+  bool keyframe = (pkt->flags & AV_PKT_FLAG_KEY) != 0;
+  bool has_stamp = enc->sei_side_data &&
+                   encoder_sei_packet_has_stamp(pkt, enc->codec_type == 1);
+  uint8_t *sei_nal = NULL;
+  size_t sei_nal_size = 0;
+
+  if (keyframe && !has_stamp && enc->codec_type != 2) {
+    uint8_t *payload = NULL;
+    size_t payload_size = 0;
+    sei_nal_type_t nal_type =
+        (enc->codec_type == 1) ? SEI_NAL_H265_PREFIX : SEI_NAL_H264;
+    ntp_timestamp_t stamp = queued->ntp_time;
+    capture_time_ring_get(&enc->capture_times, pkt->pts, &stamp);
+    if (build_ntp_sei_payload(pkt->pts, &stamp, &payload, &payload_size)) {
+      build_sei_nal_unit(payload, payload_size, nal_type, &sei_nal,
+                         &sei_nal_size);
+      bfree(payload);
+
+      encoder_log(LOG_DEBUG, enc,
+                  "[Software] Inserted SEI: PTS=%lld NTP=%u.%u Size=%zu",
+                  pkt->pts, stamp.seconds, stamp.fraction, sei_nal_size);
+    }
+  }
+
+  enc->packet_stamped = has_stamp || sei_nal != NULL;
+
+  /* 组装 Packet (buffer 借自共享池) */
+  size_t total_size = pkt->size + sei_nal_size;
+  enc->packet_buffer = packet_pool_acquire(total_size);
+  if (!enc->packet_buffer) {
+    encoder_log(LOG_ERROR, enc, "Failed to allocate packet buffer");
+    bfree(sei_nal);
+    return false;
+  }
+
+  size_t offset = 0;
+  if (sei_nal) {
+    memcpy(enc->packet_buffer, sei_nal, sei_nal_size);
+    offset += sei_nal_size;
+    bfree(sei_nal);
+  }
+  memcpy(enc->packet_buffer + offset, pkt->data, pkt->size);
+
+  packet->data = enc->packet_buffer;
+  packet->size = total_size;
+  packet->type = OBS_ENCODER_VIDEO;
+  packet->pts = pkt->pts;
+  packet->dts = pkt->dts;
+  packet->keyframe = keyframe;
+
+  return true;
+}
+
+/* 获取视频信息 - Internal (public for unified encoder) */
+void software_encoder_get_video_info_internal(void *data,
+                                              struct video_scale_info *info) {
+  UNUSED_PARAMETER(data);
+  info->format = VIDEO_FORMAT_I420;
+}
+
+/* 获取 Extra Data - Internal (public for unified encoder) */
+bool software_encoder_get_extra_data_internal(void *data, uint8_t **extra_data,
+                                              size_t *size) {
+  software_encoder_t *enc = (software_encoder_t *)data;
+  if (!enc || !enc->extra_data)
+    return false;
+  *extra_data = enc->extra_data;
+  *size = enc->extra_data_size;
+  return true;
+}
+
+#endif // ENABLE_SOFTWARE
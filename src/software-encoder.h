@@ -0,0 +1,75 @@
+#ifndef SOFTWARE_ENCODER_H
+#define SOFTWARE_ENCODER_H
+
+#include <obs-module.h>
+
+#ifdef ENABLE_SOFTWARE
+
+#include "capture-time-ring.h"
+#include "encoder-packet-queue.h"
+#include "encoder-sei.h"
+#include "ntp-client.h"
+#include <libavcodec/avcodec.h>
+#include <libavutil/opt.h>
+
+/* CPU 编码器 (libx264 / libx265 / libsvtav1), 用于没有 GPU 的机器 */
+typedef struct software_encoder {
+  obs_encoder_t *encoder;
+
+  /* FFmpeg 编码器 */
+  const AVCodec *codec;
+  AVCodecContext *codec_context;
+  AVFrame *frame;
+
+  /* 配置 */
+  int width;
+  int height;
+  int fps_num;
+  int fps_den;
+  int bitrate; // kbps
+  int keyint;  // frames
+  int bframes;
+  int threads;      /* 0 = 自动 */
+  bool low_latency; /* zerolatency: 无 lookahead / B 帧, 切片线程 */
+  char *profile;
+  char *preset;
+
+  /* Codec Type */
+  int codec_type;      /* 0=H.264, 1=H.265, 2=AV1 */
+  char codec_name[32]; /* FFmpeg encoder name */
+
+  /* Extra Data (SPS/PPS) */
+  uint8_t *extra_data;
+  size_t extra_data_size;
+
+  /* NTP 同步 */
+  ntp_client_t ntp_client;
+  uint64_t last_ntp_sync_time;
+  ntp_timestamp_t current_ntp_time;
+  uint32_t ntp_sync_interval_ms; /* NTP同步间隔（毫秒） */
+  capture_time_ring_t capture_times; /* PTS -> 送入编码器时的NTP时间 */
+
+  /* 时间戳SEI由编码器写入(udu_sei) */
+  bool sei_side_data;
+
+  /* Packet 缓冲区 */
+  encoder_packet_queue_t packet_queue; /* 已取出、尚未输出的 Packet */
+  uint8_t *packet_buffer;              // 交给OBS的数据,下次encode时归还到池
+  bool packet_stamped;                 // 交给OBS的Packet带有时间戳SEI(统计用)
+} software_encoder_t;
+
+/* Public API functions for unified encoder */
+void *software_encoder_create_internal(obs_data_t *settings,
+                                       obs_encoder_t *encoder);
+bool software_encoder_encode_internal(void *data, struct encoder_frame *frame,
+                                      struct encoder_packet *packet,
+                                      bool *received_packet);
+void software_encoder_get_video_info_internal(void *data,
+                                              struct video_scale_info *info);
+bool software_encoder_get_extra_data_internal(void *data, uint8_t **extra_data,
+                                              size_t *size);
+void software_encoder_destroy(software_encoder_t *enc);
+
+#endif // ENABLE_SOFTWARE
+
+#endif // SOFTWARE_ENCODER_H
@@ -0,0 +1,501 @@
+/******************************************************************************
+    SRT Listener Hub - Implementation
+    Copyright (C) 2026
+
+    Shared listeners, streamid routing and the per-port I/O thread
+******************************************************************************/
+
+#include "srt-hub.h"
+
+#ifdef HAVE_LIBSRT
+
+#include <libavutil/error.h>
+#include <obs-module.h>
+#include <stdio.h>
+#include <string.h>
+#include <util/bmem.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+#ifdef _WIN32
+#include <srt/srt.h>
+#include <ws2tcpip.h>
+#else
+#include <netdb.h>
+#include <srt.h>
+#endif
+
+#define hub_log(level, format, ...)                                            \
+  blog(level, "[SRT Hub] " format, ##__VA_ARGS__)
+
+/* I/O线程检查停止标志的间隔, 以及一次epoll等待的最大事件数 */
+#define SRT_HUB_POLL_INTERVAL_MS 100
+#define SRT_HUB_EVENTS 64
+
+typedef struct srt_hub srt_hub_t;
+
+struct srt_hub_route {
+  srt_hub_t *hub;
+  srt_socket_config_t config; /* config.streamid为路由键 */
+
+  SRTSOCKET socket;       /* 当前连接, 未连接时为SRT_INVALID_SOCK */
+  uint64_t reserved_time; /* 监听回调已接受了连接, 等待accept */
+  bool closed;            /* 连接已断开, 读完队列后返回EOF */
+  int latency_ms;
+
+  /* 接收队列(环形), 由hub->mutex保护 */
+  uint8_t *queue;
+  size_t head;
+  size_t size;
+  uint64_t dropped; /* 队列已满丢弃的字节数 */
+  os_event_t *event; /* 有新数据或连接状态变化 */
+
+  srt_hub_route_t *next;
+};
+
+struct srt_hub {
+  char port[16];
+  SRTSOCKET listener;
+  int epoll;
+  pthread_t thread;
+  volatile bool active;
+
+  pthread_mutex_t mutex; /* 保护routes及其队列 */
+  srt_hub_route_t *routes;
+
+  /* I/O线程的批量接收缓冲区 */
+  uint8_t batch[SRT_INPUT_BATCH * SRT_LIVE_MAX_PLSIZE];
+
+  srt_hub_t *next;
+};
+
+static pthread_mutex_t hubs_mutex = PTHREAD_MUTEX_INITIALIZER;
+static srt_hub_t *hubs;
+
+/*============================================================================
+ * 路由 (调用者持有hub->mutex)
+ *============================================================================*/
+
+static bool is_reserved(const srt_hub_route_t *route, uint64_t now) {
+  return route->reserved_time &&
+         now - route->reserved_time <
+             (uint64_t)SRT_HUB_RESERVE_TIMEOUT_MS * 1000000ULL;
+}
+
+/*
+ * 按streamid查找路由: 先精确匹配, 再匹配streamid为空的路由
+ * reserved为false时查找空闲的路由(监听回调), 为true时查找已预留的(accept)
+ */
+static srt_hub_route_t *find_route(srt_hub_t *hub, const char *streamid,
+                                   bool reserved) {
+  uint64_t now = os_gettime_ns();
+  srt_hub_route_t *wildcard = NULL;
+
+  for (srt_hub_route_t *route = hub->routes; route; route = route->next) {
+    if (route->socket != SRT_INVALID_SOCK || route->closed ||
+        is_reserved(route, now) != reserved)
+      continue;
+    if (strcmp(route->config.streamid, streamid) == 0)
+      return route;
+    if (!route->config.streamid[0] && !wildcard)
+      wildcard = route;
+  }
+  return wildcard;
+}
+
+static srt_hub_route_t *route_of_socket(srt_hub_t *hub, SRTSOCKET socket) {
+  for (srt_hub_route_t *route = hub->routes; route; route = route->next) {
+    if (route->socket == socket)
+      return route;
+  }
+  return NULL;
+}
+
+static void queue_push(srt_hub_route_t *route, const uint8_t *data,
+                       size_t size) {
+  if (route->size + size > SRT_HUB_QUEUE_SIZE) {
+    route->dropped += size;
+    return;
+  }
+
+  size_t tail = (route->head + route->size) % SRT_HUB_QUEUE_SIZE;
+  size_t first = SRT_HUB_QUEUE_SIZE - tail;
+  if (first > size)
+    first = size;
+  memcpy(route->queue + tail, data, first);
+  memcpy(route->queue, data + first, size - first);
+  route->size += size;
+}
+
+static size_t queue_pop(srt_hub_route_t *route, uint8_t *buf, size_t size) {
+  if (size > route->size)
+    size = route->size;
+
+  size_t first = SRT_HUB_QUEUE_SIZE - route->head;
+  if (first > size)
+    first = size;
+  memcpy(buf, route->queue + route->head, first);
+  memcpy(buf + first, route->queue, size - first);
+  route->head = (route->head + size) % SRT_HUB_QUEUE_SIZE;
+  route->size -= size;
+  return size;
+}
+
+/* 断开路由与连接, 返回的socket须在释放hub->mutex后关闭
+ * (srt_close可能等待正在调用监听回调的libsrt线程) */
+static SRTSOCKET detach_route_socket(srt_hub_t *hub, srt_hub_route_t *route) {
+  SRTSOCKET socket = route->socket;
+  srt_epoll_remove_usock(hub->epoll, socket);
+  route->socket = SRT_INVALID_SOCK;
+  return socket;
+}
+
+/*============================================================================
+ * I/O线程
+ *============================================================================*/
+
+/* 在libsrt的线程中调用: 没有登记该streamid的源时直接拒绝握手 */
+static int listen_callback(void *opaque, SRTSOCKET socket, int hs_version,
+                           const struct sockaddr *peer, const char *streamid) {
+  UNUSED_PARAMETER(hs_version);
+  UNUSED_PARAMETER(peer);
+  srt_hub_t *hub = opaque;
+  if (!streamid)
+    streamid = "";
+
+  srt_socket_config_t config;
+  pthread_mutex_lock(&hub->mutex);
+  srt_hub_route_t *route = find_route(hub, streamid, false);
+  if (route) {
+    route->reserved_time = os_gettime_ns();
+    config = route->config;
+  }
+  pthread_mutex_unlock(&hub->mutex);
+
+  if (!route) {
+    hub_log(LOG_WARNING, "Port %s: rejected stream '%s' (no receiver)",
+            hub->port, streamid);
+    return -1;
+  }
+
+  /* 该源的延迟/密码等应用于这个连接; streamid由发送端决定 */
+  config.streamid[0] = '\0';
+  srt_socket_configure(socket, &config);
+  return 0;
+}
+
+static void accept_connection(srt_hub_t *hub) {
+  SRTSOCKET socket = srt_accept(hub->listener, NULL, NULL);
+  if (socket == SRT_INVALID_SOCK)
+    return;
+
+  char streamid[512];
+  int length = sizeof(streamid) - 1;
+  if (srt_getsockflag(socket, SRTO_STREAMID, streamid, &length) == SRT_ERROR)
+    length = 0;
+  streamid[length] = '\0';
+
+  int latency = 0, latency_size = sizeof(latency);
+  srt_getsockflag(socket, SRTO_RCVLATENCY, &latency, &latency_size);
+
+  int rcvsyn = 0;
+  int events = SRT_EPOLL_IN | SRT_EPOLL_ERR;
+  bool ok = srt_setsockflag(socket, SRTO_RCVSYN, &rcvsyn, sizeof(rcvsyn)) !=
+                SRT_ERROR &&
+            srt_epoll_add_usock(hub->epoll, socket, &events) != SRT_ERROR;
+
+  pthread_mutex_lock(&hub->mutex);
+  srt_hub_route_t *route = ok ? find_route(hub, streamid, true) : NULL;
+  if (route) {
+    route->socket = socket;
+    route->reserved_time = 0;
+    route->latency_ms = latency;
+    os_event_signal(route->event);
+  }
+  pthread_mutex_unlock(&hub->mutex);
+
+  if (!route) {
+    /* 预留期间源已注销 */
+    srt_epoll_remove_usock(hub->epoll, socket);
+    srt_close(socket);
+    return;
+  }
+  hub_log(LOG_INFO, "Port %s: sender connected to stream '%s'", hub->port,
+          streamid);
+}
+
+/* 取出一个socket上所有已到达的消息, 一次加锁放入对应源的队列 */
+static void drain_socket(srt_hub_t *hub, SRTSOCKET socket) {
+  size_t filled = 0;
+  bool broken = false;
+
+  while (sizeof(hub->batch) - filled >= SRT_LIVE_MAX_PLSIZE) {
+    int n = srt_recvmsg2(socket, (char *)hub->batch + filled,
+                         (int)(sizeof(hub->batch) - filled), NULL);
+    if (n > 0) {
+      filled += (size_t)n;
+      continue;
+    }
+    broken = n == 0 || srt_getlasterror(NULL) != SRT_EASYNCRCV;
+    break;
+  }
+
+  pthread_mutex_lock(&hub->mutex);
+  srt_hub_route_t *route = route_of_socket(hub, socket);
+  if (route) {
+    if (filled)
+      queue_push(route, hub->batch, filled);
+    if (broken) {
+      detach_route_socket(hub, route);
+      route->closed = true;
+      hub_log(LOG_INFO, "Port %s: stream '%s' disconnected", hub->port,
+              route->config.streamid);
+    }
+    if (filled || broken)
+      os_event_signal(route->event);
+  }
+  pthread_mutex_unlock(&hub->mutex);
+
+  /* 路由不存在时源已注销, 连接已由srt_hub_unsubscribe关闭 */
+  if (broken && route)
+    srt_close(socket);
+}
+
+static void *hub_thread(void *data) {
+  srt_hub_t *hub = data;
+  os_set_thread_name("srt-hub");
+
+  SRT_EPOLL_EVENT events[SRT_HUB_EVENTS];
+  while (hub->active) {
+    int count = srt_epoll_uwait(hub->epoll, events, SRT_HUB_EVENTS,
+                                SRT_HUB_POLL_INTERVAL_MS);
+    for (int i = 0; i < count; i++) {
+      if (events[i].fd == hub->listener)
+        accept_connection(hub);
+      else
+        drain_socket(hub, events[i].fd);
+    }
+  }
+  return NULL;
+}
+
+/*============================================================================
+ * 监听
+ *============================================================================*/
+
+static void hub_destroy(srt_hub_t *hub) {
+  if (hub->active) {
+    hub->active = false;
+    pthread_join(hub->thread, NULL);
+  }
+  if (hub->epoll >= 0)
+    srt_epoll_release(hub->epoll);
+  if (hub->listener != SRT_INVALID_SOCK)
+    srt_close(hub->listener);
+  pthread_mutex_destroy(&hub->mutex);
+  bfree(hub);
+  srt_cleanup();
+}
+
+static srt_hub_t *hub_create(const char *host, const char *port,
+                             const srt_socket_config_t *config) {
+  srt_startup();
+
+  srt_hub_t *hub = bzalloc(sizeof(srt_hub_t));
+  snprintf(hub->port, sizeof(hub->port), "%s", port);
+  hub->listener = SRT_INVALID_SOCK;
+  hub->epoll = -1;
+  pthread_mutex_init(&hub->mutex, NULL);
+
+  struct addrinfo hints = {0}, *addr = NULL;
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_DGRAM;
+  hints.ai_flags = AI_PASSIVE;
+  if (getaddrinfo(host[0] ? host : NULL, port, &hints, &addr) != 0 ||
+      !addr) {
+    hub_log(LOG_ERROR, "Cannot resolve listen address '%s'", host);
+    hub_destroy(hub);
+    return NULL;
+  }
+
+  /* 第一个登记者的参数作为监听的默认值, 密码等按连接在回调中设置 */
+  srt_socket_config_t defaults = *config;
+  defaults.streamid[0] = '\0';
+  defaults.passphrase[0] = '\0';
+
+  int rcvsyn = 0;
+  int events = SRT_EPOLL_IN | SRT_EPOLL_ERR;
+  hub->listener = srt_create_socket();
+  bool ok = hub->listener != SRT_INVALID_SOCK &&
+            srt_socket_configure(hub->listener, &defaults) &&
+            srt_setsockflag(hub->listener, SRTO_RCVSYN, &rcvsyn,
+                            sizeof(rcvsyn)) != SRT_ERROR &&
+            srt_bind(hub->listener, addr->ai_addr, (int)addr->ai_addrlen) !=
+                SRT_ERROR &&
+            srt_listen_callback(hub->listener, listen_callback, hub) !=
+                SRT_ERROR &&
+            srt_listen(hub->listener, SRT_HUB_EVENTS) != SRT_ERROR &&
+            (hub->epoll = srt_epoll_create()) >= 0 &&
+            srt_epoll_add_usock(hub->epoll, hub->listener, &events) !=
+                SRT_ERROR;
+  freeaddrinfo(addr);
+
+  if (!ok) {
+    hub_log(LOG_ERROR, "Cannot listen on port %s: %s", port,
+            srt_getlasterror_str());
+    hub_destroy(hub);
+    return NULL;
+  }
+
+  hub->active = true;
+  if (pthread_create(&hub->thread, NULL, hub_thread, hub) != 0) {
+    hub->active = false;
+    hub_destroy(hub);
+    return NULL;
+  }
+
+  hub_log(LOG_INFO, "Listening on port %s", port);
+  return hub;
+}
+
+/*============================================================================
+ * 接口
+ *============================================================================*/
+
+srt_hub_route_t *srt_hub_subscribe(const char *host, const char *port,
+                                   const srt_socket_config_t *config) {
+  srt_hub_route_t *route = bzalloc(sizeof(srt_hub_route_t));
+  route->config = *config;
+  route->socket = SRT_INVALID_SOCK;
+  route->queue = bmalloc(SRT_HUB_QUEUE_SIZE);
+  if (os_event_init(&route->event, OS_EVENT_TYPE_AUTO) != 0) {
+    bfree(route->queue);
+    bfree(route);
+    return NULL;
+  }
+
+  pthread_mutex_lock(&hubs_mutex);
+  srt_hub_t *hub = hubs;
+  while (hub && strcmp(hub->port, port) != 0)
+    hub = hub->next;
+  if (!hub && (hub = hub_create(host, port, config)) != NULL) {
+    hub->next = hubs;
+    hubs = hub;
+  }
+
+  if (hub) {
+    pthread_mutex_lock(&hub->mutex);
+    route->hub = hub;
+    route->next = hub->routes;
+    hub->routes = route;
+    pthread_mutex_unlock(&hub->mutex);
+  }
+  pthread_mutex_unlock(&hubs_mutex);
+
+  if (!hub) {
+    os_event_destroy(route->event);
+    bfree(route->queue);
+    bfree(route);
+    return NULL;
+  }
+
+  hub_log(LOG_INFO, "Port %s: waiting for stream '%s'", port,
+          config->streamid[0] ? config->streamid : "*");
+  return route;
+}
+
+bool srt_hub_wait(srt_hub_route_t *route, volatile bool *active) {
+  while (*active) {
+    pthread_mutex_lock(&route->hub->mutex);
+    bool connected = route->socket != SRT_INVALID_SOCK || route->closed;
+    pthread_mutex_unlock(&route->hub->mutex);
+    if (connected)
+      return true;
+
+    os_event_timedwait(route->event, SRT_HUB_POLL_INTERVAL_MS);
+  }
+  return false;
+}
+
+int srt_hub_read(srt_hub_route_t *route, uint8_t *buf, int size,
+                 int timeout_ms, volatile bool *active) {
+  uint64_t deadline = os_gettime_ns() + (uint64_t)timeout_ms * 1000000ULL;
+
+  for (;;) {
+    pthread_mutex_lock(&route->hub->mutex);
+    size_t n = queue_pop(route, buf, (size_t)size);
+    bool closed = route->closed;
+    pthread_mutex_unlock(&route->hub->mutex);
+
+    if (n)
+      return (int)n;
+    if (closed)
+      return AVERROR_EOF;
+    if (!*active)
+      return AVERROR_EXIT;
+    if (os_gettime_ns() >= deadline)
+      return AVERROR(ETIMEDOUT);
+
+    os_event_timedwait(route->event, SRT_HUB_POLL_INTERVAL_MS);
+  }
+}
+
+int srt_hub_latency_ms(srt_hub_route_t *route) {
+  pthread_mutex_lock(&route->hub->mutex);
+  int latency = route->latency_ms;
+  pthread_mutex_unlock(&route->hub->mutex);
+  return latency;
+}
+
+int srt_hub_socket(srt_hub_route_t *route) {
+  pthread_mutex_lock(&route->hub->mutex);
+  SRTSOCKET socket = route->socket;
+  pthread_mutex_unlock(&route->hub->mutex);
+  return socket;
+}
+
+void srt_hub_unsubscribe(srt_hub_route_t *route) {
+  if (!route)
+    return;
+
+  srt_hub_t *hub = route->hub;
+  pthread_mutex_lock(&hubs_mutex);
+
+  pthread_mutex_lock(&hub->mutex);
+  for (srt_hub_route_t **p = &hub->routes; *p; p = &(*p)->next) {
+    if (*p == route) {
+      *p = route->next;
+      break;
+    }
+  }
+  SRTSOCKET socket = route->socket != SRT_INVALID_SOCK
+                         ? detach_route_socket(hub, route)
+                         : SRT_INVALID_SOCK;
+  bool empty = hub->routes == NULL;
+  pthread_mutex_unlock(&hub->mutex);
+
+  if (socket != SRT_INVALID_SOCK)
+    srt_close(socket);
+
+  if (empty) {
+    for (srt_hub_t **p = &hubs; *p; p = &(*p)->next) {
+      if (*p == hub) {
+        *p = hub->next;
+        break;
+      }
+    }
+    hub_log(LOG_INFO, "Port %s: last receiver gone, closing", hub->port);
+    hub_destroy(hub);
+  }
+  pthread_mutex_unlock(&hubs_mutex);
+
+  if (route->dropped)
+    hub_log(LOG_WARNING, "Stream '%s': %llu bytes dropped (receiver stalled)",
+            route->config.streamid, (unsigned long long)route->dropped);
+
+  os_event_destroy(route->event);
+  bfree(route->queue);
+  bfree(route);
+}
+
+#endif /* HAVE_LIBSRT */
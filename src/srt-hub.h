@@ -0,0 +1,63 @@
+/******************************************************************************
+    SRT Listener Hub - Header File
+    Copyright (C) 2026
+
+    One SRT listener per port shared by every receiver source in listener
+    mode. Incoming callers are routed to the source registered for their
+    streamid, and all connected sockets are drained by a single
+    epoll-driven I/O thread per port
+******************************************************************************/
+
+#pragma once
+
+#include "srt-input.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 每个连接的接收队列; 源停止读取(卡住)时新数据被丢弃 */
+#define SRT_HUB_QUEUE_SIZE (4 * 1024 * 1024)
+
+/* 多久内未完成accept的预留视为失效(握手失败) */
+#define SRT_HUB_RESERVE_TIMEOUT_MS 5000
+
+typedef struct srt_hub_route srt_hub_route_t;
+
+/*
+ * 在端口上登记一个streamid (该端口的第一个登记者创建监听和I/O线程)
+ * 参数:
+ *   host - 绑定地址, 空表示所有地址(只有第一个登记者的值生效)
+ *   config - streamid为路由键, 空streamid接收没有其他匹配的任意连接;
+ *            其余参数应用于路由到这里的连接
+ * 返回:
+ *   NULL - 无法监听该端口
+ */
+srt_hub_route_t *srt_hub_subscribe(const char *host, const char *port,
+                                   const srt_socket_config_t *config);
+
+/* 等待发送端连入; active变为false时返回false */
+bool srt_hub_wait(srt_hub_route_t *route, volatile bool *active);
+
+/*
+ * 取出已收到的数据(一次取出队列中的全部, 最多size字节)
+ * 返回:
+ *   字节数, 或AVERROR_EOF(连接断开)/AVERROR_EXIT/AVERROR(ETIMEDOUT)
+ */
+int srt_hub_read(srt_hub_route_t *route, uint8_t *buf, int size,
+                 int timeout_ms, volatile bool *active);
+
+/* 握手协商后的接收延迟(毫秒) */
+int srt_hub_latency_ms(srt_hub_route_t *route);
+
+/* 当前连接的SRTSOCKET (读取统计用), 未连接时为-1 */
+int srt_hub_socket(srt_hub_route_t *route);
+
+/* 注销并关闭该路由的连接; 端口上最后一个路由注销时停止监听 */
+void srt_hub_unsubscribe(srt_hub_route_t *route);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,485 @@
+/******************************************************************************
+    SRT Input - Implementation
+    Copyright (C) 2026
+
+    libsrt socket setup, URL option parsing and the batched AVIO read path
+******************************************************************************/
+
+#include "srt-input.h"
+#include "srt-hub.h"
+#include <libavutil/error.h>
+#include <libavutil/mem.h>
+#include <obs-module.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <util/bmem.h>
+#include <util/platform.h>
+
+#ifdef HAVE_LIBSRT
+#ifdef _WIN32
+#include <srt/srt.h>
+#include <ws2tcpip.h>
+#else
+#include <netdb.h>
+#include <srt.h>
+#endif
+#endif
+
+#define srt_log(level, format, ...)                                            \
+  blog(level, "[SRT Input] " format, ##__VA_ARGS__)
+
+#ifdef HAVE_LIBSRT
+
+/* 等待数据时检查停止标志的间隔 */
+#define SRT_POLL_INTERVAL_MS 100
+
+struct srt_input {
+  SRTSOCKET socket; /* 主叫模式的连接 */
+  int epoll;
+  srt_hub_route_t *route; /* 监听模式: 数据来自共享监听 */
+  AVIOContext *avio;
+  volatile bool *active;
+  int timeout_ms;
+  int latency_ms;
+
+  /* AVIO请求的长度小于一个消息时, 多余部分留到下一次读取 */
+  uint8_t spill[SRT_LIVE_MAX_PLSIZE];
+  int spill_size;
+  int spill_pos;
+
+  uint64_t messages; /* 收到的消息数 */
+  uint64_t reads;    /* 返回了数据的读取次数 */
+  char url[256];
+};
+
+/*============================================================================
+ * URL解析
+ *============================================================================*/
+
+static int hex_value(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+/* 读取查询参数(百分号解码), 不存在时返回false */
+static bool get_query(const char *url, const char *key, char *value,
+                      size_t size) {
+  const char *p = strchr(url, '?');
+  size_t key_len = strlen(key);
+
+  while (p) {
+    p++;
+    if (strncmp(p, key, key_len) == 0 && p[key_len] == '=') {
+      const char *src = p + key_len + 1;
+      size_t n = 0;
+      while (*src && *src != '&' && n + 1 < size) {
+        int hi, lo;
+        if (*src == '%' && (hi = hex_value(src[1])) >= 0 &&
+            (lo = hex_value(src[2])) >= 0) {
+          value[n++] = (char)(hi << 4 | lo);
+          src += 3;
+        } else {
+          value[n++] = *src++;
+        }
+      }
+      value[n] = '\0';
+      return true;
+    }
+    p = strchr(p, '&');
+  }
+  return false;
+}
+
+static int get_query_int(const char *url, const char *key, int def) {
+  char value[32];
+  return get_query(url, key, value, sizeof(value)) ? atoi(value) : def;
+}
+
+/* srt://host:port 或 srt://[v6]:port, 主机为空表示监听所有地址 */
+static bool parse_address(const char *url, char *host, size_t host_size,
+                          char *port, size_t port_size) {
+  if (strncmp(url, "srt://", 6) != 0)
+    return false;
+
+  const char *p = url + 6;
+  const char *end = p + strcspn(p, "/?");
+  const char *colon;
+
+  if (*p == '[') {
+    const char *close = memchr(p, ']', (size_t)(end - p));
+    if (!close || close[1] != ':')
+      return false;
+    snprintf(host, host_size, "%.*s", (int)(close - p - 1), p + 1);
+    colon = close + 1;
+  } else {
+    colon = NULL;
+    for (const char *c = p; c < end; c++) {
+      if (*c == ':')
+        colon = c;
+    }
+    if (!colon)
+      return false;
+    snprintf(host, host_size, "%.*s", (int)(colon - p), p);
+  }
+
+  snprintf(port, port_size, "%.*s", (int)(end - colon - 1), colon + 1);
+  return port[0] != '\0';
+}
+
+/*============================================================================
+ * 连接
+ *============================================================================*/
+
+static bool set_flag(SRTSOCKET socket, SRT_SOCKOPT option, const void *value,
+                     int size, const char *name) {
+  if (srt_setsockflag(socket, option, value, size) == SRT_ERROR) {
+    srt_log(LOG_WARNING, "Cannot set %s: %s", name, srt_getlasterror_str());
+    return false;
+  }
+  return true;
+}
+
+static bool set_int(SRTSOCKET socket, SRT_SOCKOPT option, int value,
+                    const char *name) {
+  return set_flag(socket, option, &value, sizeof(value), name);
+}
+
+/* 源设置中非0的值优先, 其次是URL参数 */
+static void resolve_config(const char *url,
+                           const srt_input_options_t *options,
+                           srt_socket_config_t *config) {
+  memset(config, 0, sizeof(*config));
+
+  /* URL中的latency以微秒为单位 (FFmpeg约定) */
+  config->latency_ms = options->latency_ms;
+  if (!config->latency_ms) {
+    int latency_us = get_query_int(url, "rcvlatency", -1);
+    if (latency_us < 0)
+      latency_us = get_query_int(url, "latency", -1);
+    config->latency_ms = latency_us >= 0 ? latency_us / 1000 : 0;
+  }
+
+  config->rcvbuf_bytes = options->rcvbuf_bytes
+                             ? options->rcvbuf_bytes
+                             : get_query_int(url, "rcvbuf", 0);
+  config->payload_size = options->payload_size;
+  if (!config->payload_size)
+    config->payload_size = get_query_int(url, "payload_size", 0);
+  if (!config->payload_size)
+    config->payload_size = get_query_int(url, "pkt_size", 0);
+
+  config->timeout_ms = options->timeout_ms > 0 ? options->timeout_ms : 2000;
+  config->pbkeylen = get_query_int(url, "pbkeylen", 0);
+  get_query(url, "streamid", config->streamid, sizeof(config->streamid));
+  get_query(url, "passphrase", config->passphrase,
+            sizeof(config->passphrase));
+}
+
+bool srt_socket_configure(int socket, const srt_socket_config_t *config) {
+  bool ok = set_int(socket, SRTO_TRANSTYPE, SRTT_LIVE, "transtype") &&
+            set_int(socket, SRTO_CONNTIMEO, config->timeout_ms, "conntimeo");
+  if (ok && config->latency_ms > 0)
+    ok = set_int(socket, SRTO_RCVLATENCY, config->latency_ms, "rcvlatency");
+  if (ok && config->rcvbuf_bytes > 0)
+    ok = set_int(socket, SRTO_RCVBUF, config->rcvbuf_bytes, "rcvbuf");
+  if (ok && config->payload_size > 0)
+    ok = set_int(socket, SRTO_PAYLOADSIZE, config->payload_size,
+                 "payload_size");
+  if (ok && config->streamid[0])
+    ok = set_flag(socket, SRTO_STREAMID, config->streamid,
+                  (int)strlen(config->streamid), "streamid");
+  if (ok && config->passphrase[0])
+    ok = set_flag(socket, SRTO_PASSPHRASE, config->passphrase,
+                  (int)strlen(config->passphrase), "passphrase");
+  if (ok && config->pbkeylen > 0)
+    ok = set_int(socket, SRTO_PBKEYLEN, config->pbkeylen, "pbkeylen");
+  return ok;
+}
+
+/* 主叫模式: 连接到发送端(或SRT服务器) */
+static SRTSOCKET connect_socket(const char *url, const char *host,
+                                const char *port,
+                                const srt_socket_config_t *config) {
+  struct addrinfo hints = {0}, *addr = NULL;
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_DGRAM;
+  if (!host[0] || getaddrinfo(host, port, &hints, &addr) != 0 || !addr) {
+    srt_log(LOG_WARNING, "Cannot resolve %s", url);
+    return SRT_INVALID_SOCK;
+  }
+
+  SRTSOCKET socket = srt_create_socket();
+  if (socket == SRT_INVALID_SOCK || !srt_socket_configure(socket, config) ||
+      srt_connect(socket, addr->ai_addr, (int)addr->ai_addrlen) ==
+          SRT_ERROR) {
+    srt_log(LOG_WARNING, "Connection to %s failed: %s", url,
+            srt_getlasterror_str());
+    if (socket != SRT_INVALID_SOCK)
+      srt_close(socket);
+    socket = SRT_INVALID_SOCK;
+  }
+
+  freeaddrinfo(addr);
+  return socket;
+}
+
+/*============================================================================
+ * 读取
+ *============================================================================*/
+
+/* 读取一个消息, 没有已到达的消息时返回0 */
+static int recv_message(srt_input_t *input, uint8_t *buf, int size) {
+  int n = srt_recvmsg2(input->socket, (char *)buf, size, NULL);
+  if (n > 0) {
+    input->messages++;
+    return n;
+  }
+  if (n == SRT_ERROR && srt_getlasterror(NULL) == SRT_EASYNCRCV)
+    return 0;
+
+  srt_log(LOG_WARNING, "Receive from %s failed: %s", input->url,
+          n == 0 ? "connection closed" : srt_getlasterror_str());
+  return n == 0 ? AVERROR_EOF : AVERROR(EIO);
+}
+
+/* AVIO回调: 一次唤醒取出所有已到达的消息, 减少系统调用和线程切换 */
+static int read_packet(void *opaque, uint8_t *buf, int size) {
+  srt_input_t *input = opaque;
+
+  /* 监听模式由hub的I/O线程接收, 这里一次取出队列中的全部数据 */
+  if (input->route) {
+    int n = srt_hub_read(input->route, buf, size, input->timeout_ms,
+                         input->active);
+    if (n > 0)
+      input->reads++;
+    else if (n == AVERROR(ETIMEDOUT))
+      srt_log(LOG_WARNING, "No data from %s for %d ms", input->url,
+              input->timeout_ms);
+    return n;
+  }
+
+  if (input->spill_pos < input->spill_size) {
+    int n = input->spill_size - input->spill_pos;
+    if (n > size)
+      n = size;
+    memcpy(buf, input->spill + input->spill_pos, n);
+    input->spill_pos += n;
+    return n;
+  }
+
+  uint64_t deadline =
+      os_gettime_ns() + (uint64_t)input->timeout_ms * 1000000ULL;
+
+  for (;;) {
+    /* 消息不能拆开接收, 剩余空间不足一个最大消息时停止 */
+    int filled = 0;
+    while (size - filled >= SRT_LIVE_MAX_PLSIZE) {
+      int n = recv_message(input, buf + filled, size - filled);
+      if (n < 0)
+        return filled ? filled : n;
+      if (n == 0)
+        break;
+      filled += n;
+    }
+
+    if (!filled && size < SRT_LIVE_MAX_PLSIZE) {
+      int n = recv_message(input, input->spill, sizeof(input->spill));
+      if (n < 0)
+        return n;
+      if (n > 0) {
+        filled = n < size ? n : size;
+        memcpy(buf, input->spill, filled);
+        input->spill_size = n;
+        input->spill_pos = filled;
+      }
+    }
+
+    if (filled) {
+      input->reads++;
+      return filled;
+    }
+
+    if (!*input->active)
+      return AVERROR_EXIT;
+    if (os_gettime_ns() >= deadline) {
+      srt_log(LOG_WARNING, "No data from %s for %d ms", input->url,
+              input->timeout_ms);
+      return AVERROR(ETIMEDOUT);
+    }
+
+    SRT_EPOLL_EVENT event;
+    srt_epoll_uwait(input->epoll, &event, 1, SRT_POLL_INTERVAL_MS);
+  }
+}
+
+bool srt_input_available(void) { return true; }
+
+srt_input_t *srt_input_open(const char *url,
+                            const srt_input_options_t *options,
+                            volatile bool *active) {
+  char host[256], port[16], mode[16] = "caller";
+  if (!parse_address(url, host, sizeof(host), port, sizeof(port))) {
+    srt_log(LOG_ERROR, "Invalid SRT URL: %s", url);
+    return NULL;
+  }
+  get_query(url, "mode", mode, sizeof(mode));
+  bool listener = strcmp(mode, "listener") == 0;
+  if (!listener && strcmp(mode, "caller") != 0) {
+    srt_log(LOG_ERROR, "Unsupported SRT mode '%s'", mode);
+    return NULL;
+  }
+
+  srt_socket_config_t config;
+  resolve_config(url, options, &config);
+
+  srt_startup();
+  srt_input_t *input = bzalloc(sizeof(srt_input_t));
+  input->socket = SRT_INVALID_SOCK;
+  input->epoll = -1;
+  input->active = active;
+  input->timeout_ms = config.timeout_ms;
+  snprintf(input->url, sizeof(input->url), "%s", url);
+
+  if (listener) {
+    /* 同一端口的所有源共用一个监听, 按streamid分配连接 */
+    input->route = srt_hub_subscribe(host, port, &config);
+    if (!input->route || !srt_hub_wait(input->route, active))
+      goto fail;
+    input->latency_ms = srt_hub_latency_ms(input->route);
+  } else {
+    input->socket = connect_socket(url, host, port, &config);
+    if (input->socket == SRT_INVALID_SOCK)
+      goto fail;
+
+    /* 连接后改为非阻塞接收, 由epoll等待 */
+    int events = SRT_EPOLL_IN | SRT_EPOLL_ERR;
+    if (!set_int(input->socket, SRTO_RCVSYN, 0, "rcvsyn") ||
+        (input->epoll = srt_epoll_create()) < 0 ||
+        srt_epoll_add_usock(input->epoll, input->socket, &events) < 0)
+      goto fail;
+
+    int latency = 0, latency_size = sizeof(latency);
+    if (srt_getsockflag(input->socket, SRTO_RCVLATENCY, &latency,
+                        &latency_size) != SRT_ERROR)
+      input->latency_ms = latency;
+  }
+
+  int size = SRT_INPUT_BATCH * SRT_LIVE_MAX_PLSIZE;
+  uint8_t *buffer = av_malloc(size);
+  if (!buffer)
+    goto fail;
+  input->avio = avio_alloc_context(buffer, size, 0, input, read_packet, NULL,
+                                   NULL);
+  if (!input->avio) {
+    av_free(buffer);
+    goto fail;
+  }
+
+  srt_log(LOG_INFO, "Connected to %s (latency %d ms)", url,
+          input->latency_ms);
+  return input;
+
+fail:
+  srt_input_close(input);
+  return NULL;
+}
+
+AVIOContext *srt_input_avio(srt_input_t *input) {
+  return input ? input->avio : NULL;
+}
+
+int srt_input_latency_ms(const srt_input_t *input) {
+  return input ? input->latency_ms : 0;
+}
+
+bool srt_input_get_stats(srt_input_t *input, srt_input_stats_t *stats) {
+  if (!input)
+    return false;
+
+  SRTSOCKET socket =
+      input->route ? srt_hub_socket(input->route) : input->socket;
+  SRT_TRACEBSTATS perf;
+  if (socket == SRT_INVALID_SOCK ||
+      srt_bstats(socket, &perf, 1) == SRT_ERROR)
+    return false;
+
+  stats->rtt_ms = perf.msRTT;
+  stats->recv_mbps = perf.mbpsRecvRate;
+  stats->bandwidth_mbps = perf.mbpsBandwidth;
+  stats->packets_received = perf.pktRecv;
+  stats->packets_lost = perf.pktRcvLoss;
+  stats->packets_retrans = perf.pktRcvRetrans;
+  stats->packets_dropped = perf.pktRcvDrop;
+  stats->rcv_buf_ms = perf.msRcvBuf;
+  stats->tsbpd_delay_ms = perf.msRcvTsbPdDelay;
+  return true;
+}
+
+void srt_input_close(srt_input_t *input) {
+  if (!input)
+    return;
+
+  if (input->messages)
+    srt_log(LOG_INFO,
+            "Closed %s (%llu messages in %llu reads, %.1f per wakeup)",
+            input->url, (unsigned long long)input->messages,
+            (unsigned long long)input->reads,
+            (double)input->messages / (double)input->reads);
+
+  if (input->avio) {
+    av_freep(&input->avio->buffer);
+    avio_context_free(&input->avio);
+  }
+  if (input->epoll >= 0)
+    srt_epoll_release(input->epoll);
+  if (input->socket != SRT_INVALID_SOCK)
+    srt_close(input->socket);
+  srt_hub_unsubscribe(input->route);
+  bfree(input);
+  srt_cleanup();
+}
+
+#else /* !HAVE_LIBSRT */
+
+bool srt_input_available(void) { return false; }
+
+bool srt_socket_configure(int socket, const srt_socket_config_t *config) {
+  UNUSED_PARAMETER(socket);
+  UNUSED_PARAMETER(config);
+  return false;
+}
+
+srt_input_t *srt_input_open(const char *url,
+                            const srt_input_options_t *options,
+                            volatile bool *active) {
+  UNUSED_PARAMETER(options);
+  UNUSED_PARAMETER(active);
+  srt_log(LOG_WARNING, "Built without libsrt, cannot open %s natively", url);
+  return NULL;
+}
+
+AVIOContext *srt_input_avio(srt_input_t *input) {
+  UNUSED_PARAMETER(input);
+  return NULL;
+}
+
+int srt_input_latency_ms(const srt_input_t *input) {
+  UNUSED_PARAMETER(input);
+  return 0;
+}
+
+bool srt_input_get_stats(srt_input_t *input, srt_input_stats_t *stats) {
+  UNUSED_PARAMETER(input);
+  UNUSED_PARAMETER(stats);
+  return false;
+}
+
+void srt_input_close(srt_input_t *input) { UNUSED_PARAMETER(input); }
+
+#endif
@@ -0,0 +1,97 @@
+/******************************************************************************
+    SRT Input - Header File
+    Copyright (C) 2026
+
+    Native libsrt receive path for the SEI receiver: connects (or listens)
+    with per-source latency / buffer / payload settings and exposes the
+    stream as a custom AVIOContext that drains every queued message per
+    wakeup
+******************************************************************************/
+
+#pragma once
+
+#include <libavformat/avio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 每次唤醒最多读取的消息数(AVIO缓冲区 = 批量 x 最大载荷) */
+#define SRT_INPUT_BATCH 64
+
+/* 每个源可调的参数, 0表示使用URL中的值或libsrt默认值 */
+typedef struct srt_input_options {
+  int latency_ms;   /* 接收延迟(TSBPD) */
+  int rcvbuf_bytes; /* SRT接收缓冲区 */
+  int payload_size; /* SRTO_PAYLOADSIZE, TS应为188的倍数 */
+  int timeout_ms;   /* 连接及无数据超时 */
+} srt_input_options_t;
+
+/* URL参数与源设置合并后的连接参数 (srt-input与srt-hub共用), 0/空表示默认 */
+typedef struct srt_socket_config {
+  int latency_ms;
+  int rcvbuf_bytes;
+  int payload_size;
+  int timeout_ms;
+  int pbkeylen;
+  char streamid[512];
+  char passphrase[80];
+} srt_socket_config_t;
+
+/* 在连接(或监听)之前设置socket选项; socket为SRTSOCKET */
+bool srt_socket_configure(int socket, const srt_socket_config_t *config);
+
+typedef struct srt_input srt_input_t;
+
+/* 编译时是否找到了libsrt; 否则只能使用FFmpeg的srt协议 */
+bool srt_input_available(void);
+
+/*
+ * 打开srt://URL (mode=caller默认; mode=listener时通过srt-hub共享端口,
+ * 按streamid等待对应的发送端连入)
+ * URL参数: mode, streamid, passphrase, pbkeylen, latency/rcvlatency(微秒),
+ *          rcvbuf(字节), payload_size/pkt_size, 与FFmpeg srt协议一致
+ * 参数:
+ *   options - 非0的字段覆盖URL中的值
+ *   active - 变为false时连接和读取立即返回(接收线程停止)
+ * 返回:
+ *   NULL - 连接失败或编译时未找到libsrt
+ */
+srt_input_t *srt_input_open(const char *url,
+                            const srt_input_options_t *options,
+                            volatile bool *active);
+
+/* 供avformat使用的AVIOContext (AVFMT_FLAG_CUSTOM_IO, 由srt_input_close释放) */
+AVIOContext *srt_input_avio(srt_input_t *input);
+
+/* 握手协商后的接收延迟(毫秒) */
+int srt_input_latency_ms(const srt_input_t *input);
+
+/* 一个采样周期的传输统计 (srt_bstats) */
+typedef struct srt_input_stats {
+  double rtt_ms;
+  double recv_mbps;      /* 接收速率 */
+  double bandwidth_mbps; /* 估计的链路带宽 */
+  int64_t packets_received;
+  int packets_lost;    /* 检测到的丢包 */
+  int packets_retrans; /* 收到的重传包 */
+  int packets_dropped; /* 超过延迟仍未到达而放弃的包 */
+  int rcv_buf_ms;      /* 接收缓冲区中数据的时长 */
+  int tsbpd_delay_ms;  /* 协商后的接收延迟 */
+} srt_input_stats_t;
+
+/*
+ * 读取自上次调用以来的传输统计(包计数按周期清零)
+ * 返回:
+ *   false - 未连接, 或不是原生接收
+ */
+bool srt_input_get_stats(srt_input_t *input, srt_input_stats_t *stats);
+
+/* 关闭连接并释放(input可以为NULL) */
+void srt_input_close(srt_input_t *input);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,175 @@
+/******************************************************************************
+    SRT Transport Stats - Implementation
+    Copyright (C) 2026
+******************************************************************************/
+
+#include "srt-stats.h"
+#include "live-stats.h"
+#include <stdio.h>
+#include <string.h>
+#include <util/threading.h>
+
+/* 基线每个周期向本周期最小值靠近的比例(跟随两端时钟的缓慢漂移) */
+#define BASELINE_RELAX_SHIFT 4
+
+void srt_stats_reset(srt_stats_t *stats) {
+  os_atomic_set_bool(&stats->valid, false);
+  os_atomic_set_bool(&stats->absolute, false);
+  os_atomic_set_long(&stats->rtt_us, 0);
+  os_atomic_set_long(&stats->recv_kbps, 0);
+  os_atomic_set_long(&stats->bandwidth_kbps, 0);
+  os_atomic_set_long(&stats->loss_ppm, 0);
+  os_atomic_set_long(&stats->lost_total, 0);
+  os_atomic_set_long(&stats->retrans_total, 0);
+  os_atomic_set_long(&stats->dropped_total, 0);
+  os_atomic_set_long(&stats->rcv_buf_ms, 0);
+  os_atomic_set_long(&stats->latency_ms, 0);
+  os_atomic_set_long(&stats->arrival_us, 0);
+  os_atomic_set_long(&stats->excess_us, 0);
+  os_atomic_set_long(&stats->late_transport, 0);
+  os_atomic_set_long(&stats->late_other, 0);
+
+  stats->has_baseline = false;
+  stats->baseline_ns = 0;
+  stats->period_sum_ns = 0;
+  stats->period_min_ns = 0;
+  stats->period_frames = 0;
+  stats->period_late = 0;
+  stats->period_absolute = false;
+}
+
+void srt_stats_add_frame(srt_stats_t *stats, int64_t latency_ns,
+                         bool absolute) {
+  /* 切换NTP/链路时间基准后旧基线不再可比 */
+  if (stats->has_baseline && absolute != stats->period_absolute) {
+    stats->has_baseline = false;
+    stats->period_sum_ns = 0;
+    stats->period_frames = 0;
+    stats->period_late = 0;
+  }
+  stats->period_absolute = absolute;
+
+  if (!stats->has_baseline || latency_ns < stats->baseline_ns) {
+    stats->baseline_ns = latency_ns;
+    stats->has_baseline = true;
+  }
+  if (stats->period_frames == 0 || latency_ns < stats->period_min_ns)
+    stats->period_min_ns = latency_ns;
+
+  stats->period_sum_ns += latency_ns;
+  stats->period_frames++;
+  if (latency_ns - stats->baseline_ns >
+      (int64_t)SRT_STATS_LATE_MARGIN_MS * 1000000)
+    stats->period_late++;
+}
+
+srt_late_cause_t srt_stats_update(srt_stats_t *stats,
+                                  const srt_input_stats_t *transport) {
+  bool transport_trouble = false;
+  if (transport) {
+    transport_trouble = transport->packets_lost > 0 ||
+                        transport->packets_retrans > 0 ||
+                        transport->packets_dropped > 0;
+
+    int64_t expected =
+        transport->packets_received + transport->packets_lost;
+    os_atomic_set_long(&stats->rtt_us, (long)(transport->rtt_ms * 1000.0));
+    os_atomic_set_long(&stats->recv_kbps,
+                       (long)(transport->recv_mbps * 1000.0));
+    os_atomic_set_long(&stats->bandwidth_kbps,
+                       (long)(transport->bandwidth_mbps * 1000.0));
+    os_atomic_set_long(&stats->loss_ppm,
+                       expected > 0 ? (long)(transport->packets_lost *
+                                             1000000LL / expected)
+                                    : 0);
+    live_stat_add(&stats->lost_total, transport->packets_lost);
+    live_stat_add(&stats->retrans_total, transport->packets_retrans);
+    live_stat_add(&stats->dropped_total, transport->packets_dropped);
+    os_atomic_set_long(&stats->rcv_buf_ms, transport->rcv_buf_ms);
+    os_atomic_set_long(&stats->latency_ms, transport->tsbpd_delay_ms);
+    os_atomic_set_bool(&stats->valid, true);
+  }
+
+  if (stats->period_frames > 0) {
+    int64_t average = stats->period_sum_ns / stats->period_frames;
+    /* 链路模式下的绝对值包含未知的时钟偏移, 只发布超出基线的部分 */
+    os_atomic_set_long(&stats->arrival_us,
+                       stats->period_absolute ? (long)(average / 1000) : 0);
+    os_atomic_set_long(&stats->excess_us,
+                       (long)((average - stats->baseline_ns) / 1000));
+    os_atomic_set_bool(&stats->absolute, stats->period_absolute);
+
+    if (stats->period_min_ns > stats->baseline_ns)
+      stats->baseline_ns += (stats->period_min_ns - stats->baseline_ns) >>
+                            BASELINE_RELAX_SHIFT;
+  }
+
+  srt_late_cause_t cause = SRT_LATE_NONE;
+  if (stats->period_late > 0) {
+    cause = transport_trouble ? SRT_LATE_TRANSPORT : SRT_LATE_OTHER;
+    live_stat_add(cause == SRT_LATE_TRANSPORT ? &stats->late_transport
+                                              : &stats->late_other,
+                  (long)stats->period_late);
+  }
+
+  stats->period_sum_ns = 0;
+  stats->period_frames = 0;
+  stats->period_late = 0;
+  return cause;
+}
+
+void srt_stats_snapshot(const srt_stats_t *stats,
+                        srt_stats_snapshot_t *snapshot) {
+  snapshot->valid = os_atomic_load_bool(&stats->valid);
+  snapshot->absolute = os_atomic_load_bool(&stats->absolute);
+  snapshot->rtt_ms = os_atomic_load_long(&stats->rtt_us) / 1000.0;
+  snapshot->recv_mbps = os_atomic_load_long(&stats->recv_kbps) / 1000.0;
+  snapshot->bandwidth_mbps =
+      os_atomic_load_long(&stats->bandwidth_kbps) / 1000.0;
+  snapshot->loss_percent = os_atomic_load_long(&stats->loss_ppm) / 10000.0;
+  snapshot->lost_total = os_atomic_load_long(&stats->lost_total);
+  snapshot->retrans_total = os_atomic_load_long(&stats->retrans_total);
+  snapshot->dropped_total = os_atomic_load_long(&stats->dropped_total);
+  snapshot->rcv_buf_ms = os_atomic_load_long(&stats->rcv_buf_ms);
+  snapshot->latency_ms = os_atomic_load_long(&stats->latency_ms);
+  snapshot->arrival_ms = os_atomic_load_long(&stats->arrival_us) / 1000.0;
+  snapshot->excess_ms = os_atomic_load_long(&stats->excess_us) / 1000.0;
+  snapshot->late_transport = os_atomic_load_long(&stats->late_transport);
+  snapshot->late_other = os_atomic_load_long(&stats->late_other);
+}
+
+size_t srt_stats_format(const srt_stats_snapshot_t *snapshot, char *buf,
+                        size_t size) {
+  if (!size)
+    return 0;
+
+  int len = 0;
+  if (snapshot->valid) {
+    len = snprintf(buf, size,
+                   "SRT: RTT %.1f ms, loss %.2f%%, retrans %ld, drop %ld\n"
+                   "Buffer %ld / %ld ms, %.2f Mbps (link %.1f Mbps)\n",
+                   snapshot->rtt_ms, snapshot->loss_percent,
+                   snapshot->retrans_total, snapshot->dropped_total,
+                   snapshot->rcv_buf_ms, snapshot->latency_ms,
+                   snapshot->recv_mbps, snapshot->bandwidth_mbps);
+  } else {
+    len = snprintf(buf, size, "SRT: no transport stats\n");
+  }
+  if (len < 0 || (size_t)len >= size)
+    return strlen(buf);
+
+  int more;
+  if (snapshot->absolute)
+    more = snprintf(buf + len, size - len,
+                    "Arrival %.1f ms (+%.1f), late %ld transport / %ld other",
+                    snapshot->arrival_ms, snapshot->excess_ms,
+                    snapshot->late_transport, snapshot->late_other);
+  else
+    more = snprintf(buf + len, size - len,
+                    "Arrival +%.1f ms, late %ld transport / %ld other",
+                    snapshot->excess_ms, snapshot->late_transport,
+                    snapshot->late_other);
+  if (more < 0 || (size_t)more >= size - len)
+    return strlen(buf);
+  return (size_t)(len + more);
+}
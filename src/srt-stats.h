@@ -0,0 +1,115 @@
+/******************************************************************************
+    SRT Transport Stats - Header File
+    Copyright (C) 2026
+
+    Per-receiver link health (RTT, loss, retransmits, receive buffer, rate)
+    sampled from srt_bstats once a second, correlated with the arrival
+    latency of stamped frames so late frames can be blamed on the transport
+    or on the clock. Written by the receive thread only and published with
+    atomics, so the UI and stats queries read it without locking
+******************************************************************************/
+
+#pragma once
+
+#include "srt-input.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 采样周期 */
+#define SRT_STATS_INTERVAL_NS 1000000000ULL
+
+/* 到达延迟超过本连接基线多少视为迟到帧 */
+#define SRT_STATS_LATE_MARGIN_MS 40
+
+/* 迟到帧的原因 */
+typedef enum srt_late_cause {
+  SRT_LATE_NONE,      /* 本周期没有迟到帧 */
+  SRT_LATE_TRANSPORT, /* 本周期有丢包/重传/丢弃 */
+  SRT_LATE_OTHER      /* 链路正常, 多为发送端或时钟问题 */
+} srt_late_cause_t;
+
+/* 发布的值(volatile long, os_atomic_*读写) 与接收线程私有的周期累计 */
+typedef struct srt_stats {
+  volatile bool valid;          /* 已有传输统计(原生接收且已采样) */
+  volatile bool absolute;       /* 到达延迟基于NTP, 为真实的单向延迟 */
+  volatile long rtt_us;         /* 往返时间 */
+  volatile long recv_kbps;      /* 接收速率 */
+  volatile long bandwidth_kbps; /* 估计的链路带宽 */
+  volatile long loss_ppm;       /* 上一周期的丢包率(百万分比) */
+  volatile long lost_total;     /* 本连接累计丢包 */
+  volatile long retrans_total;  /* 本连接累计收到的重传包 */
+  volatile long dropped_total;  /* 本连接累计丢弃的包(超过延迟未到) */
+  volatile long rcv_buf_ms;     /* 接收缓冲区中数据的时长 */
+  volatile long latency_ms;     /* 协商后的接收延迟 */
+  volatile long arrival_us;     /* 上一周期的平均到达延迟 */
+  volatile long excess_us;      /* 上一周期平均到达延迟超出基线的部分 */
+  volatile long late_transport; /* 累计迟到帧: 传输引起 */
+  volatile long late_other;     /* 累计迟到帧: 其他原因 */
+
+  /* 以下仅由接收线程访问 */
+  bool has_baseline;
+  int64_t baseline_ns;   /* 本连接的最小到达延迟(随漂移缓慢上调) */
+  int64_t period_sum_ns; /* 本周期到达延迟之和 */
+  int64_t period_min_ns;
+  uint32_t period_frames;
+  uint32_t period_late;
+  bool period_absolute;
+} srt_stats_t;
+
+/* 供界面和统计接口读取的一致副本 */
+typedef struct srt_stats_snapshot {
+  bool valid;
+  bool absolute;
+  double rtt_ms;
+  double recv_mbps;
+  double bandwidth_mbps;
+  double loss_percent;
+  long lost_total;
+  long retrans_total;
+  long dropped_total;
+  long rcv_buf_ms;
+  long latency_ms;
+  double arrival_ms;
+  double excess_ms;
+  long late_transport;
+  long late_other;
+} srt_stats_snapshot_t;
+
+/* 新连接: 清零累计值和到达延迟基线 */
+void srt_stats_reset(srt_stats_t *stats);
+
+/*
+ * 记录一帧带时间戳的帧的到达延迟(接收线程)
+ * 参数:
+ *   latency_ns - 到达的本地时间 - 发送端时间(换算到本地时钟后)
+ *   absolute - 发送端时间已由NTP换算, 否则只有相对变化有意义
+ */
+void srt_stats_add_frame(srt_stats_t *stats, int64_t latency_ns,
+                         bool absolute);
+
+/*
+ * 结束一个采样周期(接收线程, 每SRT_STATS_INTERVAL_NS一次)
+ * 参数:
+ *   transport - 本周期的srt_bstats, 非原生接收时为NULL
+ * 返回:
+ *   本周期迟到帧的原因
+ */
+srt_late_cause_t srt_stats_update(srt_stats_t *stats,
+                                  const srt_input_stats_t *transport);
+
+/* 读取当前值(任意线程) */
+void srt_stats_snapshot(const srt_stats_t *stats,
+                        srt_stats_snapshot_t *snapshot);
+
+/* 格式化为多行文本(属性的状态栏), 返回写入的长度 */
+size_t srt_stats_format(const srt_stats_snapshot_t *snapshot, char *buf,
+                        size_t size);
+
+#ifdef __cplusplus
+}
+#endif
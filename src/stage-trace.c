@@ -0,0 +1,248 @@
+/******************************************************************************
+    Stage Trace - Implementation
+    Copyright (C) 2026
+******************************************************************************/
+
+#include "stage-trace.h"
+
+#ifdef ENABLE_TRACE
+
+#include <obs-module.h>
+#include <stdio.h>
+#include <string.h>
+#include <util/dstr.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+#if defined(_MSC_VER)
+#define TRACE_THREAD_LOCAL __declspec(thread)
+#else
+#define TRACE_THREAD_LOCAL _Thread_local
+#endif
+
+#define RING_MASK (STAGE_TRACE_RING_EVENTS - 1)
+
+typedef struct trace_event {
+  const char *category;
+  const char *stage;
+  uint64_t start_ns;
+  uint64_t end_ns;
+  int64_t frame;
+} trace_event_t;
+
+/* 单写者环: 写入线程先写事件再发布head, 导出时按head判断哪些槽位有效 */
+typedef struct trace_ring {
+  trace_event_t events[STAGE_TRACE_RING_EVENTS];
+  volatile long head; /* 已发布的事件数 (按uint32回绕) */
+  uint32_t written;   /* 写入线程私有 */
+
+  /* 以下由registry_mutex保护 */
+  long tid;       /* 导出时的线程号 (复用时重新分配) */
+  char name[128]; /* 线程名 */
+  bool in_use;    /* 有线程正在写入 */
+  struct trace_ring *next;
+} trace_ring_t;
+
+static pthread_mutex_t registry_mutex = PTHREAD_MUTEX_INITIALIZER;
+static trace_ring_t *registry_head;
+static long next_tid = 1;
+static TRACE_THREAD_LOCAL trace_ring_t *thread_ring;
+
+/* 分配或复用一个空闲的环 (每个线程只调用一次) */
+static trace_ring_t *acquire_ring(const char *name) {
+  pthread_mutex_lock(&registry_mutex);
+  trace_ring_t *ring = registry_head;
+  while (ring && ring->in_use)
+    ring = ring->next;
+  if (!ring) {
+    ring = bzalloc(sizeof(trace_ring_t));
+    ring->next = registry_head;
+    registry_head = ring;
+  }
+  os_atomic_set_long(&ring->head, 0);
+  ring->written = 0;
+  ring->tid = next_tid++;
+  ring->in_use = true;
+  snprintf(ring->name, sizeof(ring->name), "%s", name ? name : "thread");
+  pthread_mutex_unlock(&registry_mutex);
+  return ring;
+}
+
+void stage_trace_thread_begin(const char *name) {
+  if (!thread_ring)
+    thread_ring = acquire_ring(name);
+}
+
+void stage_trace_thread_end(void) {
+  if (!thread_ring)
+    return;
+  pthread_mutex_lock(&registry_mutex);
+  thread_ring->in_use = false;
+  pthread_mutex_unlock(&registry_mutex);
+  thread_ring = NULL;
+}
+
+void stage_trace_record(const char *category, const char *stage,
+                        uint64_t start_ns, int64_t frame) {
+  trace_ring_t *ring = thread_ring;
+  if (!ring)
+    ring = thread_ring = acquire_ring(category);
+
+  trace_event_t *event = &ring->events[ring->written & RING_MASK];
+  event->category = category;
+  event->stage = stage;
+  event->start_ns = start_ns;
+  event->end_ns = fast_clock_now_ns();
+  event->frame = frame;
+  ring->written++;
+  os_atomic_set_long(&ring->head, (long)ring->written);
+}
+
+/* JSON字符串转义 (线程名来自源名) */
+static void cat_json_string(struct dstr *out, const char *value) {
+  dstr_cat(out, "\"");
+  for (const char *c = value; *c; c++) {
+    if (*c == '"' || *c == '\\')
+      dstr_catf(out, "\\%c", *c);
+    else if ((unsigned char)*c < 0x20)
+      dstr_catf(out, "\\u%04x", (unsigned char)*c);
+    else
+      dstr_ncat(out, c, 1);
+  }
+  dstr_cat(out, "\"");
+}
+
+/*
+ * 复制一个环的有效事件
+ * 复制期间写入线程可能继续写入并覆盖最旧的槽位: 复制后重新读取head,
+ * 丢弃可能已被覆盖(或正在被写入)的事件
+ */
+static size_t copy_ring(trace_ring_t *ring, trace_event_t *copy,
+                        uint32_t *first) {
+  uint32_t head = (uint32_t)os_atomic_load_long(&ring->head);
+  uint32_t count =
+      head < STAGE_TRACE_RING_EVENTS ? head : STAGE_TRACE_RING_EVENTS;
+  uint32_t start = head - count;
+  for (uint32_t i = 0; i < count; i++)
+    copy[i] = ring->events[(start + i) & RING_MASK];
+
+  uint32_t now = (uint32_t)os_atomic_load_long(&ring->head);
+  uint32_t skip = 0;
+  while (skip < count && now - (start + skip) >= STAGE_TRACE_RING_EVENTS)
+    skip++;
+  *first = skip;
+  return count - skip;
+}
+
+static void cat_events(struct dstr *json, trace_ring_t *ring,
+                       trace_event_t *copy, size_t *total) {
+  dstr_catf(json,
+            ",\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,"
+            "\"tid\":%ld,\"args\":{\"name\":",
+            ring->tid);
+  cat_json_string(json, ring->name);
+  dstr_cat(json, "}}");
+
+  uint32_t first = 0;
+  size_t count = copy_ring(ring, copy, &first);
+  for (size_t i = first; i < first + count; i++) {
+    const trace_event_t *event = &copy[i];
+    dstr_catf(json,
+              ",\n{\"ph\":\"X\",\"cat\":\"%s\",\"name\":\"%s\",\"pid\":1,"
+              "\"tid\":%ld,\"ts\":%.3f,\"dur\":%.3f,"
+              "\"args\":{\"frame\":%lld}}",
+              event->category, event->stage, ring->tid,
+              event->start_ns / 1000.0,
+              (event->end_ns - event->start_ns) / 1000.0,
+              (long long)event->frame);
+  }
+  *total += count;
+}
+
+/* 默认输出路径: <插件配置目录>/traces/trace_<时间>.json */
+static void default_path(struct dstr *path) {
+  char *dir = obs_module_config_path("traces");
+  if (!dir)
+    return;
+  os_mkdirs(dir);
+  char *file = os_generate_formatted_filename(
+      "json", true, "trace_%CCYY-%MM-%DD_%hh-%mm-%ss");
+  dstr_printf(path, "%s/%s", dir, file);
+  bfree(file);
+  bfree(dir);
+}
+
+bool stage_trace_dump(const char *path, size_t *events) {
+  struct dstr file = {0};
+  if (path && *path)
+    dstr_copy(&file, path);
+  else
+    default_path(&file);
+  if (!file.len) {
+    dstr_free(&file);
+    return false;
+  }
+
+  struct dstr json = {0};
+  size_t total = 0;
+  int threads = 0;
+  trace_event_t *copy =
+      bmalloc(sizeof(trace_event_t) * STAGE_TRACE_RING_EVENTS);
+
+  dstr_cat(&json, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+                  "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":1,"
+                  "\"args\":{\"name\":\"OBS (SEI Stamper)\"}}");
+  pthread_mutex_lock(&registry_mutex);
+  for (trace_ring_t *ring = registry_head; ring; ring = ring->next) {
+    cat_events(&json, ring, copy, &total);
+    threads++;
+  }
+  pthread_mutex_unlock(&registry_mutex);
+  dstr_cat(&json, "\n]}\n");
+  bfree(copy);
+
+  bool ok = os_quick_write_utf8_file(file.array, json.array, json.len, false);
+  if (ok)
+    blog(LOG_INFO, "[Stage Trace] Wrote %zu events from %d threads to %s",
+         total, threads, file.array);
+  else
+    blog(LOG_WARNING, "[Stage Trace] Failed to write %s", file.array);
+
+  if (events)
+    *events = total;
+  dstr_free(&json);
+  dstr_free(&file);
+  return ok;
+}
+
+static void trace_dump_proc(void *data, calldata_t *cd) {
+  UNUSED_PARAMETER(data);
+
+  size_t events = 0;
+  bool ok = stage_trace_dump(calldata_string(cd, "path"), &events);
+  calldata_set_bool(cd, "ok", ok);
+  calldata_set_int(cd, "events", (long long)events);
+}
+
+void stage_trace_add_procs(void) {
+  proc_handler_t *handler = obs_get_proc_handler();
+  if (!handler)
+    return;
+
+  proc_handler_add(handler,
+                   "void sei_stamper_trace_dump(in string path, out bool ok, "
+                   "out int events)",
+                   trace_dump_proc, NULL);
+}
+
+void stage_trace_free(void) {
+  pthread_mutex_lock(&registry_mutex);
+  while (registry_head) {
+    trace_ring_t *ring = registry_head;
+    registry_head = ring->next;
+    bfree(ring);
+  }
+  pthread_mutex_unlock(&registry_mutex);
+}
+
+#endif
@@ -0,0 +1,86 @@
+/******************************************************************************
+    Stage Trace - Header File
+    Copyright (C) 2026
+
+    Per-frame trace points around the receive and encode stages, kept in a
+    lock-free ring per thread and dumped on demand as Chrome/Perfetto trace
+    JSON (chrome://tracing, ui.perfetto.dev). Built only with ENABLE_TRACE
+    (CMake option SEI_STAMPER_TRACE); otherwise every trace point compiles
+    to nothing
+******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef ENABLE_TRACE
+#include "fast-clock.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef ENABLE_TRACE
+
+/* 每个线程保留的事件数 (2的幂; 每帧约10个事件, 60fps时约27秒) */
+#define STAGE_TRACE_RING_EVENTS 16384
+
+/*
+ * 为当前线程的环命名(例如接收源名), 线程的第一个事件之前调用
+ * 未命名的线程以第一个事件的类别命名
+ */
+void stage_trace_thread_begin(const char *name);
+
+/* 线程退出前调用: 之后启动的线程复用这个环 (旧事件被丢弃) */
+void stage_trace_thread_end(void);
+
+/*
+ * 记录一个从start_ns到现在的阶段(只写本线程的环, 无锁)
+ * 参数:
+ *   category - 类别(静态字符串, 如"receive"/"nvenc")
+ *   stage - 阶段名(静态字符串)
+ *   frame - 帧序号, 作为事件参数便于逐帧对照
+ */
+void stage_trace_record(const char *category, const char *stage,
+                        uint64_t start_ns, int64_t frame);
+
+/*
+ * 把所有线程的环写为Chrome trace JSON
+ * 参数:
+ *   path - 输出文件, NULL或空时写到插件配置目录下的traces/
+ *   events - 写入的事件数(可以为NULL)
+ * 返回:
+ *   true - 成功
+ */
+bool stage_trace_dump(const char *path, size_t *events);
+
+/* 在全局proc handler上注册 sei_stamper_trace_dump(in string path, ...) */
+void stage_trace_add_procs(void);
+
+/* 释放所有环(模块卸载时) */
+void stage_trace_free(void);
+
+#define TRACE_THREAD_BEGIN(name) stage_trace_thread_begin(name)
+#define TRACE_THREAD_END() stage_trace_thread_end()
+#define TRACE_START(var) uint64_t var = fast_clock_now_ns()
+#define TRACE_STAGE(var, category, stage, frame)                               \
+  stage_trace_record(category, stage, var, frame)
+
+#else
+
+#define TRACE_THREAD_BEGIN(name) ((void)0)
+#define TRACE_THREAD_END() ((void)0)
+#define TRACE_START(var) ((void)0)
+#define TRACE_STAGE(var, category, stage, frame) ((void)0)
+
+static inline void stage_trace_add_procs(void) {}
+static inline void stage_trace_free(void) {}
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,128 @@
+/******************************************************************************
+    Stream Parameter Cache - Implementation
+    Copyright (C) 2026
+
+    Process-wide, URL-keyed table of video/audio AVCodecParameters
+******************************************************************************/
+
+#include "stream-param-cache.h"
+#include <string.h>
+#include <util/threading.h>
+
+typedef struct cache_entry {
+  char url[256]; /* 空表示未使用 */
+  AVCodecParameters *video;
+  AVCodecParameters *audio;
+  uint64_t last_used; /* cache_clock的值, 用于LRU替换 */
+} cache_entry_t;
+
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static cache_entry_t cache_entries[STREAM_PARAM_CACHE_SIZE];
+static uint64_t cache_clock;
+
+static AVCodecParameters *copy_params(const AVCodecParameters *src) {
+  if (!src)
+    return NULL;
+  AVCodecParameters *dst = avcodec_parameters_alloc();
+  if (dst && avcodec_parameters_copy(dst, src) < 0)
+    avcodec_parameters_free(&dst);
+  return dst;
+}
+
+static void clear_entry(cache_entry_t *entry) {
+  avcodec_parameters_free(&entry->video);
+  avcodec_parameters_free(&entry->audio);
+  entry->url[0] = '\0';
+  entry->last_used = 0;
+}
+
+/* 调用者持有cache_mutex */
+static cache_entry_t *find_entry(const char *url) {
+  for (size_t i = 0; i < STREAM_PARAM_CACHE_SIZE; i++) {
+    if (cache_entries[i].url[0] && strcmp(cache_entries[i].url, url) == 0)
+      return &cache_entries[i];
+  }
+  return NULL;
+}
+
+bool stream_param_cache_get(const char *url, stream_params_t *params) {
+  memset(params, 0, sizeof(*params));
+  if (!url || !url[0])
+    return false;
+
+  /* 解锁后entry可能被其他线程替换, 只在锁内读取 */
+  bool found = false, has_audio = false;
+  pthread_mutex_lock(&cache_mutex);
+  cache_entry_t *entry = find_entry(url);
+  if (entry) {
+    entry->last_used = ++cache_clock;
+    params->video = copy_params(entry->video);
+    params->audio = copy_params(entry->audio);
+    has_audio = entry->audio != NULL;
+    found = true;
+  }
+  pthread_mutex_unlock(&cache_mutex);
+
+  if (!found)
+    return false;
+  if (!params->video || (has_audio && !params->audio)) {
+    stream_params_free(params);
+    return false;
+  }
+  return true;
+}
+
+void stream_param_cache_put(const char *url, const AVCodecParameters *video,
+                            const AVCodecParameters *audio) {
+  if (!url || !url[0] || strlen(url) >= sizeof(cache_entries[0].url) ||
+      !video)
+    return;
+
+  /* 在锁外复制, 失败时保留旧记录 */
+  AVCodecParameters *video_copy = copy_params(video);
+  AVCodecParameters *audio_copy = copy_params(audio);
+  if (!video_copy || (audio && !audio_copy)) {
+    avcodec_parameters_free(&video_copy);
+    avcodec_parameters_free(&audio_copy);
+    return;
+  }
+
+  pthread_mutex_lock(&cache_mutex);
+  cache_entry_t *entry = find_entry(url);
+  if (!entry) {
+    entry = &cache_entries[0];
+    for (size_t i = 1; i < STREAM_PARAM_CACHE_SIZE; i++) {
+      if (cache_entries[i].last_used < entry->last_used)
+        entry = &cache_entries[i];
+    }
+  }
+  clear_entry(entry);
+  strcpy(entry->url, url);
+  entry->video = video_copy;
+  entry->audio = audio_copy;
+  entry->last_used = ++cache_clock;
+  pthread_mutex_unlock(&cache_mutex);
+}
+
+void stream_param_cache_remove(const char *url) {
+  if (!url)
+    return;
+
+  pthread_mutex_lock(&cache_mutex);
+  cache_entry_t *entry = find_entry(url);
+  if (entry)
+    clear_entry(entry);
+  pthread_mutex_unlock(&cache_mutex);
+}
+
+void stream_params_free(stream_params_t *params) {
+  avcodec_parameters_free(&params->video);
+  avcodec_parameters_free(&params->audio);
+}
+
+void stream_param_cache_clear(void) {
+  pthread_mutex_lock(&cache_mutex);
+  for (size_t i = 0; i < STREAM_PARAM_CACHE_SIZE; i++)
+    clear_entry(&cache_entries[i]);
+  pthread_mutex_unlock(&cache_mutex);
+}
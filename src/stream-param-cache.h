@@ -0,0 +1,53 @@
+/******************************************************************************
+    Stream Parameter Cache - Header File
+    Copyright (C) 2026
+
+    Remembers the codec parameters of every receiver URL that decoded at
+    least one frame, so a reconnect can skip avformat_find_stream_info and
+    start decoding at the first keyframe
+******************************************************************************/
+
+#pragma once
+
+#include <libavcodec/avcodec.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 最多缓存的URL数, 超出时替换最久未使用的 */
+#define STREAM_PARAM_CACHE_SIZE 16
+
+/* 一个URL的流参数(副本, 由调用者释放) */
+typedef struct stream_params {
+  AVCodecParameters *video;
+  AVCodecParameters *audio; /* 流中没有音频时为NULL */
+} stream_params_t;
+
+/*
+ * 查找URL的缓存参数
+ * 返回:
+ *   true - params中为缓存的副本, 用stream_params_free释放
+ */
+bool stream_param_cache_get(const char *url, stream_params_t *params);
+
+/*
+ * 保存URL的参数(复制video/audio), 替换已有的记录
+ * audio可以为NULL
+ */
+void stream_param_cache_put(const char *url, const AVCodecParameters *video,
+                            const AVCodecParameters *audio);
+
+/* 删除URL的记录(参数失效, 下次连接完整探测) */
+void stream_param_cache_remove(const char *url);
+
+/* 释放stream_param_cache_get返回的副本 */
+void stream_params_free(stream_params_t *params);
+
+/* 清空缓存(模块卸载时调用) */
+void stream_param_cache_clear(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,183 @@
+/******************************************************************************
+    Stream Recorder - Implementation
+    Copyright (C) 2026
+
+    Stream-copy of the received video/audio into MPEG-TS plus the .ssix index
+******************************************************************************/
+
+#include "stream-recorder.h"
+#include <obs-module.h>
+#include <stdio.h>
+#include <string.h>
+
+#define recorder_log(level, format, ...)                                       \
+  blog(level, "[Stream Recorder] " format, ##__VA_ARGS__)
+
+static AVStream *add_stream(AVFormatContext *output, const AVStream *input) {
+  AVStream *stream = avformat_new_stream(output, NULL);
+  if (!stream ||
+      avcodec_parameters_copy(stream->codecpar, input->codecpar) < 0)
+    return NULL;
+  /* 输入容器的codec_tag在TS中无意义 */
+  stream->codecpar->codec_tag = 0;
+  stream->time_base = input->time_base;
+  return stream;
+}
+
+static void close_output(stream_recorder_t *recorder) {
+  if (recorder->output) {
+    if (recorder->output->pb)
+      avio_closep(&recorder->output->pb);
+    avformat_free_context(recorder->output);
+    recorder->output = NULL;
+  }
+  av_packet_free(&recorder->packet);
+}
+
+bool stream_recorder_open(stream_recorder_t *recorder, const char *path,
+                          const AVFormatContext *input, int video_index,
+                          int audio_index) {
+  memset(recorder, 0, sizeof(*recorder));
+  recorder->audio_input = -1;
+  snprintf(recorder->path, sizeof(recorder->path), "%s", path);
+
+  const AVStream *video = input->streams[video_index];
+  if (video->codecpar->codec_id != AV_CODEC_ID_H264 &&
+      video->codecpar->codec_id != AV_CODEC_ID_HEVC) {
+    recorder_log(LOG_WARNING, "Cannot record %s streams",
+                 avcodec_get_name(video->codecpar->codec_id));
+    return false;
+  }
+  recorder->codec = video->codecpar->codec_id == AV_CODEC_ID_HEVC
+                        ? SEISTAMP_CODEC_H265
+                        : SEISTAMP_CODEC_H264;
+
+  if (avformat_alloc_output_context2(&recorder->output, NULL, "mpegts",
+                                     path) < 0) {
+    recorder_log(LOG_ERROR, "Failed to create TS muxer");
+    return false;
+  }
+
+  recorder->packet = av_packet_alloc();
+  if (!recorder->packet || !add_stream(recorder->output, video))
+    goto fail;
+  recorder->video_input = video_index;
+  recorder->video_time_base = video->time_base;
+
+  if (audio_index >= 0) {
+    const AVStream *audio = input->streams[audio_index];
+    if (!add_stream(recorder->output, audio))
+      goto fail;
+    recorder->audio_input = audio_index;
+    recorder->audio_output = 1;
+    recorder->audio_time_base = audio->time_base;
+  }
+
+  if (avio_open(&recorder->output->pb, path, AVIO_FLAG_WRITE) < 0) {
+    recorder_log(LOG_ERROR, "Cannot create %s", path);
+    goto fail;
+  }
+  if (avformat_write_header(recorder->output, NULL) < 0) {
+    recorder_log(LOG_ERROR, "Failed to write TS header to %s", path);
+    goto fail;
+  }
+
+  /* 索引中的PTS使用输出时间基, write_header之后才确定(TS为1/90000) */
+  AVRational time_base = recorder->output->streams[0]->time_base;
+  char index_path[sizeof(recorder->path) + 8];
+  snprintf(index_path, sizeof(index_path), "%s%s", path,
+           SEISTAMP_INDEX_EXTENSION);
+
+  /* 索引失败不影响录像本身 */
+  recorder->index = seistamp_index_writer_create(
+      index_path, recorder->codec, time_base.num, time_base.den);
+  if (!recorder->index)
+    recorder_log(LOG_WARNING, "Recording without index: %s", index_path);
+
+  recorder_log(LOG_INFO, "Recording to %s", path);
+  return true;
+
+fail:
+  close_output(recorder);
+  return false;
+}
+
+void stream_recorder_write(stream_recorder_t *recorder,
+                           const AVPacket *packet) {
+  if (!recorder->output)
+    return;
+
+  bool video = packet->stream_index == recorder->video_input;
+  if (!video && packet->stream_index != recorder->audio_input)
+    return;
+
+  const AVStream *stream =
+      recorder->output->streams[video ? 0 : recorder->audio_output];
+  AVPacket *out = recorder->packet;
+  if (av_packet_ref(out, packet) < 0)
+    return;
+
+  out->stream_index = stream->index;
+  out->pos = -1;
+  av_packet_rescale_ts(out,
+                       video ? recorder->video_time_base
+                             : recorder->audio_time_base,
+                       stream->time_base);
+
+  int64_t offset = avio_tell(recorder->output->pb);
+  int64_t pts = out->pts;
+  bool keyframe = (out->flags & AV_PKT_FLAG_KEY) != 0;
+
+  int ret = av_write_frame(recorder->output, out);
+  av_packet_unref(out);
+
+  if (recorder->output->pb->error < 0) {
+    recorder_log(LOG_ERROR, "Write error on %s, recording stopped",
+                 recorder->path);
+    stream_recorder_close(recorder);
+    return;
+  }
+  if (ret < 0) {
+    /* 丢包造成的时间戳倒退等, 跳过该包继续录制 */
+    recorder->dropped++;
+    return;
+  }
+  recorder->packets++;
+
+  /* 只有带时间戳SEI的视频帧进入索引 */
+  seistamp_stamp_t stamp;
+  if (video && recorder->index && pts != AV_NOPTS_VALUE &&
+      seistamp_scan_access_unit(packet->data, (size_t)packet->size,
+                                recorder->codec, &stamp)) {
+    uint32_t flags = keyframe ? SEISTAMP_INDEX_KEYFRAME : 0;
+    if (!seistamp_index_writer_add(recorder->index,
+                                   seistamp_ntp_to_ns(&stamp.ntp_time), pts,
+                                   (uint64_t)offset, flags)) {
+      recorder_log(LOG_WARNING, "Index write failed, continuing without");
+      seistamp_index_writer_close(recorder->index);
+      recorder->index = NULL;
+    }
+  }
+}
+
+void stream_recorder_close(stream_recorder_t *recorder) {
+  if (!recorder->output)
+    return;
+
+  uint64_t indexed = seistamp_index_writer_count(recorder->index);
+  if (recorder->index) {
+    seistamp_index_writer_close(recorder->index);
+    recorder->index = NULL;
+  }
+
+  if (recorder->output->pb && recorder->output->pb->error >= 0)
+    av_write_trailer(recorder->output);
+  close_output(recorder);
+
+  recorder_log(LOG_INFO,
+               "Recording closed: %s (%llu packets, %llu indexed frames, "
+               "%llu dropped)",
+               recorder->path, (unsigned long long)recorder->packets,
+               (unsigned long long)indexed,
+               (unsigned long long)recorder->dropped);
+}
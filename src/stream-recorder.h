@@ -0,0 +1,68 @@
+/******************************************************************************
+    Stream Recorder - Header File
+    Copyright (C) 2026
+
+    Copies the received SRT stream into an MPEG-TS file without re-encoding
+    and writes a .ssix sidecar index (NTP time -> PTS / byte offset) next to
+    it, so recordings of several receivers can be seeked by wall-clock time
+******************************************************************************/
+
+#pragma once
+
+#include <libavformat/avformat.h>
+#include <seistamp.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct stream_recorder {
+  AVFormatContext *output; /* NULL表示未在录制 */
+  AVPacket *packet;        /* 复用的输出包 */
+  seistamp_index_writer_t *index;
+  seistamp_codec_t codec;
+
+  /* 输入流 -> 输出流 */
+  int video_input;
+  int audio_input; /* -1表示不录制音频 */
+  int audio_output;
+  AVRational video_time_base; /* 输入流的时间基 */
+  AVRational audio_time_base;
+
+  uint64_t packets; /* 已写入的包数 */
+  uint64_t dropped; /* 复用器拒绝的包(时间戳不单调等) */
+  char path[512];
+} stream_recorder_t;
+
+/*
+ * 开始录制: 创建TS文件和同名的.ssix索引
+ * 参数:
+ *   path - 录像文件路径(UTF-8), 索引为path加SEISTAMP_INDEX_EXTENSION
+ *   input - 已打开的输入(提供流参数)
+ *   video_index / audio_index - 要录制的输入流, audio_index可以为-1
+ * 返回:
+ *   false - 无法创建文件, 录像不影响接收
+ */
+bool stream_recorder_open(stream_recorder_t *recorder, const char *path,
+                          const AVFormatContext *input, int video_index,
+                          int audio_index);
+
+/*
+ * 写入一个从输入读取的包(其他流的包被忽略)
+ * 带时间戳SEI的视频帧同时写入索引; 写入失败(磁盘已满等)时停止录制
+ */
+void stream_recorder_write(stream_recorder_t *recorder,
+                           const AVPacket *packet);
+
+/* 结束录制(未在录制时无操作) */
+void stream_recorder_close(stream_recorder_t *recorder);
+
+static inline bool stream_recorder_active(const stream_recorder_t *recorder) {
+  return recorder->output != NULL;
+}
+
+#ifdef __cplusplus
+}
+#endif
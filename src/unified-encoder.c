@@ -10,8 +10,12 @@
 
 #include "unified-encoder.h"
 #include "amd-encoder.h"
+#include "metrics-server.h"
+#include "ntp-server.h"
 #include "nvenc-encoder.h"
 #include "qsv-encoder.h"
+#include "software-encoder.h"
+#include "stage-trace.h"
 #include <util/dstr.h>
 
 /* 日志宏 */
@@ -24,6 +28,7 @@ static const char *hardware_type_names[] = {
     "Intel QuickSync", // HARDWARE_TYPE_INTEL
     "NVIDIA NVENC",    // HARDWARE_TYPE_NVIDIA
     "AMD AMF",         // HARDWARE_TYPE_AMD
+    "Software (CPU)",  // HARDWARE_TYPE_SOFTWARE
 };
 
 /* 编码格式名称 */
@@ -83,6 +88,17 @@ static const char *get_encoder_name(hardware_type_t hw, codec_type_t codec) {
     default:
       return "h264_amf";
     }
+  case HARDWARE_TYPE_SOFTWARE:
+    switch (codec) {
+    case CODEC_TYPE_H264:
+      return "libx264";
+    case CODEC_TYPE_H265:
+      return "libx265";
+    case CODEC_TYPE_AV1:
+      return "libsvtav1";
+    default:
+      return "libx264";
+    }
   default:
     return "h264_qsv";
   }
@@ -118,6 +134,9 @@ void *unified_encoder_create(obs_data_t *settings, obs_encoder_t *encoder) {
     enc->codec_type = CODEC_TYPE_H264;
   }
 
+  // 底层编码器从"codec_type"读取编码格式,写回解析后的值
+  obs_data_set_int(settings, "codec_type", enc->codec_type);
+
   blog(LOG_INFO,
        "[Unified Encoder] Creating encoder with Hardware=%s, Codec=%s",
        hardware_type_names[enc->hardware_type],
@@ -204,6 +223,23 @@ void *unified_encoder_create(obs_data_t *settings, obs_encoder_t *encoder) {
     break;
   }
 
+  case HARDWARE_TYPE_SOFTWARE: {
+#ifdef ENABLE_SOFTWARE
+    // CPU编码器，适用于没有GPU的机器
+    enc->software_encoder = software_encoder_create_internal(settings, encoder);
+    if (enc->software_encoder) {
+      success = true;
+    } else {
+      blog(LOG_ERROR,
+           "[Unified Encoder] Failed to initialize software encoder");
+    }
+#else
+    blog(LOG_ERROR,
+         "[Unified Encoder] Software encoder not enabled in this build");
+#endif
+    break;
+  }
+
   default:
     blog(LOG_ERROR, "[Unified Encoder] Unknown hardware type: %d",
          enc->hardware_type);
@@ -216,6 +252,25 @@ void *unified_encoder_create(obs_data_t *settings, obs_encoder_t *encoder) {
     return NULL;
   }
 
+  // 局域网时间主机模式：在本进程内运行NTP服务器供其他实例同步
+  if (obs_data_get_bool(settings, "ntp_master_enabled")) {
+    const char *upstream = obs_data_get_bool(settings, "ntp_enabled")
+                               ? obs_data_get_string(settings, "ntp_server")
+                               : NULL;
+    enc->ntp_master_active = ntp_server_acquire(
+        (uint16_t)obs_data_get_int(settings, "ntp_master_port"), upstream,
+        (uint16_t)obs_data_get_int(settings, "ntp_port"));
+  }
+
+  // Prometheus指标端点：与时间主机相同，同一进程共享一个HTTP服务器
+  if (obs_data_get_bool(settings, "metrics_enabled")) {
+    enc->metrics_active = metrics_server_acquire(
+        obs_data_get_string(settings, "metrics_bind"),
+        (uint16_t)obs_data_get_int(settings, "metrics_port"));
+  }
+
+  encoder_stats_register(&enc->stats, encoder);
+
   blog(LOG_INFO, "[Unified Encoder] Encoder created successfully");
   return enc;
 }
@@ -232,6 +287,9 @@ void unified_encoder_destroy(void *data) {
 
   blog(LOG_INFO, "[Unified Encoder] Destroying encoder");
 
+  /* 先注销, 之后的统计查询不再访问本编码器 */
+  encoder_stats_unregister(&enc->stats);
+
   // 销毁底层编码器 - create_internal返回的是完整的encoder对象
   // 所以只需调用对应的destroy函数，不需要额外bfree
 #ifdef ENABLE_VPL
@@ -258,6 +316,23 @@ void unified_encoder_destroy(void *data) {
   }
 #endif
 
+#ifdef ENABLE_SOFTWARE
+  if (enc->software_encoder) {
+    software_encoder_destroy((software_encoder_t *)enc->software_encoder);
+    enc->software_encoder = NULL;
+  }
+#endif
+
+  if (enc->ntp_master_active) {
+    ntp_server_release();
+    enc->ntp_master_active = false;
+  }
+
+  if (enc->metrics_active) {
+    metrics_server_release();
+    enc->metrics_active = false;
+  }
+
   bfree(enc);
 }
 
@@ -265,14 +340,10 @@ void unified_encoder_destroy(void *data) {
  * 编码视频帧
  *===========================================================================*/
 
-bool unified_encoder_encode(void *data, struct encoder_frame *frame,
-                            struct encoder_packet *packet,
-                            bool *received_packet) {
-  unified_encoder_t *enc = (unified_encoder_t *)data;
-  if (!enc) {
-    return false;
-  }
-
+/* 按硬件类型调用底层编码器 */
+static bool encode_backend(unified_encoder_t *enc, struct encoder_frame *frame,
+                           struct encoder_packet *packet,
+                           bool *received_packet) {
   // 转发到相应的底层编码器
   switch (enc->hardware_type) {
   case HARDWARE_TYPE_INTEL:
@@ -302,6 +373,15 @@ bool unified_encoder_encode(void *data, struct encoder_frame *frame,
 #endif
     break;
 
+  case HARDWARE_TYPE_SOFTWARE:
+#ifdef ENABLE_SOFTWARE
+    if (enc->software_encoder) {
+      return software_encoder_encode_internal(enc->software_encoder, frame,
+                                              packet, received_packet);
+    }
+#endif
+    break;
+
   default:
     break;
   }
@@ -310,6 +390,68 @@ bool unified_encoder_encode(void *data, struct encoder_frame *frame,
   return false;
 }
 
+/* 底层编码器的NTP客户端, 送入时间环, 输出队列和时间戳标记 (统计用) */
+static void backend_state(unified_encoder_t *enc,
+                          encoder_backend_state_t *state) {
+  memset(state, 0, sizeof(*state));
+#ifdef ENABLE_VPL
+  if (enc->qsv_encoder) {
+    qsv_encoder_t *qsv = (qsv_encoder_t *)enc->qsv_encoder;
+    state->ntp_client = &qsv->ntp_client;
+    state->capture_times = &qsv->capture_times;
+    state->packet_stamped = qsv->packet_stamped;
+  }
+#endif
+#ifdef ENABLE_NVENC
+  if (enc->nvenc_encoder) {
+    nvenc_encoder_t *nvenc = (nvenc_encoder_t *)enc->nvenc_encoder;
+    state->ntp_client = &nvenc->ntp_client;
+    state->capture_times = &nvenc->capture_times;
+    state->packet_stamped = nvenc->packet_stamped;
+    state->packet_queue = &nvenc->packet_queue;
+  }
+#endif
+#ifdef ENABLE_AMD
+  if (enc->amd_encoder) {
+    amd_encoder_t *amd = (amd_encoder_t *)enc->amd_encoder;
+    state->ntp_client = &amd->ntp_client;
+    state->capture_times = &amd->capture_times;
+    state->packet_stamped = amd->packet_stamped;
+    state->packet_queue = &amd->packet_queue;
+  }
+#endif
+#ifdef ENABLE_SOFTWARE
+  if (enc->software_encoder) {
+    software_encoder_t *sw = (software_encoder_t *)enc->software_encoder;
+    state->ntp_client = &sw->ntp_client;
+    state->capture_times = &sw->capture_times;
+    state->packet_stamped = sw->packet_stamped;
+    state->packet_queue = &sw->packet_queue;
+  }
+#endif
+}
+
+bool unified_encoder_encode(void *data, struct encoder_frame *frame,
+                            struct encoder_packet *packet,
+                            bool *received_packet) {
+  unified_encoder_t *enc = (unified_encoder_t *)data;
+  if (!enc) {
+    return false;
+  }
+
+  /* 整个encode调用, 后端的各阶段显示为其子区间 */
+  TRACE_START(trace_encode);
+  bool ok = encode_backend(enc, frame, packet, received_packet);
+  TRACE_STAGE(trace_encode, "encode", "encode", frame ? frame->pts : -1);
+
+  /* 由后端报告packet是否实际带有时间戳SEI (附加数据写入或编码后拼接) */
+  bool has_packet = ok && *received_packet;
+  encoder_backend_state_t backend;
+  backend_state(enc, &backend);
+  encoder_stats_record(&enc->stats, ok, has_packet ? packet : NULL, &backend);
+  return ok;
+}
+
 /*===========================================================================
  /* 获取默认设置 - H.264专用 */
 void unified_encoder_get_defaults_h264(obs_data_t *settings) {
@@ -320,10 +462,21 @@ void unified_encoder_get_defaults_h264(obs_data_t *settings) {
   obs_data_set_default_int(settings, "bframes", 0);
   obs_data_set_default_string(settings, "profile", "high");
   obs_data_set_default_string(settings, "preset", "balanced");
+  obs_data_set_default_bool(settings, "sei_side_data", true);
+  obs_data_set_default_int(settings, "sw_threads", 0);
+  obs_data_set_default_bool(settings, "sw_low_latency", true);
   obs_data_set_default_bool(settings, "ntp_enabled", true);
   obs_data_set_default_string(settings, "ntp_server", "pool.ntp.org");
   obs_data_set_default_int(settings, "ntp_port", 123);
   obs_data_set_default_int(settings, "ntp_sync_interval_ms", 60000);
+  obs_data_set_default_bool(settings, "ntp_master_enabled", false);
+  obs_data_set_default_int(settings, "ntp_master_port",
+                           NTP_SERVER_DEFAULT_PORT);
+  obs_data_set_default_bool(settings, "metrics_enabled", false);
+  obs_data_set_default_string(settings, "metrics_bind",
+                              METRICS_SERVER_DEFAULT_BIND);
+  obs_data_set_default_int(settings, "metrics_port",
+                           METRICS_SERVER_DEFAULT_PORT);
 }
 
 /* 获取默认设置 - H.265专用 */
@@ -335,10 +488,21 @@ void unified_encoder_get_defaults_h265(obs_data_t *settings) {
   obs_data_set_default_int(settings, "bframes", 0);
   obs_data_set_default_string(settings, "profile", "high");
   obs_data_set_default_string(settings, "preset", "balanced");
+  obs_data_set_default_bool(settings, "sei_side_data", true);
+  obs_data_set_default_int(settings, "sw_threads", 0);
+  obs_data_set_default_bool(settings, "sw_low_latency", true);
   obs_data_set_default_bool(settings, "ntp_enabled", true);
   obs_data_set_default_string(settings, "ntp_server", "pool.ntp.org");
   obs_data_set_default_int(settings, "ntp_port", 123);
   obs_data_set_default_int(settings, "ntp_sync_interval_ms", 60000);
+  obs_data_set_default_bool(settings, "ntp_master_enabled", false);
+  obs_data_set_default_int(settings, "ntp_master_port",
+                           NTP_SERVER_DEFAULT_PORT);
+  obs_data_set_default_bool(settings, "metrics_enabled", false);
+  obs_data_set_default_string(settings, "metrics_bind",
+                              METRICS_SERVER_DEFAULT_BIND);
+  obs_data_set_default_int(settings, "metrics_port",
+                           METRICS_SERVER_DEFAULT_PORT);
 }
 
 /* 获取默认设置 - AV1专用 */
@@ -350,10 +514,21 @@ void unified_encoder_get_defaults_av1(obs_data_t *settings) {
   obs_data_set_default_int(settings, "bframes", 0);
   obs_data_set_default_string(settings, "profile", "high");
   obs_data_set_default_string(settings, "preset", "balanced");
+  obs_data_set_default_bool(settings, "sei_side_data", true);
+  obs_data_set_default_int(settings, "sw_threads", 0);
+  obs_data_set_default_bool(settings, "sw_low_latency", true);
   obs_data_set_default_bool(settings, "ntp_enabled", true);
   obs_data_set_default_string(settings, "ntp_server", "pool.ntp.org");
   obs_data_set_default_int(settings, "ntp_port", 123);
   obs_data_set_default_int(settings, "ntp_sync_interval_ms", 60000);
+  obs_data_set_default_bool(settings, "ntp_master_enabled", false);
+  obs_data_set_default_int(settings, "ntp_master_port",
+                           NTP_SERVER_DEFAULT_PORT);
+  obs_data_set_default_bool(settings, "metrics_enabled", false);
+  obs_data_set_default_string(settings, "metrics_bind",
+                              METRICS_SERVER_DEFAULT_BIND);
+  obs_data_set_default_int(settings, "metrics_port",
+                           METRICS_SERVER_DEFAULT_PORT);
 }
 
 /*===========================================================================
@@ -374,12 +549,29 @@ void unified_encoder_get_defaults(obs_data_t *settings) {
   obs_data_set_default_string(settings, "profile", "high");    // profile
   obs_data_set_default_string(settings, "preset", "balanced"); // preset
 
+  // 时间戳SEI优先由编码器写入(帧附加数据)
+  obs_data_set_default_bool(settings, "sei_side_data", true);
+
+  // 软件编码器: 自动线程数, 低延迟
+  obs_data_set_default_int(settings, "sw_threads", 0);
+  obs_data_set_default_bool(settings, "sw_low_latency", true);
+
   // NTP同步默认值
   obs_data_set_default_bool(settings, "ntp_enabled", true);
   obs_data_set_default_string(settings, "ntp_server", "pool.ntp.org");
   obs_data_set_default_int(settings, "ntp_port", 123);
   obs_data_set_default_int(settings, "ntp_sync_interval_ms",
                            60000); // 60秒
+
+  // 局域网时间主机默认关闭
+  obs_data_set_default_bool(settings, "ntp_master_enabled", false);
+  obs_data_set_default_int(settings, "ntp_master_port",
+                           NTP_SERVER_DEFAULT_PORT);
+  obs_data_set_default_bool(settings, "metrics_enabled", false);
+  obs_data_set_default_string(settings, "metrics_bind",
+                              METRICS_SERVER_DEFAULT_BIND);
+  obs_data_set_default_int(settings, "metrics_port",
+                           METRICS_SERVER_DEFAULT_PORT);
 }
 
 /*===========================================================================
@@ -399,6 +591,7 @@ obs_properties_t *unified_encoder_properties(void *unused) {
   obs_property_list_add_int(hw_list, "Intel QuickSync", HARDWARE_TYPE_INTEL);
   obs_property_list_add_int(hw_list, "NVIDIA NVENC", HARDWARE_TYPE_NVIDIA);
   obs_property_list_add_int(hw_list, "AMD AMF", HARDWARE_TYPE_AMD);
+  obs_property_list_add_int(hw_list, "Software (CPU)", HARDWARE_TYPE_SOFTWARE);
 
   // Codec Format 已经通过注册不同的encoder固定，不再需要UI选择
 
@@ -423,6 +616,16 @@ obs_properties_t *unified_encoder_properties(void *unused) {
   obs_property_list_add_string(preset_list, "Balanced", "balanced");
   obs_property_list_add_string(preset_list, "Quality", "quality");
 
+  // 编码器支持时由其写入时间戳SEI,否则编码后拼接
+  obs_properties_add_bool(props, "sei_side_data",
+                          "Let Encoder Write Timestamp SEI");
+
+  // 软件编码器调优（仅Software (CPU)使用）
+  obs_properties_add_int(props, "sw_threads", "CPU Threads (0 = Auto)", 0, 64,
+                         1);
+  obs_properties_add_bool(props, "sw_low_latency",
+                          "CPU Low Latency (no lookahead / B-frames)");
+
   // NTP同步设置
   obs_properties_add_bool(props, "ntp_enabled", "Enable NTP Sync");
   obs_properties_add_text(props, "ntp_server", "NTP Server", OBS_TEXT_DEFAULT);
@@ -430,6 +633,19 @@ obs_properties_t *unified_encoder_properties(void *unused) {
   obs_properties_add_int(props, "ntp_sync_interval_ms",
                          "NTP Sync Interval (ms)", 1000, 300000, 1000);
 
+  // 局域网时间主机：其他SEI Stamper实例可将NTP Server指向本机
+  obs_properties_add_bool(props, "ntp_master_enabled",
+                          "Act as LAN Time Master (NTP Server)");
+  obs_properties_add_int(props, "ntp_master_port", "Time Master Port", 1,
+                         65535, 1);
+
+  // Prometheus指标端点：http://<bind>:<port>/metrics
+  obs_properties_add_bool(props, "metrics_enabled",
+                          "Serve Prometheus Metrics (HTTP)");
+  obs_properties_add_text(props, "metrics_bind", "Metrics Bind Address",
+                          OBS_TEXT_DEFAULT);
+  obs_properties_add_int(props, "metrics_port", "Metrics Port", 1, 65535, 1);
+
   return props;
 }
 
@@ -500,6 +716,15 @@ void unified_encoder_get_video_info(void *data, struct video_scale_info *info) {
 #endif
     break;
 
+  case HARDWARE_TYPE_SOFTWARE:
+#ifdef ENABLE_SOFTWARE
+    if (enc->software_encoder) {
+      software_encoder_get_video_info_internal(enc->software_encoder, info);
+      return;
+    }
+#endif
+    break;
+
   default:
     break;
   }
@@ -548,6 +773,15 @@ bool unified_encoder_get_extra_data(void *data, uint8_t **extra_data,
 #endif
     break;
 
+  case HARDWARE_TYPE_SOFTWARE:
+#ifdef ENABLE_SOFTWARE
+    if (enc->software_encoder) {
+      return software_encoder_get_extra_data_internal(enc->software_encoder,
+                                                      extra_data, size);
+    }
+#endif
+    break;
+
   default:
     break;
   }
@@ -11,6 +11,7 @@
 #ifndef UNIFIED_ENCODER_H
 #define UNIFIED_ENCODER_H
 
+#include "encoder-stats.h"
 #include <obs-module.h>
 
 #ifdef __cplusplus
@@ -19,9 +20,10 @@ extern "C" {
 
 /* 硬件编码器类型 */
 typedef enum {
-  HARDWARE_TYPE_INTEL = 0,  /* Intel QuickSync */
-  HARDWARE_TYPE_NVIDIA = 1, /* NVIDIA NVENC */
-  HARDWARE_TYPE_AMD = 2,    /* AMD AMF */
+  HARDWARE_TYPE_INTEL = 0,    /* Intel QuickSync */
+  HARDWARE_TYPE_NVIDIA = 1,   /* NVIDIA NVENC */
+  HARDWARE_TYPE_AMD = 2,      /* AMD AMF */
+  HARDWARE_TYPE_SOFTWARE = 3, /* CPU: libx264 / libx265 / SVT-AV1 */
   HARDWARE_TYPE_COUNT
 } hardware_type_t;
 
@@ -42,9 +44,19 @@ typedef struct unified_encoder {
   codec_type_t codec_type;       /* 编码格式选择 */
 
   /* 底层编码器实例（只有一个会被使用） */
-  void *qsv_encoder;   /* qsv_encoder_t* */
-  void *nvenc_encoder; /* nvenc_encoder_t* */
-  void *amd_encoder;   /* amd_encoder_t* */
+  void *qsv_encoder;      /* qsv_encoder_t* */
+  void *nvenc_encoder;    /* nvenc_encoder_t* */
+  void *amd_encoder;      /* amd_encoder_t* */
+  void *software_encoder; /* software_encoder_t* */
+
+  /* 局域网时间主机 */
+  bool ntp_master_active; /* 是否持有共享NTP服务器的引用 */
+
+  /* Prometheus指标端点 */
+  bool metrics_active; /* 是否持有共享指标服务器的引用 */
+
+  /* 实时统计 (编码线程写入, 通过全局proc handler查询) */
+  encoder_stats_t stats;
 
 } unified_encoder_t;
 
@@ -0,0 +1,573 @@
+/******************************************************************************
+    Encoder Stamping Benchmark
+    Copyright (C) 2026
+
+    Feeds synthetic frames through the FFmpeg wrapper encoder
+    (sei_stamper_h264/h265) via the OBS shim and reports per-frame encode
+    latency, throughput and the cost of each stamping step. Needs no GPU:
+    the default codec is libx264. NTP queries go to a loopback mock server.
+******************************************************************************/
+
+#define _GNU_SOURCE
+#include "capture-time-ring.h"
+#include "fast-clock.h"
+#include "mock-ntp-server.h"
+#include "ntp-client.h"
+#include "packet-pool.h"
+#include "sei-handler.h"
+#include <getopt.h>
+#include <obs-module.h>
+#include <stdlib.h>
+#include <string.h>
+#include <util/platform.h>
+
+extern struct obs_encoder_info sei_stamper_h264_encoder_info;
+extern struct obs_encoder_info sei_stamper_h265_encoder_info;
+
+/* 运行模式 */
+typedef enum bench_mode {
+  BENCH_MODE_OFF,       /* 不打时间戳 (ntp_enabled = false) */
+  BENCH_MODE_SPLICE,    /* 编码后在关键帧前拼接SEI */
+  BENCH_MODE_SIDE_DATA, /* 由编码器按帧附加数据写入SEI */
+  BENCH_MODE_COUNT,
+} bench_mode_t;
+
+static const char *mode_names[BENCH_MODE_COUNT] = {"off", "splice",
+                                                   "side-data"};
+
+typedef struct bench_options {
+  uint32_t width;
+  uint32_t height;
+  uint32_t fps;
+  uint32_t frames;
+  uint32_t warmup; /* 不计入统计的前N帧 (首帧包含NTP同步) */
+  uint32_t bitrate;
+  uint32_t keyint_sec;
+  uint32_t bframes;
+  const char *codec;
+  const char *preset;
+  bool hevc;
+  bool realtime; /* 按帧率节拍送帧,否则尽可能快 */
+  bool modes[BENCH_MODE_COUNT];
+} bench_options_t;
+
+/* 一次运行得到的输出Packet信息,供微基准重放 */
+typedef struct packet_record {
+  size_t size;
+  int64_t pts;
+  bool keyframe;
+} packet_record_t;
+
+typedef struct run_result {
+  int64_t *latencies; /* 每次encode调用耗时 */
+  size_t latency_count;
+  packet_record_t *packets;
+  size_t packet_count;
+  size_t keyframes;
+  size_t stamped; /* 含时间戳SEI的Packet数 */
+  uint64_t bytes;
+  uint64_t elapsed_ns;
+} run_result_t;
+
+static int compare_int64(const void *a, const void *b) {
+  int64_t x = *(const int64_t *)a;
+  int64_t y = *(const int64_t *)b;
+  return (x > y) - (x < y);
+}
+
+static int64_t percentile(const int64_t *sorted, size_t count, double p) {
+  if (count == 0)
+    return 0;
+  size_t index = (size_t)((double)(count - 1) * p / 100.0 + 0.5);
+  return sorted[index];
+}
+
+static double mean(const int64_t *values, size_t count) {
+  if (count == 0)
+    return 0.0;
+  double sum = 0.0;
+  for (size_t i = 0; i < count; i++)
+    sum += (double)values[i];
+  return sum / (double)count;
+}
+
+/* 排序后输出 mean/p50/p90/p99/max (微秒) */
+static void print_latency(const char *label, int64_t *values, size_t count) {
+  qsort(values, count, sizeof(int64_t), compare_int64);
+  printf("  %-16s mean %8.2f  p50 %8.2f  p90 %8.2f  p99 %8.2f  max %8.2f us\n",
+         label, mean(values, count) / 1000.0,
+         percentile(values, count, 50) / 1000.0,
+         percentile(values, count, 90) / 1000.0,
+         percentile(values, count, 99) / 1000.0,
+         count ? values[count - 1] / 1000.0 : 0.0);
+}
+
+/* 合成NV12帧: 随时间平移的斜向渐变,保证编码器有真实的运动可编 */
+static void fill_nv12(uint8_t *y_plane, uint8_t *uv_plane, uint32_t width,
+                      uint32_t height, uint32_t index) {
+  for (uint32_t y = 0; y < height; y++) {
+    uint8_t *row = y_plane + (size_t)y * width;
+    for (uint32_t x = 0; x < width; x++)
+      row[x] = (uint8_t)(x + y + index * 4);
+  }
+  for (uint32_t y = 0; y < height / 2; y++) {
+    uint8_t *row = uv_plane + (size_t)y * width;
+    for (uint32_t x = 0; x < width; x += 2) {
+      row[x] = (uint8_t)(128 + ((x + index) & 0x3f));
+      row[x + 1] = (uint8_t)(128 - ((y + index) & 0x3f));
+    }
+  }
+}
+
+static bool packet_has_stamp(const uint8_t *data, size_t size) {
+  return memmem(data, size, SEI_STAMPER_UUID, sizeof(SEI_STAMPER_UUID)) !=
+         NULL;
+}
+
+static void run_result_free(run_result_t *result) {
+  free(result->latencies);
+  free(result->packets);
+  memset(result, 0, sizeof(*result));
+}
+
+/* 宏基准: 通过obs_encoder_info回调完整地创建/编码/销毁 */
+static bool run_encoder(const bench_options_t *opt, bench_mode_t mode,
+                        uint16_t ntp_port, run_result_t *result) {
+  const struct obs_encoder_info *info = opt->hevc
+                                            ? &sei_stamper_h265_encoder_info
+                                            : &sei_stamper_h264_encoder_info;
+
+  struct video_output_info voi = {
+      .name = "bench",
+      .format = VIDEO_FORMAT_NV12,
+      .fps_num = opt->fps,
+      .fps_den = 1,
+      .width = opt->width,
+      .height = opt->height,
+      .colorspace = VIDEO_CS_709,
+      .range = VIDEO_RANGE_PARTIAL,
+  };
+  obs_encoder_t *encoder = obs_shim_encoder_create(mode_names[mode], &voi);
+
+  obs_data_t *settings = obs_data_create();
+  info->get_defaults(settings);
+  obs_data_set_string(settings, "codec_name", opt->codec);
+  obs_data_set_string(settings, "preset", opt->preset);
+  obs_data_set_string(settings, "profile", opt->hevc ? "main" : "high");
+  obs_data_set_int(settings, "bitrate", opt->bitrate);
+  obs_data_set_int(settings, "keyint_sec", opt->keyint_sec);
+  obs_data_set_int(settings, "bframes", opt->bframes);
+  obs_data_set_bool(settings, "ntp_enabled", mode != BENCH_MODE_OFF);
+  obs_data_set_bool(settings, "sei_side_data", mode == BENCH_MODE_SIDE_DATA);
+  obs_data_set_string(settings, "ntp_server", "127.0.0.1");
+  obs_data_set_int(settings, "ntp_port", ntp_port);
+
+  void *enc = info->create(settings, encoder);
+  obs_data_release(settings);
+  if (!enc) {
+    fprintf(stderr, "[%s] Failed to create encoder %s\n", mode_names[mode],
+            opt->codec);
+    obs_shim_encoder_destroy(encoder);
+    return false;
+  }
+
+  struct video_scale_info vsi = {.format = VIDEO_FORMAT_NV12};
+  info->get_video_info(enc, &vsi);
+  if (vsi.format != VIDEO_FORMAT_NV12) {
+    fprintf(stderr, "[%s] %s wants %s input, only NV12 is generated\n",
+            mode_names[mode], opt->codec, get_video_format_name(vsi.format));
+    info->destroy(enc);
+    obs_shim_encoder_destroy(encoder);
+    return false;
+  }
+
+  size_t luma_size = (size_t)opt->width * opt->height;
+  uint8_t *planes = malloc(luma_size + luma_size / 2);
+
+  memset(result, 0, sizeof(*result));
+  result->latencies = calloc(opt->frames, sizeof(int64_t));
+  result->packets = calloc(opt->frames, sizeof(packet_record_t));
+
+  uint64_t frame_interval = 1000000000ULL / opt->fps;
+  uint64_t start = os_gettime_ns();
+  bool ok = true;
+
+  for (uint32_t i = 0; i < opt->frames; i++) {
+    fill_nv12(planes, planes + luma_size, opt->width, opt->height, i);
+
+    if (opt->realtime) {
+      uint64_t target = start + i * frame_interval;
+      uint64_t now = os_gettime_ns();
+      if (target > now)
+        os_sleep_ms((uint32_t)((target - now) / 1000000ULL));
+    }
+
+    struct encoder_frame frame = {
+        .data = {planes, planes + luma_size},
+        .linesize = {opt->width, opt->width},
+        .frames = 1,
+        .pts = i,
+    };
+    struct encoder_packet packet = {0};
+    bool received = false;
+
+    uint64_t before = fast_clock_now_ns();
+    if (!info->encode(enc, &frame, &packet, &received)) {
+      fprintf(stderr, "[%s] encode failed at frame %u\n", mode_names[mode], i);
+      ok = false;
+      break;
+    }
+    uint64_t after = fast_clock_now_ns();
+
+    if (i >= opt->warmup)
+      result->latencies[result->latency_count++] = (int64_t)(after - before);
+
+    if (received) {
+      packet_record_t *rec = &result->packets[result->packet_count++];
+      rec->size = packet.size;
+      rec->pts = packet.pts;
+      rec->keyframe = packet.keyframe;
+      result->bytes += packet.size;
+      if (packet.keyframe)
+        result->keyframes++;
+      if (packet_has_stamp(packet.data, packet.size))
+        result->stamped++;
+    }
+  }
+
+  result->elapsed_ns = os_gettime_ns() - start;
+
+  info->destroy(enc);
+  obs_shim_encoder_destroy(encoder);
+  free(planes);
+  return ok;
+}
+
+static void print_run(const bench_options_t *opt, bench_mode_t mode,
+                      run_result_t *result) {
+  double seconds = result->elapsed_ns / 1e9;
+  printf("Mode %s: %zu packets (%zu keyframes, %zu stamped), %.1f fps, "
+         "%.0f kbps\n",
+         mode_names[mode], result->packet_count, result->keyframes,
+         result->stamped, seconds > 0 ? opt->frames / seconds : 0.0,
+         result->bytes * 8.0 / 1000.0 / ((double)opt->frames / opt->fps));
+  print_latency("encode call", result->latencies, result->latency_count);
+}
+
+/*
+ * 微基准: 按宏基准得到的真实Packet大小重放打时间戳的各个步骤
+ * (NTP读取、PTS环、SEI构造、从池借buffer并拼接), 分别统计
+ * 每帧都打和只在关键帧打两种策略
+ */
+static void run_stamp_steps(const run_result_t *packets, uint16_t ntp_port,
+                            bool hevc) {
+  enum { STEP_NTP, STEP_RING, STEP_SEI, STEP_ASSEMBLE, STEP_COUNT };
+  static const char *step_names[STEP_COUNT] = {"NTP read", "PTS ring",
+                                               "SEI build", "assembly"};
+
+  size_t count = packets->packet_count;
+  if (count == 0)
+    return;
+
+  int64_t *samples[STEP_COUNT];
+  int64_t totals[STEP_COUNT] = {0};
+  int64_t key_totals[STEP_COUNT] = {0};
+  for (int s = 0; s < STEP_COUNT; s++)
+    samples[s] = calloc(count, sizeof(int64_t));
+
+  size_t max_size = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (packets->packets[i].size > max_size)
+      max_size = packets->packets[i].size;
+  }
+  uint8_t *source = malloc(max_size);
+  memset(source, 0x5a, max_size);
+
+  ntp_client_t client;
+  ntp_client_init(&client, "127.0.0.1", ntp_port);
+  ntp_client_sync(&client);
+
+  capture_time_ring_t ring;
+  capture_time_ring_init(&ring, 1);
+  sei_nal_type_t nal_type = hevc ? SEI_NAL_H265_PREFIX : SEI_NAL_H264;
+
+  for (size_t i = 0; i < count; i++) {
+    const packet_record_t *rec = &packets->packets[i];
+    ntp_timestamp_t stamp;
+    uint64_t t0 = fast_clock_now_ns();
+
+    ntp_client_get_time_or_local(&client, &stamp);
+    uint64_t t1 = fast_clock_now_ns();
+
+    capture_time_ring_put(&ring, rec->pts, &stamp);
+    capture_time_ring_get(&ring, rec->pts, &stamp);
+    uint64_t t2 = fast_clock_now_ns();
+
+    uint8_t *payload = NULL;
+    size_t payload_size = 0;
+    uint8_t *sei_nal = NULL;
+    size_t sei_nal_size = 0;
+    if (build_ntp_sei_payload(rec->pts, &stamp, &payload, &payload_size)) {
+      build_sei_nal_unit(payload, payload_size, nal_type, &sei_nal,
+                         &sei_nal_size);
+      bfree(payload);
+    }
+    uint64_t t3 = fast_clock_now_ns();
+
+    uint8_t *buffer = packet_pool_acquire(rec->size + sei_nal_size);
+    if (buffer) {
+      if (sei_nal)
+        memcpy(buffer, sei_nal, sei_nal_size);
+      memcpy(buffer + sei_nal_size, source, rec->size);
+    }
+    bfree(sei_nal);
+    packet_pool_release(buffer);
+    uint64_t t4 = fast_clock_now_ns();
+
+    int64_t step[STEP_COUNT] = {(int64_t)(t1 - t0), (int64_t)(t2 - t1),
+                                (int64_t)(t3 - t2), (int64_t)(t4 - t3)};
+    for (int s = 0; s < STEP_COUNT; s++) {
+      samples[s][i] = step[s];
+      totals[s] += step[s];
+      if (rec->keyframe)
+        key_totals[s] += step[s];
+    }
+  }
+
+  printf("Stamping steps (%zu packets replayed, %s clock):\n", count,
+         fast_clock_is_tsc() ? "TSC" : "system");
+  for (int s = 0; s < STEP_COUNT; s++)
+    print_latency(step_names[s], samples[s], count);
+
+  int64_t per_frame = 0;
+  int64_t keyframe_only = 0;
+  for (int s = 0; s < STEP_COUNT; s++) {
+    per_frame += totals[s];
+    keyframe_only += key_totals[s];
+  }
+  printf("  %-16s per-frame %8.2f us/frame  keyframe-only %8.2f us/frame\n",
+         "amortized", per_frame / 1000.0 / (double)count,
+         keyframe_only / 1000.0 / (double)count);
+
+  for (int s = 0; s < STEP_COUNT; s++)
+    free(samples[s]);
+  free(source);
+  ntp_client_destroy(&client);
+}
+
+static bool parse_modes(const char *list, bool *modes) {
+  memset(modes, 0, sizeof(bool) * BENCH_MODE_COUNT);
+
+  char *copy = strdup(list);
+  char *save = NULL;
+  bool ok = true;
+  for (char *token = strtok_r(copy, ",", &save); token;
+       token = strtok_r(NULL, ",", &save)) {
+    bool found = false;
+    for (int m = 0; m < BENCH_MODE_COUNT; m++) {
+      if (strcmp(token, mode_names[m]) == 0) {
+        modes[m] = found = true;
+        break;
+      }
+    }
+    if (!found) {
+      fprintf(stderr, "Unknown mode: %s\n", token);
+      ok = false;
+    }
+  }
+  free(copy);
+  return ok;
+}
+
+/* libseistamp日志转发到shim, 使--verbose同样作用于库内的消息 */
+static void seistamp_log_to_shim(int level, const char *format, va_list args,
+                                 void *param) {
+  (void)param;
+  blogva(level, format, args);
+}
+
+static void usage(const char *argv0) {
+  printf(
+      "Usage: %s [options]\n"
+      "Input:\n"
+      "  --width N              frame width (default 1920)\n"
+      "  --height N             frame height (default 1080)\n"
+      "  --fps N                frame rate (default 60)\n"
+      "  --frames N             frames per mode (default 600)\n"
+      "  --warmup N             frames excluded from latency stats "
+      "(default 10)\n"
+      "  --realtime             pace input at --fps instead of flat out\n"
+      "Encoder:\n"
+      "  --codec NAME           FFmpeg encoder (default libx264)\n"
+      "  --hevc                 use the H.265 wrapper (e.g. --codec libx265)\n"
+      "  --preset NAME          encoder preset (default veryfast)\n"
+      "  --bitrate N            kbps (default 6000)\n"
+      "  --keyint-sec N         keyframe interval (default 2)\n"
+      "  --bframes N            B-frames (default 0)\n"
+      "  --modes LIST           comma list of off,splice,side-data "
+      "(default all)\n"
+      "  --verbose              log encoder/client messages\n",
+      argv0);
+}
+
+int main(int argc, char **argv) {
+  bench_options_t opt = {
+      .width = 1920,
+      .height = 1080,
+      .fps = 60,
+      .frames = 600,
+      .warmup = 10,
+      .bitrate = 6000,
+      .keyint_sec = 2,
+      .bframes = 0,
+      .codec = "libx264",
+      .preset = "veryfast",
+      .modes = {true, true, true},
+  };
+
+  static const struct option long_options[] = {
+      {"width", required_argument, NULL, 'W'},
+      {"height", required_argument, NULL, 'H'},
+      {"fps", required_argument, NULL, 'f'},
+      {"frames", required_argument, NULL, 'n'},
+      {"warmup", required_argument, NULL, 'w'},
+      {"realtime", no_argument, NULL, 'r'},
+      {"codec", required_argument, NULL, 'c'},
+      {"hevc", no_argument, NULL, 'e'},
+      {"preset", required_argument, NULL, 'p'},
+      {"bitrate", required_argument, NULL, 'b'},
+      {"keyint-sec", required_argument, NULL, 'k'},
+      {"bframes", required_argument, NULL, 'B'},
+      {"modes", required_argument, NULL, 'm'},
+      {"verbose", no_argument, NULL, 'v'},
+      {"help", no_argument, NULL, 'h'},
+      {NULL, 0, NULL, 0},
+  };
+
+  int c;
+  while ((c = getopt_long(argc, argv, "h", long_options, NULL)) != -1) {
+    switch (c) {
+    case 'W':
+      opt.width = (uint32_t)strtoul(optarg, NULL, 10);
+      break;
+    case 'H':
+      opt.height = (uint32_t)strtoul(optarg, NULL, 10);
+      break;
+    case 'f':
+      opt.fps = (uint32_t)strtoul(optarg, NULL, 10);
+      break;
+    case 'n':
+      opt.frames = (uint32_t)strtoul(optarg, NULL, 10);
+      break;
+    case 'w':
+      opt.warmup = (uint32_t)strtoul(optarg, NULL, 10);
+      break;
+    case 'r':
+      opt.realtime = true;
+      break;
+    case 'c':
+      opt.codec = optarg;
+      break;
+    case 'e':
+      opt.hevc = true;
+      break;
+    case 'p':
+      opt.preset = optarg;
+      break;
+    case 'b':
+      opt.bitrate = (uint32_t)strtoul(optarg, NULL, 10);
+      break;
+    case 'k':
+      opt.keyint_sec = (uint32_t)strtoul(optarg, NULL, 10);
+      break;
+    case 'B':
+      opt.bframes = (uint32_t)strtoul(optarg, NULL, 10);
+      break;
+    case 'm':
+      if (!parse_modes(optarg, opt.modes))
+        return 2;
+      break;
+    case 'v':
+      obs_shim_set_log_level(LOG_DEBUG);
+      break;
+    default:
+      usage(argv[0]);
+      return c == 'h' ? 0 : 2;
+    }
+  }
+
+  if (opt.fps == 0 || opt.frames == 0 || opt.width < 16 || opt.height < 16 ||
+      (opt.width & 1) || (opt.height & 1)) {
+    usage(argv[0]);
+    return 2;
+  }
+  if (opt.warmup >= opt.frames)
+    opt.warmup = 0;
+
+  fast_clock_init();
+  seistamp_set_log_handler(seistamp_log_to_shim, NULL);
+  seistamp_set_clock(fast_clock_now_ns);
+
+  /* 本地回环上的NTP服务器,避免基准依赖外网 */
+  mock_ntp_config_t mock = {.seed = 1};
+  mock.offset_ns = (int64_t)(ntp_get_wallclock_ns() - os_gettime_ns());
+  mock_ntp_server_t server;
+  if (!mock_ntp_server_start(&server, &mock)) {
+    fprintf(stderr, "Failed to start mock NTP server\n");
+    return 1;
+  }
+
+  printf("%s %ux%u @ %u fps, %u frames, %u kbps, keyint %u s, %u B-frames, "
+         "%s\n",
+         opt.codec, opt.width, opt.height, opt.fps, opt.frames, opt.bitrate,
+         opt.keyint_sec, opt.bframes, opt.realtime ? "realtime" : "flat out");
+
+  int status = 0;
+  double baseline_mean = -1.0;
+  run_result_t replay = {0};
+
+  for (int m = 0; m < BENCH_MODE_COUNT; m++) {
+    if (!opt.modes[m])
+      continue;
+
+    run_result_t result;
+    if (!run_encoder(&opt, (bench_mode_t)m, server.port, &result)) {
+      run_result_free(&result);
+      status = 1;
+      continue;
+    }
+
+    print_run(&opt, (bench_mode_t)m, &result);
+
+    /* print_latency已排序; 均值与顺序无关 */
+    double run_mean = mean(result.latencies, result.latency_count);
+    if (m == BENCH_MODE_OFF) {
+      baseline_mean = run_mean;
+    } else if (baseline_mean >= 0.0) {
+      printf("  %-16s %+8.2f us/frame vs off\n", "stamping cost",
+             (run_mean - baseline_mean) / 1000.0);
+    }
+
+    /* 保留一次运行的Packet序列用于微基准 */
+    if (replay.packet_count == 0) {
+      replay = result;
+      result.latencies = NULL;
+      result.packets = NULL;
+    }
+    run_result_free(&result);
+  }
+
+  run_stamp_steps(&replay, server.port, opt.hevc);
+  run_result_free(&replay);
+
+  packet_pool_stats_t pool_stats;
+  packet_pool_get_stats(&pool_stats);
+  printf("Packet pool: peak %zu KiB, %llu allocations, %llu reuses\n",
+         pool_stats.high_water_bytes / 1024,
+         (unsigned long long)pool_stats.allocations,
+         (unsigned long long)pool_stats.reuses);
+  packet_pool_trim();
+
+  mock_ntp_server_stop(&server);
+  return status;
+}
@@ -0,0 +1,174 @@
+/******************************************************************************
+    Mock NTP Server - Implementation
+    Copyright (C) 2026
+
+    Loopback NTP server with configurable clock offset, drift, asymmetric
+    delay, jitter and packet loss, for offline sync-accuracy benchmarks
+******************************************************************************/
+
+#include "mock-ntp-server.h"
+#include "ntp-client.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <obs-module.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <util/platform.h>
+
+#define mock_log(level, format, ...)                                           \
+  blog(level, "[Mock NTP] " format, ##__VA_ARGS__)
+
+static uint32_t next_random(mock_ntp_server_t *server) {
+  /* xorshift32 */
+  uint32_t x = server->rng_state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  server->rng_state = x;
+  return x;
+}
+
+static double random_unit(mock_ntp_server_t *server) {
+  return (double)next_random(server) / 4294967296.0;
+}
+
+static void sleep_until_ns(uint64_t target_ns) {
+  struct timespec ts;
+  ts.tv_sec = (time_t)(target_ns / 1000000000ULL);
+  ts.tv_nsec = (long)(target_ns % 1000000000ULL);
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+    ;
+}
+
+static uint64_t path_delay_ns(mock_ntp_server_t *server, uint32_t base_us) {
+  uint64_t delay = (uint64_t)base_us * 1000ULL;
+  if (server->config.jitter_us > 0) {
+    double jitter_ns = server->config.jitter_us * 1000.0;
+    delay += (uint64_t)(random_unit(server) * jitter_ns);
+  }
+  return delay;
+}
+
+static void put_timestamp(ntp_timestamp_t *dst, uint64_t ns) {
+  ntp_timestamp_t ts;
+  ntp_timestamp_from_ns(ns, &ts);
+  dst->seconds = htonl(ts.seconds);
+  dst->fraction = htonl(ts.fraction);
+}
+
+uint64_t mock_ntp_server_time_ns(const mock_ntp_server_t *server,
+                                 uint64_t local_ns) {
+  return (uint64_t)((int64_t)local_ns +
+                    mock_ntp_server_true_offset(server, local_ns));
+}
+
+int64_t mock_ntp_server_true_offset(const mock_ntp_server_t *server,
+                                    uint64_t local_ns) {
+  double elapsed = (double)(int64_t)(local_ns - server->start_ns);
+  return server->config.offset_ns +
+         (int64_t)(elapsed * server->config.drift_ppm * 1e-6);
+}
+
+static void *mock_ntp_thread(void *data) {
+  mock_ntp_server_t *server = data;
+  os_set_thread_name("mock-ntp");
+
+  while (server->active) {
+    ntp_packet_t packet;
+    struct sockaddr_storage from;
+    socklen_t from_len = sizeof(from);
+
+    ssize_t ret = recvfrom(server->socket_fd, &packet, sizeof(packet), 0,
+                           (struct sockaddr *)&from, &from_len);
+    uint64_t arrival = os_gettime_ns();
+    if (ret < (ssize_t)sizeof(packet))
+      continue;
+
+    server->requests++;
+    if (random_unit(server) < server->config.loss_rate) {
+      server->dropped++;
+      continue;
+    }
+
+    /* 上行延迟: 请求"到达"服务器的时刻 */
+    sleep_until_ns(arrival + path_delay_ns(server,
+                                           server->config.uplink_delay_us));
+    uint64_t t2 = mock_ntp_server_time_ns(server, os_gettime_ns());
+
+    ntp_timestamp_t originate = packet.transmit_timestamp;
+    memset(&packet, 0, sizeof(packet));
+    packet.li_vn_mode = (0 << 6) | (4 << 3) | 4; /* 版本4, 服务器模式 */
+    packet.stratum = 1;
+    packet.precision = (uint8_t)-20;
+    memcpy(&packet.reference_id, "MOCK", 4);
+    packet.originate_timestamp = originate;
+    put_timestamp(&packet.reference_timestamp, t2);
+    put_timestamp(&packet.receive_timestamp, t2);
+
+    uint64_t t3_local = os_gettime_ns();
+    put_timestamp(&packet.transmit_timestamp,
+                  mock_ntp_server_time_ns(server, t3_local));
+
+    /* 下行延迟: 应答"离开"网络的时刻 */
+    sleep_until_ns(t3_local + path_delay_ns(server,
+                                            server->config.downlink_delay_us));
+    sendto(server->socket_fd, &packet, sizeof(packet), 0,
+           (struct sockaddr *)&from, from_len);
+  }
+
+  return NULL;
+}
+
+bool mock_ntp_server_start(mock_ntp_server_t *server,
+                           const mock_ntp_config_t *config) {
+  memset(server, 0, sizeof(*server));
+  server->config = *config;
+  server->rng_state = config->seed ? config->seed : 0x12345678;
+  server->start_ns = os_gettime_ns();
+
+  server->socket_fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (server->socket_fd < 0) {
+    mock_log(LOG_ERROR, "socket() failed: %s", strerror(errno));
+    return false;
+  }
+
+  struct sockaddr_in addr = {0};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = 0;
+  socklen_t addr_len = sizeof(addr);
+  if (bind(server->socket_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+      getsockname(server->socket_fd, (struct sockaddr *)&addr, &addr_len) <
+          0) {
+    mock_log(LOG_ERROR, "bind() failed: %s", strerror(errno));
+    close(server->socket_fd);
+    return false;
+  }
+  server->port = ntohs(addr.sin_port);
+
+  /* 短超时,便于停止 */
+  struct timeval timeout = {.tv_sec = 0, .tv_usec = 100000};
+  setsockopt(server->socket_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout,
+             sizeof(timeout));
+
+  server->active = true;
+  if (pthread_create(&server->thread, NULL, mock_ntp_thread, server) != 0) {
+    server->active = false;
+    close(server->socket_fd);
+    return false;
+  }
+
+  return true;
+}
+
+void mock_ntp_server_stop(mock_ntp_server_t *server) {
+  if (!server->active)
+    return;
+
+  server->active = false;
+  pthread_join(server->thread, NULL);
+  close(server->socket_fd);
+}
@@ -0,0 +1,65 @@
+/******************************************************************************
+    Mock NTP Server - Header File
+    Copyright (C) 2026
+
+    Loopback NTP server with configurable clock offset, drift, asymmetric
+    delay, jitter and packet loss, for offline sync-accuracy benchmarks
+******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <util/threading.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 模拟条件 */
+typedef struct mock_ntp_config {
+  int64_t offset_ns;          /* 服务器时钟 - 本地单调时钟 */
+  double drift_ppm;           /* 服务器时钟频率偏差 */
+  uint32_t uplink_delay_us;   /* 请求方向的固定延迟 */
+  uint32_t downlink_delay_us; /* 应答方向的固定延迟 */
+  uint32_t jitter_us;         /* 每个方向附加的随机延迟上限(均匀分布) */
+  double loss_rate;           /* 请求丢弃概率 (0~1) */
+  uint32_t seed;              /* 随机数种子 */
+} mock_ntp_config_t;
+
+/* 模拟服务器上下文 */
+typedef struct mock_ntp_server {
+  mock_ntp_config_t config;
+  int socket_fd;
+  uint16_t port; /* 实际监听端口(127.0.0.1) */
+  pthread_t thread;
+  volatile bool active;
+  uint64_t start_ns; /* 漂移起点 */
+  uint32_t rng_state;
+
+  uint32_t requests; /* 收到的请求数 */
+  uint32_t dropped;  /* 模拟丢弃的请求数 */
+} mock_ntp_server_t;
+
+/*
+ * 在127.0.0.1的随机端口上启动模拟服务器
+ * 返回:
+ *   true - 成功, server->port 为监听端口
+ *   false - 失败
+ */
+bool mock_ntp_server_start(mock_ntp_server_t *server,
+                           const mock_ntp_config_t *config);
+
+void mock_ntp_server_stop(mock_ntp_server_t *server);
+
+/* 给定本地单调时间时服务器时钟的读数(Unix纪元纳秒) */
+uint64_t mock_ntp_server_time_ns(const mock_ntp_server_t *server,
+                                 uint64_t local_ns);
+
+/* 给定本地单调时间时的真实偏移(服务器时钟 - 本地时钟) */
+int64_t mock_ntp_server_true_offset(const mock_ntp_server_t *server,
+                                    uint64_t local_ns);
+
+#ifdef __cplusplus
+}
+#endif
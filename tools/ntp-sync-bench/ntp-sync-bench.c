@@ -0,0 +1,367 @@
+/******************************************************************************
+    NTP Sync Benchmark
+    Copyright (C) 2026
+
+    Drives ntp_client_t and the receiver resync policy against a mock NTP
+    server and reports offset error percentiles, convergence time and
+    resync counts. Runs fully offline on loopback.
+******************************************************************************/
+
+#include "mock-ntp-server.h"
+#include "ntp-client.h"
+#include <getopt.h>
+#include <obs-module.h>
+#include <stdlib.h>
+#include <string.h>
+#include <util/platform.h>
+
+typedef struct bench_options {
+  mock_ntp_config_t mock;
+  uint32_t rounds;             /* 阶段1: 同步次数 */
+  uint32_t round_interval_ms;  /* 阶段1: 两次同步间隔 */
+  uint32_t timeout_ms;         /* 客户端应答超时 */
+  uint32_t tolerance_us;       /* 收敛判定阈值 */
+  uint32_t duration_s;         /* 阶段2: 模拟接收时长 */
+  uint32_t fps;                /* 阶段2: 帧率 */
+  uint32_t gop;                /* 阶段2: 关键帧间隔(帧) */
+  uint32_t stream_latency_ms;  /* 阶段2: 采集到接收的端到端延迟 */
+  uint32_t sync_interval_ms;   /* 阶段2: 最小同步间隔 */
+  uint32_t drift_threshold_ms; /* 阶段2: 漂移阈值 */
+  uint32_t max_p99_us;         /* 非0时,p99超过该值则返回失败 */
+} bench_options_t;
+
+static int compare_int64(const void *a, const void *b) {
+  int64_t x = *(const int64_t *)a;
+  int64_t y = *(const int64_t *)b;
+  return (x > y) - (x < y);
+}
+
+/* 对绝对值排序后取百分位 */
+static int64_t percentile(int64_t *sorted, size_t count, double p) {
+  if (count == 0)
+    return 0;
+  size_t index = (size_t)((double)(count - 1) * p / 100.0 + 0.5);
+  return sorted[index];
+}
+
+static void sort_abs(int64_t *values, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    if (values[i] < 0)
+      values[i] = -values[i];
+  }
+  qsort(values, count, sizeof(int64_t), compare_int64);
+}
+
+static void print_percentiles(const char *label, int64_t *values,
+                              size_t count) {
+  sort_abs(values, count);
+  printf("  %-16s p50 %8.1f us  p90 %8.1f us  p99 %8.1f us  max %8.1f us\n",
+         label, percentile(values, count, 50) / 1000.0,
+         percentile(values, count, 90) / 1000.0,
+         percentile(values, count, 99) / 1000.0,
+         count ? values[count - 1] / 1000.0 : 0.0);
+}
+
+/* 阶段1: 反复执行ntp_client_sync,统计偏移误差和收敛时间 */
+static int64_t run_sync_accuracy(const bench_options_t *opt,
+                                 mock_ntp_server_t *server) {
+  ntp_client_t client;
+  ntp_client_init(&client, "127.0.0.1", server->port);
+  client.timeout_ms = opt->timeout_ms;
+
+  int64_t *errors = calloc(opt->rounds, sizeof(int64_t));
+  size_t count = 0;
+  uint32_t failed = 0;
+  int64_t converged_ms = -1;
+  uint32_t converged_round = 0;
+  uint64_t start = os_gettime_ns();
+
+  for (uint32_t i = 0; i < opt->rounds; i++) {
+    if (ntp_client_sync(&client)) {
+      int64_t error = client.time_offset_ns -
+                      mock_ntp_server_true_offset(server,
+                                                  client.last_sync_local_time);
+      errors[count++] = error;
+
+      int64_t tolerance_ns = (int64_t)opt->tolerance_us * 1000;
+      if (converged_ms < 0 && llabs(error) <= tolerance_ns) {
+        converged_ms = (int64_t)(os_gettime_ns() - start) / 1000000;
+        converged_round = i + 1;
+      }
+    } else {
+      failed++;
+    }
+
+    if (opt->round_interval_ms)
+      os_sleep_ms(opt->round_interval_ms);
+  }
+
+  printf("Sync accuracy: %u rounds, %zu ok, %u failed (%u requests dropped)\n",
+         opt->rounds, count, failed, server->dropped);
+  print_percentiles("offset error", errors, count);
+  if (converged_ms >= 0) {
+    printf("  convergence      within %u us after %lld ms (round %u)\n",
+           opt->tolerance_us, (long long)converged_ms, converged_round);
+  } else {
+    printf("  convergence      never within %u us\n", opt->tolerance_us);
+  }
+
+  int64_t p99 = percentile(errors, count, 99);
+  free(errors);
+  ntp_client_destroy(&client);
+  return p99;
+}
+
+/* 阶段2: 以实时帧率模拟接收端,按ntp_client_check_resync触发同步 */
+static void run_resync_policy(const bench_options_t *opt,
+                              mock_ntp_server_t *server) {
+  ntp_client_t client;
+  ntp_client_init(&client, "127.0.0.1", server->port);
+  client.timeout_ms = opt->timeout_ms;
+
+  ntp_resync_policy_t policy = {
+      .min_interval_ns = (uint64_t)opt->sync_interval_ms * 1000000ULL,
+      .drift_threshold_ns = (int64_t)opt->drift_threshold_ms * 1000000LL,
+  };
+
+  uint64_t frame_count = (uint64_t)opt->duration_s * opt->fps;
+  uint64_t frame_interval = 1000000000ULL / opt->fps;
+  uint64_t latency = (uint64_t)opt->stream_latency_ms * 1000000ULL;
+  int64_t *display_errors = calloc(frame_count, sizeof(int64_t));
+  size_t display_count = 0;
+  uint32_t reasons[NTP_RESYNC_DRIFT + 1] = {0};
+  uint32_t failed = 0;
+  uint64_t last_sync = 0;
+  uint64_t start = os_gettime_ns();
+
+  for (uint64_t i = 0; i < frame_count; i++) {
+    uint64_t target = start + i * frame_interval;
+    uint64_t now = os_gettime_ns();
+    if (target > now) {
+      os_sleep_ms((uint32_t)((target - now) / 1000000ULL));
+      now = os_gettime_ns();
+    }
+
+    /* 发送端与服务器完全同步,帧在 now - latency 时采集 */
+    uint64_t capture_local = now - latency;
+    ntp_timestamp_t frame_time;
+    ntp_timestamp_from_ns(mock_ntp_server_time_ns(server, capture_local),
+                          &frame_time);
+    bool keyframe = (i % opt->gop) == 0;
+
+    ntp_resync_reason_t reason = ntp_client_check_resync(
+        &client, &policy, now, last_sync, keyframe, &frame_time);
+    if (reason != NTP_RESYNC_NONE) {
+      reasons[reason]++;
+      last_sync = now;
+      if (!ntp_client_sync(&client))
+        failed++;
+    }
+
+    /* 显示时间误差: 按接收端偏移还原出的采集时间 - 真实采集时间 */
+    if (client.is_synced) {
+      int64_t display = (int64_t)ntp_timestamp_to_ns(&frame_time) -
+                        ntp_client_get_offset(&client);
+      display_errors[display_count++] = display - (int64_t)capture_local;
+    }
+  }
+
+  uint32_t total = reasons[NTP_RESYNC_INITIAL] + reasons[NTP_RESYNC_KEYFRAME] +
+                   reasons[NTP_RESYNC_DRIFT];
+  printf("Resync policy: %u s at %u fps, GOP %u, stream latency %u ms\n",
+         opt->duration_s, opt->fps, opt->gop, opt->stream_latency_ms);
+  printf("  resyncs          %u (initial %u, keyframe %u, drift %u), "
+         "%u failed, %.1f/min\n",
+         total, reasons[NTP_RESYNC_INITIAL], reasons[NTP_RESYNC_KEYFRAME],
+         reasons[NTP_RESYNC_DRIFT], failed,
+         opt->duration_s ? total * 60.0 / opt->duration_s : 0.0);
+  print_percentiles("display error", display_errors, display_count);
+
+  free(display_errors);
+  ntp_client_destroy(&client);
+}
+
+/* libseistamp日志转发到shim, 使--verbose同样作用于库内的消息 */
+static void seistamp_log_to_shim(int level, const char *format, va_list args,
+                                 void *param) {
+  (void)param;
+  blogva(level, format, args);
+}
+
+static void usage(const char *argv0) {
+  printf(
+      "Usage: %s [options]\n"
+      "Mock server:\n"
+      "  --offset-ms N          server clock offset (default 250)\n"
+      "  --drift-ppm N          server clock frequency error (default 0)\n"
+      "  --up-delay-ms N        request path delay (default 2)\n"
+      "  --down-delay-ms N      response path delay (default 2)\n"
+      "  --jitter-ms N          extra delay per direction (default 0.5)\n"
+      "  --loss N               request loss rate 0..1 (default 0)\n"
+      "  --seed N               random seed (default 1)\n"
+      "Sync accuracy:\n"
+      "  --rounds N             sync rounds (default 200)\n"
+      "  --interval-ms N        pause between rounds (default 20)\n"
+      "  --timeout-ms N         client reply timeout (default 200)\n"
+      "  --tolerance-us N       convergence threshold (default 1000)\n"
+      "  --max-p99-us N         fail if p99 offset error exceeds N\n"
+      "Resync policy:\n"
+      "  --duration-s N         receive time, 0 to skip (default 10)\n"
+      "  --fps N                frame rate (default 60)\n"
+      "  --gop N                keyframe interval in frames (default 120)\n"
+      "  --stream-latency-ms N  capture-to-receive latency (default 200)\n"
+      "  --sync-interval-ms N   minimum resync interval (default 10000)\n"
+      "  --drift-threshold-ms N drift threshold (default 50)\n"
+      "  --verbose              log client/server messages\n",
+      argv0);
+}
+
+int main(int argc, char **argv) {
+  bench_options_t opt = {
+      .mock =
+          {
+              .offset_ns = 250000000LL,
+              .uplink_delay_us = 2000,
+              .downlink_delay_us = 2000,
+              .jitter_us = 500,
+              .seed = 1,
+          },
+      .rounds = 200,
+      .round_interval_ms = 20,
+      .timeout_ms = 200,
+      .tolerance_us = 1000,
+      .duration_s = 10,
+      .fps = 60,
+      .gop = 120,
+      .stream_latency_ms = 200,
+      .sync_interval_ms = 10000,
+      .drift_threshold_ms = 50,
+  };
+
+  static const struct option long_options[] = {
+      {"offset-ms", required_argument, NULL, 'o'},
+      {"drift-ppm", required_argument, NULL, 'd'},
+      {"up-delay-ms", required_argument, NULL, 'u'},
+      {"down-delay-ms", required_argument, NULL, 'w'},
+      {"jitter-ms", required_argument, NULL, 'j'},
+      {"loss", required_argument, NULL, 'l'},
+      {"seed", required_argument, NULL, 's'},
+      {"rounds", required_argument, NULL, 'r'},
+      {"interval-ms", required_argument, NULL, 'i'},
+      {"timeout-ms", required_argument, NULL, 't'},
+      {"tolerance-us", required_argument, NULL, 'T'},
+      {"max-p99-us", required_argument, NULL, 'm'},
+      {"duration-s", required_argument, NULL, 'D'},
+      {"fps", required_argument, NULL, 'f'},
+      {"gop", required_argument, NULL, 'g'},
+      {"stream-latency-ms", required_argument, NULL, 'L'},
+      {"sync-interval-ms", required_argument, NULL, 'S'},
+      {"drift-threshold-ms", required_argument, NULL, 'R'},
+      {"verbose", no_argument, NULL, 'v'},
+      {"help", no_argument, NULL, 'h'},
+      {NULL, 0, NULL, 0},
+  };
+
+  int c;
+  while ((c = getopt_long(argc, argv, "h", long_options, NULL)) != -1) {
+    switch (c) {
+    case 'o':
+      opt.mock.offset_ns = (int64_t)(atof(optarg) * 1e6);
+      break;
+    case 'd':
+      opt.mock.drift_ppm = atof(optarg);
+      break;
+    case 'u':
+      opt.mock.uplink_delay_us = (uint32_t)(atof(optarg) * 1000.0);
+      break;
+    case 'w':
+      opt.mock.downlink_delay_us = (uint32_t)(atof(optarg) * 1000.0);
+      break;
+    case 'j':
+      opt.mock.jitter_us = (uint32_t)(atof(optarg) * 1000.0);
+      break;
+    case 'l':
+      opt.mock.loss_rate = atof(optarg);
+      break;
+    case 's':
+      opt.mock.seed = (uint32_t)strtoul(optarg, NULL, 10);
+      break;
+    case 'r':
+      opt.rounds = (uint32_t)strtoul(optarg, NULL, 10);
+      break;
+    case 'i':
+      opt.round_interval_ms = (uint32_t)strtoul(optarg, NULL, 10);
+      break;
+    case 't':
+      opt.timeout_ms = (uint32_t)strtoul(optarg, NULL, 10);
+      break;
+    case 'T':
+      opt.tolerance_us = (uint32_t)strtoul(optarg, NULL, 10);
+      break;
+    case 'm':
+      opt.max_p99_us = (uint32_t)strtoul(optarg, NULL, 10);
+      break;
+    case 'D':
+      opt.duration_s = (uint32_t)strtoul(optarg, NULL, 10);
+      break;
+    case 'f':
+      opt.fps = (uint32_t)strtoul(optarg, NULL, 10);
+      break;
+    case 'g':
+      opt.gop = (uint32_t)strtoul(optarg, NULL, 10);
+      break;
+    case 'L':
+      opt.stream_latency_ms = (uint32_t)strtoul(optarg, NULL, 10);
+      break;
+    case 'S':
+      opt.sync_interval_ms = (uint32_t)strtoul(optarg, NULL, 10);
+      break;
+    case 'R':
+      opt.drift_threshold_ms = (uint32_t)strtoul(optarg, NULL, 10);
+      break;
+    case 'v':
+      obs_shim_set_log_level(LOG_DEBUG);
+      break;
+    default:
+      usage(argv[0]);
+      return c == 'h' ? 0 : 2;
+    }
+  }
+
+  if (opt.fps == 0 || opt.gop == 0) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  seistamp_set_log_handler(seistamp_log_to_shim, NULL);
+  seistamp_set_clock(fast_clock_now_ns);
+
+  /* 服务器时钟以本机系统时钟为基准,再加上配置的偏移 */
+  opt.mock.offset_ns += (int64_t)(ntp_get_wallclock_ns() - os_gettime_ns());
+
+  mock_ntp_server_t server;
+  if (!mock_ntp_server_start(&server, &opt.mock)) {
+    fprintf(stderr, "Failed to start mock NTP server\n");
+    return 1;
+  }
+
+  printf("Mock NTP server on 127.0.0.1:%u (delay up %.1f ms / down %.1f ms, "
+         "jitter %.1f ms, loss %.1f%%, drift %.1f ppm)\n",
+         server.port, opt.mock.uplink_delay_us / 1000.0,
+         opt.mock.downlink_delay_us / 1000.0, opt.mock.jitter_us / 1000.0,
+         opt.mock.loss_rate * 100.0, opt.mock.drift_ppm);
+
+  int64_t p99 = run_sync_accuracy(&opt, &server);
+  if (opt.duration_s > 0)
+    run_resync_policy(&opt, &server);
+
+  mock_ntp_server_stop(&server);
+
+  if (opt.max_p99_us && p99 > (int64_t)opt.max_p99_us * 1000) {
+    printf("FAIL: p99 offset error %.1f us exceeds %u us\n", p99 / 1000.0,
+           opt.max_p99_us);
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,86 @@
+/******************************************************************************
+    OBS Shim - media-io/video-io.h
+    Copyright (C) 2026
+******************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MAX_AV_PLANES 8
+
+/* 取值与libobs一致,只列出插件用到的格式 */
+enum video_format {
+  VIDEO_FORMAT_NONE = 0,
+  VIDEO_FORMAT_I420 = 1,
+  VIDEO_FORMAT_NV12 = 2,
+  VIDEO_FORMAT_I444 = 10,
+  VIDEO_FORMAT_I010 = 17,
+  VIDEO_FORMAT_P010 = 18,
+};
+
+enum video_colorspace {
+  VIDEO_CS_DEFAULT,
+  VIDEO_CS_601,
+  VIDEO_CS_709,
+  VIDEO_CS_SRGB,
+  VIDEO_CS_2100_PQ,
+  VIDEO_CS_2100_HLG,
+};
+
+enum video_range_type {
+  VIDEO_RANGE_DEFAULT,
+  VIDEO_RANGE_PARTIAL,
+  VIDEO_RANGE_FULL,
+};
+
+struct video_output_info {
+  const char *name;
+  enum video_format format;
+  uint32_t fps_num;
+  uint32_t fps_den;
+  uint32_t width;
+  uint32_t height;
+  size_t cache_size;
+  enum video_colorspace colorspace;
+  enum video_range_type range;
+};
+
+struct video_scale_info {
+  enum video_format format;
+  uint32_t width;
+  uint32_t height;
+  enum video_range_type range;
+  enum video_colorspace colorspace;
+};
+
+typedef struct video_output video_t;
+
+const struct video_output_info *video_output_get_info(const video_t *video);
+
+static inline const char *get_video_format_name(enum video_format format) {
+  switch (format) {
+  case VIDEO_FORMAT_I420:
+    return "I420";
+  case VIDEO_FORMAT_NV12:
+    return "NV12";
+  case VIDEO_FORMAT_I444:
+    return "I444";
+  case VIDEO_FORMAT_I010:
+    return "I010";
+  case VIDEO_FORMAT_P010:
+    return "P010";
+  case VIDEO_FORMAT_NONE:
+    break;
+  }
+  return "None";
+}
+
+#ifdef __cplusplus
+}
+#endif
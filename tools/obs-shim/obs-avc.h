@@ -0,0 +1,10 @@
+/******************************************************************************
+    OBS Shim - obs-avc.h
+    Copyright (C) 2026
+
+    Included by the encoder sources; none of its helpers are used offline
+******************************************************************************/
+
+#pragma once
+
+#include "obs-module.h"
@@ -0,0 +1,39 @@
+/******************************************************************************
+    OBS Shim - obs-data.h
+    Copyright (C) 2026
+
+    Flat key/value settings store; enough for encoder create/defaults
+******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct obs_data obs_data_t;
+
+obs_data_t *obs_data_create(void);
+void obs_data_release(obs_data_t *data);
+
+void obs_data_set_string(obs_data_t *data, const char *name, const char *val);
+void obs_data_set_int(obs_data_t *data, const char *name, long long val);
+void obs_data_set_bool(obs_data_t *data, const char *name, bool val);
+
+void obs_data_set_default_string(obs_data_t *data, const char *name,
+                                 const char *val);
+void obs_data_set_default_int(obs_data_t *data, const char *name,
+                              long long val);
+void obs_data_set_default_bool(obs_data_t *data, const char *name, bool val);
+
+/* 未设置时返回默认值,两者都没有时返回 ""/0/false */
+const char *obs_data_get_string(obs_data_t *data, const char *name);
+long long obs_data_get_int(obs_data_t *data, const char *name);
+bool obs_data_get_bool(obs_data_t *data, const char *name);
+
+#ifdef __cplusplus
+}
+#endif
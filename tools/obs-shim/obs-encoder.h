@@ -0,0 +1,83 @@
+/******************************************************************************
+    OBS Shim - obs-encoder.h
+    Copyright (C) 2026
+
+    Encoder callback table and a stand-in obs_encoder_t, so offline tools can
+    drive the plugin's obs_encoder_info implementations directly
+******************************************************************************/
+
+#pragma once
+
+#include "media-io/video-io.h"
+#include "obs-data.h"
+#include "obs-properties.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OBS_ENCODER_CAP_DEPRECATED (1 << 0)
+#define OBS_ENCODER_CAP_PASS_TEXTURE (1 << 1)
+
+enum obs_encoder_type {
+  OBS_ENCODER_AUDIO,
+  OBS_ENCODER_VIDEO,
+};
+
+typedef struct obs_encoder obs_encoder_t;
+
+struct encoder_frame {
+  uint8_t *data[MAX_AV_PLANES];
+  uint32_t linesize[MAX_AV_PLANES];
+  uint32_t frames;
+  int64_t pts;
+};
+
+struct encoder_packet {
+  uint8_t *data;
+  size_t size;
+  int64_t pts;
+  int64_t dts;
+  int32_t timebase_num;
+  int32_t timebase_den;
+  enum obs_encoder_type type;
+  bool keyframe;
+};
+
+struct obs_encoder_info {
+  const char *id;
+  enum obs_encoder_type type;
+  const char *codec;
+  const char *(*get_name)(void *type_data);
+  void *(*create)(obs_data_t *settings, obs_encoder_t *encoder);
+  void (*destroy)(void *data);
+  bool (*encode)(void *data, struct encoder_frame *frame,
+                 struct encoder_packet *packet, bool *received_packet);
+  size_t (*get_frame_size)(void *data);
+  void (*get_defaults)(obs_data_t *settings);
+  obs_properties_t *(*get_properties)(void *data);
+  bool (*update)(void *data, obs_data_t *settings);
+  bool (*get_extra_data)(void *data, uint8_t **extra_data, size_t *size);
+  bool (*get_sei_data)(void *data, uint8_t **sei_data, size_t *size);
+  void (*get_video_info)(void *data, struct video_scale_info *info);
+  void *type_data;
+  void (*free_type_data)(void *type_data);
+  uint32_t caps;
+};
+
+const char *obs_encoder_get_name(const obs_encoder_t *encoder);
+uint32_t obs_encoder_get_width(const obs_encoder_t *encoder);
+uint32_t obs_encoder_get_height(const obs_encoder_t *encoder);
+video_t *obs_encoder_video(const obs_encoder_t *encoder);
+
+/* 创建替身编码器: 名称和视频输出参数由调用者提供(复制保存) */
+obs_encoder_t *obs_shim_encoder_create(const char *name,
+                                       const struct video_output_info *voi);
+void obs_shim_encoder_destroy(obs_encoder_t *encoder);
+
+#ifdef __cplusplus
+}
+#endif
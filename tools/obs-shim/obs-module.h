@@ -0,0 +1,45 @@
+/******************************************************************************
+    OBS Shim - obs-module.h
+    Copyright (C) 2026
+
+    Minimal stand-in for the libobs APIs used by the plugin modules, so they
+    can be compiled into offline tools without an OBS installation
+******************************************************************************/
+
+#pragma once
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "obs-encoder.h"
+#include "util/bmem.h"
+#include "util/platform.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 日志级别 (与libobs一致) */
+enum {
+  LOG_ERROR = 100,
+  LOG_WARNING = 200,
+  LOG_INFO = 300,
+  LOG_DEBUG = 400,
+};
+
+#define UNUSED_PARAMETER(param) (void)param
+
+/* 输出日志到stderr,低于当前级别的消息被忽略 */
+void blog(int log_level, const char *format, ...);
+void blogva(int log_level, const char *format, va_list args);
+
+/* 设置日志级别(默认LOG_WARNING) */
+void obs_shim_set_log_level(int log_level);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,61 @@
+/******************************************************************************
+    OBS Shim - obs-properties.h
+    Copyright (C) 2026
+
+    Property builders are no-ops; offline tools never show a UI
+******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct obs_properties obs_properties_t;
+typedef struct obs_property obs_property_t;
+
+enum obs_combo_type {
+  OBS_COMBO_TYPE_INVALID,
+  OBS_COMBO_TYPE_EDITABLE,
+  OBS_COMBO_TYPE_LIST,
+};
+
+enum obs_combo_format {
+  OBS_COMBO_FORMAT_INVALID,
+  OBS_COMBO_FORMAT_INT,
+  OBS_COMBO_FORMAT_FLOAT,
+  OBS_COMBO_FORMAT_STRING,
+};
+
+enum obs_text_type {
+  OBS_TEXT_DEFAULT,
+  OBS_TEXT_PASSWORD,
+  OBS_TEXT_MULTILINE,
+};
+
+obs_properties_t *obs_properties_create(void);
+obs_property_t *obs_properties_add_bool(obs_properties_t *props,
+                                        const char *name,
+                                        const char *description);
+obs_property_t *obs_properties_add_int(obs_properties_t *props,
+                                       const char *name,
+                                       const char *description, int min,
+                                       int max, int step);
+obs_property_t *obs_properties_add_text(obs_properties_t *props,
+                                        const char *name,
+                                        const char *description,
+                                        enum obs_text_type type);
+obs_property_t *obs_properties_add_list(obs_properties_t *props,
+                                        const char *name,
+                                        const char *description,
+                                        enum obs_combo_type type,
+                                        enum obs_combo_format format);
+size_t obs_property_list_add_string(obs_property_t *p, const char *name,
+                                    const char *val);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,282 @@
+/******************************************************************************
+    OBS Shim - Implementation
+    Copyright (C) 2026
+
+    Minimal stand-in for the libobs APIs used by the plugin modules, so they
+    can be compiled into offline tools without an OBS installation
+******************************************************************************/
+
+#define _GNU_SOURCE
+#include "obs-module.h"
+#include "util/threading.h"
+#include <stdlib.h>
+#include <time.h>
+
+static int shim_log_level = LOG_WARNING;
+
+void obs_shim_set_log_level(int log_level) { shim_log_level = log_level; }
+
+void blogva(int log_level, const char *format, va_list args) {
+  if (log_level > shim_log_level)
+    return;
+
+  vfprintf(stderr, format, args);
+  fputc('\n', stderr);
+}
+
+void blog(int log_level, const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  blogva(log_level, format, args);
+  va_end(args);
+}
+
+uint64_t os_gettime_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void os_sleep_ms(uint32_t duration) {
+  struct timespec ts;
+  ts.tv_sec = duration / 1000;
+  ts.tv_nsec = (long)(duration % 1000) * 1000000L;
+  nanosleep(&ts, NULL);
+}
+
+void os_set_thread_name(const char *name) {
+#ifdef __linux__
+  char truncated[16];
+  strncpy(truncated, name, sizeof(truncated) - 1);
+  truncated[sizeof(truncated) - 1] = '\0';
+  pthread_setname_np(pthread_self(), truncated);
+#else
+  UNUSED_PARAMETER(name);
+#endif
+}
+
+/* ------------------------------------------------------------------------- */
+/* obs_data: 单向链表,每项保存当前值和默认值 */
+
+enum data_type { DATA_STRING, DATA_INT, DATA_BOOL };
+
+struct data_item {
+  struct data_item *next;
+  char *name;
+  enum data_type type;
+  bool has_value;
+  bool has_default;
+  char *string_value;
+  char *string_default;
+  long long int_value; /* 整数和布尔共用 */
+  long long int_default;
+};
+
+struct obs_data {
+  struct data_item *items;
+};
+
+obs_data_t *obs_data_create(void) { return bzalloc(sizeof(obs_data_t)); }
+
+void obs_data_release(obs_data_t *data) {
+  if (!data)
+    return;
+
+  struct data_item *item = data->items;
+  while (item) {
+    struct data_item *next = item->next;
+    bfree(item->name);
+    bfree(item->string_value);
+    bfree(item->string_default);
+    bfree(item);
+    item = next;
+  }
+  bfree(data);
+}
+
+static struct data_item *find_item(obs_data_t *data, const char *name) {
+  for (struct data_item *item = data->items; item; item = item->next) {
+    if (strcmp(item->name, name) == 0)
+      return item;
+  }
+  return NULL;
+}
+
+static struct data_item *get_item(obs_data_t *data, const char *name,
+                                  enum data_type type) {
+  struct data_item *item = find_item(data, name);
+  if (!item) {
+    item = bzalloc(sizeof(struct data_item));
+    item->name = bstrdup(name);
+    item->next = data->items;
+    data->items = item;
+  }
+  item->type = type;
+  return item;
+}
+
+void obs_data_set_string(obs_data_t *data, const char *name, const char *val) {
+  struct data_item *item = get_item(data, name, DATA_STRING);
+  bfree(item->string_value);
+  item->string_value = bstrdup(val ? val : "");
+  item->has_value = true;
+}
+
+void obs_data_set_int(obs_data_t *data, const char *name, long long val) {
+  struct data_item *item = get_item(data, name, DATA_INT);
+  item->int_value = val;
+  item->has_value = true;
+}
+
+void obs_data_set_bool(obs_data_t *data, const char *name, bool val) {
+  struct data_item *item = get_item(data, name, DATA_BOOL);
+  item->int_value = val;
+  item->has_value = true;
+}
+
+void obs_data_set_default_string(obs_data_t *data, const char *name,
+                                 const char *val) {
+  struct data_item *item = get_item(data, name, DATA_STRING);
+  bfree(item->string_default);
+  item->string_default = bstrdup(val ? val : "");
+  item->has_default = true;
+}
+
+void obs_data_set_default_int(obs_data_t *data, const char *name,
+                              long long val) {
+  struct data_item *item = get_item(data, name, DATA_INT);
+  item->int_default = val;
+  item->has_default = true;
+}
+
+void obs_data_set_default_bool(obs_data_t *data, const char *name, bool val) {
+  struct data_item *item = get_item(data, name, DATA_BOOL);
+  item->int_default = val;
+  item->has_default = true;
+}
+
+const char *obs_data_get_string(obs_data_t *data, const char *name) {
+  struct data_item *item = find_item(data, name);
+  if (!item || item->type != DATA_STRING)
+    return "";
+  if (item->has_value)
+    return item->string_value;
+  return item->has_default ? item->string_default : "";
+}
+
+long long obs_data_get_int(obs_data_t *data, const char *name) {
+  struct data_item *item = find_item(data, name);
+  if (!item || item->type == DATA_STRING)
+    return 0;
+  return item->has_value ? item->int_value : item->int_default;
+}
+
+bool obs_data_get_bool(obs_data_t *data, const char *name) {
+  return obs_data_get_int(data, name) != 0;
+}
+
+/* ------------------------------------------------------------------------- */
+/* obs_encoder_t / video_t */
+
+struct video_output {
+  struct video_output_info info;
+};
+
+struct obs_encoder {
+  char *name;
+  struct video_output video;
+};
+
+obs_encoder_t *obs_shim_encoder_create(const char *name,
+                                       const struct video_output_info *voi) {
+  obs_encoder_t *encoder = bzalloc(sizeof(obs_encoder_t));
+  encoder->name = bstrdup(name);
+  encoder->video.info = *voi;
+  return encoder;
+}
+
+void obs_shim_encoder_destroy(obs_encoder_t *encoder) {
+  if (!encoder)
+    return;
+  bfree(encoder->name);
+  bfree(encoder);
+}
+
+const char *obs_encoder_get_name(const obs_encoder_t *encoder) {
+  return encoder ? encoder->name : NULL;
+}
+
+uint32_t obs_encoder_get_width(const obs_encoder_t *encoder) {
+  return encoder->video.info.width;
+}
+
+uint32_t obs_encoder_get_height(const obs_encoder_t *encoder) {
+  return encoder->video.info.height;
+}
+
+video_t *obs_encoder_video(const obs_encoder_t *encoder) {
+  return (video_t *)&encoder->video;
+}
+
+const struct video_output_info *video_output_get_info(const video_t *video) {
+  return video ? &video->info : NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+/* 属性: 离线工具没有界面,全部为空操作 */
+
+obs_properties_t *obs_properties_create(void) { return NULL; }
+
+obs_property_t *obs_properties_add_bool(obs_properties_t *props,
+                                        const char *name,
+                                        const char *description) {
+  UNUSED_PARAMETER(props);
+  UNUSED_PARAMETER(name);
+  UNUSED_PARAMETER(description);
+  return NULL;
+}
+
+obs_property_t *obs_properties_add_int(obs_properties_t *props,
+                                       const char *name,
+                                       const char *description, int min,
+                                       int max, int step) {
+  UNUSED_PARAMETER(props);
+  UNUSED_PARAMETER(name);
+  UNUSED_PARAMETER(description);
+  UNUSED_PARAMETER(min);
+  UNUSED_PARAMETER(max);
+  UNUSED_PARAMETER(step);
+  return NULL;
+}
+
+obs_property_t *obs_properties_add_text(obs_properties_t *props,
+                                        const char *name,
+                                        const char *description,
+                                        enum obs_text_type type) {
+  UNUSED_PARAMETER(props);
+  UNUSED_PARAMETER(name);
+  UNUSED_PARAMETER(description);
+  UNUSED_PARAMETER(type);
+  return NULL;
+}
+
+obs_property_t *obs_properties_add_list(obs_properties_t *props,
+                                        const char *name,
+                                        const char *description,
+                                        enum obs_combo_type type,
+                                        enum obs_combo_format format) {
+  UNUSED_PARAMETER(props);
+  UNUSED_PARAMETER(name);
+  UNUSED_PARAMETER(description);
+  UNUSED_PARAMETER(type);
+  UNUSED_PARAMETER(format);
+  return NULL;
+}
+
+size_t obs_property_list_add_string(obs_property_t *p, const char *name,
+                                    const char *val) {
+  UNUSED_PARAMETER(p);
+  UNUSED_PARAMETER(name);
+  UNUSED_PARAMETER(val);
+  return 0;
+}
@@ -0,0 +1,28 @@
+/******************************************************************************
+    OBS Shim - util/bmem.h
+    Copyright (C) 2026
+******************************************************************************/
+
+#pragma once
+
+#include <stdlib.h>
+#include <string.h>
+
+static inline void *bmalloc(size_t size) { return malloc(size ? size : 1); }
+
+static inline void *bzalloc(size_t size) { return calloc(1, size ? size : 1); }
+
+static inline void *brealloc(void *ptr, size_t size) {
+  return realloc(ptr, size ? size : 1);
+}
+
+static inline void bfree(void *ptr) { free(ptr); }
+
+static inline char *bstrdup(const char *str) {
+  if (!str)
+    return NULL;
+  size_t len = strlen(str) + 1;
+  char *dup = (char *)bmalloc(len);
+  memcpy(dup, str, len);
+  return dup;
+}
@@ -0,0 +1,13 @@
+/******************************************************************************
+    OBS Shim - util/dstr.h
+    Copyright (C) 2026
+******************************************************************************/
+
+#pragma once
+
+#include <string.h>
+
+#ifndef _WIN32
+#include <strings.h>
+#define _strnicmp strncasecmp
+#endif
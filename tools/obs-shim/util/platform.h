@@ -0,0 +1,24 @@
+/******************************************************************************
+    OBS Shim - util/platform.h
+    Copyright (C) 2026
+******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 单调时钟(纳秒) */
+uint64_t os_gettime_ns(void);
+
+void os_sleep_ms(uint32_t duration);
+
+void os_set_thread_name(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
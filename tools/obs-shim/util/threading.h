@@ -0,0 +1,33 @@
+/******************************************************************************
+    OBS Shim - util/threading.h
+    Copyright (C) 2026
+******************************************************************************/
+
+#pragma once
+
+#include <pthread.h>
+#include <stdbool.h>
+
+static inline long os_atomic_inc_long(volatile long *val) {
+  return __atomic_add_fetch(val, 1, __ATOMIC_SEQ_CST);
+}
+
+static inline long os_atomic_dec_long(volatile long *val) {
+  return __atomic_sub_fetch(val, 1, __ATOMIC_SEQ_CST);
+}
+
+static inline long os_atomic_load_long(const volatile long *ptr) {
+  return __atomic_load_n(ptr, __ATOMIC_SEQ_CST);
+}
+
+static inline void os_atomic_set_long(volatile long *ptr, long val) {
+  __atomic_store_n(ptr, val, __ATOMIC_SEQ_CST);
+}
+
+static inline bool os_atomic_load_bool(const volatile bool *ptr) {
+  return __atomic_load_n(ptr, __ATOMIC_SEQ_CST);
+}
+
+static inline void os_atomic_set_bool(volatile bool *ptr, bool val) {
+  __atomic_store_n(ptr, val, __ATOMIC_SEQ_CST);
+}
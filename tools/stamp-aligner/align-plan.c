@@ -0,0 +1,66 @@
+/******************************************************************************
+    Stamp Aligner - Planning
+    Copyright (C) 2026
+******************************************************************************/
+
+#include "align-plan.h"
+#include <stdio.h>
+
+/* 最后一个ntp_ns <= t的时间戳; 全部晚于t时返回0 */
+static size_t stamp_before(const stream_scan_t *scan, uint64_t ntp_ns) {
+  size_t lo = 0, hi = scan->stamp_count;
+  while (hi - lo > 1) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (scan->stamps[mid].ntp_ns <= ntp_ns)
+      lo = mid;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+int64_t align_time_at(const stream_scan_t *scan, uint64_t ntp_ns) {
+  size_t i = stamp_before(scan, ntp_ns);
+  const stamp_record_t *a = &scan->stamps[i];
+
+  /* 范围之外(或NTP倒退的相邻时间戳)以最近的时间戳1:1外推 */
+  if (ntp_ns < a->ntp_ns || i + 1 >= scan->stamp_count ||
+      scan->stamps[i + 1].ntp_ns <= a->ntp_ns)
+    return a->time_us + ((int64_t)(ntp_ns - a->ntp_ns)) / 1000;
+
+  const stamp_record_t *b = &scan->stamps[i + 1];
+  double t = (double)(ntp_ns - a->ntp_ns) / (double)(b->ntp_ns - a->ntp_ns);
+  return a->time_us + (int64_t)(t * (double)(b->time_us - a->time_us));
+}
+
+bool align_window(const stream_scan_t *const *scans, size_t count,
+                  align_window_t *window, char *error, size_t error_size) {
+  window->start_ntp_ns = 0;
+  window->end_ntp_ns = UINT64_MAX;
+
+  for (size_t i = 0; i < count; i++) {
+    const stream_scan_t *scan = scans[i];
+    if (scan->stamp_count == 0) {
+      snprintf(error, error_size, "file %zu has no stamps", i + 1);
+      return false;
+    }
+
+    /* 容器时间0和最后一帧对应的NTP时间 */
+    const stamp_record_t *first = &scan->stamps[0];
+    const stamp_record_t *last = &scan->stamps[scan->stamp_count - 1];
+    uint64_t start = first->ntp_ns - (uint64_t)(first->time_us * 1000);
+    uint64_t end =
+        last->ntp_ns + (uint64_t)((scan->duration_us - last->time_us) * 1000);
+
+    if (start > window->start_ntp_ns)
+      window->start_ntp_ns = start;
+    if (end < window->end_ntp_ns)
+      window->end_ntp_ns = end;
+  }
+
+  if (window->end_ntp_ns <= window->start_ntp_ns) {
+    snprintf(error, error_size, "recordings do not overlap in time");
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,41 @@
+/******************************************************************************
+    Stamp Aligner - Planning
+    Copyright (C) 2026
+
+    Maps the SEI Stamper stamps of several recordings onto one NTP timeline
+    and finds the window every recording covers. Pure arithmetic on the
+    scanner output, no FFmpeg.
+******************************************************************************/
+
+#pragma once
+
+#include "stream-scan.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 所有录像共同覆盖的NTP时间段 */
+typedef struct align_window {
+  uint64_t start_ntp_ns;
+  uint64_t end_ntp_ns;
+} align_window_t;
+
+/*
+ * 文件在NTP时刻ntp_ns的容器时间(微秒)
+ * 在相邻时间戳之间线性插值; 时间戳范围之外按1:1外推(录像首尾)
+ * 要求scan->stamp_count > 0
+ */
+int64_t align_time_at(const stream_scan_t *scan, uint64_t ntp_ns);
+
+/*
+ * 计算共同时间段: 每个文件的首尾帧外推到NTP时间, 取最晚的开始和最早的结束
+ * 返回:
+ *   false - 有文件没有时间戳或时间段不重叠, 原因写入error
+ */
+bool align_window(const stream_scan_t *const *scans, size_t count,
+                  align_window_t *window, char *error, size_t error_size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,332 @@
+/******************************************************************************
+    Stamp Aligner
+    Copyright (C) 2026
+
+    Trims recordings of the same event from several SEI Stamper encoders to
+    the NTP window they all cover, so the outputs start on the same instant
+    and can be dropped onto an editing timeline without manual syncing.
+    Stamps are read with the stamp-analyzer scanners; cutting is done with
+    libavformat stream copy, one file per worker thread.
+******************************************************************************/
+
+#include "align-plan.h"
+#include "trim.h"
+#include <getopt.h>
+#include <libavutil/log.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef struct aligner_options {
+  const char *output_dir;
+  unsigned threads; /* 0 = CPU核数 */
+  bool dry_run;     /* 只打印剪切计划 */
+  bool verbose;
+  trim_options_t trim;
+} aligner_options_t;
+
+typedef struct align_job {
+  const char *path;
+  char output[PATH_MAX];
+  size_t size;
+  bool ok;
+  stream_scan_t scan;
+  trim_job_t trim;
+  char error[160];
+} align_job_t;
+
+typedef void (*job_func_t)(align_job_t *job, const aligner_options_t *options);
+
+typedef struct work_queue {
+  align_job_t *jobs;
+  long count;
+  long next; /* 下一个待处理的文件, 原子递增 */
+  job_func_t func;
+  const aligner_options_t *options;
+} work_queue_t;
+
+static void log_handler(int level, const char *format, va_list args,
+                        void *param) {
+  const aligner_options_t *options = param;
+  if (!options->verbose && level > SEISTAMP_LOG_WARNING)
+    return;
+  vfprintf(stderr, format, args);
+  fputc('\n', stderr);
+}
+
+static double now_s(void) { return (double)seistamp_now_ns() / 1e9; }
+
+static void format_time(int64_t time_us, char *buf, size_t size) {
+  const char *sign = time_us < 0 ? "-" : "";
+  int64_t ms = (time_us < 0 ? -time_us : time_us) / 1000;
+  snprintf(buf, size, "%s%02d:%02d:%02d.%03d", sign, (int)(ms / 3600000),
+           (int)(ms / 60000 % 60), (int)(ms / 1000 % 60), (int)(ms % 1000));
+}
+
+/* ------------------------------------------------------------------------- */
+/* 线程池: 扫描和剪切两个阶段共用 */
+
+static void *worker_thread(void *param) {
+  work_queue_t *queue = param;
+  for (;;) {
+    long index = __atomic_fetch_add(&queue->next, 1, __ATOMIC_RELAXED);
+    if (index >= queue->count)
+      return NULL;
+    queue->func(&queue->jobs[index], queue->options);
+  }
+}
+
+static void run_pool(align_job_t *jobs, size_t count, job_func_t func,
+                     const aligner_options_t *options) {
+  unsigned threads = options->threads;
+  if (threads == 0) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = cpus > 0 ? (unsigned)cpus : 1;
+  }
+  if (threads > count)
+    threads = (unsigned)count;
+
+  work_queue_t queue = {.jobs = jobs, .count = (long)count, .func = func,
+                        .options = options};
+  pthread_t *workers = calloc(threads, sizeof(pthread_t));
+  unsigned started = 0;
+  for (; workers && started < threads; started++) {
+    if (pthread_create(&workers[started], NULL, worker_thread, &queue) != 0)
+      break;
+  }
+  /* 线程创建失败时在主线程中处理剩余文件 */
+  worker_thread(&queue);
+  for (unsigned i = 0; i < started; i++)
+    pthread_join(workers[i], NULL);
+  free(workers);
+}
+
+static void scan_job(align_job_t *job, const aligner_options_t *options) {
+  (void)options;
+  job->ok = stream_scan_path(job->path, 30.0, &job->scan, &job->size);
+  if (!job->ok) {
+    snprintf(job->error, sizeof(job->error), "%s", job->scan.error);
+  } else if (job->scan.format == STREAM_FORMAT_ANNEXB) {
+    /* 裸码流没有时间戳, 无法按时间剪切 */
+    snprintf(job->error, sizeof(job->error),
+             "raw Annex B has no timestamps, remux to TS or MP4 first");
+    job->ok = false;
+  } else if (job->scan.stamp_count == 0) {
+    snprintf(job->error, sizeof(job->error), "no SEI Stamper stamps");
+    job->ok = false;
+  }
+}
+
+static void trim_job(align_job_t *job, const aligner_options_t *options) {
+  job->ok = trim_file(&job->trim, &options->trim);
+  if (!job->ok)
+    snprintf(job->error, sizeof(job->error), "%s", job->trim.error);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* 输出文件名与输入相同, 放在输出目录下; 拒绝覆盖输入 */
+static bool make_output_path(align_job_t *job, const char *output_dir) {
+  const char *name = strrchr(job->path, '/');
+  name = name ? name + 1 : job->path;
+  snprintf(job->output, sizeof(job->output), "%s/%s", output_dir, name);
+
+  char input_real[PATH_MAX], dir_real[PATH_MAX], output_real[PATH_MAX];
+  if (realpath(job->path, input_real) && realpath(output_dir, dir_real)) {
+    snprintf(output_real, sizeof(output_real), "%s/%s", dir_real, name);
+    if (strcmp(input_real, output_real) == 0) {
+      snprintf(job->error, sizeof(job->error),
+               "output would overwrite the input");
+      return false;
+    }
+  }
+  return true;
+}
+
+static void print_plan(const align_job_t *jobs, size_t count,
+                       const align_window_t *window) {
+  printf("Common window: %.3f s starting at NTP %.6f\n",
+         (double)(window->end_ntp_ns - window->start_ntp_ns) / 1e9,
+         (double)window->start_ntp_ns / 1e9);
+
+  for (size_t i = 0; i < count; i++) {
+    char start[32], end[32];
+    format_time(jobs[i].trim.start_us, start, sizeof(start));
+    format_time(jobs[i].trim.end_us, end, sizeof(end));
+    printf("  %-24s %s -> %s  (%zu stamps)\n", jobs[i].path, start, end,
+           jobs[i].scan.stamp_count);
+  }
+}
+
+static void print_result(const align_job_t *job, bool smart) {
+  if (!job->ok) {
+    printf("  %-24s error: %s\n", job->path, job->error);
+    return;
+  }
+  if (smart && job->trim.encoded_frames) {
+    printf("  %-24s %s, %llu frames re-encoded, %llu packets copied\n",
+           job->path, job->output,
+           (unsigned long long)job->trim.encoded_frames,
+           (unsigned long long)job->trim.copied_packets);
+  } else {
+    printf("  %-24s %s, starts %.1f ms early (keyframe), %llu packets "
+           "copied\n",
+           job->path, job->output, (double)job->trim.lead_us / 1e3,
+           (unsigned long long)job->trim.copied_packets);
+  }
+}
+
+static void usage(const char *argv0) {
+  fprintf(
+      stderr,
+      "Usage: %s -o DIR [options] FILE...\n"
+      "Trim recordings (TS, MP4/MOV) to the NTP window covered by all of\n"
+      "them, using their SEI Stamper timestamps. Packets are copied; the\n"
+      "cut snaps to the keyframe before the common start unless --smart.\n\n"
+      "  -o, --output DIR  directory for the aligned files (same names)\n"
+      "  --smart           re-encode the first GOP for a frame-exact start\n"
+      "  --encoder NAME    encoder for --smart (default: by input codec)\n"
+      "  --crf N           quality of the re-encoded frames (default 18)\n"
+      "  --threads N       worker threads (default: number of CPUs)\n"
+      "  --dry-run         print the cut points only\n"
+      "  --verbose         log library and FFmpeg messages\n",
+      argv0);
+}
+
+int main(int argc, char **argv) {
+  aligner_options_t options = {.trim = {.crf = 18}};
+
+  static const struct option long_options[] = {
+      {"output", required_argument, NULL, 'o'},
+      {"smart", no_argument, NULL, 's'},
+      {"encoder", required_argument, NULL, 'e'},
+      {"crf", required_argument, NULL, 'q'},
+      {"threads", required_argument, NULL, 't'},
+      {"dry-run", no_argument, NULL, 'n'},
+      {"verbose", no_argument, NULL, 'v'},
+      {"help", no_argument, NULL, 'h'},
+      {NULL, 0, NULL, 0},
+  };
+
+  int c;
+  while ((c = getopt_long(argc, argv, "o:h", long_options, NULL)) != -1) {
+    switch (c) {
+    case 'o':
+      options.output_dir = optarg;
+      break;
+    case 's':
+      options.trim.smart = true;
+      break;
+    case 'e':
+      options.trim.encoder = optarg;
+      break;
+    case 'q':
+      options.trim.crf = atoi(optarg);
+      break;
+    case 't':
+      options.threads = (unsigned)strtoul(optarg, NULL, 10);
+      break;
+    case 'n':
+      options.dry_run = true;
+      break;
+    case 'v':
+      options.verbose = true;
+      break;
+    default:
+      usage(argv[0]);
+      return c == 'h' ? 0 : 2;
+    }
+  }
+
+  size_t count = (size_t)(argc - optind);
+  if (count < 2 || (!options.output_dir && !options.dry_run)) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  seistamp_set_log_handler(log_handler, &options);
+  av_log_set_level(options.verbose ? AV_LOG_INFO : AV_LOG_ERROR);
+
+  align_job_t *jobs = calloc(count, sizeof(align_job_t));
+  const stream_scan_t **scans = calloc(count, sizeof(stream_scan_t *));
+  if (!jobs || !scans)
+    return 1;
+  for (size_t i = 0; i < count; i++) {
+    jobs[i].path = argv[optind + (int)i];
+    scans[i] = &jobs[i].scan;
+  }
+
+  /* 1. 扫描时间戳 */
+  double start = now_s();
+  run_pool(jobs, count, scan_job, &options);
+  double scan_s = now_s() - start;
+
+  int status = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (!jobs[i].ok) {
+      fprintf(stderr, "%s: %s\n", jobs[i].path, jobs[i].error);
+      status = 1;
+    }
+  }
+
+  /* 2. 共同时间段和每个文件的剪切点 */
+  align_window_t window;
+  char error[128];
+  if (!status && !align_window(scans, count, &window, error, sizeof(error))) {
+    fprintf(stderr, "Cannot align: %s\n", error);
+    status = 1;
+  }
+  if (status)
+    goto out;
+
+  for (size_t i = 0; i < count; i++) {
+    trim_job_t *trim = &jobs[i].trim;
+    trim->input = jobs[i].path;
+    trim->output = jobs[i].output;
+    trim->start_us = align_time_at(&jobs[i].scan, window.start_ntp_ns);
+    trim->end_us = align_time_at(&jobs[i].scan, window.end_ntp_ns);
+    trim->start_ntp_ns = window.start_ntp_ns;
+  }
+  print_plan(jobs, count, &window);
+  if (options.dry_run)
+    goto out;
+
+  for (size_t i = 0; i < count; i++) {
+    if (!make_output_path(&jobs[i], options.output_dir)) {
+      fprintf(stderr, "%s: %s\n", jobs[i].path, jobs[i].error);
+      status = 1;
+    }
+    for (size_t j = 0; j < i; j++) {
+      if (strcmp(jobs[i].output, jobs[j].output) == 0) {
+        fprintf(stderr, "%s and %s have the same file name\n", jobs[j].path,
+                jobs[i].path);
+        status = 1;
+      }
+    }
+  }
+  if (status)
+    goto out;
+
+  /* 3. 剪切 */
+  start = now_s();
+  run_pool(jobs, count, trim_job, &options);
+  double trim_s = now_s() - start;
+
+  printf("\nAligned files\n");
+  for (size_t i = 0; i < count; i++) {
+    print_result(&jobs[i], options.trim.smart);
+    if (!jobs[i].ok)
+      status = 1;
+  }
+  printf("\nScanned in %.2f s, trimmed in %.2f s\n", scan_s, trim_s);
+
+out:
+  for (size_t i = 0; i < count; i++)
+    stream_scan_free(&jobs[i].scan);
+  free(scans);
+  free(jobs);
+  return status;
+}
@@ -0,0 +1,787 @@
+/******************************************************************************
+    Stamp Aligner - Trimming
+    Copyright (C) 2026
+******************************************************************************/
+
+#include "trim.h"
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/opt.h>
+#include <seistamp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* 向前seek后仍落在起点之后时, 依次扩大的回退量(秒); 最后从头读 */
+static const int64_t seek_backoff_s[] = {0, 2, 10, 60};
+
+typedef struct packet_list {
+  AVPacket **items;
+  size_t count;
+  size_t capacity;
+} packet_list_t;
+
+typedef struct trim_context {
+  trim_job_t *job;
+  const trim_options_t *options;
+
+  AVFormatContext *ic;
+  AVFormatContext *oc;
+  AVPacket *pkt;
+  int video; /* 输入视频流序号 */
+
+  /* 每个输入流: 输出流序号(-1丢弃)、时间偏移和结束时间(各自时间基) */
+  int *stream_map;
+  int64_t *offsets;
+  int64_t *ends;
+  bool *finished;
+  unsigned open_streams; /* 尚未到达结束时间的输出流 */
+
+  int64_t first_pts; /* 视频流时间基 */
+  int64_t start_pts;
+  int64_t end_pts;
+
+  /* 起点之前的视频包, 从最后一个不晚于起点的关键帧开始 */
+  packet_list_t preroll;
+  bool in_preroll;
+
+  /* 精确模式: 从起点关键帧解码, 重新编码起点到下一个关键帧之间的帧 */
+  AVCodecContext *dec;
+  AVCodecContext *enc;
+  AVFrame *frame;
+  AVPacket *enc_pkt;
+  packet_list_t encoded; /* 等下一个关键帧到达后再统一确定dts */
+  AVPacket *resume_pkt;  /* 下一个关键帧, 其前导帧仍需解码 */
+  bool reencoding;
+  bool sei_pending;
+  int64_t reorder_delay; /* 起点关键帧的pts - dts */
+  int length_size;       /* 0: Annex B输出, 否则为NAL长度前缀字节数 */
+} trim_context_t;
+
+static bool fail(trim_context_t *ctx, const char *what, int ret) {
+  char errbuf[128];
+  av_strerror(ret, errbuf, sizeof(errbuf));
+  snprintf(ctx->job->error, sizeof(ctx->job->error), "%s: %s", what, errbuf);
+  return false;
+}
+
+/* avcC/hvcC中的NAL长度前缀; Annex B的附加数据(TS等)返回0 */
+static int nal_length_size(const AVCodecParameters *par) {
+  const uint8_t *extra = par->extradata;
+  if (!extra || extra[0] != 1)
+    return 0;
+  if (par->codec_id == AV_CODEC_ID_H264 && par->extradata_size >= 5)
+    return (extra[4] & 0x03) + 1;
+  if (par->codec_id == AV_CODEC_ID_HEVC && par->extradata_size >= 23)
+    return (extra[21] & 0x03) + 1;
+  return 0;
+}
+
+/* 取走pkt中的引用 */
+static bool packet_list_push(trim_context_t *ctx, packet_list_t *list,
+                             AVPacket *pkt) {
+  if (list->count == list->capacity) {
+    size_t capacity = list->capacity ? list->capacity * 2 : 64;
+    AVPacket **items = realloc(list->items, capacity * sizeof(AVPacket *));
+    if (!items)
+      return fail(ctx, "out of memory", AVERROR(ENOMEM));
+    list->items = items;
+    list->capacity = capacity;
+  }
+
+  AVPacket *item = av_packet_alloc();
+  if (!item)
+    return fail(ctx, "out of memory", AVERROR(ENOMEM));
+  av_packet_move_ref(item, pkt);
+  list->items[list->count++] = item;
+  return true;
+}
+
+static void packet_list_clear(packet_list_t *list) {
+  for (size_t i = 0; i < list->count; i++)
+    av_packet_free(&list->items[i]);
+  list->count = 0;
+}
+
+static void packet_list_free(packet_list_t *list) {
+  packet_list_clear(list);
+  free(list->items);
+  list->items = NULL;
+  list->capacity = 0;
+}
+
+/*
+ * 附加数据中的参数集(SPS/PPS/VPS), 按输出的打包方式写入buf
+ * avcC/hvcC转为长度前缀, Annex B附加数据原样复制
+ * 返回写入的字节数, buf为NULL时只计算长度
+ */
+static size_t parameter_sets(const AVCodecParameters *par, int length_size,
+                             uint8_t *buf) {
+  const uint8_t *extra = par->extradata;
+  size_t size = par->extradata_size > 0 ? (size_t)par->extradata_size : 0;
+  if (!length_size) {
+    if (buf && size)
+      memcpy(buf, extra, size);
+    return size;
+  }
+
+  /* avcC: SPS数组和PPS数组; hvcC: 22字节头之后为若干NAL数组 */
+  bool hevc = par->codec_id == AV_CODEC_ID_HEVC;
+  size_t p = hevc ? 22 : 5;
+  if (size <= p)
+    return 0;
+  unsigned arrays = hevc ? extra[p++] : 2;
+
+  size_t out = 0;
+  for (unsigned a = 0; a < arrays && p < size; a++) {
+    unsigned count;
+    if (hevc) {
+      if (p + 3 > size)
+        break;
+      count = ((unsigned)extra[p + 1] << 8) | extra[p + 2];
+      p += 3;
+    } else {
+      count = a == 0 ? (extra[p] & 0x1F) : extra[p];
+      p++;
+    }
+
+    for (unsigned i = 0; i < count && p + 2 <= size; i++) {
+      size_t nal_size = ((size_t)extra[p] << 8) | extra[p + 1];
+      p += 2;
+      if (nal_size > size - p)
+        return out;
+      if (buf) {
+        for (int b = 0; b < length_size; b++)
+          buf[out + (size_t)b] =
+              (uint8_t)(nal_size >> (8 * (length_size - 1 - b)));
+        memcpy(buf + out + length_size, extra + p, nal_size);
+      }
+      out += (size_t)length_size + nal_size;
+      p += nal_size;
+    }
+  }
+  return out;
+}
+
+/* ------------------------------------------------------------------------- */
+/* 输入/输出 */
+
+static bool open_input(trim_context_t *ctx) {
+  int ret = avformat_open_input(&ctx->ic, ctx->job->input, NULL, NULL);
+  if (ret < 0)
+    return fail(ctx, "cannot open input", ret);
+
+  ret = avformat_find_stream_info(ctx->ic, NULL);
+  if (ret < 0)
+    return fail(ctx, "cannot read stream info", ret);
+
+  ctx->video =
+      av_find_best_stream(ctx->ic, AVMEDIA_TYPE_VIDEO, -1, -1, NULL, 0);
+  if (ctx->video < 0)
+    return fail(ctx, "no video stream", ctx->video);
+
+  /* 扫描器的容器时间以视频流的第一个显示时间为零点 */
+  const AVStream *st = ctx->ic->streams[ctx->video];
+  ctx->first_pts = st->start_time != AV_NOPTS_VALUE ? st->start_time : 0;
+  ctx->start_pts = ctx->first_pts + av_rescale_q(ctx->job->start_us,
+                                                 AV_TIME_BASE_Q, st->time_base);
+  ctx->end_pts = ctx->first_pts + av_rescale_q(ctx->job->end_us,
+                                               AV_TIME_BASE_Q, st->time_base);
+  return true;
+}
+
+static bool is_mp4(const AVFormatContext *oc) {
+  const char *name = oc->oformat->name;
+  return strstr(name, "mp4") || strstr(name, "mov");
+}
+
+/* 只保留音视频; 所有流按同一绝对时间平移以保持音画同步 */
+static bool open_output(trim_context_t *ctx) {
+  int ret = avformat_alloc_output_context2(&ctx->oc, NULL, NULL,
+                                           ctx->job->output);
+  if (ret < 0)
+    return fail(ctx, "cannot create output", ret);
+
+  unsigned count = ctx->ic->nb_streams;
+  ctx->stream_map = calloc(count, sizeof(int));
+  ctx->offsets = calloc(count, sizeof(int64_t));
+  ctx->ends = calloc(count, sizeof(int64_t));
+  ctx->finished = calloc(count, sizeof(bool));
+  if (!ctx->stream_map || !ctx->offsets || !ctx->ends || !ctx->finished)
+    return fail(ctx, "cannot create output", AVERROR(ENOMEM));
+
+  AVRational video_tb = ctx->ic->streams[ctx->video]->time_base;
+  for (unsigned i = 0; i < count; i++) {
+    AVStream *in = ctx->ic->streams[i];
+    enum AVMediaType type = in->codecpar->codec_type;
+    ctx->stream_map[i] = -1;
+    if (type != AVMEDIA_TYPE_VIDEO && type != AVMEDIA_TYPE_AUDIO)
+      continue;
+    if (type == AVMEDIA_TYPE_VIDEO && (int)i != ctx->video)
+      continue;
+
+    AVStream *out = avformat_new_stream(ctx->oc, NULL);
+    if (!out)
+      return fail(ctx, "cannot create output stream", AVERROR(ENOMEM));
+    ret = avcodec_parameters_copy(out->codecpar, in->codecpar);
+    if (ret < 0)
+      return fail(ctx, "cannot copy codec parameters", ret);
+    out->codecpar->codec_tag = 0;
+
+    /* 重新编码的GOP带有自己的参数集, MP4中需要声明为带内参数集 */
+    if ((int)i == ctx->video && ctx->options->smart && is_mp4(ctx->oc)) {
+      if (in->codecpar->codec_id == AV_CODEC_ID_H264)
+        out->codecpar->codec_tag = MKTAG('a', 'v', 'c', '3');
+      else if (in->codecpar->codec_id == AV_CODEC_ID_HEVC)
+        out->codecpar->codec_tag = MKTAG('h', 'e', 'v', '1');
+    }
+    out->time_base = in->time_base;
+
+    ctx->stream_map[i] = out->index;
+    ctx->offsets[i] = av_rescale_q(ctx->start_pts, video_tb, in->time_base);
+    ctx->ends[i] = av_rescale_q(ctx->end_pts, video_tb, in->time_base);
+    ctx->open_streams++;
+  }
+
+  if (!(ctx->oc->oformat->flags & AVFMT_NOFILE)) {
+    ret = avio_open(&ctx->oc->pb, ctx->job->output, AVIO_FLAG_WRITE);
+    if (ret < 0)
+      return fail(ctx, "cannot write output", ret);
+  }
+
+  ret = avformat_write_header(ctx->oc, NULL);
+  if (ret < 0)
+    return fail(ctx, "cannot write header", ret);
+  return true;
+}
+
+/* 平移时间戳并写出; pkt的时间基为输入流的时间基 */
+static bool write_packet(trim_context_t *ctx, int input_index, AVPacket *pkt) {
+  AVStream *in = ctx->ic->streams[input_index];
+  int output_index = ctx->stream_map[input_index];
+  int64_t offset = ctx->offsets[input_index];
+
+  if (pkt->pts != AV_NOPTS_VALUE)
+    pkt->pts -= offset;
+  if (pkt->dts != AV_NOPTS_VALUE)
+    pkt->dts -= offset;
+  av_packet_rescale_ts(pkt, in->time_base,
+                       ctx->oc->streams[output_index]->time_base);
+  pkt->stream_index = output_index;
+  pkt->pos = -1;
+
+  int ret = av_interleaved_write_frame(ctx->oc, pkt);
+  if (ret < 0)
+    return fail(ctx, "write failed", ret);
+  ctx->job->copied_packets++;
+  return true;
+}
+
+static void finish_stream(trim_context_t *ctx, int input_index) {
+  if (!ctx->finished[input_index]) {
+    ctx->finished[input_index] = true;
+    ctx->open_streams--;
+  }
+}
+
+/* ------------------------------------------------------------------------- */
+/* 精确模式: 重新编码 */
+
+static bool open_decoder(trim_context_t *ctx) {
+  const AVStream *st = ctx->ic->streams[ctx->video];
+  const AVCodec *codec = avcodec_find_decoder(st->codecpar->codec_id);
+  if (!codec)
+    return fail(ctx, "no decoder", AVERROR_DECODER_NOT_FOUND);
+
+  ctx->dec = avcodec_alloc_context3(codec);
+  ctx->frame = av_frame_alloc();
+  ctx->enc_pkt = av_packet_alloc();
+  if (!ctx->dec || !ctx->frame || !ctx->enc_pkt)
+    return fail(ctx, "cannot create decoder", AVERROR(ENOMEM));
+
+  int ret = avcodec_parameters_to_context(ctx->dec, st->codecpar);
+  if (ret < 0)
+    return fail(ctx, "cannot configure decoder", ret);
+  ctx->dec->pkt_timebase = st->time_base;
+
+  ret = avcodec_open2(ctx->dec, codec, NULL);
+  if (ret < 0)
+    return fail(ctx, "cannot open decoder", ret);
+
+  ctx->length_size = nal_length_size(st->codecpar);
+  return true;
+}
+
+/*
+ * 编码器在第一帧解码后打开(需要实际的像素格式)
+ * 不使用全局头: 参数集随关键帧写在码流中, 与原始GOP的参数集互不影响
+ */
+static bool open_encoder(trim_context_t *ctx, const AVFrame *frame) {
+  const AVStream *st = ctx->ic->streams[ctx->video];
+  const AVCodec *codec =
+      ctx->options->encoder
+          ? avcodec_find_encoder_by_name(ctx->options->encoder)
+          : avcodec_find_encoder(st->codecpar->codec_id);
+  if (!codec)
+    return fail(ctx, "no encoder", AVERROR_ENCODER_NOT_FOUND);
+  /* 重新编码的GOP与后面复制的包必须是同一种编码 */
+  if (codec->id != st->codecpar->codec_id)
+    return fail(ctx, "encoder does not match the input codec",
+                AVERROR(EINVAL));
+
+  ctx->enc = avcodec_alloc_context3(codec);
+  if (!ctx->enc)
+    return fail(ctx, "cannot create encoder", AVERROR(ENOMEM));
+
+  ctx->enc->width = frame->width;
+  ctx->enc->height = frame->height;
+  ctx->enc->pix_fmt = (enum AVPixelFormat)frame->format;
+  ctx->enc->sample_aspect_ratio = frame->sample_aspect_ratio;
+  ctx->enc->color_range = frame->color_range;
+  ctx->enc->color_primaries = frame->color_primaries;
+  ctx->enc->color_trc = frame->color_trc;
+  ctx->enc->colorspace = frame->colorspace;
+  ctx->enc->time_base = st->time_base;
+  ctx->enc->framerate = st->avg_frame_rate;
+  /* 没有B帧: 编码顺序即显示顺序, dts可以直接由pts推出 */
+  ctx->enc->max_b_frames = 0;
+  ctx->enc->gop_size = 1 << 16; /* 整段只有开头一个关键帧 */
+  if (st->codecpar->bit_rate > 0)
+    ctx->enc->bit_rate = st->codecpar->bit_rate;
+
+  AVDictionary *opts = NULL;
+  av_dict_set_int(&opts, "crf", ctx->options->crf, 0);
+  int ret = avcodec_open2(ctx->enc, codec, &opts);
+  av_dict_free(&opts);
+  if (ret < 0)
+    return fail(ctx, "cannot open encoder", ret);
+  return true;
+}
+
+/* Annex B -> 长度前缀 */
+static size_t annexb_to_length_prefixed(const uint8_t *src, size_t size,
+                                        int length_size, uint8_t *dst) {
+  size_t out = 0, i = 0;
+  while (i + 3 <= size) {
+    /* 定位起始码 */
+    if (!(src[i] == 0 && src[i + 1] == 0 && src[i + 2] == 1)) {
+      i++;
+      continue;
+    }
+    size_t nal = i + 3;
+    size_t end = nal;
+    while (end + 3 <= size &&
+           !(src[end] == 0 && src[end + 1] == 0 && src[end + 2] <= 1))
+      end++;
+    if (end + 3 > size)
+      end = size;
+
+    /* 去掉下一个起始码之前的尾随零(4字节起始码的首字节) */
+    size_t nal_end = end;
+    while (nal_end > nal && src[nal_end - 1] == 0)
+      nal_end--;
+
+    size_t nal_size = nal_end - nal;
+    for (int b = length_size - 1; b >= 0; b--)
+      dst[out++] = (uint8_t)(nal_size >> (8 * b));
+    memcpy(dst + out, src + nal, nal_size);
+    out += nal_size;
+    i = end;
+  }
+  return out;
+}
+
+/* 首帧前插入时间戳SEI; MP4等输出转换为长度前缀格式 */
+static bool rewrite_encoded(trim_context_t *ctx, AVPacket *pkt) {
+  uint8_t *sei = NULL;
+  size_t sei_size = 0;
+  if (ctx->sei_pending) {
+    /* 首帧可能比起点晚不到一帧 */
+    AVRational tb = ctx->ic->streams[ctx->video]->time_base;
+    int64_t offset_ns = av_rescale_q(pkt->pts - ctx->start_pts, tb,
+                                     (AVRational){1, 1000000000});
+    seistamp_ntp_time_t ntp;
+    seistamp_ntp_from_ns(ctx->job->start_ntp_ns + (uint64_t)offset_ns, &ntp);
+    seistamp_codec_t codec = ctx->enc->codec_id == AV_CODEC_ID_HEVC
+                                 ? SEISTAMP_CODEC_H265
+                                 : SEISTAMP_CODEC_H264;
+    sei = seistamp_build_sei_nal(pkt->pts, &ntp, codec, &sei_size);
+    ctx->sei_pending = false;
+  }
+
+  if (!sei && !ctx->length_size)
+    return true;
+
+  size_t annexb_size = sei_size + (size_t)pkt->size;
+  uint8_t *annexb = malloc(annexb_size);
+  if (!annexb) {
+    seistamp_free(sei);
+    return fail(ctx, "cannot rewrite packet", AVERROR(ENOMEM));
+  }
+  if (sei)
+    memcpy(annexb, sei, sei_size);
+  memcpy(annexb + sei_size, pkt->data, (size_t)pkt->size);
+  seistamp_free(sei);
+
+  /* 3字节起始码换成4字节长度时每个NAL最多多1字节 */
+  AVPacket *out = av_packet_alloc();
+  int ret = out ? av_new_packet(out, (int)(annexb_size + annexb_size / 3 + 4))
+                : AVERROR(ENOMEM);
+  if (ret < 0) {
+    free(annexb);
+    av_packet_free(&out);
+    return fail(ctx, "cannot rewrite packet", ret);
+  }
+
+  if (ctx->length_size) {
+    out->size = (int)annexb_to_length_prefixed(annexb, annexb_size,
+                                               ctx->length_size, out->data);
+  } else {
+    memcpy(out->data, annexb, annexb_size);
+    out->size = (int)annexb_size;
+  }
+  free(annexb);
+
+  av_packet_copy_props(out, pkt);
+  av_packet_unref(pkt);
+  av_packet_move_ref(pkt, out);
+  av_packet_free(&out);
+  return true;
+}
+
+static bool drain_encoder(trim_context_t *ctx) {
+  for (;;) {
+    int ret = avcodec_receive_packet(ctx->enc, ctx->enc_pkt);
+    if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
+      return true;
+    if (ret < 0)
+      return fail(ctx, "encode failed", ret);
+
+    AVPacket *pkt = ctx->enc_pkt;
+    if (!rewrite_encoded(ctx, pkt) ||
+        !packet_list_push(ctx, &ctx->encoded, pkt)) {
+      av_packet_unref(pkt);
+      return false;
+    }
+  }
+}
+
+static bool encode_frame(trim_context_t *ctx, AVFrame *frame) {
+  if (frame) {
+    if (!ctx->enc && !open_encoder(ctx, frame))
+      return false;
+    frame->pict_type = AV_PICTURE_TYPE_NONE;
+    ctx->job->encoded_frames++;
+  } else if (!ctx->enc) {
+    return true;
+  }
+
+  int ret = avcodec_send_frame(ctx->enc, frame);
+  if (ret < 0 && ret != AVERROR_EOF)
+    return fail(ctx, "encode failed", ret);
+  return drain_encoder(ctx);
+}
+
+static bool drain_decoder(trim_context_t *ctx) {
+  for (;;) {
+    int ret = avcodec_receive_frame(ctx->dec, ctx->frame);
+    if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
+      return true;
+    if (ret < 0)
+      return fail(ctx, "decode failed", ret);
+
+    /* 只保留起点到下一个关键帧(或终点)之间的帧 */
+    int64_t pts = ctx->frame->best_effort_timestamp;
+    int64_t limit = ctx->end_pts;
+    if (ctx->resume_pkt && ctx->resume_pkt->pts < limit)
+      limit = ctx->resume_pkt->pts;
+    bool keep = pts != AV_NOPTS_VALUE && pts >= ctx->start_pts && pts < limit;
+    if (keep) {
+      ctx->frame->pts = pts;
+      if (!encode_frame(ctx, ctx->frame)) {
+        av_frame_unref(ctx->frame);
+        return false;
+      }
+    }
+    av_frame_unref(ctx->frame);
+  }
+}
+
+static bool decode_packet(trim_context_t *ctx, const AVPacket *pkt) {
+  int ret = avcodec_send_packet(ctx->dec, pkt);
+  if (ret < 0 && ret != AVERROR_EOF)
+    return fail(ctx, "decode failed", ret);
+  return drain_decoder(ctx);
+}
+
+/* 恢复复制的关键帧前重复原始参数集, 否则解码器沿用重新编码段的参数集 */
+static bool restore_parameter_sets(trim_context_t *ctx, AVPacket *pkt) {
+  const AVCodecParameters *par = ctx->ic->streams[ctx->video]->codecpar;
+  size_t size = parameter_sets(par, ctx->length_size, NULL);
+  if (size == 0)
+    return true;
+
+  AVPacket *out = av_packet_alloc();
+  int ret = out ? av_new_packet(out, (int)(size + (size_t)pkt->size))
+                : AVERROR(ENOMEM);
+  if (ret < 0) {
+    av_packet_free(&out);
+    return fail(ctx, "cannot rewrite packet", ret);
+  }
+  parameter_sets(par, ctx->length_size, out->data);
+  memcpy(out->data + size, pkt->data, (size_t)pkt->size);
+
+  av_packet_copy_props(out, pkt);
+  av_packet_unref(pkt);
+  av_packet_move_ref(pkt, out);
+  av_packet_free(&out);
+  return true;
+}
+
+/*
+ * 冲刷解码器和编码器并写出重新编码的帧, 之后恢复复制
+ * 所有重新编码的帧按同一偏移设置dts: 不晚于pts, 且早于下一个关键帧的dts
+ */
+static bool finish_reencode(trim_context_t *ctx) {
+  ctx->reencoding = false;
+  if (!decode_packet(ctx, NULL) || !encode_frame(ctx, NULL))
+    return false;
+
+  int64_t shift = ctx->reorder_delay > 0 ? ctx->reorder_delay : 0;
+  if (ctx->resume_pkt && ctx->encoded.count) {
+    int64_t last = ctx->encoded.items[ctx->encoded.count - 1]->pts;
+    if (ctx->resume_pkt->dts != AV_NOPTS_VALUE &&
+        last - shift >= ctx->resume_pkt->dts)
+      shift = last - ctx->resume_pkt->dts + 1;
+  }
+
+  for (size_t i = 0; i < ctx->encoded.count; i++) {
+    AVPacket *pkt = ctx->encoded.items[i];
+    pkt->dts = pkt->pts - shift;
+    if (!write_packet(ctx, ctx->video, pkt))
+      return false;
+  }
+  packet_list_clear(&ctx->encoded);
+
+  if (!ctx->resume_pkt)
+    return true;
+  bool ok = restore_parameter_sets(ctx, ctx->resume_pkt) &&
+            write_packet(ctx, ctx->video, ctx->resume_pkt);
+  av_packet_free(&ctx->resume_pkt);
+  return ok;
+}
+
+static bool reencode_packet(trim_context_t *ctx, AVPacket *pkt) {
+  bool key = pkt->flags & AV_PKT_FLAG_KEY;
+
+  if (ctx->resume_pkt) {
+    /* 开放GOP: 解码顺序在关键帧之后、显示在其之前的前导帧 */
+    if (pkt->pts != AV_NOPTS_VALUE && pkt->pts < ctx->resume_pkt->pts)
+      return decode_packet(ctx, pkt);
+    return finish_reencode(ctx) && write_packet(ctx, ctx->video, pkt);
+  }
+
+  /* 起点之后的第一个关键帧原样复制, 但前导帧需要以它为参考解码 */
+  if (key && pkt->pts != AV_NOPTS_VALUE && pkt->pts > ctx->start_pts) {
+    ctx->resume_pkt = av_packet_clone(pkt);
+    if (!ctx->resume_pkt)
+      return fail(ctx, "out of memory", AVERROR(ENOMEM));
+  }
+  return decode_packet(ctx, pkt);
+}
+
+/* 起点之前的包已确定: 复制, 或在精确模式下送入解码器 */
+static bool end_preroll(trim_context_t *ctx) {
+  ctx->in_preroll = false;
+  if (ctx->preroll.count == 0)
+    return true;
+
+  const AVPacket *key = ctx->preroll.items[0];
+  AVRational tb = ctx->ic->streams[ctx->video]->time_base;
+  ctx->job->lead_us =
+      av_rescale_q(ctx->start_pts - key->pts, tb, AV_TIME_BASE_Q);
+
+  if (ctx->options->smart && key->pts < ctx->start_pts) {
+    if (!open_decoder(ctx))
+      return false;
+    ctx->reencoding = true;
+    ctx->sei_pending = ctx->job->start_ntp_ns != 0;
+    ctx->reorder_delay =
+        key->dts != AV_NOPTS_VALUE ? key->pts - key->dts : 0;
+    ctx->job->lead_us = 0;
+  }
+
+  bool ok = true;
+  for (size_t i = 0; ok && i < ctx->preroll.count; i++) {
+    AVPacket *pkt = ctx->preroll.items[i];
+    ok = ctx->reencoding ? reencode_packet(ctx, pkt)
+                         : write_packet(ctx, ctx->video, pkt);
+  }
+  packet_list_clear(&ctx->preroll);
+  return ok;
+}
+
+/* 视频到达终点或文件结束 */
+static bool end_video(trim_context_t *ctx) {
+  if (ctx->in_preroll && !end_preroll(ctx))
+    return false;
+  return !ctx->reencoding || finish_reencode(ctx);
+}
+
+/* ------------------------------------------------------------------------- */
+/* 主循环 */
+
+/* seek到起点之前的关键帧, 成功时pkt中为该关键帧 */
+static bool seek_keyframe(trim_context_t *ctx) {
+  const AVStream *st = ctx->ic->streams[ctx->video];
+  size_t attempts = sizeof(seek_backoff_s) / sizeof(seek_backoff_s[0]);
+
+  for (size_t attempt = 0; attempt <= attempts; attempt++) {
+    int ret;
+    if (attempt < attempts) {
+      int64_t backoff = av_rescale_q(seek_backoff_s[attempt] * AV_TIME_BASE,
+                                     AV_TIME_BASE_Q, st->time_base);
+      ret = av_seek_frame(ctx->ic, ctx->video, ctx->start_pts - backoff,
+                          AVSEEK_FLAG_BACKWARD);
+    } else {
+      /* TS按时间seek不精确, 可能越过第一个关键帧; 从头读时按字节seek */
+      ret = av_seek_frame(ctx->ic, -1, 0, AVSEEK_FLAG_BYTE);
+      if (ret < 0)
+        ret = av_seek_frame(ctx->ic, ctx->video, ctx->first_pts,
+                            AVSEEK_FLAG_BACKWARD);
+    }
+    if (ret < 0)
+      continue;
+
+    while ((ret = av_read_frame(ctx->ic, ctx->pkt)) >= 0) {
+      if (ctx->pkt->stream_index == ctx->video &&
+          (ctx->pkt->flags & AV_PKT_FLAG_KEY) &&
+          ctx->pkt->pts != AV_NOPTS_VALUE)
+        break;
+      av_packet_unref(ctx->pkt);
+    }
+    if (ret < 0)
+      continue;
+
+    /* 最后一次尝试从头开始, 再早也没有关键帧 */
+    if (ctx->pkt->pts <= ctx->start_pts || attempt == attempts)
+      return true;
+    av_packet_unref(ctx->pkt);
+  }
+  return fail(ctx, "no keyframe before the start", AVERROR_INVALIDDATA);
+}
+
+static bool handle_video(trim_context_t *ctx, AVPacket *pkt) {
+  int64_t dts = pkt->dts != AV_NOPTS_VALUE ? pkt->dts : pkt->pts;
+
+  /* 按解码顺序在终点处停止, 保留终点前显示的帧的参考帧 */
+  if (dts != AV_NOPTS_VALUE && dts >= ctx->end_pts) {
+    finish_stream(ctx, ctx->video);
+    return end_video(ctx);
+  }
+
+  /*
+   * seek可能落在更早的GOP: 缓存到解码时间越过起点为止,
+   * 遇到不晚于起点的关键帧就丢弃之前缓存的包
+   */
+  if (ctx->in_preroll) {
+    if (dts == AV_NOPTS_VALUE || dts <= ctx->start_pts) {
+      if ((pkt->flags & AV_PKT_FLAG_KEY) && pkt->pts != AV_NOPTS_VALUE &&
+          pkt->pts <= ctx->start_pts)
+        packet_list_clear(&ctx->preroll);
+      return packet_list_push(ctx, &ctx->preroll, pkt);
+    }
+    if (!end_preroll(ctx))
+      return false;
+  }
+
+  if (ctx->reencoding)
+    return reencode_packet(ctx, pkt);
+  return write_packet(ctx, ctx->video, pkt);
+}
+
+static bool handle_other(trim_context_t *ctx, AVPacket *pkt) {
+  int index = pkt->stream_index;
+  if (pkt->pts == AV_NOPTS_VALUE)
+    return true;
+
+  if (pkt->pts >= ctx->ends[index]) {
+    finish_stream(ctx, index);
+    return true;
+  }
+  /* 音频从起点开始, 不随视频的前导帧提前 */
+  if (pkt->pts + pkt->duration <= ctx->offsets[index])
+    return true;
+  return write_packet(ctx, index, pkt);
+}
+
+static bool process(trim_context_t *ctx, AVPacket *pkt) {
+  int index = pkt->stream_index;
+  if (index < 0 || (unsigned)index >= ctx->ic->nb_streams ||
+      ctx->stream_map[index] < 0 || ctx->finished[index])
+    return true;
+  return index == ctx->video ? handle_video(ctx, pkt)
+                             : handle_other(ctx, pkt);
+}
+
+static bool run(trim_context_t *ctx) {
+  if (!open_input(ctx) || !open_output(ctx))
+    return false;
+
+  ctx->pkt = av_packet_alloc();
+  if (!ctx->pkt)
+    return fail(ctx, "out of memory", AVERROR(ENOMEM));
+  if (!seek_keyframe(ctx))
+    return false;
+
+  ctx->in_preroll = true;
+  bool ok = process(ctx, ctx->pkt);
+  av_packet_unref(ctx->pkt);
+
+  int ret = 0;
+  while (ok && ctx->open_streams > 0 &&
+         (ret = av_read_frame(ctx->ic, ctx->pkt)) >= 0) {
+    ok = process(ctx, ctx->pkt);
+    av_packet_unref(ctx->pkt);
+  }
+  if (!ok)
+    return false;
+  if (ret < 0 && ret != AVERROR_EOF)
+    return fail(ctx, "read failed", ret);
+
+  /* 文件在起点附近或第一个GOP内结束 */
+  if (!end_video(ctx))
+    return false;
+
+  ret = av_write_trailer(ctx->oc);
+  if (ret < 0)
+    return fail(ctx, "cannot finish output", ret);
+  return true;
+}
+
+bool trim_file(trim_job_t *job, const trim_options_t *options) {
+  trim_context_t ctx = {.job = job, .options = options};
+  job->error[0] = '\0';
+
+  bool ok = run(&ctx);
+
+  avcodec_free_context(&ctx.dec);
+  avcodec_free_context(&ctx.enc);
+  av_frame_free(&ctx.frame);
+  av_packet_free(&ctx.enc_pkt);
+  av_packet_free(&ctx.resume_pkt);
+  av_packet_free(&ctx.pkt);
+  packet_list_free(&ctx.preroll);
+  packet_list_free(&ctx.encoded);
+  if (ctx.oc) {
+    if (!(ctx.oc->oformat->flags & AVFMT_NOFILE))
+      avio_closep(&ctx.oc->pb);
+    avformat_free_context(ctx.oc);
+  }
+  avformat_close_input(&ctx.ic);
+  free(ctx.stream_map);
+  free(ctx.offsets);
+  free(ctx.ends);
+  free(ctx.finished);
+  return ok;
+}
@@ -0,0 +1,51 @@
+/******************************************************************************
+    Stamp Aligner - Trimming
+    Copyright (C) 2026
+
+    Cuts one recording to a container time range with libavformat. Packets
+    are stream-copied; the cut snaps to the keyframe at or before the start,
+    or in smart mode only the frames of the first GOP from the start onwards
+    are re-encoded so the output begins exactly at the requested frame.
+******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct trim_options {
+  bool smart;          /* 重新编码第一个GOP, 精确到帧 */
+  const char *encoder; /* 重新编码使用的编码器, NULL按输入编码选择 */
+  int crf;             /* 重新编码的质量(libx264/libx265) */
+} trim_options_t;
+
+typedef struct trim_job {
+  const char *input;
+  const char *output; /* 容器格式按扩展名选择 */
+
+  /* 容器时间(微秒, 相对视频流起点), 与stream_scan_t中的time_us一致 */
+  int64_t start_us;
+  int64_t end_us;
+  uint64_t start_ntp_ns; /* 写入重新编码首帧的时间戳SEI */
+
+  /* 结果 */
+  int64_t lead_us; /* 输出中位于起点之前的画面(关键帧模式) */
+  uint64_t copied_packets;
+  uint64_t encoded_frames;
+  char error[160];
+} trim_job_t;
+
+/*
+ * 剪切一个文件; 输出的时间零点对应start_us
+ * 返回:
+ *   false - 失败, 原因见job->error
+ */
+bool trim_file(trim_job_t *job, const trim_options_t *options);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,542 @@
+/******************************************************************************
+    Stamp Analyzer - MP4 Scanner
+    Copyright (C) 2026
+
+    Walks the video track of an MP4/MOV file through its sample tables
+    (stsz/stco/stsc/stts/ctts) or, for fragmented files, through moof/trun.
+    Only the NAL units in front of the first slice of each sample are read.
+******************************************************************************/
+
+#include "stream-scan.h"
+#include <stdio.h>
+#include <string.h>
+
+#define FOURCC(a, b, c, d)                                                     \
+  (((uint32_t)(a) << 24) | ((uint32_t)(b) << 16) | ((uint32_t)(c) << 8) |     \
+   (uint32_t)(d))
+
+/* VisualSampleEntry中子box之前的字段长度 */
+#define VISUAL_SAMPLE_ENTRY_SIZE 78
+
+typedef struct mp4_slice {
+  const uint8_t *data;
+  size_t size;
+} mp4_slice_t;
+
+typedef struct mp4_track {
+  uint32_t track_id;
+  uint32_t timescale;
+  seistamp_codec_t codec;
+  int length_size; /* NAL长度前缀字节数 */
+  /* 时间零点: 编辑列表的media_time, 没有编辑列表时取第一帧的显示时间,
+   * 与TS扫描器以第一个PTS为零点一致 */
+  int64_t media_time;
+  bool has_media_time;
+
+  mp4_slice_t stts, ctts, stsc, stsz, stco;
+  bool co64;
+
+  uint32_t default_duration; /* trex */
+  uint32_t default_size;
+} mp4_track_t;
+
+static inline uint32_t rb32(const uint8_t *p) {
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+         ((uint32_t)p[2] << 8) | p[3];
+}
+
+static inline uint64_t rb64(const uint8_t *p) {
+  return ((uint64_t)rb32(p) << 32) | rb32(p + 4);
+}
+
+/* 读取box头; 返回false表示数据不完整 */
+static bool read_box(const uint8_t *data, size_t size, size_t offset,
+                     uint32_t *type, mp4_slice_t *payload, size_t *next) {
+  if (offset + 8 > size)
+    return false;
+
+  uint64_t box_size = rb32(data + offset);
+  size_t header = 8;
+  *type = rb32(data + offset + 4);
+
+  if (box_size == 1) {
+    if (offset + 16 > size)
+      return false;
+    box_size = rb64(data + offset + 8);
+    header = 16;
+  } else if (box_size == 0) {
+    box_size = size - offset;
+  }
+
+  if (box_size < header || box_size > size - offset)
+    return false;
+
+  payload->data = data + offset + header;
+  payload->size = (size_t)box_size - header;
+  *next = offset + (size_t)box_size;
+  return true;
+}
+
+/* 未找到时不修改out */
+static bool find_box(mp4_slice_t parent, uint32_t type, mp4_slice_t *out) {
+  size_t offset = 0;
+  while (offset < parent.size) {
+    uint32_t box_type;
+    mp4_slice_t payload;
+    size_t next;
+    if (!read_box(parent.data, parent.size, offset, &box_type, &payload,
+                  &next))
+      return false;
+    if (box_type == type) {
+      *out = payload;
+      return true;
+    }
+    offset = next;
+  }
+  return false;
+}
+
+/* 解析stsd的第一个条目: 编码和NAL长度前缀 */
+static bool parse_sample_entry(mp4_slice_t stsd, mp4_track_t *track,
+                               char *error, size_t error_size) {
+  /* version/flags(4) + entry_count(4) */
+  if (stsd.size < 16) {
+    snprintf(error, error_size, "truncated stsd");
+    return false;
+  }
+
+  mp4_slice_t entry;
+  uint32_t format;
+  size_t next;
+  if (!read_box(stsd.data + 8, stsd.size - 8, 0, &format, &entry, &next))
+    return false;
+
+  uint32_t config_type;
+  if (format == FOURCC('a', 'v', 'c', '1') ||
+      format == FOURCC('a', 'v', 'c', '3')) {
+    track->codec = SEISTAMP_CODEC_H264;
+    config_type = FOURCC('a', 'v', 'c', 'C');
+  } else if (format == FOURCC('h', 'v', 'c', '1') ||
+             format == FOURCC('h', 'e', 'v', '1')) {
+    track->codec = SEISTAMP_CODEC_H265;
+    config_type = FOURCC('h', 'v', 'c', 'C');
+  } else {
+    snprintf(error, error_size, "unsupported video codec '%c%c%c%c'",
+             (char)(format >> 24), (char)(format >> 16), (char)(format >> 8),
+             (char)format);
+    return false;
+  }
+
+  if (entry.size < VISUAL_SAMPLE_ENTRY_SIZE)
+    return false;
+  mp4_slice_t children = {entry.data + VISUAL_SAMPLE_ENTRY_SIZE,
+                          entry.size - VISUAL_SAMPLE_ENTRY_SIZE};
+  mp4_slice_t config;
+  if (!find_box(children, config_type, &config)) {
+    snprintf(error, error_size, "missing decoder configuration");
+    return false;
+  }
+
+  /* avcC: lengthSizeMinusOne在第5字节; hvcC在第22字节 */
+  size_t index = track->codec == SEISTAMP_CODEC_H265 ? 21 : 4;
+  if (config.size <= index)
+    return false;
+  track->length_size = (config.data[index] & 0x03) + 1;
+  return true;
+}
+
+/* 编辑列表中第一个非空条目的media_time; 空条目(-1)只是延迟播放, 忽略 */
+static bool read_media_time(mp4_slice_t trak, int64_t *media_time_out) {
+  mp4_slice_t edts, elst;
+  if (!find_box(trak, FOURCC('e', 'd', 't', 's'), &edts) ||
+      !find_box(edts, FOURCC('e', 'l', 's', 't'), &elst) || elst.size < 8)
+    return false;
+
+  bool v1 = elst.data[0] == 1;
+  size_t entry_size = v1 ? 20 : 12;
+  uint32_t count = rb32(elst.data + 4);
+  for (uint32_t i = 0; i < count; i++) {
+    const uint8_t *entry = elst.data + 8 + (size_t)i * entry_size;
+    if ((size_t)(entry - elst.data) + entry_size > elst.size)
+      break;
+    int64_t media_time =
+        v1 ? (int64_t)rb64(entry + 8) : (int64_t)(int32_t)rb32(entry + 4);
+    if (media_time >= 0) {
+      *media_time_out = media_time;
+      return true;
+    }
+  }
+  return false;
+}
+
+/* 在moov中查找第一条视频轨道 */
+static bool find_video_track(mp4_slice_t moov, mp4_track_t *track,
+                             char *error, size_t error_size) {
+  size_t offset = 0;
+  while (offset < moov.size) {
+    uint32_t type;
+    mp4_slice_t trak, mdia, hdlr, mdhd, tkhd, minf, stbl, stsd;
+    size_t next;
+    if (!read_box(moov.data, moov.size, offset, &type, &trak, &next))
+      break;
+    offset = next;
+
+    if (type != FOURCC('t', 'r', 'a', 'k') ||
+        !find_box(trak, FOURCC('m', 'd', 'i', 'a'), &mdia) ||
+        !find_box(mdia, FOURCC('h', 'd', 'l', 'r'), &hdlr) ||
+        hdlr.size < 12 || rb32(hdlr.data + 8) != FOURCC('v', 'i', 'd', 'e'))
+      continue;
+
+    if (!find_box(trak, FOURCC('t', 'k', 'h', 'd'), &tkhd) ||
+        !find_box(mdia, FOURCC('m', 'd', 'h', 'd'), &mdhd) ||
+        !find_box(mdia, FOURCC('m', 'i', 'n', 'f'), &minf) ||
+        !find_box(minf, FOURCC('s', 't', 'b', 'l'), &stbl) ||
+        !find_box(stbl, FOURCC('s', 't', 's', 'd'), &stsd))
+      continue;
+
+    /* version 1 使用64位时间字段 */
+    bool v1 = tkhd.size > 0 && tkhd.data[0] == 1;
+    if (tkhd.size < (v1 ? 24u : 16u))
+      continue;
+    track->track_id = rb32(tkhd.data + (v1 ? 20 : 12));
+
+    v1 = mdhd.size > 0 && mdhd.data[0] == 1;
+    if (mdhd.size < (v1 ? 24u : 16u))
+      continue;
+    track->timescale = rb32(mdhd.data + (v1 ? 20 : 12));
+    track->has_media_time = read_media_time(trak, &track->media_time);
+
+    if (!parse_sample_entry(stsd, track, error, error_size))
+      return false;
+
+    find_box(stbl, FOURCC('s', 't', 't', 's'), &track->stts);
+    find_box(stbl, FOURCC('c', 't', 't', 's'), &track->ctts);
+    find_box(stbl, FOURCC('s', 't', 's', 'c'), &track->stsc);
+    find_box(stbl, FOURCC('s', 't', 's', 'z'), &track->stsz);
+    if (!find_box(stbl, FOURCC('s', 't', 'c', 'o'), &track->stco))
+      track->co64 = find_box(stbl, FOURCC('c', 'o', '6', '4'), &track->stco);
+    return track->timescale != 0;
+  }
+
+  snprintf(error, error_size, "no video track");
+  return false;
+}
+
+/* 分片MP4的默认值 (moov/mvex/trex) */
+static void read_trex(mp4_slice_t moov, mp4_track_t *track) {
+  mp4_slice_t mvex, trex;
+  if (!find_box(moov, FOURCC('m', 'v', 'e', 'x'), &mvex))
+    return;
+
+  size_t offset = 0;
+  while (offset < mvex.size) {
+    uint32_t type;
+    size_t next;
+    if (!read_box(mvex.data, mvex.size, offset, &type, &trex, &next))
+      return;
+    offset = next;
+    if (type == FOURCC('t', 'r', 'e', 'x') && trex.size >= 24 &&
+        rb32(trex.data + 4) == track->track_id) {
+      track->default_duration = rb32(trex.data + 12);
+      track->default_size = rb32(trex.data + 16);
+      return;
+    }
+  }
+}
+
+/* 样本显示时间(媒体时间刻度) -> 相对零点的PTS(媒体时间刻度) */
+static int64_t sample_pts(mp4_track_t *track, int64_t composition) {
+  if (!track->has_media_time) {
+    track->media_time = composition;
+    track->has_media_time = true;
+  }
+  return composition - track->media_time;
+}
+
+static bool scan_sample(const uint8_t *data, size_t size, uint64_t offset,
+                        uint32_t sample_size, int64_t pts,
+                        const mp4_track_t *track, stream_scan_t *scan) {
+  uint64_t frame = scan->frames++;
+  int64_t time_us = pts * 1000000 / (int64_t)track->timescale;
+  scan->duration_us = time_us;
+
+  if (offset > size || sample_size > size - offset)
+    return true;
+
+  seistamp_stamp_t stamp;
+  bool keyframe = false;
+  if (!stream_scan_length_prefixed(data + offset, sample_size,
+                                   track->length_size, track->codec, &stamp,
+                                   &keyframe))
+    return true;
+
+  stamp_record_t *record = stream_scan_add_stamp(scan, frame, time_us, &stamp);
+  if (!record)
+    return false;
+  record->stream_pts = pts;
+  record->offset = offset;
+  record->keyframe = keyframe;
+  return true;
+}
+
+/* ------------------------------------------------------------------------- */
+/* 非分片: 按样本表遍历 */
+
+typedef struct run_iter {
+  mp4_slice_t table; /* stts/ctts: entry_count后为(count, value)对 */
+  uint32_t entries;
+  uint32_t index;
+  uint32_t remaining;
+  uint32_t value;
+} run_iter_t;
+
+static void run_iter_init(run_iter_t *it, mp4_slice_t table) {
+  memset(it, 0, sizeof(*it));
+  if (table.size >= 8) {
+    it->table = table;
+    it->entries = rb32(table.data + 4);
+    if ((uint64_t)it->entries * 8 > table.size - 8)
+      it->entries = (uint32_t)((table.size - 8) / 8);
+  }
+}
+
+static uint32_t run_iter_next(run_iter_t *it) {
+  while (it->remaining == 0) {
+    if (it->index >= it->entries)
+      return it->value;
+    const uint8_t *entry = it->table.data + 8 + (size_t)it->index++ * 8;
+    it->remaining = rb32(entry);
+    it->value = rb32(entry + 4);
+  }
+  it->remaining--;
+  return it->value;
+}
+
+static bool scan_sample_tables(const uint8_t *data, size_t size,
+                               mp4_track_t *track, stream_scan_t *scan) {
+  const mp4_slice_t *stsz = &track->stsz;
+  const mp4_slice_t *stco = &track->stco;
+  const mp4_slice_t *stsc = &track->stsc;
+
+  uint32_t fixed_size = rb32(stsz->data + 4);
+  uint32_t sample_count = rb32(stsz->data + 8);
+  if (!fixed_size && (uint64_t)sample_count * 4 > stsz->size - 12)
+    sample_count = (uint32_t)((stsz->size - 12) / 4);
+
+  size_t entry_size = track->co64 ? 8 : 4;
+  uint32_t chunk_count = stco->size >= 8 ? rb32(stco->data + 4) : 0;
+  if ((uint64_t)chunk_count * entry_size > stco->size - 8)
+    chunk_count = (uint32_t)((stco->size - 8) / entry_size);
+
+  uint32_t stsc_count = stsc->size >= 8 ? rb32(stsc->data + 4) : 0;
+  if ((uint64_t)stsc_count * 12 > stsc->size - 8)
+    stsc_count = (uint32_t)((stsc->size - 8) / 12);
+
+  run_iter_t stts, ctts;
+  run_iter_init(&stts, track->stts);
+  run_iter_init(&ctts, track->ctts);
+
+  uint32_t sample = 0;
+  int64_t dts = 0;
+  uint32_t stsc_index = 0;
+  uint32_t samples_per_chunk = 0;
+
+  for (uint32_t chunk = 1; chunk <= chunk_count && sample < sample_count;
+       chunk++) {
+    /* stsc: (first_chunk, samples_per_chunk, sample_description_index) */
+    while (stsc_index < stsc_count &&
+           rb32(stsc->data + 8 + (size_t)stsc_index * 12) <= chunk) {
+      samples_per_chunk = rb32(stsc->data + 8 + (size_t)stsc_index * 12 + 4);
+      stsc_index++;
+    }
+
+    const uint8_t *entry = stco->data + 8 + (size_t)(chunk - 1) * entry_size;
+    uint64_t offset = track->co64 ? rb64(entry) : rb32(entry);
+
+    for (uint32_t i = 0; i < samples_per_chunk && sample < sample_count;
+         i++, sample++) {
+      uint32_t sample_size =
+          fixed_size ? fixed_size : rb32(stsz->data + 12 + (size_t)sample * 4);
+      int32_t cto = (int32_t)run_iter_next(&ctts);
+      int64_t pts = sample_pts(track, dts + cto);
+
+      if (!scan_sample(data, size, offset, sample_size, pts, track, scan))
+        return false;
+
+      offset += sample_size;
+      dts += run_iter_next(&stts);
+    }
+  }
+  return true;
+}
+
+/* ------------------------------------------------------------------------- */
+/* 分片: moof/traf/trun */
+
+/* tfhd flags */
+#define TFHD_BASE_DATA_OFFSET 0x000001
+#define TFHD_SAMPLE_DESCRIPTION 0x000002
+#define TFHD_DEFAULT_DURATION 0x000008
+#define TFHD_DEFAULT_SIZE 0x000010
+#define TFHD_DEFAULT_FLAGS 0x000020
+
+/* trun flags */
+#define TRUN_DATA_OFFSET 0x000001
+#define TRUN_FIRST_SAMPLE_FLAGS 0x000004
+#define TRUN_DURATION 0x000100
+#define TRUN_SIZE 0x000200
+#define TRUN_FLAGS 0x000400
+#define TRUN_CTO 0x000800
+
+static bool scan_traf(const uint8_t *data, size_t size, size_t moof_offset,
+                      mp4_slice_t traf, mp4_track_t *track,
+                      int64_t *decode_time, stream_scan_t *scan) {
+  mp4_slice_t tfhd, tfdt;
+  if (!find_box(traf, FOURCC('t', 'f', 'h', 'd'), &tfhd) || tfhd.size < 8 ||
+      rb32(tfhd.data + 4) != track->track_id)
+    return true;
+
+  uint32_t flags = rb32(tfhd.data) & 0xFFFFFF;
+  size_t p = 8;
+  uint64_t base = moof_offset;
+  uint32_t default_duration = track->default_duration;
+  uint32_t default_size = track->default_size;
+
+  if ((flags & TFHD_BASE_DATA_OFFSET) && p + 8 <= tfhd.size) {
+    base = rb64(tfhd.data + p);
+    p += 8;
+  }
+  if (flags & TFHD_SAMPLE_DESCRIPTION)
+    p += 4;
+  if ((flags & TFHD_DEFAULT_DURATION) && p + 4 <= tfhd.size) {
+    default_duration = rb32(tfhd.data + p);
+    p += 4;
+  }
+  if ((flags & TFHD_DEFAULT_SIZE) && p + 4 <= tfhd.size)
+    default_size = rb32(tfhd.data + p);
+
+  if (find_box(traf, FOURCC('t', 'f', 'd', 't'), &tfdt) && tfdt.size >= 8)
+    *decode_time = tfdt.data[0] == 1 && tfdt.size >= 12
+                       ? (int64_t)rb64(tfdt.data + 4)
+                       : (int64_t)rb32(tfdt.data + 4);
+
+  /* 一个traf可以有多个trun; 无data_offset时数据紧接上一个trun */
+  uint64_t data_offset = base;
+  size_t offset = 0;
+  while (offset < traf.size) {
+    uint32_t type;
+    mp4_slice_t trun;
+    size_t next;
+    if (!read_box(traf.data, traf.size, offset, &type, &trun, &next))
+      break;
+    offset = next;
+    if (type != FOURCC('t', 'r', 'u', 'n') || trun.size < 8)
+      continue;
+
+    uint32_t trun_flags = rb32(trun.data) & 0xFFFFFF;
+    uint32_t count = rb32(trun.data + 4);
+    size_t q = 8;
+
+    if (trun_flags & TRUN_DATA_OFFSET) {
+      if (q + 4 > trun.size)
+        continue;
+      data_offset = base + (int64_t)(int32_t)rb32(trun.data + q);
+      q += 4;
+    }
+    if (trun_flags & TRUN_FIRST_SAMPLE_FLAGS)
+      q += 4;
+
+    size_t record_size = 4 * (!!(trun_flags & TRUN_DURATION) +
+                              !!(trun_flags & TRUN_SIZE) +
+                              !!(trun_flags & TRUN_FLAGS) +
+                              !!(trun_flags & TRUN_CTO));
+
+    for (uint32_t i = 0; i < count && q + record_size <= trun.size; i++) {
+      uint32_t duration = default_duration;
+      uint32_t sample_size = default_size;
+      int32_t cto = 0;
+
+      if (trun_flags & TRUN_DURATION) {
+        duration = rb32(trun.data + q);
+        q += 4;
+      }
+      if (trun_flags & TRUN_SIZE) {
+        sample_size = rb32(trun.data + q);
+        q += 4;
+      }
+      if (trun_flags & TRUN_FLAGS)
+        q += 4;
+      if (trun_flags & TRUN_CTO) {
+        cto = (int32_t)rb32(trun.data + q);
+        q += 4;
+      }
+
+      int64_t pts = sample_pts(track, *decode_time + cto);
+      if (!scan_sample(data, size, data_offset, sample_size, pts, track, scan))
+        return false;
+
+      data_offset += sample_size;
+      *decode_time += duration;
+    }
+  }
+  return true;
+}
+
+static bool scan_fragments(const uint8_t *data, size_t size,
+                           mp4_track_t *track, stream_scan_t *scan) {
+  int64_t decode_time = 0;
+  size_t offset = 0;
+
+  while (offset < size) {
+    uint32_t type;
+    mp4_slice_t moof, traf;
+    size_t next;
+    if (!read_box(data, size, offset, &type, &moof, &next))
+      break;
+
+    if (type == FOURCC('m', 'o', 'o', 'f')) {
+      size_t child = 0;
+      while (child < moof.size) {
+        uint32_t child_type;
+        size_t child_next;
+        if (!read_box(moof.data, moof.size, child, &child_type, &traf,
+                      &child_next))
+          break;
+        child = child_next;
+        if (child_type == FOURCC('t', 'r', 'a', 'f') &&
+            !scan_traf(data, size, offset, traf, track, &decode_time, scan))
+          return false;
+      }
+    }
+    offset = next;
+  }
+  return true;
+}
+
+bool stream_scan_mp4(const uint8_t *data, size_t size, stream_scan_t *scan) {
+  mp4_slice_t file = {data, size};
+  mp4_slice_t moov;
+  if (!find_box(file, FOURCC('m', 'o', 'o', 'v'), &moov)) {
+    snprintf(scan->error, sizeof(scan->error),
+             "no moov box (unfinished recording?)");
+    return false;
+  }
+
+  mp4_track_t track = {0};
+  if (!find_video_track(moov, &track, scan->error, sizeof(scan->error))) {
+    if (!scan->error[0])
+      snprintf(scan->error, sizeof(scan->error), "malformed video track");
+    return false;
+  }
+  scan->codec = track.codec;
+  scan->time_base_num = 1;
+  scan->time_base_den = (int32_t)track.timescale;
+
+  /* 有完整样本表时优先使用, 否则按分片遍历 */
+  if (track.stsz.size >= 12 && track.stco.size >= 8 &&
+      track.stsc.size >= 8 && rb32(track.stsz.data + 8) > 0)
+    return scan_sample_tables(data, size, &track, scan);
+
+  read_trex(moov, &track);
+  return scan_fragments(data, size, &track, scan);
+}
@@ -0,0 +1,474 @@
+/******************************************************************************
+    Stamp Analyzer
+    Copyright (C) 2026
+
+    Offline checker for recordings of SEI Stamper streams. Memory-maps
+    TS/MP4/raw Annex B files, scans them without decoding on a pool of
+    worker threads and reports per-file stamp cadence, gaps and NTP clock
+    drift, plus the skew of every file against a reference recording.
+******************************************************************************/
+
+#include "stream-scan.h"
+#include <getopt.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef struct analyzer_options {
+  double fps;        /* 裸码流的帧率 */
+  double gap_factor; /* 间隔超过中位数的多少倍视为缺口 */
+  unsigned threads;  /* 0 = CPU核数 */
+  const char *csv_path;
+  bool write_index; /* 在每个录像旁写入.ssix索引 */
+  bool verbose;
+} analyzer_options_t;
+
+typedef struct file_job {
+  const char *path;
+  char index_path[PATH_MAX]; /* 已写入的索引, 空表示未写入 */
+  size_t size;
+  double elapsed_s;
+  bool ok;
+  stream_scan_t scan;
+  char error[160];
+} file_job_t;
+
+typedef struct work_queue {
+  file_job_t *jobs;
+  long count;
+  long next; /* 下一个待处理的文件, 原子递增 */
+  const analyzer_options_t *options;
+} work_queue_t;
+
+/* libseistamp日志: 只在--verbose时输出 */
+static void log_handler(int level, const char *format, va_list args,
+                        void *param) {
+  const analyzer_options_t *options = param;
+  if (!options->verbose && level > SEISTAMP_LOG_WARNING)
+    return;
+  vfprintf(stderr, format, args);
+  fputc('\n', stderr);
+}
+
+static double now_s(void) { return (double)seistamp_now_ns() / 1e9; }
+
+/* ------------------------------------------------------------------------- */
+/* 扫描 */
+
+static void analyze_file(file_job_t *job, const analyzer_options_t *options) {
+  double start = now_s();
+  job->ok = stream_scan_path(job->path, options->fps, &job->scan, &job->size);
+
+  /* 没有时间戳的文件不需要索引 */
+  if (job->ok && options->write_index && job->scan.stamp_count > 0) {
+    snprintf(job->index_path, sizeof(job->index_path), "%s%s", job->path,
+             SEISTAMP_INDEX_EXTENSION);
+    job->ok = stream_scan_write_index(&job->scan, job->index_path);
+    if (!job->ok)
+      job->index_path[0] = '\0';
+  }
+
+  if (!job->ok)
+    snprintf(job->error, sizeof(job->error), "%s", job->scan.error);
+  job->elapsed_s = now_s() - start;
+}
+
+static void *worker_thread(void *param) {
+  work_queue_t *queue = param;
+  for (;;) {
+    long index = __atomic_fetch_add(&queue->next, 1, __ATOMIC_RELAXED);
+    if (index >= queue->count)
+      return NULL;
+    analyze_file(&queue->jobs[index], queue->options);
+  }
+}
+
+/* ------------------------------------------------------------------------- */
+/* 报告 */
+
+static int compare_double(const void *a, const void *b) {
+  double x = *(const double *)a;
+  double y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+static double median(double *values, size_t count) {
+  qsort(values, count, sizeof(double), compare_double);
+  return count ? values[count / 2] : 0.0;
+}
+
+static void format_time(int64_t time_us, char *buf, size_t size) {
+  if (time_us < 0)
+    time_us = 0;
+  int64_t ms = time_us / 1000;
+  snprintf(buf, size, "%02d:%02d:%02d.%03d", (int)(ms / 3600000),
+           (int)(ms / 60000 % 60), (int)(ms / 1000 % 60), (int)(ms % 1000));
+}
+
+static const char *codec_name(seistamp_codec_t codec) {
+  return codec == SEISTAMP_CODEC_H265 ? "H.265" : "H.264";
+}
+
+/* 时间戳间隔与缺口 */
+static void report_cadence(const stream_scan_t *scan, double gap_factor) {
+  size_t count = scan->stamp_count;
+  double *intervals = malloc((count - 1) * sizeof(double));
+  if (!intervals)
+    return;
+
+  double min_ms = INFINITY, max_ms = 0.0;
+  uint64_t frame_sum = 0;
+  for (size_t i = 1; i < count; i++) {
+    double ms =
+        (double)(scan->stamps[i].time_us - scan->stamps[i - 1].time_us) / 1e3;
+    intervals[i - 1] = ms;
+    frame_sum += scan->stamps[i].frame - scan->stamps[i - 1].frame;
+    if (ms < min_ms)
+      min_ms = ms;
+    if (ms > max_ms)
+      max_ms = ms;
+  }
+
+  /* median()会排序, 先统计缺口需要原始顺序 */
+  double *sorted = malloc((count - 1) * sizeof(double));
+  if (!sorted) {
+    free(intervals);
+    return;
+  }
+  memcpy(sorted, intervals, (count - 1) * sizeof(double));
+  double median_ms = median(sorted, count - 1);
+  free(sorted);
+
+  size_t gaps = 0, largest = 0;
+  for (size_t i = 0; i < count - 1; i++) {
+    if (intervals[i] > median_ms * gap_factor) {
+      gaps++;
+      if (!largest || intervals[i] > intervals[largest - 1])
+        largest = i + 1;
+    }
+  }
+
+  printf("  cadence      median %.1f ms (avg %.1f frames)  min %.1f ms  "
+         "max %.1f ms\n",
+         median_ms, (double)frame_sum / (double)(count - 1), min_ms, max_ms);
+
+  if (gaps) {
+    char at[32];
+    format_time(scan->stamps[largest - 1].time_us, at, sizeof(at));
+    printf("  gaps         %zu (> %.1fx median), largest %.1f ms after %s\n",
+           gaps, gap_factor, intervals[largest - 1], at);
+  } else {
+    printf("  gaps         none\n");
+  }
+  free(intervals);
+}
+
+/* NTP时间与容器时间的线性拟合: 斜率即两者的频率差 */
+static void report_clock(const stream_scan_t *scan) {
+  const stamp_record_t *s = scan->stamps;
+  size_t count = scan->stamp_count;
+  double sx = 0, sy = 0, sxx = 0, sxy = 0;
+  size_t backwards = 0;
+
+  for (size_t i = 0; i < count; i++) {
+    double x = (double)(s[i].time_us - s[0].time_us) / 1e6;
+    double y = (double)((int64_t)(s[i].ntp_ns - s[0].ntp_ns)) / 1e9;
+    sx += x;
+    sy += y;
+    sxx += x * x;
+    sxy += x * y;
+    if (i > 0 && s[i].ntp_ns < s[i - 1].ntp_ns)
+      backwards++;
+  }
+
+  double n = (double)count;
+  double denom = n * sxx - sx * sx;
+  if (denom <= 0.0) {
+    printf("  ntp clock    container time does not advance\n");
+    return;
+  }
+  double slope = (n * sxy - sx * sy) / denom;
+  double intercept = (sy - slope * sx) / n;
+
+  double max_residual = 0.0;
+  for (size_t i = 0; i < count; i++) {
+    double x = (double)(s[i].time_us - s[0].time_us) / 1e6;
+    double y = (double)((int64_t)(s[i].ntp_ns - s[0].ntp_ns)) / 1e9;
+    double r = fabs(y - (slope * x + intercept));
+    if (r > max_residual)
+      max_residual = r;
+  }
+
+  printf("  ntp clock    drift %+.1f ppm vs container, residual max %.3f "
+         "ms, %zu backwards\n",
+         (slope - 1.0) * 1e6, max_residual * 1e3, backwards);
+}
+
+static void report_file(const file_job_t *job,
+                        const analyzer_options_t *options) {
+  if (!job->ok) {
+    printf("%s: error: %s\n", job->path, job->error);
+    return;
+  }
+
+  const stream_scan_t *scan = &job->scan;
+  printf("%s: %s %s, %llu frames, %.1f s, %zu stamps (%.1f MiB in %.2f s)\n",
+         job->path, stream_format_name(scan->format), codec_name(scan->codec),
+         (unsigned long long)scan->frames, (double)scan->duration_us / 1e6,
+         scan->stamp_count, (double)job->size / (1024.0 * 1024.0),
+         job->elapsed_s);
+  if (job->index_path[0])
+    printf("  index: %s\n", job->index_path);
+
+  if (scan->stamp_count >= 2) {
+    report_cadence(scan, options->gap_factor);
+    report_clock(scan);
+  }
+}
+
+/*
+ * 文件在NTP时刻t的容器时间: 在相邻两个时间戳之间线性插值
+ * 返回false表示t不在该文件的时间戳范围内
+ */
+static bool container_time_at(const stream_scan_t *scan, uint64_t ntp_ns,
+                              size_t *cursor, double *time_us) {
+  const stamp_record_t *s = scan->stamps;
+  size_t i = *cursor;
+
+  while (i + 1 < scan->stamp_count && s[i + 1].ntp_ns < ntp_ns)
+    i++;
+  *cursor = i;
+
+  if (i + 1 >= scan->stamp_count || s[i].ntp_ns > ntp_ns)
+    return false;
+
+  double span = (double)(s[i + 1].ntp_ns - s[i].ntp_ns);
+  double t = span > 0 ? (double)(ntp_ns - s[i].ntp_ns) / span : 0.0;
+  *time_us = (double)s[i].time_us +
+             t * (double)(s[i + 1].time_us - s[i].time_us);
+  return true;
+}
+
+/*
+ * 跨文件偏差: 同一NTP时刻在该文件中比参考文件晚出现多少(毫秒)
+ * 每个时间戳一个值, 不在参考文件时间范围内的为NAN
+ */
+static double *compute_skew(const stream_scan_t *scan,
+                            const stream_scan_t *reference) {
+  double *skews = malloc((scan->stamp_count + 1) * sizeof(double));
+  if (!skews)
+    return NULL;
+
+  size_t cursor = 0;
+  for (size_t i = 0; i < scan->stamp_count; i++) {
+    const stamp_record_t *s = &scan->stamps[i];
+    double ref_time_us;
+    skews[i] = container_time_at(reference, s->ntp_ns, &cursor, &ref_time_us)
+                   ? ((double)s->time_us - ref_time_us) / 1e3
+                   : NAN;
+  }
+  return skews;
+}
+
+/* 中位数即剪辑时需要的固定偏移, 跨度说明单一偏移是否足够 */
+static void report_skew(const file_job_t *job, const double *skews) {
+  size_t count = job->scan.stamp_count;
+  double *matched = malloc((count + 1) * sizeof(double));
+  if (!matched)
+    return;
+
+  size_t n = 0;
+  double min_ms = INFINITY, max_ms = -INFINITY;
+  for (size_t i = 0; i < count; i++) {
+    if (isnan(skews[i]))
+      continue;
+    matched[n++] = skews[i];
+    min_ms = fmin(min_ms, skews[i]);
+    max_ms = fmax(max_ms, skews[i]);
+  }
+
+  if (n) {
+    printf("  %-24s median %+.3f ms  min %+.3f ms  max %+.3f ms  "
+           "span %.3f ms (%zu frames)\n",
+           job->path, median(matched, n), min_ms, max_ms, max_ms - min_ms,
+           n);
+  } else {
+    printf("  %-24s no overlapping stamps\n", job->path);
+  }
+  free(matched);
+}
+
+/* 每个时间戳一行; 参考文件和无法对齐的帧偏差列留空 */
+static void write_csv(FILE *csv, const file_job_t *job, const double *skews) {
+  for (size_t i = 0; i < job->scan.stamp_count; i++) {
+    const stamp_record_t *s = &job->scan.stamps[i];
+    fprintf(csv, "%s,%llu,%.6f,%.9f,", job->path,
+            (unsigned long long)s->frame, (double)s->time_us / 1e6,
+            (double)s->ntp_ns / 1e9);
+    if (skews && !isnan(skews[i]))
+      fprintf(csv, "%.3f", skews[i]);
+    fputc('\n', csv);
+  }
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void usage(const char *argv0) {
+  fprintf(
+      stderr,
+      "Usage: %s [options] FILE...\n"
+      "Scan recordings (TS, MP4/MOV, raw .h264/.h265) for SEI Stamper\n"
+      "timestamps without decoding. The first file with stamps is the\n"
+      "reference for cross-file skew.\n\n"
+      "  --fps N           frame rate of raw Annex B files (default 30)\n"
+      "  --gap-factor X    interval > X * median counts as a gap "
+      "(default 1.5)\n"
+      "  --threads N       worker threads (default: number of CPUs)\n"
+      "  --csv FILE        write every stamp and its skew to FILE\n"
+      "  --write-index     write FILE.ssix next to each recording for\n"
+      "                    stamp-seek and other players\n"
+      "  --verbose         log library messages\n",
+      argv0);
+}
+
+int main(int argc, char **argv) {
+  analyzer_options_t options = {.fps = 30.0, .gap_factor = 1.5};
+
+  static const struct option long_options[] = {
+      {"fps", required_argument, NULL, 'f'},
+      {"gap-factor", required_argument, NULL, 'g'},
+      {"threads", required_argument, NULL, 't'},
+      {"csv", required_argument, NULL, 'c'},
+      {"write-index", no_argument, NULL, 'i'},
+      {"verbose", no_argument, NULL, 'v'},
+      {"help", no_argument, NULL, 'h'},
+      {NULL, 0, NULL, 0},
+  };
+
+  int c;
+  while ((c = getopt_long(argc, argv, "h", long_options, NULL)) != -1) {
+    switch (c) {
+    case 'f':
+      options.fps = atof(optarg);
+      break;
+    case 'g':
+      options.gap_factor = atof(optarg);
+      break;
+    case 't':
+      options.threads = (unsigned)strtoul(optarg, NULL, 10);
+      break;
+    case 'c':
+      options.csv_path = optarg;
+      break;
+    case 'i':
+      options.write_index = true;
+      break;
+    case 'v':
+      options.verbose = true;
+      break;
+    default:
+      usage(argv[0]);
+      return c == 'h' ? 0 : 2;
+    }
+  }
+
+  size_t count = (size_t)(argc - optind);
+  if (count == 0 || options.fps <= 0.0 || options.gap_factor <= 1.0) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  seistamp_set_log_handler(log_handler, &options);
+
+  file_job_t *jobs = calloc(count, sizeof(file_job_t));
+  if (!jobs)
+    return 1;
+  for (size_t i = 0; i < count; i++)
+    jobs[i].path = argv[optind + (int)i];
+
+  unsigned threads = options.threads;
+  if (threads == 0) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = cpus > 0 ? (unsigned)cpus : 1;
+  }
+  if (threads > count)
+    threads = (unsigned)count;
+
+  work_queue_t queue = {.jobs = jobs, .count = (long)count,
+                        .options = &options};
+  pthread_t *workers = calloc(threads, sizeof(pthread_t));
+  if (!workers)
+    return 1;
+
+  double start = now_s();
+  unsigned started = 0;
+  for (; started < threads; started++) {
+    if (pthread_create(&workers[started], NULL, worker_thread, &queue) != 0)
+      break;
+  }
+  /* 线程创建失败时在主线程中处理剩余文件 */
+  worker_thread(&queue);
+  for (unsigned i = 0; i < started; i++)
+    pthread_join(workers[i], NULL);
+  double elapsed = now_s() - start;
+  free(workers);
+
+  size_t total_bytes = 0, failed = 0, ref = count;
+  for (size_t i = 0; i < count; i++) {
+    report_file(&jobs[i], &options);
+    total_bytes += jobs[i].size;
+    if (!jobs[i].ok)
+      failed++;
+    else if (ref == count && jobs[i].scan.stamp_count > 0)
+      ref = i;
+  }
+
+  FILE *csv = NULL;
+  if (options.csv_path) {
+    csv = fopen(options.csv_path, "w");
+    if (csv)
+      fprintf(csv, "file,frame,time_s,ntp_s,skew_ms\n");
+    else
+      fprintf(stderr, "Cannot write %s\n", options.csv_path);
+  }
+
+  if (ref < count && count - failed > 1)
+    printf("\nCross-file skew vs %s (container time of the same NTP "
+           "instant)\n",
+           jobs[ref].path);
+
+  for (size_t i = 0; i < count; i++) {
+    if (!jobs[i].ok)
+      continue;
+
+    double *skews = NULL;
+    if (ref < count && i != ref) {
+      skews = compute_skew(&jobs[i].scan, &jobs[ref].scan);
+      if (skews)
+        report_skew(&jobs[i], skews);
+    }
+    if (csv)
+      write_csv(csv, &jobs[i], skews);
+    free(skews);
+  }
+
+  if (csv)
+    fclose(csv);
+
+  printf("\nScanned %zu file(s), %.1f MiB in %.2f s (%.0f MiB/s, %u "
+         "threads)\n",
+         count, (double)total_bytes / (1024.0 * 1024.0), elapsed,
+         elapsed > 0 ? (double)total_bytes / (1024.0 * 1024.0) / elapsed
+                     : 0.0,
+         started ? started : 1);
+
+  for (size_t i = 0; i < count; i++)
+    stream_scan_free(&jobs[i].scan);
+  free(jobs);
+  return failed ? 1 : 0;
+}
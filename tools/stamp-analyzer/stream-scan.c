@@ -0,0 +1,571 @@
+/******************************************************************************
+    Stamp Analyzer - Stream Scanner
+    Copyright (C) 2026
+
+    Format detection, raw Annex B and MPEG-TS scanners. MP4 is in mp4-scan.c.
+******************************************************************************/
+
+#include "stream-scan.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TS_PACKET_SIZE 188
+#define M2TS_PACKET_SIZE 192
+
+/* 每个PES只保留开头部分: 时间戳SEI位于第一个slice之前 */
+#define PES_SCAN_LIMIT (64 * 1024)
+
+/* MPEG-TS stream_type */
+#define TS_STREAM_H264 0x1B
+#define TS_STREAM_H265 0x24
+
+/* 33位PTS回绕 */
+#define PTS_WRAP (1LL << 33)
+
+const char *stream_format_name(stream_format_t format) {
+  switch (format) {
+  case STREAM_FORMAT_ANNEXB:
+    return "Annex B";
+  case STREAM_FORMAT_TS:
+    return "TS";
+  case STREAM_FORMAT_MP4:
+    return "MP4";
+  default:
+    return "unknown";
+  }
+}
+
+stamp_record_t *stream_scan_add_stamp(stream_scan_t *scan, uint64_t frame,
+                                      int64_t time_us,
+                                      const seistamp_stamp_t *stamp) {
+  if (scan->stamp_count == scan->stamp_capacity) {
+    size_t capacity = scan->stamp_capacity ? scan->stamp_capacity * 2 : 1024;
+    stamp_record_t *stamps =
+        realloc(scan->stamps, capacity * sizeof(stamp_record_t));
+    if (!stamps) {
+      snprintf(scan->error, sizeof(scan->error), "out of memory");
+      return NULL;
+    }
+    scan->stamps = stamps;
+    scan->stamp_capacity = capacity;
+  }
+
+  stamp_record_t *record = &scan->stamps[scan->stamp_count++];
+  memset(record, 0, sizeof(*record));
+  record->frame = frame;
+  record->time_us = time_us;
+  record->ntp_ns = seistamp_ntp_to_ns(&stamp->ntp_time);
+  record->pts = stamp->pts;
+  return record;
+}
+
+void stream_scan_free(stream_scan_t *scan) {
+  if (!scan)
+    return;
+  free(scan->stamps);
+  memset(scan, 0, sizeof(*scan));
+}
+
+bool stream_scan_write_index(stream_scan_t *scan, const char *index_path) {
+  seistamp_index_writer_t *writer = seistamp_index_writer_create(
+      index_path, scan->codec, scan->time_base_num, scan->time_base_den);
+  if (!writer) {
+    snprintf(scan->error, sizeof(scan->error), "cannot create %s",
+             index_path);
+    return false;
+  }
+
+  bool ok = true;
+  for (size_t i = 0; ok && i < scan->stamp_count; i++) {
+    const stamp_record_t *record = &scan->stamps[i];
+    ok = seistamp_index_writer_add(
+        writer, record->ntp_ns, record->stream_pts, record->offset,
+        record->keyframe ? SEISTAMP_INDEX_KEYFRAME : 0);
+  }
+  if (!seistamp_index_writer_close(writer) || !ok) {
+    snprintf(scan->error, sizeof(scan->error), "write error on %s",
+             index_path);
+    return false;
+  }
+  return true;
+}
+
+/* NAL类型与VCL判断 (data指向NAL头) */
+static inline uint8_t nal_type(const uint8_t *nal, seistamp_codec_t codec) {
+  if (codec == SEISTAMP_CODEC_H265)
+    return (nal[0] >> 1) & 0x3F;
+  return nal[0] & 0x1F;
+}
+
+static inline bool is_vcl(uint8_t type, seistamp_codec_t codec) {
+  if (codec == SEISTAMP_CODEC_H265)
+    return type < 32;
+  return type >= 1 && type <= 5;
+}
+
+bool stream_scan_is_keyframe_nal(const uint8_t *nal, seistamp_codec_t codec) {
+  uint8_t type = nal_type(nal, codec);
+  /* H.265 IRAP: BLA/IDR/CRA (16-23) */
+  if (codec == SEISTAMP_CODEC_H265)
+    return type >= 16 && type <= 23;
+  return type == 5;
+}
+
+bool stream_scan_length_prefixed(const uint8_t *data, size_t size,
+                                 int length_size, seistamp_codec_t codec,
+                                 seistamp_stamp_t *stamp_out,
+                                 bool *keyframe_out) {
+  size_t offset = 0;
+  bool found = false;
+
+  while (offset + (size_t)length_size < size) {
+    size_t length = 0;
+    for (int i = 0; i < length_size; i++)
+      length = (length << 8) | data[offset + i];
+    offset += (size_t)length_size;
+
+    if (length == 0 || length > size - offset)
+      break;
+
+    const uint8_t *nal = data + offset;
+    if (is_vcl(nal_type(nal, codec), codec)) {
+      if (found && keyframe_out)
+        *keyframe_out = stream_scan_is_keyframe_nal(nal, codec);
+      break;
+    }
+    if (!found && seistamp_scan_nal(nal, length, codec, stamp_out)) {
+      found = true;
+      if (!keyframe_out)
+        break;
+    }
+
+    offset += length;
+  }
+  return found;
+}
+
+/* ------------------------------------------------------------------------- */
+/* 裸Annex B码流 */
+
+/* 返回起始码(00 00 01)之后第一个字节的偏移,没有时返回size */
+static size_t next_start_code(const uint8_t *data, size_t size, size_t from) {
+  while (from + 3 <= size) {
+    const uint8_t *p = memchr(data + from + 2, 0x01, size - from - 2);
+    if (!p)
+      return size;
+
+    size_t pos = (size_t)(p - data);
+    if (data[pos - 1] == 0x00 && data[pos - 2] == 0x00)
+      return pos + 1;
+    from = pos - 1;
+  }
+  return size;
+}
+
+bool stream_scan_annexb_keyframe(const uint8_t *data, size_t size,
+                                 seistamp_codec_t codec) {
+  for (size_t start = next_start_code(data, size, 0); start < size;
+       start = next_start_code(data, size, start)) {
+    if (is_vcl(nal_type(data + start, codec), codec))
+      return stream_scan_is_keyframe_nal(data + start, codec);
+  }
+  return false;
+}
+
+/* 先看扩展名,再看第一个NAL头 (H.265 VPS/SPS/PPS/AUD/SEI的第二字节为0x01) */
+static seistamp_codec_t guess_annexb_codec(const uint8_t *data, size_t size,
+                                           const char *path) {
+  const char *ext = path ? strrchr(path, '.') : NULL;
+  if (ext) {
+    if (!strcasecmp(ext, ".h265") || !strcasecmp(ext, ".265") ||
+        !strcasecmp(ext, ".hevc"))
+      return SEISTAMP_CODEC_H265;
+    if (!strcasecmp(ext, ".h264") || !strcasecmp(ext, ".264") ||
+        !strcasecmp(ext, ".avc"))
+      return SEISTAMP_CODEC_H264;
+  }
+
+  size_t start = next_start_code(data, size, 0);
+  if (start + 2 <= size && data[start + 1] == 0x01) {
+    uint8_t type = (data[start] >> 1) & 0x3F;
+    if (type >= 32 && type <= 40)
+      return SEISTAMP_CODEC_H265;
+  }
+  return SEISTAMP_CODEC_H264;
+}
+
+static bool scan_annexb(const uint8_t *data, size_t size, double fps,
+                        stream_scan_t *scan) {
+  seistamp_codec_t codec = scan->codec;
+  size_t header_size = codec == SEISTAMP_CODEC_H265 ? 2 : 1;
+  size_t start = next_start_code(data, size, 0);
+
+  /* 没有容器时间, PTS即帧序号 */
+  scan->time_base_num = 1000;
+  scan->time_base_den = (int32_t)(fps * 1000.0 + 0.5);
+
+  size_t au_start = 0;       /* 当前访问单元第一个起始码的偏移 */
+  bool after_vcl = false;    /* 上一个NAL属于图像数据 */
+  size_t pending = SIZE_MAX; /* 等待第一个slice判断关键帧的记录 */
+
+  while (start < size) {
+    size_t next = next_start_code(data, size, start);
+    size_t end = next < size ? next - 3 : size;
+    while (end > start && data[end - 1] == 0x00)
+      end--;
+
+    if (end > start + header_size) {
+      const uint8_t *nal = data + start;
+      uint8_t type = nal_type(nal, codec);
+      seistamp_stamp_t stamp;
+
+      if (is_vcl(type, codec)) {
+        /* first_mb_in_slice == 0 / first_slice_segment_in_pic_flag:
+         * slice头的第一个比特为1时开始新的一帧 */
+        if (nal[header_size] & 0x80) {
+          if (pending != SIZE_MAX) {
+            scan->stamps[pending].keyframe =
+                stream_scan_is_keyframe_nal(nal, codec);
+            pending = SIZE_MAX;
+          }
+          scan->frames++;
+        }
+        after_vcl = true;
+      } else {
+        /* 图像数据之后的第一个非VCL NAL开始新的访问单元 */
+        if (after_vcl) {
+          au_start = start - 3;
+          if (au_start > 0 && data[au_start - 1] == 0x00)
+            au_start--;
+          after_vcl = false;
+        }
+        if (seistamp_scan_nal(nal, end - start, codec, &stamp)) {
+          /* SEI属于其后的第一帧 */
+          int64_t time_us = (int64_t)((double)scan->frames * 1e6 / fps);
+          stamp_record_t *record =
+              stream_scan_add_stamp(scan, scan->frames, time_us, &stamp);
+          if (!record)
+            return false;
+          record->stream_pts = (int64_t)scan->frames;
+          record->offset = au_start;
+          pending = scan->stamp_count - 1;
+        }
+      }
+    }
+    start = next;
+  }
+
+  scan->duration_us = (int64_t)((double)scan->frames * 1e6 / fps);
+  return true;
+}
+
+/* ------------------------------------------------------------------------- */
+/* MPEG-TS */
+
+typedef struct ts_demux {
+  stream_scan_t *scan;
+  int pmt_pid;
+  int video_pid;
+
+  uint8_t *pes;    /* 当前PES的开头部分 */
+  size_t pes_size;
+  bool pes_active;
+  bool pes_has_pts;
+  int64_t pes_pts;     /* 已展开回绕 */
+  uint64_t pes_offset; /* PES第一个TS包在文件中的偏移 */
+
+  int64_t first_pts;
+  int64_t last_pts;
+  int64_t pts_wrap_offset;
+  bool have_pts;
+} ts_demux_t;
+
+/* 返回section起始位置(跳过pointer_field), 失败返回NULL */
+static const uint8_t *ts_section(const uint8_t *payload, size_t size,
+                                 size_t *section_size) {
+  if (size < 1 || (size_t)payload[0] + 1 + 3 > size)
+    return NULL;
+
+  const uint8_t *section = payload + 1 + payload[0];
+  size_t available = size - 1 - payload[0];
+  size_t length = (((size_t)section[1] & 0x0F) << 8) | section[2];
+
+  /* 只处理单个TS包内的PAT/PMT */
+  if (length + 3 > available || length < 9)
+    return NULL;
+  *section_size = length + 3;
+  return section;
+}
+
+static void ts_parse_pat(ts_demux_t *ts, const uint8_t *payload, size_t size) {
+  size_t section_size;
+  const uint8_t *s = ts_section(payload, size, &section_size);
+  if (!s || s[0] != 0x00)
+    return;
+
+  /* 节目循环: 跳过8字节头, 去掉4字节CRC */
+  for (size_t i = 8; i + 4 <= section_size - 4; i += 4) {
+    int program = (s[i] << 8) | s[i + 1];
+    if (program != 0) {
+      ts->pmt_pid = ((s[i + 2] & 0x1F) << 8) | s[i + 3];
+      return;
+    }
+  }
+}
+
+static void ts_parse_pmt(ts_demux_t *ts, const uint8_t *payload, size_t size) {
+  size_t section_size;
+  const uint8_t *s = ts_section(payload, size, &section_size);
+  if (!s || s[0] != 0x02 || section_size < 16)
+    return;
+
+  size_t info_length = (((size_t)s[10] & 0x0F) << 8) | s[11];
+  size_t i = 12 + info_length;
+
+  while (i + 5 <= section_size - 4) {
+    uint8_t stream_type = s[i];
+    int pid = ((s[i + 1] & 0x1F) << 8) | s[i + 2];
+    size_t es_info_length = (((size_t)s[i + 3] & 0x0F) << 8) | s[i + 4];
+
+    if (stream_type == TS_STREAM_H264 || stream_type == TS_STREAM_H265) {
+      ts->video_pid = pid;
+      ts->scan->codec = stream_type == TS_STREAM_H265 ? SEISTAMP_CODEC_H265
+                                                      : SEISTAMP_CODEC_H264;
+      return;
+    }
+    i += 5 + es_info_length;
+  }
+}
+
+static int64_t ts_read_pts(const uint8_t *p) {
+  return ((int64_t)(p[0] & 0x0E) << 29) | ((int64_t)p[1] << 22) |
+         ((int64_t)(p[2] & 0xFE) << 14) | ((int64_t)p[3] << 7) |
+         ((int64_t)p[4] >> 1);
+}
+
+/* 展开33位回绕, 返回单调的90kHz时间 */
+static int64_t ts_unwrap_pts(ts_demux_t *ts, int64_t pts) {
+  pts += ts->pts_wrap_offset;
+  if (ts->have_pts && pts < ts->last_pts - PTS_WRAP / 2) {
+    ts->pts_wrap_offset += PTS_WRAP;
+    pts += PTS_WRAP;
+  }
+  if (!ts->have_pts) {
+    ts->first_pts = pts;
+    ts->have_pts = true;
+  }
+  ts->last_pts = pts;
+  return pts;
+}
+
+static bool ts_flush_pes(ts_demux_t *ts) {
+  if (!ts->pes_active)
+    return true;
+  ts->pes_active = false;
+
+  stream_scan_t *scan = ts->scan;
+  uint64_t frame = scan->frames++;
+  int64_t pts = ts->pes_has_pts ? ts->pes_pts : ts->last_pts;
+  int64_t time_us = ts->have_pts ? (pts - ts->first_pts) * 100 / 9 : 0;
+  scan->duration_us = time_us;
+
+  seistamp_stamp_t stamp;
+  if (!seistamp_scan_access_unit(ts->pes, ts->pes_size, scan->codec, &stamp))
+    return true;
+
+  stamp_record_t *record = stream_scan_add_stamp(scan, frame, time_us, &stamp);
+  if (!record)
+    return false;
+  record->stream_pts = pts;
+  record->offset = ts->pes_offset;
+  record->keyframe =
+      stream_scan_annexb_keyframe(ts->pes, ts->pes_size, scan->codec);
+  return true;
+}
+
+static void ts_append_pes(ts_demux_t *ts, const uint8_t *data, size_t size) {
+  size_t room = PES_SCAN_LIMIT - ts->pes_size;
+  if (size > room)
+    size = room;
+  memcpy(ts->pes + ts->pes_size, data, size);
+  ts->pes_size += size;
+}
+
+static bool ts_start_pes(ts_demux_t *ts, const uint8_t *payload, size_t size,
+                         uint64_t packet_offset) {
+  if (!ts_flush_pes(ts))
+    return false;
+
+  /* PES头: 00 00 01 stream_id length(2) flags(2) header_length */
+  if (size < 9 || payload[0] || payload[1] || payload[2] != 0x01)
+    return true;
+
+  size_t header_end = 9 + (size_t)payload[8];
+  if (header_end > size)
+    return true;
+
+  ts->pes_active = true;
+  ts->pes_size = 0;
+  ts->pes_offset = packet_offset;
+  ts->pes_has_pts = (payload[7] & 0x80) && size >= 14;
+  if (ts->pes_has_pts)
+    ts->pes_pts = ts_unwrap_pts(ts, ts_read_pts(payload + 9));
+
+  ts_append_pes(ts, payload + header_end, size - header_end);
+  return true;
+}
+
+/* 188字节或192字节(M2TS)包, 连续三个同步字节才确认 */
+static size_t ts_packet_size(const uint8_t *data, size_t size) {
+  if (size >= 3 * TS_PACKET_SIZE && data[0] == 0x47 &&
+      data[TS_PACKET_SIZE] == 0x47 && data[2 * TS_PACKET_SIZE] == 0x47)
+    return TS_PACKET_SIZE;
+  if (size >= 3 * M2TS_PACKET_SIZE && data[4] == 0x47 &&
+      data[4 + M2TS_PACKET_SIZE] == 0x47 &&
+      data[4 + 2 * M2TS_PACKET_SIZE] == 0x47)
+    return M2TS_PACKET_SIZE;
+  return 0;
+}
+
+static bool scan_ts(const uint8_t *data, size_t size, size_t packet_size,
+                    stream_scan_t *scan) {
+  ts_demux_t ts = {.scan = scan, .pmt_pid = -1, .video_pid = -1};
+  scan->time_base_num = 1;
+  scan->time_base_den = 90000;
+  ts.pes = malloc(PES_SCAN_LIMIT);
+  if (!ts.pes) {
+    snprintf(scan->error, sizeof(scan->error), "out of memory");
+    return false;
+  }
+
+  /* M2TS每包前有4字节时间码 */
+  size_t skip = packet_size - TS_PACKET_SIZE;
+  bool ok = true;
+
+  for (size_t offset = 0; ok && offset + packet_size <= size;
+       offset += packet_size) {
+    const uint8_t *p = data + offset + skip;
+    if (p[0] != 0x47) {
+      /* 失去同步: 向后查找下一个同步字节 */
+      const uint8_t *sync = memchr(p, 0x47, size - offset - skip);
+      if (!sync)
+        break;
+      offset = (size_t)(sync - data) - skip - packet_size;
+      continue;
+    }
+
+    int pid = ((p[1] & 0x1F) << 8) | p[2];
+    bool unit_start = p[1] & 0x40;
+    int adaptation = (p[3] >> 4) & 0x03;
+    size_t payload_offset = 4;
+
+    if (adaptation & 0x02)
+      payload_offset += 1 + (size_t)p[4];
+    if (!(adaptation & 0x01) || payload_offset >= TS_PACKET_SIZE)
+      continue;
+
+    const uint8_t *payload = p + payload_offset;
+    size_t payload_size = TS_PACKET_SIZE - payload_offset;
+
+    if (pid == ts.video_pid) {
+      if (unit_start)
+        ok = ts_start_pes(&ts, payload, payload_size, offset);
+      else if (ts.pes_active)
+        ts_append_pes(&ts, payload, payload_size);
+    } else if (pid == 0 && unit_start) {
+      ts_parse_pat(&ts, payload, payload_size);
+    } else if (pid == ts.pmt_pid && unit_start && ts.video_pid < 0) {
+      ts_parse_pmt(&ts, payload, payload_size);
+    }
+  }
+
+  if (ok)
+    ok = ts_flush_pes(&ts);
+  free(ts.pes);
+
+  if (ok && ts.video_pid < 0) {
+    snprintf(scan->error, sizeof(scan->error),
+             "no H.264/H.265 stream in PMT");
+    return false;
+  }
+  return ok;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static bool is_mp4(const uint8_t *data, size_t size) {
+  static const char *const types[] = {"ftyp", "moov", "mdat", "free",
+                                      "styp", "wide", "skip"};
+  if (size < 8)
+    return false;
+  for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+    if (memcmp(data + 4, types[i], 4) == 0)
+      return true;
+  }
+  return false;
+}
+
+bool stream_scan_file(const uint8_t *data, size_t size, const char *path,
+                      double fps, stream_scan_t *scan) {
+  memset(scan, 0, sizeof(*scan));
+
+  size_t packet_size = ts_packet_size(data, size);
+  if (packet_size) {
+    scan->format = STREAM_FORMAT_TS;
+    return scan_ts(data, size, packet_size, scan);
+  }
+
+  if (is_mp4(data, size)) {
+    scan->format = STREAM_FORMAT_MP4;
+    return stream_scan_mp4(data, size, scan);
+  }
+
+  if (size >= 4 && data[0] == 0x00 && data[1] == 0x00 &&
+      (data[2] == 0x01 || (data[2] == 0x00 && data[3] == 0x01))) {
+    scan->format = STREAM_FORMAT_ANNEXB;
+    scan->codec = guess_annexb_codec(data, size, path);
+    return scan_annexb(data, size, fps, scan);
+  }
+
+  snprintf(scan->error, sizeof(scan->error), "unrecognized file format");
+  return false;
+}
+
+bool stream_scan_path(const char *path, double fps, stream_scan_t *scan,
+                      size_t *size_out) {
+  memset(scan, 0, sizeof(*scan));
+  *size_out = 0;
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    snprintf(scan->error, sizeof(scan->error), "cannot open: %m");
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    snprintf(scan->error, sizeof(scan->error), "empty or unreadable file");
+    close(fd);
+    return false;
+  }
+  size_t size = (size_t)st.st_size;
+
+  const uint8_t *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    snprintf(scan->error, sizeof(scan->error), "mmap failed: %m");
+    return false;
+  }
+  madvise((void *)data, size, MADV_SEQUENTIAL);
+
+  bool ok = stream_scan_file(data, size, path, fps, scan);
+  munmap((void *)data, size);
+  *size_out = size;
+  return ok;
+}
@@ -0,0 +1,122 @@
+/******************************************************************************
+    Stamp Analyzer - Stream Scanner
+    Copyright (C) 2026
+
+    Demux-only scanners for MPEG-TS, MP4 and raw Annex B files. Each scanner
+    walks the video elementary stream frame by frame, reads only the NAL
+    units in front of the first slice and records every SEI Stamper stamp.
+******************************************************************************/
+
+#pragma once
+
+#include <seistamp.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum stream_format {
+  STREAM_FORMAT_UNKNOWN = 0,
+  STREAM_FORMAT_ANNEXB, /* 裸H.264/H.265码流 */
+  STREAM_FORMAT_TS,     /* MPEG-TS (SRT/OBS录制) */
+  STREAM_FORMAT_MP4,    /* MP4/MOV, 包括分片MP4 */
+} stream_format_t;
+
+/* 一个带时间戳SEI的帧 */
+typedef struct stamp_record {
+  uint64_t frame;  /* 帧序号(显示时间由容器给出) */
+  int64_t time_us; /* 容器时间(微秒), 裸码流按帧率推算 */
+  uint64_t ntp_ns; /* 帧送入编码器时的NTP时间(Unix纪元纳秒) */
+  int64_t pts;     /* SEI中的编码器PTS */
+
+  /* 写入.ssix索引用 */
+  int64_t stream_pts; /* 容器PTS(TS已展开回绕), 时间基见stream_scan_t */
+  uint64_t offset;    /* 帧在文件中的字节偏移 */
+  bool keyframe;      /* IDR/IRAP帧 */
+} stamp_record_t;
+
+typedef struct stream_scan {
+  stream_format_t format;
+  seistamp_codec_t codec;
+  uint64_t frames;       /* 视频帧数 */
+  int64_t duration_us;   /* 最后一帧的容器时间 */
+  int32_t time_base_num; /* stream_pts的时间基 */
+  int32_t time_base_den;
+  stamp_record_t *stamps;
+  size_t stamp_count;
+  size_t stamp_capacity;
+  char error[128]; /* 失败原因 */
+} stream_scan_t;
+
+/*
+ * 扫描整个文件
+ * 参数:
+ *   data / size - 文件内容(通常为mmap)
+ *   path - 文件名, 用于按扩展名判断裸码流的编码
+ *   fps - 裸码流没有时间信息, 按该帧率推算容器时间
+ *   scan - 输出(需要stream_scan_free释放)
+ * 返回:
+ *   false - 格式无法识别或没有视频轨道, 原因见scan->error
+ */
+bool stream_scan_file(const uint8_t *data, size_t size, const char *path,
+                      double fps, stream_scan_t *scan);
+
+/*
+ * 以mmap方式读取并扫描文件
+ * 参数:
+ *   size_out - 文件大小(统计吞吐量用)
+ */
+bool stream_scan_path(const char *path, double fps, stream_scan_t *scan,
+                      size_t *size_out);
+
+void stream_scan_free(stream_scan_t *scan);
+
+/*
+ * 把时间戳写成.ssix索引 (libseistamp格式), 供播放工具按NTP时间定位
+ * 参数:
+ *   index_path - 通常为录像路径加SEISTAMP_INDEX_EXTENSION
+ * 返回:
+ *   false - 无法写入, 原因见scan->error
+ */
+bool stream_scan_write_index(stream_scan_t *scan, const char *index_path);
+
+const char *stream_format_name(stream_format_t format);
+
+/* 以下供各格式的扫描器使用 */
+
+/*
+ * 记录一个时间戳; stream_pts/offset/keyframe由调用者填写
+ * 返回:
+ *   新记录, 内存不足时返回NULL
+ */
+stamp_record_t *stream_scan_add_stamp(stream_scan_t *scan, uint64_t frame,
+                                      int64_t time_us,
+                                      const seistamp_stamp_t *stamp);
+
+/* 帧的第一个VCL NAL是否为IDR (H.264) / IRAP (H.265) */
+bool stream_scan_is_keyframe_nal(const uint8_t *nal, seistamp_codec_t codec);
+
+/* 在Annex B访问单元中查找第一个VCL NAL并判断是否为关键帧 */
+bool stream_scan_annexb_keyframe(const uint8_t *data, size_t size,
+                                 seistamp_codec_t codec);
+
+/*
+ * 扫描一帧长度前缀格式的数据(MP4 sample), 遇到第一个VCL NAL即停止
+ * 参数:
+ *   keyframe_out - 非NULL时找到时间戳后继续到第一个VCL NAL判断关键帧
+ * 返回:
+ *   true - 找到时间戳SEI
+ */
+bool stream_scan_length_prefixed(const uint8_t *data, size_t size,
+                                 int length_size, seistamp_codec_t codec,
+                                 seistamp_stamp_t *stamp_out,
+                                 bool *keyframe_out);
+
+bool stream_scan_mp4(const uint8_t *data, size_t size, stream_scan_t *scan);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,256 @@
+/******************************************************************************
+    Stamp Seek
+    Copyright (C) 2026
+
+    Looks up a wall-clock instant in the .ssix sidecar indexes of several
+    recordings (written by the receiver or stamp-analyzer --write-index)
+    and prints, for every angle, the frame shown at that instant and the
+    keyframe to start decoding from. Only the indexes are mapped; the
+    media files are never opened.
+******************************************************************************/
+
+#include <getopt.h>
+#include <limits.h>
+#include <seistamp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct seek_options {
+  bool utc; /* 按UTC而非本地时间解析和显示 */
+  bool verbose;
+} seek_options_t;
+
+static void log_handler(int level, const char *format, va_list args,
+                        void *param) {
+  const seek_options_t *options = param;
+  if (!options->verbose && level > SEISTAMP_LOG_WARNING)
+    return;
+  vfprintf(stderr, format, args);
+  fputc('\n', stderr);
+}
+
+static void format_wallclock(uint64_t ntp_ns, bool utc, char *buf,
+                             size_t size) {
+  time_t seconds = (time_t)(ntp_ns / 1000000000ULL);
+  struct tm tm;
+  if (utc)
+    gmtime_r(&seconds, &tm);
+  else
+    localtime_r(&seconds, &tm);
+
+  char date[32];
+  strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", &tm);
+  snprintf(buf, size, "%s.%03d", date,
+           (int)(ntp_ns / 1000000ULL % 1000ULL));
+}
+
+/* "SS.fff"中的小数部分 -> 纳秒 */
+static uint64_t parse_fraction_ns(const char *fraction) {
+  uint64_t ns = 0, scale = 100000000ULL;
+  for (; *fraction >= '0' && *fraction <= '9' && scale; fraction++) {
+    ns += (uint64_t)(*fraction - '0') * scale;
+    scale /= 10;
+  }
+  return ns;
+}
+
+/*
+ * 解析查找时间:
+ *   1700000000.25           Unix秒
+ *   2026-10-18T12:03:15.240 日期和时间 (也可用空格分隔)
+ *   12:03:15.240            第一个索引首帧所在日期的时刻;
+ *                           早于首帧时刻时视为跨过午夜的第二天
+ */
+static bool parse_time(const char *text, const seistamp_index_t *first,
+                       bool utc, uint64_t *ntp_ns) {
+  if (!strchr(text, ':')) {
+    char *end;
+    double seconds = strtod(text, &end);
+    if (end == text || *end || seconds < 0)
+      return false;
+    *ntp_ns = (uint64_t)(seconds * 1e9 + 0.5);
+    return true;
+  }
+
+  struct tm tm = {0};
+  int hour, minute, second, consumed = 0;
+  bool has_date = false;
+  if (sscanf(text, "%d-%d-%d%*1[T ]%d:%d:%d%n", &tm.tm_year, &tm.tm_mon,
+             &tm.tm_mday, &hour, &minute, &second, &consumed) == 6) {
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    has_date = true;
+  } else if (sscanf(text, "%d:%d:%d%n", &hour, &minute, &second,
+                    &consumed) != 3) {
+    return false;
+  }
+
+  const char *rest = text + consumed;
+  uint64_t fraction_ns = 0;
+  if (*rest == '.')
+    fraction_ns = parse_fraction_ns(++rest);
+  else if (*rest)
+    return false;
+
+  time_t first_seconds = 0;
+  if (!has_date) {
+    if (first->count == 0)
+      return false;
+    first_seconds = (time_t)(first->entries[0].ntp_ns / 1000000000ULL);
+    if (utc)
+      gmtime_r(&first_seconds, &tm);
+    else
+      localtime_r(&first_seconds, &tm);
+  }
+  tm.tm_hour = hour;
+  tm.tm_min = minute;
+  tm.tm_sec = second;
+  tm.tm_isdst = -1;
+
+  time_t seconds = utc ? timegm(&tm) : mktime(&tm);
+  if (seconds == (time_t)-1)
+    return false;
+  if (!has_date && seconds < first_seconds)
+    seconds += 86400;
+
+  *ntp_ns = (uint64_t)seconds * 1000000000ULL + fraction_ns;
+  return true;
+}
+
+static double pts_seconds(const seistamp_index_t *index, int64_t pts) {
+  return (double)pts * index->header.time_base_num /
+         index->header.time_base_den;
+}
+
+static void report(const char *path, const seistamp_index_t *index,
+                   uint64_t ntp_ns, bool utc) {
+  char first[40], last[40];
+  format_wallclock(index->entries[0].ntp_ns, utc, first, sizeof(first));
+  format_wallclock(index->entries[index->count - 1].ntp_ns, utc, last,
+                   sizeof(last));
+
+  /* 最后一帧显示一个帧间隔 */
+  size_t n = index->count;
+  uint64_t last_interval =
+      n > 1 ? index->entries[n - 1].ntp_ns - index->entries[n - 2].ntp_ns : 0;
+
+  size_t i = seistamp_index_find(index, ntp_ns);
+  if (i == SIZE_MAX ||
+      (i == n - 1 && ntp_ns - index->entries[i].ntp_ns > last_interval)) {
+    printf("%s: not covered (indexed %s to %s)\n", path, first, last);
+    return;
+  }
+
+  const seistamp_index_entry_t *entry = &index->entries[i];
+  char when[40];
+  format_wallclock(entry->ntp_ns, utc, when, sizeof(when));
+  printf("%s\n  frame     %s (%.1f ms before), pts %lld (%.3f s), "
+         "offset %llu%s\n",
+         path, when, (double)(ntp_ns - entry->ntp_ns) / 1e6,
+         (long long)entry->pts, pts_seconds(index, entry->pts),
+         (unsigned long long)entry->offset,
+         (entry->flags & SEISTAMP_INDEX_KEYFRAME) ? ", keyframe" : "");
+
+  size_t k = seistamp_index_find_keyframe(index, i);
+  if (k == SIZE_MAX) {
+    printf("  keyframe  none indexed before this frame\n");
+  } else if (k != i) {
+    const seistamp_index_entry_t *key = &index->entries[k];
+    printf("  keyframe  pts %lld (%.3f s), offset %llu, %zu frames "
+           "earlier\n",
+           (long long)key->pts, pts_seconds(index, key->pts),
+           (unsigned long long)key->offset, i - k);
+  }
+}
+
+static void usage(const char *argv0) {
+  fprintf(stderr,
+          "Usage: %s [options] TIME FILE...\n"
+          "Find the frame of each recording shown at wall-clock TIME using\n"
+          "the .ssix sidecar indexes (FILE may be the recording or its\n"
+          "index). TIME is Unix seconds, YYYY-MM-DDTHH:MM:SS.fff or\n"
+          "HH:MM:SS.fff on the day the first recording starts.\n\n"
+          "  --utc       TIME and output are UTC (default: local time)\n"
+          "  --verbose   log library messages\n",
+          argv0);
+}
+
+int main(int argc, char **argv) {
+  seek_options_t options = {0};
+
+  static const struct option long_options[] = {
+      {"utc", no_argument, NULL, 'u'},
+      {"verbose", no_argument, NULL, 'v'},
+      {"help", no_argument, NULL, 'h'},
+      {NULL, 0, NULL, 0},
+  };
+
+  int c;
+  while ((c = getopt_long(argc, argv, "h", long_options, NULL)) != -1) {
+    switch (c) {
+    case 'u':
+      options.utc = true;
+      break;
+    case 'v':
+      options.verbose = true;
+      break;
+    default:
+      usage(argv[0]);
+      return c == 'h' ? 0 : 2;
+    }
+  }
+
+  if (argc - optind < 2) {
+    usage(argv[0]);
+    return 2;
+  }
+  seistamp_set_log_handler(log_handler, &options);
+
+  const char *time_text = argv[optind];
+  size_t count = (size_t)(argc - optind - 1);
+  char **paths = argv + optind + 1;
+
+  seistamp_index_t *indexes = calloc(count, sizeof(seistamp_index_t));
+  if (!indexes)
+    return 1;
+
+  int status = 0;
+  for (size_t i = 0; i < count; i++) {
+    /* 录像路径自动加上索引扩展名 */
+    char path[PATH_MAX];
+    size_t length = strlen(paths[i]);
+    size_t ext = strlen(SEISTAMP_INDEX_EXTENSION);
+    if (length > ext &&
+        strcmp(paths[i] + length - ext, SEISTAMP_INDEX_EXTENSION) == 0)
+      snprintf(path, sizeof(path), "%s", paths[i]);
+    else
+      snprintf(path, sizeof(path), "%s%s", paths[i],
+               SEISTAMP_INDEX_EXTENSION);
+
+    if (!seistamp_index_open(&indexes[i], path) || indexes[i].count == 0) {
+      fprintf(stderr, "%s: no usable index\n", path);
+      status = 1;
+    }
+  }
+
+  uint64_t ntp_ns = 0;
+  if (!status && !parse_time(time_text, &indexes[0], options.utc, &ntp_ns)) {
+    fprintf(stderr, "Cannot parse time '%s'\n", time_text);
+    status = 2;
+  }
+
+  if (!status) {
+    char when[40];
+    format_wallclock(ntp_ns, options.utc, when, sizeof(when));
+    printf("Seeking to %s\n", when);
+    for (size_t i = 0; i < count; i++)
+      report(paths[i], &indexes[i], ntp_ns, options.utc);
+  }
+
+  for (size_t i = 0; i < count; i++)
+    seistamp_index_close(&indexes[i]);
+  free(indexes);
+  return status;
+}